@@ -7,7 +7,7 @@
 #define CHUNKWM_EXTERN extern "C"
 
 // NOTE(koekeishiya): Increment upon ABI breaking changes!
-#define CHUNKWM_PLUGIN_API_VERSION 6
+#define CHUNKWM_PLUGIN_API_VERSION 7
 
 // NOTE(koekeishiya): Forward-declare struct
 struct plugin;
@@ -18,11 +18,82 @@ typedef PLUGIN_BOOL_FUNC(plugin_bool_func);
 #define PLUGIN_VOID_FUNC(name) void name()
 typedef PLUGIN_VOID_FUNC(plugin_void_func);
 
-#define PLUGIN_MAIN_FUNC(name)   \
-    bool name(const char *Node,  \
+#define PLUGIN_MAIN_FUNC(name)                \
+    bool name(chunkwm_plugin_export Export,   \
+              uint32_t Topic,                 \
+              const char *Node,               \
               void *Data)
 typedef PLUGIN_MAIN_FUNC(plugin_main_func);
 
+/*
+ * NOTE(koekeishiya): Exports are small consecutive integers, so a switch over them compiles
+ * to a jump table instead of a chain of string comparisons. 'Topic' is only set for
+ * 'chunkwm_export_plugin_broadcast', see 'chunkwm_api.InternTopic'.
+ *
+ *     PLUGIN_MAIN_FUNC(PluginMain)
+ *     {
+ *         CHUNKWM_DISPATCH_BEGIN(Export)
+ *         CHUNKWM_DISPATCH_CASE(chunkwm_export_window_created)
+ *         CHUNKWM_DISPATCH(chunkwm_export_window_deminimized, NewWindowHandler(Data))
+ *         CHUNKWM_DISPATCH(chunkwm_export_window_destroyed, WindowDestroyedHandler(Data))
+ *         CHUNKWM_DISPATCH_END()
+ *         return false;
+ *     }
+ */
+#define CHUNKWM_DISPATCH_BEGIN(Export) switch (Export) {
+#define CHUNKWM_DISPATCH_CASE(Export) case Export:
+#define CHUNKWM_DISPATCH(Export, ...) case Export: { __VA_ARGS__; } return true;
+#define CHUNKWM_DISPATCH_END() default: break; }
+
+/*
+ * NOTE(koekeishiya): A plugin can opt in to receive the events that chunkwm dispatched in
+ * quick succession, e.g. when an application launches or the space changes, in a single
+ * call, see 'CHUNKWM_PLUGIN_VTABLE_BATCH'. The events are in the order they were posted, and
+ * the data of every event stays valid until the call returns. The main function is still
+ * called for 'chunkwm_export_events_subscribed'.
+ */
+struct chunkwm_event
+{
+    chunkwm_plugin_export Export;
+    uint32_t Topic;
+    const char *Node;
+    void *Data;
+};
+
+#define PLUGIN_BATCH_FUNC(name) void name(chunkwm_event *Events, uint32_t Count)
+typedef PLUGIN_BATCH_FUNC(plugin_batch_func);
+
+/*
+ * NOTE(koekeishiya): Filters are checked by chunkwm before an event is posted to a plugin,
+ * so that a plugin is not woken for events it would ignore, see 'CHUNKWM_PLUGIN_SUBSCRIBE_FILTERED'.
+ * They apply to window and application exports. An event is delivered if, for every type of
+ * filter listed for its export, at least one of them matches.
+ *
+ *     chunkwm_filter_owner     the name of the application equals 'String'
+ *     chunkwm_filter_level     the window level equals 'Integer'
+ *     chunkwm_filter_role      the role of the window equals 'String'
+ *     chunkwm_filter_subrole   the subrole of the window equals 'String'
+ *     chunkwm_filter_changed   the window id or pid differs from the last event delivered
+ */
+enum chunkwm_filter_type
+{
+    chunkwm_filter_owner,
+    chunkwm_filter_level,
+    chunkwm_filter_role,
+    chunkwm_filter_subrole,
+    chunkwm_filter_changed,
+
+    chunkwm_filter_type_count
+};
+
+struct chunkwm_filter
+{
+    chunkwm_plugin_export Export;
+    chunkwm_filter_type Type;
+    const char *String;
+    int Integer;
+};
+
 struct plugin
 {
     plugin_bool_func *Init;
@@ -31,6 +102,11 @@ struct plugin
 
     chunkwm_plugin_export *Subscriptions;
     unsigned SubscriptionCount;
+
+    plugin_batch_func *RunBatch;
+
+    chunkwm_filter *Filters;
+    unsigned FilterCount;
 };
 
 CHUNKWM_EXTERN typedef plugin *(*plugin_func)();
@@ -51,6 +127,15 @@ struct plugin_details
         Plugin->Run = PlMain;                                    \
     }
 
+#define CHUNKWM_PLUGIN_VTABLE_BATCH(PlInit, PlDeInit, PlMain, PlBatch) \
+    void InitPluginVTable(plugin *Plugin)                        \
+    {                                                            \
+        Plugin->Init = PlInit;                                   \
+        Plugin->DeInit = PlDeInit;                               \
+        Plugin->Run = PlMain;                                    \
+        Plugin->RunBatch = PlBatch;                              \
+    }
+
 #define CHUNKWM_PLUGIN_SUBSCRIBE(Sub)                            \
     void InitPluginSubscriptions(plugin *Plugin)                 \
     {                                                            \
@@ -58,6 +143,60 @@ struct plugin_details
         Plugin->Subscriptions = Sub;                             \
     }
 
+#define CHUNKWM_PLUGIN_SUBSCRIBE_FILTERED(Sub, Filter)           \
+    void InitPluginSubscriptions(plugin *Plugin)                 \
+    {                                                            \
+        Plugin->SubscriptionCount = sizeof(Sub) / sizeof(*Sub);  \
+        Plugin->Subscriptions = Sub;                             \
+        Plugin->FilterCount = sizeof(Filter) / sizeof(*Filter);  \
+        Plugin->Filters = Filter;                                \
+    }
+
+/*
+ * NOTE(koekeishiya): Plugins that are loaded together when chunkwm starts are initialized in
+ * parallel. A plugin that must be initialized after other plugins lists their names, e.g.
+ * CHUNKWM_PLUGIN_LOAD_AFTER("Tiling"). Plugins that are not loaded are ignored; this only
+ * orders the init functions, and a plugin is never loaded because it is listed here.
+ */
+#define CHUNKWM_PLUGIN_LOAD_AFTER(...)                           \
+    CHUNKWM_EXTERN                                               \
+    {                                                            \
+        const char *LoadAfter[] = { __VA_ARGS__, NULL };         \
+    }
+
+/*
+ * NOTE(koekeishiya): A plugin that is unloaded and loaded again from the same file, e.g. by
+ * the plugin watcher or 'chunkc core::unload' followed by 'chunkc core::load', can hand its
+ * state to the next instance, see 'CHUNKWM_PLUGIN_STATE'. 'Save' is called before 'DeInit'
+ * and allocates 'Data' with malloc; chunkwm owns it afterwards and keeps it in memory only.
+ * 'Restore' is called before 'Init' of the next instance, and 'Data' is only valid for the
+ * duration of the call. A plugin must check that it understands the state, it may have been
+ * saved by an older version of the plugin. The state is discarded once it has been restored.
+ */
+struct chunkwm_state
+{
+    void *Data;
+    size_t Size;
+};
+
+#define PLUGIN_SAVE_STATE_FUNC(name) bool name(chunkwm_state *State)
+typedef PLUGIN_SAVE_STATE_FUNC(plugin_save_state_func);
+
+#define PLUGIN_RESTORE_STATE_FUNC(name) bool name(chunkwm_state *State)
+typedef PLUGIN_RESTORE_STATE_FUNC(plugin_restore_state_func);
+
+struct plugin_state_handoff
+{
+    plugin_save_state_func *Save;
+    plugin_restore_state_func *Restore;
+};
+
+#define CHUNKWM_PLUGIN_STATE(PlSave, PlRestore)                  \
+    CHUNKWM_EXTERN                                               \
+    {                                                            \
+        plugin_state_handoff StateHandoff = { PlSave, PlRestore }; \
+    }
+
 #define CHUNKWM_PLUGIN(PluginName, PluginVersion)                \
       CHUNKWM_EXTERN                                             \
       {                                                          \
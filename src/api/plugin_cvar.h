@@ -2,25 +2,157 @@
 #define CHUNKWM_PLUGIN_CVAR_H
 
 #include <stddef.h>
+#include <stdint.h>
 
+/*
+ * NOTE(koekeishiya): The value of a cvar is parsed once when it is updated, so that reading
+ * it as a number does not have to. 'Unsigned' is parsed as hexadecimal, the way that it is
+ * written by 'UpdateCVar'. A number that could not be parsed is 0.
+ *
+ * Readers never take a lock. The numbers are read under 'Sequence', which is odd while an
+ * update is writing them, and the string is replaced and freed once no reader can still be
+ * using it.
+ *
+ * A cvar is never removed, so a pointer to it can be kept as a handle, see 'ResolveCVar'.
+ * 'Hash' is the hash of 'Name' used by the cvar table of chunkwm.
+ */
 struct cvar
 {
     const char *Name;
-    char *Value;
+    uint32_t Hash;
+    char *volatile Value;
+
+    uint32_t volatile Sequence;
+    int Integer;
+    unsigned Unsigned;
+    float FloatingPoint;
 };
 
 #define CHUNKWM_API_BROADCAST_FUNC(name) void name(const char *Plugin, const char *Event, void *Data, size_t Size)
 typedef CHUNKWM_API_BROADCAST_FUNC(plugin_broadcast_func);
 
+// NOTE(koekeishiya): Returns the id passed as 'Topic' when 'Plugin' broadcasts 'Event', or 0 if there are too many.
+#define CHUNKWM_API_INTERN_TOPIC_FUNC(name) uint32_t name(const char *Plugin, const char *Event)
+typedef CHUNKWM_API_INTERN_TOPIC_FUNC(plugin_intern_topic_func);
+
+// NOTE(koekeishiya): Same as 'Broadcast', for a topic returned by 'InternTopic'.
+#define CHUNKWM_API_BROADCAST_TOPIC_FUNC(name) void name(uint32_t Topic, void *Data, size_t Size)
+typedef CHUNKWM_API_BROADCAST_TOPIC_FUNC(plugin_broadcast_topic_func);
+
+/*
+ * NOTE(koekeishiya): Deliver broadcasts of 'Event' by 'Plugin' to the plugin named 'Subscriber',
+ * which should be the name of the caller. Returns the topic id, see 'InternTopic'.
+ */
+#define CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(name) uint32_t name(const char *Subscriber, const char *Plugin, const char *Event)
+typedef CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(plugin_subscribe_topic_func);
+
+/*
+ * NOTE(koekeishiya): A method that a plugin registers through 'RegisterMethod', and that other
+ * plugins call through 'CallMethod'. It runs on the thread of the caller, while the plugin may be
+ * receiving events on another, and must lock the state that it reads. The layout of 'Request' and
+ * 'Response' is defined by the plugin that registers the method. 'Response' holds '*ResponseSize'
+ * bytes; the method sets it to the number of bytes written, or to the number of bytes it needs
+ * when it returns 'chunkwm_call_too_small'.
+ */
+enum chunkwm_call_result
+{
+    chunkwm_call_ok,
+    chunkwm_call_not_found,
+    chunkwm_call_too_small,
+    chunkwm_call_failed,
+};
+
+#define CHUNKWM_API_METHOD_FUNC(name) \
+    chunkwm_call_result name(const void *Request, size_t RequestSize, void *Response, size_t *ResponseSize)
+typedef CHUNKWM_API_METHOD_FUNC(plugin_method_func);
+
+/*
+ * NOTE(koekeishiya): 'Plugin' should be the name of the caller. Returns false if the plugin already
+ * registered a method by that name. The methods of a plugin are removed when it is unloaded.
+ */
+#define CHUNKWM_API_REGISTER_METHOD_FUNC(name) bool name(const char *Plugin, const char *Method, plugin_method_func *Function)
+typedef CHUNKWM_API_REGISTER_METHOD_FUNC(plugin_register_method_func);
+
+// NOTE(koekeishiya): Calls 'Method' of 'Plugin' and returns once it is done, see 'CHUNKWM_API_METHOD_FUNC'.
+#define CHUNKWM_API_CALL_METHOD_FUNC(name)                                                          \
+    chunkwm_call_result name(const char *Plugin, const char *Method,                                \
+                             const void *Request, size_t RequestSize, void *Response, size_t *ResponseSize)
+typedef CHUNKWM_API_CALL_METHOD_FUNC(plugin_call_method_func);
+
 #define CHUNKWM_API_UPDATE_CVAR_FUNC(name) void name(const char *Name, char *Value)
 typedef CHUNKWM_API_UPDATE_CVAR_FUNC(chunkwm_update_cvar_func);
 
+/*
+ * NOTE(koekeishiya): The string is freed once the cvar has been updated, so it must only be used
+ * between 'BeginCVarRead' and 'EndCVarRead'. 'CVarStringValue' in common/config/cvar.h copies it.
+ */
 #define CHUNKWM_API_ACQUIRE_CVAR_FUNC(name) char *name(const char *Name)
 typedef CHUNKWM_API_ACQUIRE_CVAR_FUNC(chunkwm_acquire_cvar_func);
 
+/*
+ * NOTE(koekeishiya): Reading cvars never blocks. A plugin that acquires the string of a cvar
+ * begins a read first, and passes the value it returns to 'EndCVarRead' once it is done with
+ * the string. Reads can be nested, and must not be held for long.
+ */
+#define CHUNKWM_API_BEGIN_CVAR_READ_FUNC(name) uint64_t name()
+typedef CHUNKWM_API_BEGIN_CVAR_READ_FUNC(chunkwm_begin_cvar_read_func);
+
+#define CHUNKWM_API_END_CVAR_READ_FUNC(name) void name(uint64_t Read)
+typedef CHUNKWM_API_END_CVAR_READ_FUNC(chunkwm_end_cvar_read_func);
+
 #define CHUNKWM_API_FIND_CVAR_FUNC(name) bool name(const char *Name)
 typedef CHUNKWM_API_FIND_CVAR_FUNC(chunkwm_find_cvar_func);
 
+// NOTE(koekeishiya): The value of the cvar as a number, or 0 if it does not exist, see 'cvar'.
+#define CHUNKWM_API_CVAR_INTEGER_FUNC(name) int name(const char *Name)
+typedef CHUNKWM_API_CVAR_INTEGER_FUNC(chunkwm_cvar_integer_func);
+
+#define CHUNKWM_API_CVAR_UNSIGNED_FUNC(name) unsigned name(const char *Name)
+typedef CHUNKWM_API_CVAR_UNSIGNED_FUNC(chunkwm_cvar_unsigned_func);
+
+#define CHUNKWM_API_CVAR_FLOATING_POINT_FUNC(name) float name(const char *Name)
+typedef CHUNKWM_API_CVAR_FLOATING_POINT_FUNC(chunkwm_cvar_floating_point_func);
+
+/*
+ * NOTE(koekeishiya): Returns the handle of a cvar, or NULL if it does not exist. Handles stay
+ * valid until chunkwm exits, so a plugin resolves the cvars it reads once, after it has created
+ * them in its init function, and does not look them up by name again.
+ */
+#define CHUNKWM_API_RESOLVE_CVAR_FUNC(name) cvar *name(const char *Name)
+typedef CHUNKWM_API_RESOLVE_CVAR_FUNC(chunkwm_resolve_cvar_func);
+
+// NOTE(koekeishiya): The same as the functions above, for a cvar that has been resolved.
+#define CHUNKWM_API_UPDATE_CVAR_HANDLE_FUNC(name) void name(cvar *CVar, char *Value)
+typedef CHUNKWM_API_UPDATE_CVAR_HANDLE_FUNC(chunkwm_update_cvar_handle_func);
+
+#define CHUNKWM_API_ACQUIRE_CVAR_HANDLE_FUNC(name) char *name(cvar *CVar)
+typedef CHUNKWM_API_ACQUIRE_CVAR_HANDLE_FUNC(chunkwm_acquire_cvar_handle_func);
+
+#define CHUNKWM_API_CVAR_HANDLE_INTEGER_FUNC(name) int name(cvar *CVar)
+typedef CHUNKWM_API_CVAR_HANDLE_INTEGER_FUNC(chunkwm_cvar_handle_integer_func);
+
+#define CHUNKWM_API_CVAR_HANDLE_UNSIGNED_FUNC(name) unsigned name(cvar *CVar)
+typedef CHUNKWM_API_CVAR_HANDLE_UNSIGNED_FUNC(chunkwm_cvar_handle_unsigned_func);
+
+#define CHUNKWM_API_CVAR_HANDLE_FLOATING_POINT_FUNC(name) float name(cvar *CVar)
+typedef CHUNKWM_API_CVAR_HANDLE_FLOATING_POINT_FUNC(chunkwm_cvar_handle_floating_point_func);
+
+/*
+ * NOTE(koekeishiya): Called when a watched cvar has been created or updated. Updates are coalesced,
+ * so a cvar that changes several times in a row may only be passed once, with its newest value.
+ * The callback runs in the same order as the other callbacks of the plugin, never concurrently.
+ */
+#define CHUNKWM_API_CVAR_WATCH_FUNC(name) void name(const char *Name, cvar *CVar)
+typedef CHUNKWM_API_CVAR_WATCH_FUNC(plugin_cvar_watch_func);
+
+/*
+ * NOTE(koekeishiya): 'Plugin' should be the name of the caller. 'Pattern' is the name of a cvar,
+ * and may contain '*' to match any number of characters, e.g. 'desktop_*' or '*_desktop_mode'.
+ * The watches of a plugin are removed when it is unloaded.
+ */
+#define CHUNKWM_API_WATCH_CVAR_FUNC(name) bool name(const char *Plugin, const char *Pattern, plugin_cvar_watch_func *Callback)
+typedef CHUNKWM_API_WATCH_CVAR_FUNC(chunkwm_watch_cvar_func);
+
 #ifdef CHUNKWM_CORE
 #define CHUNKWM_API_LOG_FUNC(name) void name(unsigned Level, const char *Format, ...)
 #else
@@ -35,6 +167,23 @@ struct chunkwm_api
     chunkwm_find_cvar_func *FindCVar;
     plugin_broadcast_func *Broadcast;
     chunkwm_log *Log;
+    plugin_intern_topic_func *InternTopic;
+    plugin_broadcast_topic_func *BroadcastTopic;
+    plugin_subscribe_topic_func *SubscribeTopic;
+    plugin_register_method_func *RegisterMethod;
+    plugin_call_method_func *CallMethod;
+    chunkwm_cvar_integer_func *CVarInteger;
+    chunkwm_cvar_unsigned_func *CVarUnsigned;
+    chunkwm_cvar_floating_point_func *CVarFloatingPoint;
+    chunkwm_begin_cvar_read_func *BeginCVarRead;
+    chunkwm_end_cvar_read_func *EndCVarRead;
+    chunkwm_resolve_cvar_func *ResolveCVar;
+    chunkwm_update_cvar_handle_func *UpdateCVarHandle;
+    chunkwm_acquire_cvar_handle_func *AcquireCVarHandle;
+    chunkwm_cvar_handle_integer_func *CVarHandleInteger;
+    chunkwm_cvar_handle_unsigned_func *CVarHandleUnsigned;
+    chunkwm_cvar_handle_floating_point_func *CVarHandleFloatingPoint;
+    chunkwm_watch_cvar_func *WatchCVar;
 };
 
 #endif
@@ -43,7 +43,12 @@ static const char *chunkwm_plugin_export_str[] =
     "chunkwm_export_window_deminimized",
     "chunkwm_export_window_title_changed",
 
-    "chunkwm_export_count"
+    "chunkwm_plugin_broadcast",
+    "chunkwm_daemon_command",
+    "chunkwm_events_subscribed",
+    "chunkwm_cvar_changed",
+
+    "chunkwm_export_message_count"
 };
 enum chunkwm_plugin_export
 {
@@ -71,7 +76,20 @@ enum chunkwm_plugin_export
     chunkwm_export_window_deminimized,
     chunkwm_export_window_title_changed,
 
-    chunkwm_export_count
+    chunkwm_export_count,
+
+    /*
+     * NOTE(koekeishiya): Messages that are delivered to 'PLUGIN_MAIN_FUNC', but that can
+     * not be subscribed to. A broadcast from another plugin also passes the topic id.
+     */
+    chunkwm_export_plugin_broadcast = chunkwm_export_count,
+    chunkwm_export_daemon_command,
+    chunkwm_export_events_subscribed,
+
+    // NOTE(koekeishiya): Runs the callback of a cvar watch instead, see 'WatchCVar'.
+    chunkwm_export_cvar_changed,
+
+    chunkwm_export_message_count
 };
 
 #endif
@@ -0,0 +1,80 @@
+#ifndef CHUNKWM_BENCH_H
+#define CHUNKWM_BENCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <algorithm>
+
+struct bench_samples
+{
+    uint64_t *Values;
+    size_t Count;
+    size_t Capacity;
+};
+
+inline uint64_t
+BenchNanoseconds()
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (uint64_t) Time.tv_sec * 1000000000ULL + (uint64_t) Time.tv_nsec;
+}
+
+inline void
+BenchBeginSamples(bench_samples *Samples, size_t Capacity)
+{
+    Samples->Values = (uint64_t *) malloc(Capacity * sizeof(uint64_t));
+    Samples->Count = 0;
+    Samples->Capacity = Capacity;
+}
+
+inline void
+BenchEndSamples(bench_samples *Samples)
+{
+    free(Samples->Values);
+    Samples->Values = NULL;
+    Samples->Count = 0;
+    Samples->Capacity = 0;
+}
+
+inline void
+BenchAddSample(bench_samples *Samples, uint64_t Value)
+{
+    if (Samples->Count < Samples->Capacity) {
+        Samples->Values[Samples->Count++] = Value;
+    }
+}
+
+inline void
+BenchMergeSamples(bench_samples *Dest, bench_samples *Source)
+{
+    for (size_t Index = 0; Index < Source->Count; ++Index) {
+        BenchAddSample(Dest, Source->Values[Index]);
+    }
+}
+
+// NOTE(koekeishiya): Sorts the samples in place.
+inline uint64_t
+BenchPercentile(bench_samples *Samples, double Percentile)
+{
+    if (!Samples->Count) return 0;
+
+    std::sort(Samples->Values, Samples->Values + Samples->Count);
+    size_t Index = (size_t) (Percentile / 100.0 * (Samples->Count - 1));
+    return Samples->Values[Index];
+}
+
+inline void
+BenchPrintLatency(const char *Label, bench_samples *Samples)
+{
+    printf("%-28s p50 %8llu ns  p99 %8llu ns  max %8llu ns\n",
+           Label,
+           (unsigned long long) BenchPercentile(Samples, 50.0),
+           (unsigned long long) BenchPercentile(Samples, 99.0),
+           (unsigned long long) BenchPercentile(Samples, 100.0));
+}
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * NOTE(koekeishiya): Compares the broadcast path of api version 6 against the topic bus that
+ * replaced it. Ten plugins each have a mailbox on the thread pool, the same mailboxes as the
+ * core. One of them broadcasts a small event at a high rate, and two are interested in it,
+ * like the tiling plugin and the border and ffm plugins that listen for floating windows.
+ *
+ *   legacy   the event name is formatted and the data is copied into separate allocations;
+ *            the broadcast is posted to every plugin but the sender, which compare its name
+ *   topic    the data is copied into a pooled payload and posted to the two subscribers of
+ *            the topic, which compare its id
+ *
+ * Prints broadcasts per second, from the first post until every mailbox has been drained.
+ *
+ *   make && ./bin/broadcast [threads] [broadcasts]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+#include "../core/mailbox.cpp"
+
+#define internal static
+
+#define PLUGIN_COUNT 10
+#define SUBSCRIBER_COUNT 2
+#define DEFAULT_BROADCASTS 200000
+
+#define SENDER_NAME "Tiling"
+#define EVENT_NAME "focused_window_float"
+#define TOPIC_ID 1
+
+internal const char *PluginNames[PLUGIN_COUNT] =
+{
+    SENDER_NAME, "Border", "Focus Follows Mouse", "bar", "purify",
+    "plugin5", "plugin6", "plugin7", "plugin8", "plugin9",
+};
+
+internal plugin Plugins[PLUGIN_COUNT];
+internal plugin_mailbox *Mailboxes[PLUGIN_COUNT];
+internal thread_pool Pool;
+
+internal uint64_t volatile Received[PLUGIN_COUNT];
+internal uint64_t volatile Handled[PLUGIN_COUNT];
+
+internal plugin_subscriber TopicSubscribers[SUBSCRIBER_COUNT];
+internal plugin_list TopicList = { SUBSCRIBER_COUNT, TopicSubscribers };
+
+/*
+ * NOTE(koekeishiya): Stands in for the plugins. Border and ffm handle the event, the others
+ * look for a handler and return, as a legacy plugin does for a broadcast it does not know.
+ */
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data)
+{
+    int Index = Plugin - Plugins;
+    __atomic_add_fetch(&Received[Index], 1, __ATOMIC_RELAXED);
+
+    bool Interested = Index > 0 && Index <= SUBSCRIBER_COUNT;
+    bool Match = Legacy ? strcmp(Node, SENDER_NAME "_" EVENT_NAME) == 0 : Topic == TOPIC_ID;
+    if (Interested && Match) {
+        uint32_t *Value = (uint32_t *) Data;
+        __atomic_add_fetch(&Handled[Index], Value[0] != 0, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    return false;
+}
+
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(DestroyLegacyBroadcast)
+{
+    void **BroadcastContext = (void **) Context;
+    free(BroadcastContext[0]);
+    free(BroadcastContext[1]);
+    free(BroadcastContext);
+}
+
+// NOTE(koekeishiya): 'ChunkwmBroadcast' and its callback before the topic bus, in one function.
+internal void
+LegacyBroadcast(const char *PluginName, const char *EventName, void *PluginData, size_t Size)
+{
+    void **Context = (void **) malloc(2 * sizeof(void *));
+
+    size_t TotalLength = strlen(PluginName) + strlen(EventName) + 2;
+    char *Event = (char *) malloc(TotalLength);
+    snprintf(Event, TotalLength, "%s_%s", PluginName, EventName);
+    Context[0] = Event;
+
+    void *Data = malloc(Size);
+    memcpy(Data, PluginData, Size);
+    Context[1] = Data;
+
+    plugin_payload *Payload = CreatePluginPayload(Data, &DestroyLegacyBroadcast, Context);
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        plugin_mailbox *Mailbox = Mailboxes[Index];
+        if (strncmp(Mailbox->Name, Event, strlen(Mailbox->Name)) != 0) {
+            PostPluginMailbox(Mailbox, chunkwm_export_plugin_broadcast, 0, Event, Payload);
+        }
+    }
+    ReleasePluginPayload(Payload);
+}
+
+// NOTE(koekeishiya): 'ChunkwmBroadcastTopic' and its callback, in one function.
+internal void
+TopicBroadcast(uint32_t Topic, const char *Node, void *Data, size_t Size)
+{
+    plugin_payload *Payload = CreatePluginPayloadCopy(Data, Size, (void *) (uintptr_t) Topic);
+    for (uint32_t Index = 0; Index < TopicList.Count; ++Index) {
+        PostPluginMailbox(TopicList.Subscribers[Index].Mailbox, chunkwm_export_plugin_broadcast, Topic, Node, Payload);
+    }
+    ReleasePluginPayload(Payload);
+}
+
+internal void
+CreateMailboxes(bool Legacy)
+{
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        Mailboxes[Index] = CreatePluginMailbox(Plugins + Index, PluginNames[Index], Legacy);
+        Received[Index] = 0;
+        Handled[Index] = 0;
+    }
+
+    for (int Index = 0; Index < SUBSCRIBER_COUNT; ++Index) {
+        TopicSubscribers[Index].Plugin = Plugins + Index + 1;
+        TopicSubscribers[Index].Mailbox = Mailboxes[Index + 1];
+    }
+}
+
+internal void
+DestroyMailboxes()
+{
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        DrainPluginMailbox(Mailboxes[Index]);
+        DestroyPluginMailbox(Mailboxes[Index]);
+    }
+}
+
+internal bool
+RunBenchmark(const char *Label, bool Legacy, uint32_t Broadcasts)
+{
+    CreateMailboxes(Legacy);
+
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Broadcasts; ++Index) {
+        uint32_t Data[2] = { Index + 1, Index & 1 };
+        if (Legacy) {
+            LegacyBroadcast(SENDER_NAME, EVENT_NAME, Data, sizeof(Data));
+        } else {
+            TopicBroadcast(TOPIC_ID, SENDER_NAME "_" EVENT_NAME, Data, sizeof(Data));
+        }
+    }
+
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        DrainPluginMailbox(Mailboxes[Index]);
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    uint64_t Delivered = 0;
+    bool Result = true;
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        Delivered += Received[Index];
+        if (Index > 0 && Index <= SUBSCRIBER_COUNT && Handled[Index] != Broadcasts) {
+            Result = false;
+        }
+    }
+
+    printf("%-8s %10.0f broadcasts/s  %6.1f ns/broadcast  %8llu deliveries  %s\n",
+           Label,
+           Broadcasts / (Elapsed / 1000000000.0),
+           (double) Elapsed / Broadcasts,
+           (unsigned long long) Delivered,
+           Result ? "ok" : "FAILED: a subscriber missed a broadcast");
+
+    DestroyMailboxes();
+    return Result;
+}
+
+int main(int Count, char **Args)
+{
+    int ThreadCount = Count > 1 ? atoi(Args[1]) : ThreadPoolDefaultThreadCount();
+    uint32_t Broadcasts = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_BROADCASTS;
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+    if (!BeginThreadPool(&Pool, ThreadCount) || !BeginPluginMailboxes(&Pool)) {
+        fprintf(stderr, "broadcast: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%d plugins, %d subscribers, %d threads, %u broadcasts\n",
+           PLUGIN_COUNT, SUBSCRIBER_COUNT, ThreadCount, Broadcasts);
+
+    bool Result = true;
+    Result &= RunBenchmark("legacy", true, Broadcasts);
+    Result &= RunBenchmark("topic", false, Broadcasts);
+
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
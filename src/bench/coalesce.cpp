@@ -0,0 +1,139 @@
+/*
+ * NOTE(koekeishiya): Drives the core event-loop with bursts of window moved events for
+ * a set of windows, and verifies that coalescing never drops the newest event for a window.
+ * Each handler simulates the cost of fanning an event out to plugins, so the drain time
+ * shows how much work coalescing saves.
+ *
+ *   make && ./bin/coalesce [windows] [events-per-window]
+ */
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/histogram.cpp"
+#include "../core/wakeup.cpp"
+#include "../core/dispatch/ring.cpp"
+#include "../core/dispatch/event.cpp"
+#include "../core/epoch.cpp"
+
+#define internal static
+
+#define MAX_WINDOWS 256
+#define HANDLER_COST_NS 2000
+
+internal uint32_t LastQueued[MAX_WINDOWS];
+internal uint32_t LastDispatched[MAX_WINDOWS];
+internal uint32_t volatile Dispatched;
+internal bool volatile Drained;
+
+internal inline void *
+EncodeContext(uint32_t Window, uint32_t Iteration)
+{
+    return (void *)(uintptr_t)((Window << 20) | Iteration);
+}
+
+internal void
+SimulateHandler(chunk_event *Event)
+{
+    uint32_t Value = (uint32_t)(uintptr_t) Event->Context;
+    uint32_t Window = Value >> 20;
+    uint32_t Iteration = Value & 0xFFFFF;
+
+    if (Iteration > LastDispatched[Window]) {
+        LastDispatched[Window] = Iteration;
+    }
+    ++Dispatched;
+
+    uint64_t End = BenchNanoseconds() + HANDLER_COST_NS;
+    while (BenchNanoseconds() < End);
+}
+
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowMoved)   { SimulateHandler(Event); }
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowFocused) { Drained = true; }
+
+internal void
+ProduceEvents(uint32_t Windows, uint32_t EventsPerWindow, bool Coalesce)
+{
+    for (uint32_t Iteration = 1; Iteration <= EventsPerWindow; ++Iteration) {
+        for (uint32_t Window = 0; Window < Windows; ++Window) {
+            void *Context = EncodeContext(Window, Iteration);
+            if (Coalesce) {
+                ConstructCoalescedEvent(ChunkWM_WindowMoved, Context, Window + 1);
+            } else {
+                ConstructEvent(ChunkWM_WindowMoved, Context);
+            }
+            LastQueued[Window] = Iteration;
+        }
+    }
+}
+
+internal bool
+RunBenchmark(uint32_t Windows, uint32_t EventsPerWindow, bool Coalesce)
+{
+    memset(LastQueued, 0, sizeof(LastQueued));
+    memset(LastDispatched, 0, sizeof(LastDispatched));
+    Dispatched = 0;
+    Drained = false;
+
+    event_coalesce_stats Before = EventCoalesceStats(ChunkWM_WindowMoved);
+
+    uint64_t Begin = BenchNanoseconds();
+    StartEventLoop();
+    ProduceEvents(Windows, EventsPerWindow, Coalesce);
+    ConstructEvent(ChunkWM_WindowFocused, NULL);
+
+    while (!Drained) {
+        sched_yield();
+    }
+
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+    StopEventLoop();
+
+    event_coalesce_stats After = EventCoalesceStats(ChunkWM_WindowMoved);
+
+    bool Success = true;
+    for (uint32_t Window = 0; Window < Windows; ++Window) {
+        if (LastDispatched[Window] != LastQueued[Window]) {
+            printf("window %u: newest event %u was not dispatched (last %u)\n",
+                   Window, LastQueued[Window], LastDispatched[Window]);
+            Success = false;
+        }
+    }
+
+    printf("%-9s queued %8llu  coalesced %8llu  dispatched %8u  drain %8.2f ms  %s\n",
+           Coalesce ? "coalesce" : "fifo",
+           (unsigned long long) Windows * EventsPerWindow,
+           (unsigned long long) (After.Coalesced - Before.Coalesced),
+           Dispatched,
+           (double) Elapsed / 1e6,
+           Success ? "ok" : "FAILED");
+
+    return Success;
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Windows = 32;
+    uint32_t EventsPerWindow = 500;
+
+    if (Count > 1) sscanf(Args[1], "%u", &Windows);
+    if (Count > 2) sscanf(Args[2], "%u", &EventsPerWindow);
+    if (Windows > MAX_WINDOWS) Windows = MAX_WINDOWS;
+
+    c_log_active_level = C_LOG_LEVEL_NONE;
+    if (!BeginEventLoop()) {
+        fprintf(stderr, "coalesce: could not initialize event-loop!\n");
+        return EXIT_FAILURE;
+    }
+
+    bool Success = RunBenchmark(Windows, EventsPerWindow, false) &&
+                   RunBenchmark(Windows, EventsPerWindow, true);
+
+    EndEventLoop();
+    return Success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,216 @@
+/*
+ * NOTE(koekeishiya): Compares the time it takes to apply the config-file at startup. Both
+ * configs have the same lines: cvars, core commands and plugin commands, in the proportions
+ * of a typical '.chunkwmrc'. They go through the 'DaemonCallback' of the core.
+ *
+ *   shell    '/bin/bash -c' runs the config as a script, the way 'ForkExecWait' does; every
+ *            line runs chunkc, which connects to the daemon and waits for it to answer
+ *   native   the core reads the config itself, see 'LoadNativeConfig'
+ *
+ * Plugin commands are queued until the event-loop starts, the same as at startup, so chunkc
+ * waits for its timeout on every one of them. Fails if the configs did not set the same cvars.
+ *
+ *   make && ./bin/config [lines] [runs]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "../core/constants.h"
+#include "../core/clog.h"
+#include "../core/clog.c"
+
+// NOTE(koekeishiya): Defined in callback.cpp in the core. Nothing is broadcast while the config is applied.
+void ChunkwmBroadcast(const char *PluginName, const char *EventName, void *PluginData, size_t Size) {}
+void ChunkwmBroadcastTopic(uint32_t Topic, void *Data, size_t Size) {}
+
+#include "../core/histogram.cpp"
+#include "../core/trace.cpp"
+#include "../core/dispatch/ring.cpp"
+#include "../core/dispatch/event.cpp"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+#include "../core/mailbox.cpp"
+#include "../core/filter.cpp"
+#include "../core/method.cpp"
+#include "../core/watch.cpp"
+#include "../core/plugin.cpp"
+#include "../core/shmring.cpp"
+#include "../core/host.cpp"
+#include "../core/cvar.cpp"
+#include "../core/recorder.cpp"
+#include "../core/config.cpp"
+#include "../common/config/cvar.cpp"
+#include "../common/config/tokenize.cpp"
+#include "../common/ipc/daemon.cpp"
+#include "../replay/stub/element.cpp"
+
+#define internal static
+
+#define DEFAULT_LINES 150
+#define DEFAULT_RUNS 3
+#define BENCH_PORT 3929
+#define CHUNKC_PATH "./bin/chunkc"
+
+/*
+ * NOTE(koekeishiya): Defined in callback.cpp in the core. The event-loop is not started, so the
+ * plugin commands of every run stay queued, and must fit in the event ring.
+ */
+CHUNKWM_CALLBACK(Callback_ChunkWM_PluginLoad) {}
+CHUNKWM_CALLBACK(Callback_ChunkWM_PluginUnload) {}
+CHUNKWM_CALLBACK(Callback_ChunkWM_PluginCommand) {}
+
+internal inline uint32_t
+PluginCommandCount(uint32_t Lines)
+{
+    return (Lines / 20) * 7 + (Lines % 20 > 13 ? Lines % 20 - 13 : 0);
+}
+
+/*
+ * NOTE(koekeishiya): Of every twenty lines, twelve set a cvar, one is a core command and seven
+ * are plugin commands. The value of each cvar depends on the run, so that a run that did not
+ * apply a line is noticed.
+ */
+internal bool
+WriteConfig(const char *Path, bool Native, const char *Chunkc, uint32_t Lines, uint32_t Run)
+{
+    FILE *Handle = fopen(Path, "w");
+    if (!Handle) return false;
+
+    const char *Prefix = Native ? "" : "\"$CHUNKC\" ";
+    const char *Quote = Native ? "\"" : "\\\"";
+    fprintf(Handle, "%s\n", Native ? CHUNKWM_NATIVE_CONFIG : "#!/bin/bash");
+    if (!Native) fprintf(Handle, "CHUNKC=\"%s\"\n", Chunkc);
+
+    for (uint32_t Index = 0; Index < Lines; ++Index) {
+        uint32_t Kind = Index % 20;
+        if (Kind < 12) {
+            fprintf(Handle, "%sset bench_cvar_%u %u\n", Prefix, Index, Run * 100000 + Index);
+        } else if (Kind == 12) {
+            fprintf(Handle, "%score::plugin_budget %u\n", Prefix, Index);
+        } else {
+            fprintf(Handle, "%stiling::rule --owner %sApp %u%s --state float\n", Prefix, Quote, Index, Quote);
+        }
+    }
+
+    fclose(Handle);
+    return true;
+}
+
+internal bool
+CheckConfig(uint32_t Lines, uint32_t Run)
+{
+    char Name[64];
+    for (uint32_t Index = 0; Index < Lines; ++Index) {
+        if (Index % 20 >= 12) continue;
+        snprintf(Name, sizeof(Name), "bench_cvar_%u", Index);
+        if (!FindCVarAPI(Name) || CVarIntegerValue(Name) != (int) (Run * 100000 + Index)) {
+            fprintf(stderr, "config: run %u did not set '%s'!\n", Run, Name);
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE(koekeishiya): The same as 'ForkExecWait' in chunkwm.mm.
+internal void
+RunShellConfig(const char *Path)
+{
+    int Pid = fork();
+    if (Pid == -1) {
+        fprintf(stderr, "config: fork failed!\n");
+    } else if (Pid > 0) {
+        int Status;
+        waitpid(Pid, &Status, 0);
+    } else {
+        char *Exec[] = { (char *) "/bin/bash", (char *) "-c", (char *) Path, NULL };
+        exit(execvp(Exec[0], Exec));
+    }
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Lines = Count > 1 ? (uint32_t) atoi(Args[1]) : DEFAULT_LINES;
+    uint32_t Runs = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_RUNS;
+    if (Lines == 0 || Runs == 0) {
+        fprintf(stderr, "usage: config [lines] [runs]\n");
+        return EXIT_FAILURE;
+    }
+
+    if (2 * Runs * PluginCommandCount(Lines) >= EVENT_RING_SIZE) {
+        fprintf(stderr, "config: the plugin commands of %u runs of %u lines do not fit in the event ring!\n", Runs, Lines);
+        return EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+
+    char Chunkc[PATH_MAX];
+    if (!realpath(CHUNKC_PATH, Chunkc)) {
+        fprintf(stderr, "config: could not find '%s', run make first!\n", CHUNKC_PATH);
+        return EXIT_FAILURE;
+    }
+
+    char Port[16];
+    snprintf(Port, sizeof(Port), "%d", BENCH_PORT);
+    setenv("CHUNKC_SOCKET", Port, 1);
+
+    if (!BeginCVars() || !BeginPlugins() || !BeginEventLoop()) {
+        fprintf(stderr, "config: could not initialize the core!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!StartDaemon(BENCH_PORT, DaemonCallback)) {
+        fprintf(stderr, "config: could not start the daemon on port %d!\n", BENCH_PORT);
+        return EXIT_FAILURE;
+    }
+
+    char ShellPath[] = "/tmp/chunkwm-bench-shell-XXXXXX";
+    char NativePath[] = "/tmp/chunkwm-bench-native-XXXXXX";
+    int ShellFD = mkstemp(ShellPath);
+    int NativeFD = mkstemp(NativePath);
+    if (ShellFD == -1 || NativeFD == -1) {
+        fprintf(stderr, "config: could not create config files!\n");
+        return EXIT_FAILURE;
+    }
+    close(ShellFD);
+    close(NativeFD);
+
+    // NOTE(koekeishiya): 'bash -c' executes the config, the same as '.chunkwmrc' it must be executable.
+    chmod(ShellPath, 0755);
+
+    printf("%u lines, %u runs\n", Lines, Runs);
+
+    bool Result = true;
+    uint32_t Run = 1;
+    for (uint32_t Index = 0; Result && Index < Runs; ++Index) {
+        WriteConfig(ShellPath, false, Chunkc, Lines, Run);
+        uint64_t Begin = BenchNanoseconds();
+        RunShellConfig(ShellPath);
+        uint64_t Shell = BenchNanoseconds() - Begin;
+        Result &= CheckConfig(Lines, Run++);
+
+        WriteConfig(NativePath, true, Chunkc, Lines, Run);
+        Result &= IsNativeConfig(NativePath);
+        Begin = BenchNanoseconds();
+        LoadNativeConfig(NativePath);
+        uint64_t Native = BenchNanoseconds() - Begin;
+        Result &= CheckConfig(Lines, Run++);
+
+        printf("run %u    shell %10.2f ms  native %8.3f ms\n", Index + 1, Shell / 1000000.0, Native / 1000000.0);
+    }
+
+    unlink(ShellPath);
+    unlink(NativePath);
+    StopDaemon();
+
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
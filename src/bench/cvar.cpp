@@ -0,0 +1,505 @@
+/*
+ * NOTE(koekeishiya): Measures how fast plugins can read cvars as numbers, which the tiling
+ * plugin does on every window it tiles and every window moved event. The store holds the
+ * cvars of the core and the tiling plugin, with the offsets of eight desktops, and readers
+ * cycle through the ones read on hot paths.
+ *
+ *   string   'AcquireCVar' and sscanf, what the CVar*Value functions used to do
+ *   locked   typed values in a map behind a mutex, how the store used to be read
+ *   typed    'CVarInteger', 'CVarUnsigned' and 'CVarFloatingPoint', read without a lock
+ *   handle   the same, through handles that each reader resolves once with 'ResolveCVar'
+ *   copy     'CVarStringValue' and sscanf, the way plugins read the string of a cvar
+ *
+ * Prints reads per second for 1 up to 'threads' reader threads. The stress run then adds a
+ * thread that updates the cvars that are being read as fast as it can. Typed readers also check
+ * a string on every iteration, which they acquire inside 'BeginCVarRead' and 'EndCVarRead'.
+ * Copy readers check every string they read, without beginning a read themselves. Build with
+ * 'make tsan' to run the stress under ThreadSanitizer.
+ *
+ * The last run reads the offsets and mode of a desktop the way 'GetVirtualSpaceConfig' of the
+ * tiling plugin does: by name from the map, checking that the desktop cvar exists first; by
+ * name from the hash table, resolving the desktop cvar once; through handles; and from a table
+ * of the values of each desktop, compiled once, that the tiling plugin now keeps.
+ *
+ *   make && ./bin/cvar [reads] [threads]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#include <map>
+
+#include "../api/plugin_api.h"
+#include "../common/misc/string.h"
+#include "../core/cvar.h"
+#include "../core/epoch.cpp"
+#include "../core/cvar.cpp"
+#include "../common/config/cvar.cpp"
+
+#define internal static
+
+#define DEFAULT_READS 2000000
+#define DEFAULT_THREADS 4
+#define DESKTOP_COUNT 8
+
+chunkwm_api API;
+
+internal const char *CVarNames[] =
+{
+    "plugin_dir", "plugin_hotload", "thread_count", "plugin_budget", "plugin_host",
+    "global_desktop_mode", "global_desktop_offset_top", "global_desktop_offset_bottom",
+    "global_desktop_offset_left", "global_desktop_offset_right", "global_desktop_offset_gap",
+    "desktop_padding_step_size", "desktop_gap_step_size", "focused_window", "bsp_insertion_point",
+    "active_desktop", "last_active_desktop", "bsp_spawn_left", "bsp_optimal_ratio",
+    "bsp_split_ratio", "bsp_split_mode", "monitor_focus_cycle", "window_focus_cycle",
+    "mouse_follows_focus", "mouse_move_window", "mouse_resize_window", "window_float_next",
+    "window_region_locked", "preselect_border_color", "preselect_border_width",
+    "preselect_border_radius", "window_float_topmost", "window_fade_inactive",
+    "window_fade_alpha", "window_fade_duration", "window_cgs_move",
+};
+
+// NOTE(koekeishiya): Read by 'CreateLeafNode', 'OptimalSplitMode' and 'WindowMovedHandler'.
+internal const char *FloatNames[] = { "bsp_split_ratio", "bsp_optimal_ratio", "global_desktop_offset_gap", "3_desktop_offset_top" };
+internal const char *IntegerNames[] = { "window_region_locked", "bsp_spawn_left", "window_float_next", "active_desktop" };
+internal const char *UnsignedNames[] = { "bsp_insertion_point", "preselect_border_color" };
+
+#define ARRAY_COUNT(Array) (sizeof(Array) / sizeof(*Array))
+
+/*
+ * NOTE(koekeishiya): The store before reads became lock-free, with values that are already
+ * parsed. Updates free the old string while holding the lock.
+ */
+struct legacy_cvar
+{
+    char *Value;
+    int Integer;
+    unsigned Unsigned;
+    float FloatingPoint;
+};
+
+internal std::map<const char *, legacy_cvar *, string_comparator> LegacyCVars;
+internal pthread_mutex_t LegacyCVarsLock;
+
+internal void
+LegacyUpdateCVar(const char *Name, char *Value)
+{
+    pthread_mutex_lock(&LegacyCVarsLock);
+    std::map<const char *, legacy_cvar *, string_comparator>::iterator It = LegacyCVars.find(Name);
+    legacy_cvar *Var;
+    if (It != LegacyCVars.end()) {
+        Var = It->second;
+        free(Var->Value);
+    } else {
+        Var = (legacy_cvar *) malloc(sizeof(legacy_cvar));
+        LegacyCVars[strdup(Name)] = Var;
+    }
+    Var->Value = strdup(Value);
+    Var->Integer = 0;
+    Var->Unsigned = 0;
+    Var->FloatingPoint = 0.0f;
+    sscanf(Value, "%d", &Var->Integer);
+    sscanf(Value, "%x", &Var->Unsigned);
+    sscanf(Value, "%f", &Var->FloatingPoint);
+    pthread_mutex_unlock(&LegacyCVarsLock);
+}
+
+internal legacy_cvar
+LegacyReadCVar(const char *Name)
+{
+    legacy_cvar Result = {};
+    pthread_mutex_lock(&LegacyCVarsLock);
+    std::map<const char *, legacy_cvar *, string_comparator>::iterator It = LegacyCVars.find(Name);
+    if (It != LegacyCVars.end()) Result = *It->second;
+    pthread_mutex_unlock(&LegacyCVarsLock);
+    return Result;
+}
+
+enum cvar_read_mode
+{
+    CVar_Read_String,
+    CVar_Read_Locked,
+    CVar_Read_Typed,
+    CVar_Read_Handle,
+    CVar_Read_Copy,
+};
+
+struct cvar_reader
+{
+    pthread_t Thread;
+    cvar_read_mode Mode;
+    uint32_t Reads;
+    bool Check;
+    uint32_t Invalid;
+    double Sum;
+};
+
+internal bool volatile WriterRunning;
+internal uint64_t volatile Writes;
+
+// NOTE(koekeishiya): The writer only writes whole numbers, so an acquired string must be one.
+internal bool
+IsNumberString(const char *String)
+{
+    if (!String) return false;
+
+    for (const char *Cursor = String; *Cursor; ++Cursor) {
+        if ((*Cursor < '0' || *Cursor > '9') && *Cursor != '.' && *Cursor != '-') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+internal bool
+CheckCVarString(const char *Name)
+{
+    uint64_t Read = BeginCVarReadAPI();
+    bool Result = IsNumberString(AcquireCVarAPI(Name));
+    EndCVarReadAPI(Read);
+    return Result;
+}
+
+internal bool
+LegacyCheckCVarString(const char *Name)
+{
+    pthread_mutex_lock(&LegacyCVarsLock);
+    std::map<const char *, legacy_cvar *, string_comparator>::iterator It = LegacyCVars.find(Name);
+    bool Result = (It != LegacyCVars.end()) && IsNumberString(It->second->Value);
+    pthread_mutex_unlock(&LegacyCVarsLock);
+    return Result;
+}
+
+internal void *
+ReaderThreadProc(void *Context)
+{
+    cvar_reader *Reader = (cvar_reader *) Context;
+    double Sum = 0;
+
+    cvar *FloatHandles[ARRAY_COUNT(FloatNames)];
+    cvar *IntegerHandles[ARRAY_COUNT(IntegerNames)];
+    cvar *UnsignedHandles[ARRAY_COUNT(UnsignedNames)];
+    for (size_t Index = 0; Index < ARRAY_COUNT(FloatNames); ++Index) {
+        FloatHandles[Index] = ResolveCVar(FloatNames[Index]);
+    }
+    for (size_t Index = 0; Index < ARRAY_COUNT(IntegerNames); ++Index) {
+        IntegerHandles[Index] = ResolveCVar(IntegerNames[Index]);
+    }
+    for (size_t Index = 0; Index < ARRAY_COUNT(UnsignedNames); ++Index) {
+        UnsignedHandles[Index] = ResolveCVar(UnsignedNames[Index]);
+    }
+
+    for (uint32_t Index = 0; Index < Reader->Reads; ++Index) {
+        const char *FloatName = FloatNames[Index % ARRAY_COUNT(FloatNames)];
+        const char *IntegerName = IntegerNames[Index % ARRAY_COUNT(IntegerNames)];
+        const char *UnsignedName = UnsignedNames[Index % ARRAY_COUNT(UnsignedNames)];
+
+        if (Reader->Mode == CVar_Read_String) {
+            float FloatValue = 0.0f;
+            int IntegerValue = 0;
+            unsigned UnsignedValue = 0;
+
+            char *String = AcquireCVarAPI(FloatName);
+            if (String) sscanf(String, "%f", &FloatValue);
+            String = AcquireCVarAPI(IntegerName);
+            if (String) sscanf(String, "%d", &IntegerValue);
+            String = AcquireCVarAPI(UnsignedName);
+            if (String) sscanf(String, "%x", &UnsignedValue);
+
+            Sum += FloatValue + IntegerValue + UnsignedValue;
+        } else if (Reader->Mode == CVar_Read_Locked) {
+            Sum += LegacyReadCVar(FloatName).FloatingPoint +
+                   LegacyReadCVar(IntegerName).Integer +
+                   LegacyReadCVar(UnsignedName).Unsigned;
+
+            if (Reader->Check && !LegacyCheckCVarString(FloatName)) {
+                ++Reader->Invalid;
+            }
+        } else if (Reader->Mode == CVar_Read_Copy) {
+            float FloatValue = 0.0f;
+            int IntegerValue = 0;
+            unsigned UnsignedValue = 0;
+            char String[CVAR_STRING_SIZE];
+
+            CVarStringValue(FloatName, String, sizeof(String));
+            Reader->Invalid += Reader->Check && !IsNumberString(String);
+            sscanf(String, "%f", &FloatValue);
+            CVarStringValue(IntegerName, String, sizeof(String));
+            Reader->Invalid += Reader->Check && !IsNumberString(String);
+            sscanf(String, "%d", &IntegerValue);
+            CVarStringValue(UnsignedName, String, sizeof(String));
+            Reader->Invalid += Reader->Check && !IsNumberString(String);
+            sscanf(String, "%x", &UnsignedValue);
+
+            Sum += FloatValue + IntegerValue + UnsignedValue;
+        } else if (Reader->Mode == CVar_Read_Handle) {
+            Sum += CVarFloatingPointValue(FloatHandles[Index % ARRAY_COUNT(FloatNames)]) +
+                   CVarIntegerValue(IntegerHandles[Index % ARRAY_COUNT(IntegerNames)]) +
+                   CVarUnsignedValue(UnsignedHandles[Index % ARRAY_COUNT(UnsignedNames)]);
+        } else {
+            Sum += CVarFloatingPointValue(FloatName) +
+                   CVarIntegerValue(IntegerName) +
+                   CVarUnsignedValue(UnsignedName);
+
+            if (Reader->Check && !CheckCVarString(FloatName)) {
+                ++Reader->Invalid;
+            }
+        }
+    }
+
+    Reader->Sum = Sum;
+    return NULL;
+}
+
+// NOTE(koekeishiya): Updates the cvars that readers use, with a counter so that every value is new.
+internal void *
+WriterThreadProc(void *Context)
+{
+    cvar_read_mode Mode = *(cvar_read_mode *) Context;
+    char Value[32];
+    uint64_t Count = 0;
+
+    while (__atomic_load_n(&WriterRunning, __ATOMIC_ACQUIRE)) {
+        const char *Name;
+        switch (Count % 3) {
+        case 0:  Name = FloatNames[Count % ARRAY_COUNT(FloatNames)];       break;
+        case 1:  Name = IntegerNames[Count % ARRAY_COUNT(IntegerNames)];   break;
+        default: Name = UnsignedNames[Count % ARRAY_COUNT(UnsignedNames)]; break;
+        }
+
+        snprintf(Value, sizeof(Value), "%llu", (unsigned long long) (Count % 1000));
+        if (Mode == CVar_Read_Locked) {
+            LegacyUpdateCVar(Name, Value);
+        } else {
+            UpdateCVarAPI(Name, Value);
+        }
+        ++Count;
+    }
+
+    __atomic_store_n(&Writes, Count, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+struct cvar_run
+{
+    double ReadsPerSecond;
+    double WritesPerSecond;
+    uint32_t Invalid;
+};
+
+internal cvar_run
+RunReaders(cvar_read_mode Mode, uint32_t Reads, uint32_t Threads, bool Writer)
+{
+    cvar_run Result = {};
+    cvar_reader *Readers = (cvar_reader *) calloc(Threads, sizeof(cvar_reader));
+
+    pthread_t WriterThread;
+    if (Writer) {
+        __atomic_store_n(&WriterRunning, true, __ATOMIC_RELEASE);
+        pthread_create(&WriterThread, NULL, &WriterThreadProc, &Mode);
+    }
+
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Threads; ++Index) {
+        Readers[Index].Mode = Mode;
+        Readers[Index].Reads = Reads;
+        Readers[Index].Check = Writer;
+        pthread_create(&Readers[Index].Thread, NULL, &ReaderThreadProc, Readers + Index);
+    }
+
+    for (uint32_t Index = 0; Index < Threads; ++Index) {
+        pthread_join(Readers[Index].Thread, NULL);
+        Result.Invalid += Readers[Index].Invalid;
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    if (Writer) {
+        __atomic_store_n(&WriterRunning, false, __ATOMIC_RELEASE);
+        pthread_join(WriterThread, NULL);
+        Result.WritesPerSecond = __atomic_load_n(&Writes, __ATOMIC_ACQUIRE) / (Elapsed / 1000000000.0);
+    }
+
+    free(Readers);
+
+    // NOTE(koekeishiya): Three cvars are read per iteration.
+    Result.ReadsPerSecond = 3.0 * Reads * Threads / (Elapsed / 1000000000.0);
+    return Result;
+}
+
+#define DESKTOP_KEY_COUNT 6
+internal const char *DesktopKeys[DESKTOP_KEY_COUNT] =
+{
+    "desktop_mode", "desktop_offset_top", "desktop_offset_bottom",
+    "desktop_offset_left", "desktop_offset_right", "desktop_offset_gap",
+};
+
+enum desktop_config_mode
+{
+    Desktop_Config_Map,
+    Desktop_Config_Hash,
+    Desktop_Config_Handle,
+    Desktop_Config_Table,
+};
+
+// NOTE(koekeishiya): Desktop 0 has no cvars of its own, and falls back to the global ones.
+internal double
+DesktopConfigNanoseconds(desktop_config_mode Mode, uint32_t Reads)
+{
+    cvar *Globals[DESKTOP_KEY_COUNT];
+    cvar *Handles[DESKTOP_COUNT + 1][DESKTOP_KEY_COUNT];
+    float Table[DESKTOP_COUNT + 1][DESKTOP_KEY_COUNT];
+    char Name[64];
+
+    for (int Key = 0; Key < DESKTOP_KEY_COUNT; ++Key) {
+        snprintf(Name, sizeof(Name), "global_%s", DesktopKeys[Key]);
+        Globals[Key] = ResolveCVar(Name);
+        for (int Desktop = 0; Desktop <= DESKTOP_COUNT; ++Desktop) {
+            snprintf(Name, sizeof(Name), "%d_%s", Desktop, DesktopKeys[Key]);
+            cvar *Handle = ResolveCVar(Name);
+            Handles[Desktop][Key] = Handle ? Handle : Globals[Key];
+            Table[Desktop][Key] = CVarFloatingPointValue(Handles[Desktop][Key]);
+        }
+    }
+
+    float Sum = 0.0f;
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Reads; ++Index) {
+        int Desktop = Index % (DESKTOP_COUNT + 1);
+        for (int Key = 0; Key < DESKTOP_KEY_COUNT; ++Key) {
+            if (Mode == Desktop_Config_Table) {
+                Sum += Table[Desktop][Key];
+                continue;
+            }
+
+            if (Mode == Desktop_Config_Handle) {
+                Sum += CVarFloatingPointValue(Handles[Desktop][Key]);
+                continue;
+            }
+
+            snprintf(Name, sizeof(Name), "%d_%s", Desktop, DesktopKeys[Key]);
+            if (Mode == Desktop_Config_Map) {
+                char Global[64];
+                snprintf(Global, sizeof(Global), "global_%s", DesktopKeys[Key]);
+                std::map<const char *, legacy_cvar *, string_comparator>::iterator It = LegacyCVars.find(Name);
+                Sum += It != LegacyCVars.end() ? LegacyReadCVar(Name).FloatingPoint
+                                               : LegacyReadCVar(Global).FloatingPoint;
+            } else {
+                cvar *Handle = ResolveCVar(Name);
+                Sum += CVarFloatingPointValue(Handle ? Handle : Globals[Key]);
+            }
+        }
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    if (Sum < 0) printf("%f\n", Sum);
+    return (double) Elapsed / Reads;
+}
+
+internal CVAR_ENUMERATE_FUNC(CopyLegacyCVar)
+{
+    LegacyUpdateCVar(Name, (char *) Value);
+}
+
+internal void
+CreateCVars()
+{
+    for (size_t Index = 0; Index < ARRAY_COUNT(CVarNames); ++Index) {
+        CreateCVar(CVarNames[Index], (int) Index);
+    }
+
+    char Name[64];
+    for (int Desktop = 1; Desktop <= DESKTOP_COUNT; ++Desktop) {
+        snprintf(Name, sizeof(Name), "%d_desktop_offset_top", Desktop);
+        CreateCVar(Name, 60.0f);
+        snprintf(Name, sizeof(Name), "%d_desktop_offset_bottom", Desktop);
+        CreateCVar(Name, 50.0f);
+        snprintf(Name, sizeof(Name), "%d_desktop_offset_left", Desktop);
+        CreateCVar(Name, 50.0f);
+        snprintf(Name, sizeof(Name), "%d_desktop_offset_right", Desktop);
+        CreateCVar(Name, 50.0f);
+        snprintf(Name, sizeof(Name), "%d_desktop_offset_gap", Desktop);
+        CreateCVar(Name, 20.0f);
+        snprintf(Name, sizeof(Name), "%d_desktop_mode", Desktop);
+        CreateCVar(Name, (char *) "bsp");
+    }
+
+    UpdateCVar("bsp_split_ratio", 0.5f);
+    UpdateCVar("bsp_optimal_ratio", 1.618f);
+    UpdateCVar("bsp_insertion_point", 0u);
+    UpdateCVar("preselect_border_color", 0xffd75f5fu);
+
+    // NOTE(koekeishiya): Every cvar is copied into the locked store.
+    EnumerateCVars(&CopyLegacyCVar, NULL);
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Reads = Count > 1 ? (uint32_t) atoi(Args[1]) : DEFAULT_READS;
+    uint32_t Threads = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_THREADS;
+    if (Reads == 0 || Threads == 0) {
+        fprintf(stderr, "usage: cvar [reads] [threads]\n");
+        return EXIT_FAILURE;
+    }
+
+    API.UpdateCVar = UpdateCVarAPI;
+    API.AcquireCVar = AcquireCVarAPI;
+    API.FindCVar = FindCVarAPI;
+    API.CVarInteger = CVarIntegerAPI;
+    API.CVarUnsigned = CVarUnsignedAPI;
+    API.CVarFloatingPoint = CVarFloatingPointAPI;
+    API.BeginCVarRead = BeginCVarReadAPI;
+    API.EndCVarRead = EndCVarReadAPI;
+    API.ResolveCVar = ResolveCVarAPI;
+    API.UpdateCVarHandle = UpdateCVarHandleAPI;
+    API.AcquireCVarHandle = AcquireCVarHandleAPI;
+    API.CVarHandleInteger = CVarHandleIntegerAPI;
+    API.CVarHandleUnsigned = CVarHandleUnsignedAPI;
+    API.CVarHandleFloatingPoint = CVarHandleFloatingPointAPI;
+
+    if (!BeginCVars() || pthread_mutex_init(&LegacyCVarsLock, NULL) != 0) {
+        fprintf(stderr, "cvar: could not initialize cvars!\n");
+        return EXIT_FAILURE;
+    }
+
+    CreateCVars();
+    printf("%u reads per thread\n", Reads);
+
+    for (uint32_t Active = 1; Active <= Threads; Active *= 2) {
+        cvar_run String = RunReaders(CVar_Read_String, Reads, Active, false);
+        cvar_run Locked = RunReaders(CVar_Read_Locked, Reads, Active, false);
+        cvar_run Typed = RunReaders(CVar_Read_Typed, Reads, Active, false);
+        cvar_run Handle = RunReaders(CVar_Read_Handle, Reads, Active, false);
+        printf("%2u threads          string %11.0f  locked %11.0f  typed %11.0f  handle %11.0f reads/s\n",
+               Active, String.ReadsPerSecond, Locked.ReadsPerSecond, Typed.ReadsPerSecond, Handle.ReadsPerSecond);
+    }
+
+    uint32_t Invalid = 0;
+    for (uint32_t Active = 1; Active <= Threads; Active *= 2) {
+        cvar_run Locked = RunReaders(CVar_Read_Locked, Reads, Active, true);
+        cvar_run Typed = RunReaders(CVar_Read_Typed, Reads, Active, true);
+        cvar_run Copy = RunReaders(CVar_Read_Copy, Reads, Active, true);
+        printf("%2u threads + writer  locked %11.0f reads/s %10.0f writes/s  typed %11.0f reads/s %10.0f writes/s"
+               "  copy %11.0f reads/s %10.0f writes/s\n",
+               Active, Locked.ReadsPerSecond, Locked.WritesPerSecond, Typed.ReadsPerSecond, Typed.WritesPerSecond,
+               Copy.ReadsPerSecond, Copy.WritesPerSecond);
+        Invalid += Typed.Invalid + Copy.Invalid;
+    }
+
+    printf("desktop config      map %8.0f ns  hash %8.0f ns  handle %8.0f ns  table %8.1f ns\n",
+           DesktopConfigNanoseconds(Desktop_Config_Map, Reads / 4),
+           DesktopConfigNanoseconds(Desktop_Config_Hash, Reads / 4),
+           DesktopConfigNanoseconds(Desktop_Config_Handle, Reads / 4),
+           DesktopConfigNanoseconds(Desktop_Config_Table, Reads / 4));
+
+    if (Invalid) {
+        fprintf(stderr, "cvar: %u acquired strings were not valid!\n", Invalid);
+        return EXIT_FAILURE;
+    }
+
+    EndCVars();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+/*
+ * NOTE(koekeishiya): Compares the two ways a plugin can find the handler for an event: the
+ * chain of string comparisons used by api version 6, and the switch over the export that
+ * the 'CHUNKWM_DISPATCH' macros of version 7 expand to. Both main functions handle the same
+ * events as the tiling plugin and are called through a function pointer, like the core does.
+ *
+ *   uniform    every export the tiling plugin handles, equally likely
+ *   moved      only 'chunkwm_export_window_moved', late in the chain and the most common event
+ *   broadcast  a plugin broadcast that is not handled, the chain compares against everything
+ *
+ *   make && ./bin/dispatch [events]
+ */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "../api/plugin_api.h"
+
+#define internal static
+
+#define BLOCK_SIZE 1000
+#define LEGACY_CALL ((void *) 1)
+#define SWITCH_CALL ((void *) (1ULL << 32))
+
+internal uint64_t volatile Handled[chunkwm_export_message_count];
+
+/*
+ * NOTE(koekeishiya): One handler per export, so that neither version can merge branches.
+ * Calls made by the legacy version are counted in the low half, the others in the high half.
+ */
+#define BENCH_HANDLER(Export)                                              \
+    internal __attribute__((noinline)) void Export##_handler(void *Data)  \
+    {                                                                      \
+        Handled[Export] += (uint64_t) Data;                                \
+    }
+
+BENCH_HANDLER(chunkwm_export_application_launched)
+BENCH_HANDLER(chunkwm_export_application_terminated)
+BENCH_HANDLER(chunkwm_export_application_hidden)
+BENCH_HANDLER(chunkwm_export_application_unhidden)
+BENCH_HANDLER(chunkwm_export_application_activated)
+BENCH_HANDLER(chunkwm_export_window_created)
+BENCH_HANDLER(chunkwm_export_window_destroyed)
+BENCH_HANDLER(chunkwm_export_window_minimized)
+BENCH_HANDLER(chunkwm_export_window_deminimized)
+BENCH_HANDLER(chunkwm_export_window_focused)
+BENCH_HANDLER(chunkwm_export_window_moved)
+BENCH_HANDLER(chunkwm_export_window_resized)
+BENCH_HANDLER(chunkwm_export_window_title_changed)
+BENCH_HANDLER(chunkwm_export_space_changed)
+BENCH_HANDLER(chunkwm_export_display_resized)
+BENCH_HANDLER(chunkwm_export_daemon_command)
+BENCH_HANDLER(chunkwm_export_events_subscribed)
+
+internal inline bool
+StringEquals(const char *A, const char *B)
+{
+    bool Result = (strcmp(A, B) == 0);
+    return Result;
+}
+
+// NOTE(koekeishiya): The order of the comparisons is the one used by the tiling plugin.
+internal bool
+LegacyPluginMain(const char *Node, void *Data)
+{
+    if (StringEquals(Node, "chunkwm_export_application_launched")) {
+        chunkwm_export_application_launched_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_application_terminated")) {
+        chunkwm_export_application_terminated_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_application_hidden")) {
+        chunkwm_export_application_hidden_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_application_unhidden")) {
+        chunkwm_export_application_unhidden_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_application_activated")) {
+        chunkwm_export_application_activated_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_created")) {
+        chunkwm_export_window_created_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_destroyed")) {
+        chunkwm_export_window_destroyed_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_minimized")) {
+        chunkwm_export_window_minimized_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_deminimized")) {
+        chunkwm_export_window_deminimized_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_focused")) {
+        chunkwm_export_window_focused_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_moved")) {
+        chunkwm_export_window_moved_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_resized")) {
+        chunkwm_export_window_resized_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_window_title_changed")) {
+        chunkwm_export_window_title_changed_handler(Data);
+        return true;
+    } else if ((StringEquals(Node, "chunkwm_export_space_changed")) ||
+               (StringEquals(Node, "chunkwm_export_display_changed"))) {
+        chunkwm_export_space_changed_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_export_display_resized")) {
+        chunkwm_export_display_resized_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_daemon_command")) {
+        chunkwm_export_daemon_command_handler(Data);
+        return true;
+    } else if (StringEquals(Node, "chunkwm_events_subscribed")) {
+        chunkwm_export_events_subscribed_handler(Data);
+        return true;
+    }
+
+    return false;
+}
+
+internal
+PLUGIN_MAIN_FUNC(PluginMain)
+{
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_application_launched, chunkwm_export_application_launched_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_terminated, chunkwm_export_application_terminated_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_hidden, chunkwm_export_application_hidden_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_unhidden, chunkwm_export_application_unhidden_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_activated, chunkwm_export_application_activated_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_created, chunkwm_export_window_created_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_destroyed, chunkwm_export_window_destroyed_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_minimized, chunkwm_export_window_minimized_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_deminimized, chunkwm_export_window_deminimized_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_focused, chunkwm_export_window_focused_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_moved, chunkwm_export_window_moved_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_resized, chunkwm_export_window_resized_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_title_changed, chunkwm_export_window_title_changed_handler(Data))
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_space_changed)
+    CHUNKWM_DISPATCH(chunkwm_export_display_changed, chunkwm_export_space_changed_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_display_resized, chunkwm_export_display_resized_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_daemon_command, chunkwm_export_daemon_command_handler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_events_subscribed, chunkwm_export_events_subscribed_handler(Data))
+    CHUNKWM_DISPATCH_END()
+
+    return false;
+}
+
+typedef bool legacy_main_func(const char *Node, void *Data);
+
+internal legacy_main_func *volatile LegacyRun = &LegacyPluginMain;
+internal plugin_main_func *volatile Run = &PluginMain;
+
+struct bench_event
+{
+    chunkwm_plugin_export Export;
+    const char *Node;
+};
+
+internal chunkwm_plugin_export TilingExports[] =
+{
+    chunkwm_export_application_launched,
+    chunkwm_export_application_terminated,
+    chunkwm_export_application_hidden,
+    chunkwm_export_application_unhidden,
+    chunkwm_export_application_activated,
+    chunkwm_export_window_created,
+    chunkwm_export_window_destroyed,
+    chunkwm_export_window_minimized,
+    chunkwm_export_window_deminimized,
+    chunkwm_export_window_focused,
+    chunkwm_export_window_moved,
+    chunkwm_export_window_resized,
+    chunkwm_export_window_title_changed,
+    chunkwm_export_space_changed,
+    chunkwm_export_display_changed,
+    chunkwm_export_display_resized,
+    chunkwm_export_daemon_command,
+};
+
+/*
+ * NOTE(koekeishiya): The nodes are copied, so that the legacy version can not get away with
+ * comparing pointers to the same string literal, which the core never passed it either.
+ */
+internal void
+MakeEvent(bench_event *Event, chunkwm_plugin_export Export, const char *Node)
+{
+    Event->Export = Export;
+    Event->Node = strdup(Node);
+}
+
+internal void
+RunEvents(const char *Name, bench_event *Events, uint32_t EventCount)
+{
+    bench_samples Legacy, Switch;
+    BenchBeginSamples(&Legacy, EventCount / BLOCK_SIZE);
+    BenchBeginSamples(&Switch, EventCount / BLOCK_SIZE);
+
+    // NOTE(koekeishiya): Alternate between the two blocks, so that both see the same machine state.
+    for (uint32_t Block = 0; Block + BLOCK_SIZE <= EventCount; Block += BLOCK_SIZE) {
+        uint64_t Begin = BenchNanoseconds();
+        for (uint32_t Index = Block; Index < Block + BLOCK_SIZE; ++Index) {
+            LegacyRun(Events[Index].Node, LEGACY_CALL);
+        }
+        BenchAddSample(&Legacy, BenchNanoseconds() - Begin);
+
+        Begin = BenchNanoseconds();
+        for (uint32_t Index = Block; Index < Block + BLOCK_SIZE; ++Index) {
+            Run(Events[Index].Export, 0, Events[Index].Node, SWITCH_CALL);
+        }
+        BenchAddSample(&Switch, BenchNanoseconds() - Begin);
+    }
+
+    printf("%-10s strcmp %8.2f ns/event  switch %8.2f ns/event\n", Name,
+           (double) BenchPercentile(&Legacy, 50.0) / BLOCK_SIZE,
+           (double) BenchPercentile(&Switch, 50.0) / BLOCK_SIZE);
+
+    BenchEndSamples(&Switch);
+    BenchEndSamples(&Legacy);
+}
+
+internal void
+FreeEvents(bench_event *Events, uint32_t EventCount)
+{
+    for (uint32_t Index = 0; Index < EventCount; ++Index) {
+        free((char *) Events[Index].Node);
+    }
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t EventCount = 1000000;
+    if (Count > 1) sscanf(Args[1], "%u", &EventCount);
+    if (EventCount < BLOCK_SIZE) EventCount = BLOCK_SIZE;
+
+    bench_event *Events = (bench_event *) malloc(EventCount * sizeof(bench_event));
+    printf("%u events, p50 of blocks of %u\n", EventCount, BLOCK_SIZE);
+
+    srand(1);
+    uint32_t ExportCount = sizeof(TilingExports) / sizeof(*TilingExports);
+    for (uint32_t Index = 0; Index < EventCount; ++Index) {
+        chunkwm_plugin_export Export = TilingExports[rand() % ExportCount];
+        MakeEvent(Events + Index, Export, chunkwm_plugin_export_str[Export]);
+    }
+    RunEvents("uniform", Events, EventCount);
+    FreeEvents(Events, EventCount);
+
+    for (uint32_t Index = 0; Index < EventCount; ++Index) {
+        MakeEvent(Events + Index, chunkwm_export_window_moved,
+                  chunkwm_plugin_export_str[chunkwm_export_window_moved]);
+    }
+    RunEvents("moved", Events, EventCount);
+    FreeEvents(Events, EventCount);
+
+    for (uint32_t Index = 0; Index < EventCount; ++Index) {
+        MakeEvent(Events + Index, chunkwm_export_plugin_broadcast, "Border_focused_window_changed");
+    }
+    RunEvents("broadcast", Events, EventCount);
+    FreeEvents(Events, EventCount);
+
+    // NOTE(koekeishiya): Both versions must have called the same handlers equally often.
+    for (int Index = 0; Index < chunkwm_export_message_count; ++Index) {
+        if ((Handled[Index] & 0xffffffff) != (Handled[Index] >> 32)) {
+            fprintf(stderr, "dispatch: '%s' was not handled by both versions!\n", chunkwm_plugin_export_str[Index]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    free(Events);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * NOTE(koekeishiya): Stress benchmark for the core event queue. A single consumer drains
+ * the queue while 1-16 producer threads push events as fast as they can. The lock-free
+ * ring is compared against the mutex-protected std::queue it replaced.
+ *
+ *   make && ./bin/event_ring [events-per-producer]
+ */
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <queue>
+
+#include "../core/dispatch/ring.cpp"
+
+#define internal static
+
+enum queue_kind
+{
+    Queue_Ring,
+    Queue_Mutex,
+};
+
+struct mutex_queue
+{
+    pthread_mutex_t Lock;
+    std::queue<chunk_event> Queue;
+};
+
+struct producer
+{
+    pthread_t Thread;
+    uint32_t Count;
+    bench_samples Samples;
+};
+
+internal queue_kind Kind;
+internal event_ring Ring;
+internal mutex_queue MutexQueue;
+internal uint32_t volatile StartFlag;
+
+internal inline bool
+PushEvent(chunk_event *Event)
+{
+    if (Kind == Queue_Ring) {
+        return EventRingPush(&Ring, Event);
+    }
+
+    pthread_mutex_lock(&MutexQueue.Lock);
+    MutexQueue.Queue.push(*Event);
+    pthread_mutex_unlock(&MutexQueue.Lock);
+    return true;
+}
+
+internal inline uint32_t
+PopEvents(chunk_event *Events, uint32_t Count)
+{
+    if (Kind == Queue_Ring) {
+        return EventRingPopBatch(&Ring, Events, Count);
+    }
+
+    uint32_t Result = 0;
+    pthread_mutex_lock(&MutexQueue.Lock);
+    while (Result < Count && !MutexQueue.Queue.empty()) {
+        Events[Result++] = MutexQueue.Queue.front();
+        MutexQueue.Queue.pop();
+    }
+    pthread_mutex_unlock(&MutexQueue.Lock);
+    return Result;
+}
+
+internal void *
+ProducerThreadProc(void *Data)
+{
+    producer *Producer = (producer *) Data;
+
+    while (!__atomic_load_n(&StartFlag, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    chunk_event Event = {};
+    Event.Name = "bench";
+
+    for (uint32_t Index = 0; Index < Producer->Count; ++Index) {
+        Event.Context = (void *)(uintptr_t)(Index + 1);
+
+        uint64_t Begin = BenchNanoseconds();
+        while (!PushEvent(&Event)) {
+            sched_yield();
+        }
+        uint64_t End = BenchNanoseconds();
+
+        BenchAddSample(&Producer->Samples, End - Begin);
+    }
+
+    return NULL;
+}
+
+internal void
+RunBenchmark(queue_kind QueueKind, int ProducerCount, uint32_t EventsPerProducer)
+{
+    Kind = QueueKind;
+    EventRingInit(&Ring);
+    StartFlag = 0;
+
+    producer Producers[ProducerCount];
+    for (int Index = 0; Index < ProducerCount; ++Index) {
+        Producers[Index].Count = EventsPerProducer;
+        BenchBeginSamples(&Producers[Index].Samples, EventsPerProducer);
+        pthread_create(&Producers[Index].Thread, NULL, &ProducerThreadProc, &Producers[Index]);
+    }
+
+    uint64_t Expected = (uint64_t) ProducerCount * EventsPerProducer;
+    uint64_t Received = 0;
+    chunk_event Events[EVENT_RING_BATCH];
+
+    uint64_t Begin = BenchNanoseconds();
+    __atomic_store_n(&StartFlag, 1, __ATOMIC_RELEASE);
+
+    while (Received < Expected) {
+        uint32_t Count = PopEvents(Events, EVENT_RING_BATCH);
+        if (Count) {
+            Received += Count;
+        } else {
+            sched_yield();
+        }
+    }
+
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, Expected);
+    for (int Index = 0; Index < ProducerCount; ++Index) {
+        pthread_join(Producers[Index].Thread, NULL);
+        BenchMergeSamples(&Samples, &Producers[Index].Samples);
+        BenchEndSamples(&Producers[Index].Samples);
+    }
+
+    char Label[64];
+    snprintf(Label, sizeof(Label), "%-5s %2d producers %7.2f Mev/s",
+             QueueKind == Queue_Ring ? "ring" : "mutex",
+             ProducerCount,
+             (double) Expected / ((double) Elapsed / 1e9) / 1e6);
+    BenchPrintLatency(Label, &Samples);
+    BenchEndSamples(&Samples);
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t EventsPerProducer = 200000;
+    if (Count > 1) {
+        sscanf(Args[1], "%u", &EventsPerProducer);
+    }
+
+    pthread_mutex_init(&MutexQueue.Lock, NULL);
+
+    int ProducerCounts[] = { 1, 2, 4, 8, 16 };
+    for (size_t Index = 0; Index < sizeof(ProducerCounts) / sizeof(*ProducerCounts); ++Index) {
+        RunBenchmark(Queue_Mutex, ProducerCounts[Index], EventsPerProducer);
+        RunBenchmark(Queue_Ring, ProducerCounts[Index], EventsPerProducer);
+    }
+
+    pthread_mutex_destroy(&MutexQueue.Lock);
+    return EXIT_SUCCESS;
+}
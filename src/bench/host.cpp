@@ -0,0 +1,292 @@
+/*
+ * NOTE(koekeishiya): Compares the dispatch latency of a plugin that is loaded in-process
+ * against the same plugin in a plugin host, see core/host.h. Both are posted to through a
+ * mailbox on the thread pool, the same as in the core:
+ *
+ *   in-process   the pool thread calls the plugin
+ *   hosted       the pool thread serializes the event into the shared ring, and the host
+ *                process wakes up and calls the plugin
+ *
+ * Latency is measured by the plugin, from the time the event was posted until it is called.
+ * A paced run posts one window moved event every 'interval' microseconds; a burst run posts
+ * them as fast as possible, which fills the ring of the host and shows the events it drops
+ * instead of blocking the core. Post cost is the time spent in 'PostPluginMailbox'.
+ *
+ *   make && ./bin/host [events] [interval]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+#include "host_bench.h"
+
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+#include "../core/mailbox.cpp"
+#include "../core/method.cpp"
+#include "../core/trace.cpp"
+#include "../core/shmring.cpp"
+#include "../core/host.cpp"
+#include "../common/ipc/daemon.cpp"
+#include "../replay/stub/element.cpp"
+
+#define internal static
+
+#define DEFAULT_EVENTS 20000
+#define DEFAULT_INTERVAL_US 50
+#define HOST_PATH "./bin/chunkwm-host"
+#define PLUGIN_PATH "./bin/host_plugin.so"
+#define REPORT_TIMEOUT_MS 200
+#define REPORT_ATTEMPTS 50
+
+internal thread_pool Pool;
+internal macos_application Application;
+internal macos_window *Windows;
+
+internal pthread_mutex_t ReportLock;
+internal pthread_cond_t ReportCondition;
+internal host_bench_report Report;
+internal bool Reported;
+
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data)
+{
+    return Plugin->Run(Export, Topic, Node, Data);
+}
+
+// NOTE(koekeishiya): The only topic is the report of the plugin.
+CHUNKWM_API_INTERN_TOPIC_FUNC(InternTopic)
+{
+    return 1;
+}
+
+CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(SubscribeTopic)
+{
+    return 0;
+}
+
+CHUNKWM_API_BROADCAST_TOPIC_FUNC(ChunkwmBroadcastTopic)
+{
+    if (Size != sizeof(host_bench_report)) return;
+
+    pthread_mutex_lock(&ReportLock);
+    memcpy(&Report, Data, Size);
+    Reported = true;
+    pthread_cond_signal(&ReportCondition);
+    pthread_mutex_unlock(&ReportLock);
+}
+
+void UpdateCVarAPI(const char *Name, char *Value)
+{
+}
+
+void EnumerateCVars(cvar_enumerate_func *Callback, void *Context)
+{
+}
+
+internal
+CHUNKWM_API_ACQUIRE_CVAR_FUNC(BenchAcquireCVar)
+{
+    return NULL;
+}
+
+internal
+CHUNKWM_API_FIND_CVAR_FUNC(BenchFindCVar)
+{
+    return false;
+}
+
+internal chunkwm_api API =
+{
+    UpdateCVarAPI,
+    BenchAcquireCVar,
+    BenchFindCVar,
+    NULL,
+    (chunkwm_log *) c_log,
+    InternTopic,
+    ChunkwmBroadcastTopic,
+    SubscribeTopic,
+    RegisterPluginMethod,
+    CallPluginMethod
+};
+
+internal bool
+WaitForReport(host_bench_report *Result)
+{
+    struct timespec Deadline;
+    PluginHostDeadline(&Deadline, REPORT_TIMEOUT_MS);
+
+    pthread_mutex_lock(&ReportLock);
+    while (!Reported) {
+        if (pthread_cond_timedwait(&ReportCondition, &ReportLock, &Deadline) == ETIMEDOUT) break;
+    }
+    bool Success = Reported;
+    *Result = Report;
+    Reported = false;
+    pthread_mutex_unlock(&ReportLock);
+
+    return Success;
+}
+
+internal void
+Post(plugin_mailbox *Mailbox, chunkwm_plugin_export Export, macos_window *Window)
+{
+    plugin_payload *Payload = CreatePluginPayload(Window, NULL, NULL);
+    PostPluginMailbox(Mailbox, Export, 0, chunkwm_plugin_export_str[Export], Payload);
+    ReleasePluginPayload(Payload);
+}
+
+// NOTE(koekeishiya): Every event has its own window, the in-process plugin reads it after it is posted.
+internal bool
+RunEvents(const char *Label, plugin_mailbox *Mailbox, uint32_t Events, uint32_t IntervalUs)
+{
+    bench_samples PostCost;
+    BenchBeginSamples(&PostCost, Events);
+
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Events; ++Index) {
+        uint64_t Due = Begin + (uint64_t) Index * IntervalUs * 1000;
+        while (IntervalUs && BenchNanoseconds() < Due);
+
+        macos_window *Window = Windows + Index;
+        uint64_t Posted = BenchNanoseconds();
+        Window->Position.x = (double) Posted;
+        Post(Mailbox, chunkwm_export_window_moved, Window);
+        BenchAddSample(&PostCost, BenchNanoseconds() - Posted);
+    }
+
+    /*
+     * NOTE(koekeishiya): The event that ends the run is dropped as well if the ring of the host
+     * is still full, so it is posted again until the plugin reports.
+     */
+    DrainPluginMailbox(Mailbox);
+
+    host_bench_report Result;
+    bool Done = false;
+    for (int Attempt = 0; !Done && Attempt < REPORT_ATTEMPTS; ++Attempt) {
+        Post(Mailbox, chunkwm_export_window_destroyed, Windows);
+        Done = WaitForReport(&Result);
+    }
+
+    if (!Done) {
+        fprintf(stderr, "host: %s: the plugin did not report!\n", Label);
+        BenchEndSamples(&PostCost);
+        return false;
+    }
+
+    printf("%-22s p50 %8llu ns  p99 %8llu ns  max %9llu ns  post p50 %5llu ns  received %llu/%u\n",
+           Label,
+           (unsigned long long) Result.P50,
+           (unsigned long long) Result.P99,
+           (unsigned long long) Result.Max,
+           (unsigned long long) BenchPercentile(&PostCost, 50.0),
+           (unsigned long long) Result.Count,
+           Events);
+
+    BenchEndSamples(&PostCost);
+    return true;
+}
+
+internal bool
+RunInProcess(uint32_t Events, uint32_t IntervalUs)
+{
+    void *Handle = dlopen(PLUGIN_PATH, RTLD_NOW);
+    if (!Handle) {
+        fprintf(stderr, "host: dlopen '%s' failed: %s\n", PLUGIN_PATH, dlerror());
+        return false;
+    }
+
+    plugin_details *Info = (plugin_details *) dlsym(Handle, "Exports");
+    plugin *Plugin = Info->Initialize();
+    if (!Plugin->Init(API)) {
+        fprintf(stderr, "host: plugin init failed!\n");
+        return false;
+    }
+
+    plugin_mailbox *Mailbox = CreatePluginMailbox(Plugin, Info->PluginName, false);
+    bool Result = RunEvents("in-process paced", Mailbox, Events, IntervalUs) &&
+                  RunEvents("in-process burst", Mailbox, Events, 0);
+
+    DrainPluginMailbox(Mailbox);
+    DestroyPluginMailbox(Mailbox);
+    Plugin->DeInit();
+    dlclose(Handle);
+    return Result;
+}
+
+internal bool
+RunHosted(uint32_t Events, uint32_t IntervalUs)
+{
+    plugin_host *Host = StartPluginHost(HOST_PATH, PLUGIN_PATH);
+    if (!Host) {
+        fprintf(stderr, "host: could not start '%s', run make first!\n", HOST_PATH);
+        return false;
+    }
+
+    if (!InitPluginHost(Host)) {
+        fprintf(stderr, "host: hosted plugin init failed!\n");
+        StopPluginHost(Host);
+        return false;
+    }
+
+    plugin Plugin = {};
+    plugin_mailbox *Mailbox = CreatePluginMailbox(&Plugin, Host->Info.PluginName, false);
+    Mailbox->Deliver = &DeliverPluginHostMessage;
+    Mailbox->DeliverContext = Host;
+
+    bool Result = RunEvents("hosted paced", Mailbox, Events, IntervalUs);
+    plugin_host_stats Before = PluginHostStats(Host);
+    Result &= RunEvents("hosted burst", Mailbox, Events, 0);
+    plugin_host_stats After = PluginHostStats(Host);
+
+    printf("%-22s posted %llu  dropped %llu\n", "hosted burst ring",
+           (unsigned long long) (After.Posted - Before.Posted),
+           (unsigned long long) (After.Dropped - Before.Dropped));
+
+    DrainPluginMailbox(Mailbox);
+    DestroyPluginMailbox(Mailbox);
+    StopPluginHost(Host);
+    return Result;
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Events = Count > 1 ? (uint32_t) atoi(Args[1]) : DEFAULT_EVENTS;
+    uint32_t IntervalUs = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_INTERVAL_US;
+    if (Events == 0 || Events > HOST_BENCH_MAX_EVENTS) {
+        fprintf(stderr, "host: events must be between 1 and %d\n", HOST_BENCH_MAX_EVENTS);
+        return EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+    pthread_mutex_init(&ReportLock, NULL);
+    pthread_cond_init(&ReportCondition, NULL);
+
+    if (!BeginThreadPool(&Pool, 2) || !BeginPluginMailboxes(&Pool)) {
+        fprintf(stderr, "host: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    Application.Name = (char *) "bench";
+    Application.PID = getpid();
+    Windows = (macos_window *) calloc(Events, sizeof(macos_window));
+    for (uint32_t Index = 0; Index < Events; ++Index) {
+        Windows[Index].Owner = &Application;
+        Windows[Index].Id = Index + 1;
+    }
+
+    printf("%u events, paced every %uus\n", Events, IntervalUs);
+
+    bool Result = RunInProcess(Events, IntervalUs) && RunHosted(Events, IntervalUs);
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,19 @@
+#ifndef CHUNKWM_BENCH_HOST_H
+#define CHUNKWM_BENCH_HOST_H
+
+#include <stdint.h>
+
+// NOTE(koekeishiya): Shared by the 'host' benchmark and the plugin it loads, see host.cpp.
+#define HOST_BENCH_PLUGIN "bench"
+#define HOST_BENCH_EVENT "report"
+#define HOST_BENCH_MAX_EVENTS 1000000
+
+struct host_bench_report
+{
+    uint64_t Count;
+    uint64_t P50;
+    uint64_t P99;
+    uint64_t Max;
+};
+
+#endif
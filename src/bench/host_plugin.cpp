@@ -0,0 +1,75 @@
+/*
+ * NOTE(koekeishiya): The plugin that is loaded by the 'host' benchmark, in-process and in a
+ * plugin host. The time a window moved event was posted is passed in the x position of the
+ * window. A window destroyed event ends a run: the plugin broadcasts what it measured and
+ * starts over.
+ */
+
+#include "bench.h"
+
+#include "../api/plugin_api.h"
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+
+#include "host_bench.h"
+
+#define internal static
+
+internal const char *PluginName = "bench";
+internal const char *PluginVersion = "0.1.0";
+internal chunkwm_api API;
+internal uint32_t ReportTopic;
+internal bench_samples Samples;
+
+internal void
+WindowMovedHandler(void *Data)
+{
+    macos_window *Window = (macos_window *) Data;
+    uint64_t Posted = (uint64_t) Window->Position.x;
+    BenchAddSample(&Samples, BenchNanoseconds() - Posted);
+}
+
+internal void
+WindowDestroyedHandler()
+{
+    host_bench_report Report;
+    Report.Count = Samples.Count;
+    Report.P50 = BenchPercentile(&Samples, 50.0);
+    Report.P99 = BenchPercentile(&Samples, 99.0);
+    Report.Max = BenchPercentile(&Samples, 100.0);
+    API.BroadcastTopic(ReportTopic, &Report, sizeof(Report));
+    Samples.Count = 0;
+}
+
+PLUGIN_MAIN_FUNC(PluginMain)
+{
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_window_moved, WindowMovedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_destroyed, WindowDestroyedHandler())
+    CHUNKWM_DISPATCH_END()
+    return false;
+}
+
+PLUGIN_BOOL_FUNC(PluginInit)
+{
+    API = ChunkwmAPI;
+    ReportTopic = API.InternTopic(HOST_BENCH_PLUGIN, HOST_BENCH_EVENT);
+    BenchBeginSamples(&Samples, HOST_BENCH_MAX_EVENTS);
+    return true;
+}
+
+PLUGIN_VOID_FUNC(PluginDeInit)
+{
+    BenchEndSamples(&Samples);
+}
+
+CHUNKWM_PLUGIN_VTABLE(PluginInit, PluginDeInit, PluginMain)
+
+chunkwm_plugin_export Subscriptions[] =
+{
+    chunkwm_export_window_moved,
+    chunkwm_export_window_destroyed,
+};
+CHUNKWM_PLUGIN_SUBSCRIBE(Subscriptions)
+
+CHUNKWM_PLUGIN(PluginName, PluginVersion);
@@ -0,0 +1,211 @@
+/*
+ * NOTE(koekeishiya): Stress test for the plugin mailboxes. The main thread stands in for the
+ * event-loop: it keeps one window up to date, and after every change posts a window moved
+ * event to every plugin, with a copy of the window as 'PostPluginWindow' in callback.cpp does.
+ * Every eighth event is also posted as a fence without a node, and every thirty-second event
+ * carries data with a destructor, like a window destroyed event. One plugin takes its events
+ * in batches, and its mailbox is flushed at the end of every round of 'round' events.
+ *
+ * Each plugin checks that it never runs concurrently with itself, that it sees its events in
+ * the order they were posted, and that the window it is given is not changed while it reads
+ * it. Fails if a check fails, if an event was not delivered, or if data was not destroyed.
+ * Build with 'make tsan' to run it under ThreadSanitizer.
+ *
+ *   make && ./bin/mailbox [threads] [events] [round]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+#include "../core/mailbox.cpp"
+
+#define internal static
+
+#define PLUGIN_COUNT 8
+#define BATCH_PLUGIN 0
+#define DEFAULT_EVENTS 200000
+#define DEFAULT_ROUND 16
+#define FENCE_INTERVAL 8
+#define DESTROY_INTERVAL 32
+
+// NOTE(koekeishiya): Stands in for the fields of a macos_window that the event-loop updates.
+struct bench_window
+{
+    uint32_t Id;
+    uint32_t Sequence;
+    double X, Y;
+    double Width, Height;
+};
+
+struct bench_plugin
+{
+    int volatile Running;
+    uint32_t LastSequence;
+    uint64_t Received;
+    uint64_t Overlapped;
+    uint64_t Reordered;
+    uint64_t Torn;
+};
+
+internal plugin Plugins[PLUGIN_COUNT];
+internal plugin_mailbox *Mailboxes[PLUGIN_COUNT];
+internal bench_plugin States[PLUGIN_COUNT];
+internal thread_pool Pool;
+
+internal uint64_t volatile Created;
+internal uint64_t volatile Destroyed;
+
+internal void
+CheckWindow(bench_plugin *State, bench_window *Window)
+{
+    if (Window->Sequence <= State->LastSequence) {
+        ++State->Reordered;
+    }
+    State->LastSequence = Window->Sequence;
+
+    double Value = (double) Window->Sequence;
+    if ((Window->X != Value) || (Window->Y != Value) ||
+        (Window->Width != Value) || (Window->Height != Value)) {
+        ++State->Torn;
+    }
+
+    ++State->Received;
+}
+
+internal void
+RunPluginChecked(int Index, chunkwm_event *Events, uint32_t Count)
+{
+    bench_plugin *State = States + Index;
+    if (!__sync_bool_compare_and_swap(&State->Running, 0, 1)) {
+        __atomic_add_fetch(&State->Overlapped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    for (uint32_t Event = 0; Event < Count; ++Event) {
+        CheckWindow(State, (bench_window *) Events[Event].Data);
+    }
+
+    __atomic_store_n(&State->Running, 0, __ATOMIC_RELEASE);
+}
+
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data)
+{
+    chunkwm_event Event = { Export, Topic, Node, Data };
+    RunPluginChecked(Plugin - Plugins, &Event, 1);
+    return true;
+}
+
+internal
+PLUGIN_BATCH_FUNC(RunBatchPlugin)
+{
+    RunPluginChecked(BATCH_PLUGIN, Events, Count);
+}
+
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(DestroyWindowCopy)
+{
+    free(Data);
+    __atomic_add_fetch(&Destroyed, 1, __ATOMIC_RELAXED);
+}
+
+internal plugin_payload *
+CreateWindowPayload(bench_window *Window, bool Destroy)
+{
+    if (Destroy) {
+        bench_window *Copy = (bench_window *) malloc(sizeof(bench_window));
+        memcpy(Copy, Window, sizeof(bench_window));
+        ++Created;
+        return CreatePluginPayload(Copy, &DestroyWindowCopy, NULL);
+    }
+
+    return CreatePluginPayloadCopy(Window, sizeof(bench_window), NULL);
+}
+
+int main(int Count, char **Args)
+{
+    int ThreadCount = Count > 1 ? atoi(Args[1]) : ThreadPoolDefaultThreadCount();
+    uint32_t Events = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_EVENTS;
+    uint32_t Round = Count > 3 ? (uint32_t) atoi(Args[3]) : DEFAULT_ROUND;
+    if (ThreadCount <= 0 || Events == 0 || Round == 0) {
+        fprintf(stderr, "usage: mailbox [threads] [events] [round]\n");
+        return EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+    if (!BeginThreadPool(&Pool, ThreadCount) || !BeginPluginMailboxes(&Pool)) {
+        fprintf(stderr, "mailbox: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    Plugins[BATCH_PLUGIN].RunBatch = &RunBatchPlugin;
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        Mailboxes[Index] = CreatePluginMailbox(Plugins + Index, "plugin", false);
+    }
+
+    printf("%d plugins, %d threads, %u events, round %u\n", PLUGIN_COUNT, ThreadCount, Events, Round);
+
+    bench_window Window = {};
+    Window.Id = 1;
+
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 1; Index <= Events; ++Index) {
+        Window.Sequence = Index;
+        Window.X = Window.Y = (double) Index;
+        Window.Width = Window.Height = (double) Index;
+
+        bool Destroy = (Index % DESTROY_INTERVAL) == 0;
+        plugin_payload *Payload = CreateWindowPayload(&Window, Destroy);
+        for (int Plugin = 0; Plugin < PLUGIN_COUNT; ++Plugin) {
+            PostPluginMailbox(Mailboxes[Plugin], chunkwm_export_window_moved, 0, "chunkwm_export_window_moved", Payload);
+            if ((Index % FENCE_INTERVAL) == 0) {
+                PostPluginMailbox(Mailboxes[Plugin], chunkwm_export_window_moved, 0, NULL, Payload);
+            }
+        }
+        ReleasePluginPayload(Payload);
+
+        if ((Index % Round) == 0) {
+            FlushPluginMailboxes();
+        }
+    }
+
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        DrainPluginMailbox(Mailboxes[Index]);
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    bool Result = Destroyed == Created;
+    for (int Index = 0; Index < PLUGIN_COUNT; ++Index) {
+        bench_plugin *State = States + Index;
+        bool Passed = ((State->Received == Events) &&
+                       (State->Overlapped == 0) &&
+                       (State->Reordered == 0) &&
+                       (State->Torn == 0));
+        printf("plugin %d %-6s received %8llu  overlapped %llu  reordered %llu  torn %llu  %s\n",
+               Index, Index == BATCH_PLUGIN ? "batch" : "",
+               (unsigned long long) State->Received,
+               (unsigned long long) State->Overlapped,
+               (unsigned long long) State->Reordered,
+               (unsigned long long) State->Torn,
+               Passed ? "ok" : "FAILED");
+        Result &= Passed;
+        DestroyPluginMailbox(Mailboxes[Index]);
+    }
+
+    printf("%.1f ns/event  destroyed %llu of %llu  %s\n",
+           (double) Elapsed / Events,
+           (unsigned long long) Destroyed,
+           (unsigned long long) Created,
+           Result ? "ok" : "FAILED");
+
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
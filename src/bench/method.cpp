@@ -0,0 +1,255 @@
+/*
+ * NOTE(koekeishiya): Compares the ways a plugin can ask the tiling plugin for the layout of
+ * the active desktop. The layout has a handful of windows, like a typical desktop.
+ *
+ *   daemon   the plugin connects to the daemon of chunkwm, sends a query and parses the text
+ *            that is written back, as plugins had to before methods existed
+ *   method   the plugin calls a method that the tiling plugin registered, which copies the
+ *            layout into a buffer of the caller, see core/method.h
+ *
+ * The daemon is served by the same code as the daemon of chunkwm, on another port. Prints
+ * the latency of a single request, and calls per second from several threads for methods.
+ *
+ *   make && ./bin/method [requests] [threads]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+#include "../plugins/tiling/methods.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/epoch.cpp"
+#include "../core/method.cpp"
+#include "../common/ipc/daemon.cpp"
+
+#define internal static
+
+#define DEFAULT_REQUESTS 10000
+#define DEFAULT_THREADS 4
+#define DAEMON_PORT 39201
+#define LAYOUT_WINDOWS 6
+#define LAYOUT_BUFFER_SIZE (sizeof(tiling_desktop_layout) + 64 * sizeof(tiling_layout_node))
+
+internal tiling_layout_node Layout[LAYOUT_WINDOWS];
+internal pthread_mutex_t LayoutLock;
+
+// NOTE(koekeishiya): Stands in for the tiling plugin, which locks the virtual space while it copies the tree.
+internal
+CHUNKWM_API_METHOD_FUNC(DesktopLayoutMethod)
+{
+    size_t Size = sizeof(tiling_desktop_layout) + LAYOUT_WINDOWS * sizeof(tiling_layout_node);
+    if (*ResponseSize < Size) {
+        *ResponseSize = Size;
+        return chunkwm_call_too_small;
+    }
+
+    tiling_desktop_layout *Result = (tiling_desktop_layout *) Response;
+    Result->DesktopId = 1;
+    Result->Mode = Tiling_Layout_Bsp;
+    Result->Count = LAYOUT_WINDOWS;
+
+    pthread_mutex_lock(&LayoutLock);
+    memcpy(Result + 1, Layout, sizeof(Layout));
+    pthread_mutex_unlock(&LayoutLock);
+
+    *ResponseSize = Size;
+    return chunkwm_call_ok;
+}
+
+internal
+DAEMON_CALLBACK(DaemonCallback)
+{
+    char Reply[512];
+    size_t Length = snprintf(Reply, sizeof(Reply), "%d %d\n", 1, LAYOUT_WINDOWS);
+
+    pthread_mutex_lock(&LayoutLock);
+    for (int Index = 0; Index < LAYOUT_WINDOWS; ++Index) {
+        tiling_layout_node *Node = Layout + Index;
+        Length += snprintf(Reply + Length, sizeof(Reply) - Length, "%d %.0f %.0f %.0f %.0f\n",
+                           Node->WindowId, Node->X, Node->Y, Node->Width, Node->Height);
+    }
+    pthread_mutex_unlock(&LayoutLock);
+
+    WriteToSocket(Reply, SockFD);
+    CloseSocket(SockFD);
+}
+
+// NOTE(koekeishiya): 'ReadFromSocket' returns at most 255 bytes at a time.
+internal bool
+RequestDaemonLayout(uint32_t *Count)
+{
+    int SockFD;
+    if (!ConnectToDaemon(&SockFD, DAEMON_PORT)) {
+        CloseSocket(SockFD);
+        return false;
+    }
+
+    WriteToSocket("tiling::query --desktop layout", SockFD);
+
+    char Buffer[1024];
+    size_t Length = 0;
+    char *Part;
+    while ((Part = ReadFromSocket(SockFD))) {
+        size_t PartLength = strlen(Part);
+        if (Length + PartLength < sizeof(Buffer)) {
+            memcpy(Buffer + Length, Part, PartLength);
+            Length += PartLength;
+        }
+        free(Part);
+    }
+    Buffer[Length] = '\0';
+    CloseSocket(SockFD);
+
+    unsigned DesktopId, Windows;
+    char *Cursor = Buffer;
+    if (sscanf(Cursor, "%u %u", &DesktopId, &Windows) != 2) return false;
+
+    tiling_layout_node Nodes[LAYOUT_WINDOWS];
+    for (uint32_t Index = 0; Index < Windows && Index < LAYOUT_WINDOWS; ++Index) {
+        Cursor = strchr(Cursor, '\n');
+        if (!Cursor) return false;
+        ++Cursor;
+
+        tiling_layout_node *Node = Nodes + Index;
+        if (sscanf(Cursor, "%u %f %f %f %f", &Node->WindowId, &Node->X, &Node->Y, &Node->Width, &Node->Height) != 5) {
+            return false;
+        }
+    }
+
+    *Count = Windows;
+    return true;
+}
+
+internal bool
+RequestMethodLayout(uint32_t *Count)
+{
+    char Buffer[LAYOUT_BUFFER_SIZE];
+    size_t Size = sizeof(Buffer);
+    chunkwm_call_result Result = CallPluginMethod(TILING_PLUGIN_NAME, TILING_METHOD_DESKTOP_LAYOUT, NULL, 0, Buffer, &Size);
+    if (Result != chunkwm_call_ok) return false;
+
+    *Count = ((tiling_desktop_layout *) Buffer)->Count;
+    return true;
+}
+
+typedef bool request_layout_func(uint32_t *Count);
+
+internal bool
+RunLatency(const char *Label, request_layout_func *Request, uint32_t Requests)
+{
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, Requests);
+
+    for (uint32_t Index = 0; Index < Requests; ++Index) {
+        uint32_t Count = 0;
+        uint64_t Begin = BenchNanoseconds();
+        bool Success = Request(&Count);
+        BenchAddSample(&Samples, BenchNanoseconds() - Begin);
+
+        if (!Success || Count != LAYOUT_WINDOWS) {
+            fprintf(stderr, "method: %s request %u failed!\n", Label, Index);
+            BenchEndSamples(&Samples);
+            return false;
+        }
+    }
+
+    BenchPrintLatency(Label, &Samples);
+    BenchEndSamples(&Samples);
+    return true;
+}
+
+struct method_thread
+{
+    pthread_t Thread;
+    uint32_t Requests;
+    uint32_t Failed;
+};
+
+internal void *
+MethodThreadProc(void *Context)
+{
+    method_thread *Thread = (method_thread *) Context;
+    for (uint32_t Index = 0; Index < Thread->Requests; ++Index) {
+        uint32_t Count;
+        if (!RequestMethodLayout(&Count)) ++Thread->Failed;
+    }
+    return NULL;
+}
+
+internal bool
+RunThroughput(uint32_t Requests, uint32_t Threads)
+{
+    method_thread *Workers = (method_thread *) calloc(Threads, sizeof(method_thread));
+
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Threads; ++Index) {
+        Workers[Index].Requests = Requests;
+        pthread_create(&Workers[Index].Thread, NULL, &MethodThreadProc, Workers + Index);
+    }
+
+    uint32_t Failed = 0;
+    for (uint32_t Index = 0; Index < Threads; ++Index) {
+        pthread_join(Workers[Index].Thread, NULL);
+        Failed += Workers[Index].Failed;
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+    free(Workers);
+
+    printf("%-28s %u threads  %.0f calls/s\n", "method", Threads,
+           (double) Requests * Threads / (Elapsed / 1000000000.0));
+
+    if (Failed) {
+        fprintf(stderr, "method: %u calls failed!\n", Failed);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Requests = Count > 1 ? (uint32_t) atoi(Args[1]) : DEFAULT_REQUESTS;
+    uint32_t Threads = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_THREADS;
+    if (Requests == 0 || Threads == 0) {
+        fprintf(stderr, "usage: method [requests] [threads]\n");
+        return EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+    pthread_mutex_init(&LayoutLock, NULL);
+
+    for (int Index = 0; Index < LAYOUT_WINDOWS; ++Index) {
+        Layout[Index].WindowId = 100 + Index;
+        Layout[Index].X = 20.0f + 460.0f * (Index % 3);
+        Layout[Index].Y = 60.0f + 420.0f * (Index / 3);
+        Layout[Index].Width = 440.0f;
+        Layout[Index].Height = 400.0f;
+    }
+
+    if (!BeginPluginMethods() ||
+        !RegisterPluginMethod(TILING_PLUGIN_NAME, TILING_METHOD_DESKTOP_LAYOUT, DesktopLayoutMethod)) {
+        fprintf(stderr, "method: could not register method!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!StartDaemon(DAEMON_PORT, DaemonCallback)) {
+        fprintf(stderr, "method: could not start daemon on port %d!\n", DAEMON_PORT);
+        return EXIT_FAILURE;
+    }
+
+    printf("%u requests, %d windows\n", Requests, LAYOUT_WINDOWS);
+
+    bool Result = RunLatency("daemon", RequestDaemonLayout, Requests) &&
+                  RunLatency("method", RequestMethodLayout, Requests) &&
+                  RunThroughput(Requests, Threads);
+
+    StopDaemon();
+    RemovePluginMethods(TILING_PLUGIN_NAME);
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,264 @@
+/*
+ * NOTE(koekeishiya): Compares the fixed-size work-queue that used to run plugin callbacks
+ * against the work-stealing thread pool that replaced it. A batch is a number of tasks that
+ * are submitted together and waited on, like a plugin export sent to every loaded plugin.
+ *
+ *   tiny       batches of 8 tasks that do almost nothing, the cost is all in the queue
+ *   heavy      batches of 8 tasks that spin for 200us, e.g. a plugin that moves windows
+ *   overflow   a single batch of 10000 tiny tasks, the old queue only had room for 255
+ *   blocked    batches where one task sleeps for 20ms, like a plugin stuck on an unresponsive
+ *              application; prints the processor time used by the waiting thread and the process
+ *
+ *   make && ./bin/pool [threads] [batches]
+ */
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+
+#define internal static
+
+#define BATCH_SIZE 8
+#define HEAVY_TASK_NS 200000
+#define OVERFLOW_TASK_COUNT 10000
+#define BLOCKED_TASK_US 20000
+#define BLOCKED_BATCHES 25
+
+/*
+ * NOTE(koekeishiya): The old work-queue, kept here so that the two can be compared.
+ * A single submitter, a ring of 256 entries and a waiter that spins until all are done.
+ */
+struct legacy_queue_entry
+{
+    thread_pool_callback *Callback;
+    void *Data;
+};
+
+struct legacy_queue
+{
+    uint32_t volatile EntriesCompleted;
+    uint32_t volatile EntryCount;
+    uint32_t volatile EntryToWrite;
+    uint32_t volatile EntryToRead;
+    wakeup Wakeup;
+
+    legacy_queue_entry Entries[256];
+};
+
+internal bool
+DoNextLegacyQueueEntry(legacy_queue *Queue)
+{
+    uint32_t EntryToRead = Queue->EntryToRead;
+    uint32_t NextEntryToRead = (EntryToRead + 1) % 256;
+    if (EntryToRead != Queue->EntryToWrite) {
+        uint32_t Index = __sync_val_compare_and_swap(&Queue->EntryToRead, EntryToRead, NextEntryToRead);
+        if (Index == EntryToRead) {
+            legacy_queue_entry Entry = Queue->Entries[Index];
+            Entry.Callback(Entry.Data);
+            __sync_fetch_and_add(&Queue->EntriesCompleted, 1);
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+internal void
+AddLegacyQueueEntry(legacy_queue *Queue, thread_pool_callback *Callback, void *Data)
+{
+    legacy_queue_entry *Entry = Queue->Entries + Queue->EntryToWrite;
+    Entry->Callback = Callback;
+    Entry->Data = Data;
+    ++Queue->EntryCount;
+
+    asm volatile("" ::: "memory");
+    Queue->EntryToWrite = (Queue->EntryToWrite + 1) % 256;
+    WakeupPost(&Queue->Wakeup);
+}
+
+internal void
+CompleteLegacyQueue(legacy_queue *Queue)
+{
+    while (Queue->EntryCount != Queue->EntriesCompleted) {
+        DoNextLegacyQueueEntry(Queue);
+    }
+
+    Queue->EntryCount = 0;
+    Queue->EntriesCompleted = 0;
+}
+
+internal void *
+LegacyQueueThreadProc(void *Data)
+{
+    legacy_queue *Queue = (legacy_queue *) Data;
+    for (;;) {
+        if (DoNextLegacyQueueEntry(Queue)) {
+            WakeupWait(&Queue->Wakeup);
+        }
+    }
+
+    return NULL;
+}
+
+enum pool_kind
+{
+    Pool_Legacy,
+    Pool_Stealing,
+};
+
+internal pool_kind Kind;
+internal legacy_queue LegacyQueue;
+internal thread_pool Pool;
+internal uint32_t volatile TasksRun;
+
+internal
+THREAD_POOL_CALLBACK(TinyTask)
+{
+    __atomic_add_fetch(&TasksRun, 1, __ATOMIC_RELAXED);
+}
+
+internal
+THREAD_POOL_CALLBACK(HeavyTask)
+{
+    uint64_t End = BenchNanoseconds() + HEAVY_TASK_NS;
+    while (BenchNanoseconds() < End);
+    __atomic_add_fetch(&TasksRun, 1, __ATOMIC_RELAXED);
+}
+
+internal
+THREAD_POOL_CALLBACK(BlockedTask)
+{
+    if (Data) usleep(BLOCKED_TASK_US);
+    __atomic_add_fetch(&TasksRun, 1, __ATOMIC_RELAXED);
+}
+
+// NOTE(koekeishiya): The first task of a batch is passed 'FirstData', the others NULL.
+internal void
+RunBatch(thread_pool_callback *Callback, uint32_t TaskCount, void *FirstData = NULL)
+{
+    if (Kind == Pool_Legacy) {
+        for (uint32_t Index = 0; Index < TaskCount; ++Index) {
+            AddLegacyQueueEntry(&LegacyQueue, Callback, Index ? NULL : FirstData);
+        }
+        CompleteLegacyQueue(&LegacyQueue);
+    } else {
+        task_group Group = {};
+        for (uint32_t Index = 0; Index < TaskCount; ++Index) {
+            ThreadPoolSubmit(&Pool, &Group, Callback, Index ? NULL : FirstData);
+        }
+        ThreadPoolWait(&Pool, &Group);
+    }
+}
+
+internal uint64_t
+CpuNanoseconds(clockid_t Clock)
+{
+    struct timespec Time;
+    clock_gettime(Clock, &Time);
+    return (uint64_t) Time.tv_sec * 1000000000ULL + (uint64_t) Time.tv_nsec;
+}
+
+internal const char *
+KindName()
+{
+    return Kind == Pool_Legacy ? "work-queue" : "pool";
+}
+
+internal void
+RunBatches(const char *Name, thread_pool_callback *Callback, uint32_t Batches)
+{
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, Batches);
+
+    TasksRun = 0;
+    uint64_t Start = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Batches; ++Index) {
+        uint64_t Begin = BenchNanoseconds();
+        RunBatch(Callback, BATCH_SIZE);
+        BenchAddSample(&Samples, BenchNanoseconds() - Begin);
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Start;
+
+    if (TasksRun != Batches * BATCH_SIZE) {
+        fprintf(stderr, "pool: %s ran %u of %u tasks!\n", KindName(), TasksRun, Batches * BATCH_SIZE);
+        exit(EXIT_FAILURE);
+    }
+
+    char Label[64];
+    snprintf(Label, sizeof(Label), "%-10s %s", KindName(), Name);
+    BenchPrintLatency(Label, &Samples);
+    printf("%-28s %.0f tasks/s\n", "", (double) TasksRun / (Elapsed / 1000000000.0));
+    BenchEndSamples(&Samples);
+}
+
+internal void
+RunBlocked()
+{
+    uint64_t Begin = BenchNanoseconds();
+    uint64_t ThreadBegin = CpuNanoseconds(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t ProcessBegin = CpuNanoseconds(CLOCK_PROCESS_CPUTIME_ID);
+
+    for (uint32_t Index = 0; Index < BLOCKED_BATCHES; ++Index) {
+        RunBatch(&BlockedTask, BATCH_SIZE, (void *) 1);
+    }
+
+    double Elapsed = (BenchNanoseconds() - Begin) / 1000000.0;
+    double Thread = (CpuNanoseconds(CLOCK_THREAD_CPUTIME_ID) - ThreadBegin) / 1000000.0;
+    double Process = (CpuNanoseconds(CLOCK_PROCESS_CPUTIME_ID) - ProcessBegin) / 1000000.0;
+
+    printf("%-10s %-17s wall %8.1f ms  waiter cpu %8.1f ms  process cpu %8.1f ms\n",
+           KindName(), "blocked", Elapsed, Thread, Process);
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t ThreadCount = ThreadPoolDefaultThreadCount();
+    uint32_t Batches = 2000;
+    if (Count > 1) sscanf(Args[1], "%u", &ThreadCount);
+    if (Count > 2) sscanf(Args[2], "%u", &Batches);
+
+    printf("%u threads, %u batches of %u tasks\n", ThreadCount, Batches, BATCH_SIZE);
+
+    WakeupInit(&LegacyQueue.Wakeup);
+    for (uint32_t Index = 0; Index < ThreadCount; ++Index) {
+        pthread_t Thread;
+        pthread_create(&Thread, NULL, &LegacyQueueThreadProc, &LegacyQueue);
+    }
+
+    if (!BeginThreadPool(&Pool, ThreadCount)) {
+        fprintf(stderr, "pool: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    // NOTE(koekeishiya): Alternate between the two kinds, so that both see the same machine state.
+    pool_kind Kinds[] = { Pool_Legacy, Pool_Stealing };
+    for (size_t Index = 0; Index < sizeof(Kinds) / sizeof(*Kinds); ++Index) {
+        Kind = Kinds[Index];
+        RunBatches("tiny", &TinyTask, Batches);
+    }
+
+    for (size_t Index = 0; Index < sizeof(Kinds) / sizeof(*Kinds); ++Index) {
+        Kind = Kinds[Index];
+        RunBatches("heavy", &HeavyTask, Batches / 10);
+    }
+
+    for (size_t Index = 0; Index < sizeof(Kinds) / sizeof(*Kinds); ++Index) {
+        Kind = Kinds[Index];
+        RunBlocked();
+    }
+
+    Kind = Pool_Stealing;
+    TasksRun = 0;
+    uint64_t Begin = BenchNanoseconds();
+    RunBatch(&TinyTask, OVERFLOW_TASK_COUNT);
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+    printf("%-10s %-17s %u tasks in %.2f ms\n", KindName(), "overflow", TasksRun, Elapsed / 1000000.0);
+
+    EndThreadPool(&Pool);
+    return TasksRun == OVERFLOW_TASK_COUNT ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,223 @@
+/*
+ * NOTE(koekeishiya): Measures how long a window focused event waits in the core event-loop
+ * while a producer floods it with window title changed events, such as a noisy terminal.
+ * The run is repeated with focus events placed in the same lane as the flood (fifo) and
+ * in their default interactive lane. The queue wait recorded by the event-loop itself,
+ * as reported by 'core::stats', is printed next to the measured latency.
+ *
+ * A last run has several producers push events into every lane, with a window destroyed
+ * event every so often. Fails if an event that took an earlier sequence than a window
+ * destroyed event is dispatched after it, or if an event is lost.
+ *
+ *   make && ./bin/priority [duration-ms]
+ */
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/histogram.cpp"
+#include "../core/wakeup.cpp"
+#include "../core/epoch.cpp"
+#include "../core/dispatch/ring.cpp"
+#include "../core/dispatch/event.cpp"
+
+#define internal static
+
+#define MAX_FOCUS_EVENTS 4096
+#define FOCUS_INTERVAL_US 2000
+#define HANDLER_COST_NS 5000
+#define BARRIER_PRODUCERS 4
+#define BARRIER_EVENTS 50000
+#define BARRIER_INTERVAL 64
+
+internal uint64_t QueuedAt[MAX_FOCUS_EVENTS];
+internal uint64_t DispatchedAt[MAX_FOCUS_EVENTS];
+internal uint32_t volatile FocusDispatched;
+internal bool volatile Flooding;
+
+internal void
+SimulateHandler()
+{
+    uint64_t End = BenchNanoseconds() + HANDLER_COST_NS;
+    while (BenchNanoseconds() < End);
+}
+
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowTitleChanged)
+{
+    SimulateHandler();
+}
+
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowFocused)
+{
+    uint32_t Index = (uint32_t)(uintptr_t) Event->Context;
+    DispatchedAt[Index] = BenchNanoseconds();
+    __sync_fetch_and_add(&FocusDispatched, 1);
+    SimulateHandler();
+}
+
+/*
+ * NOTE(koekeishiya): Only touched by the event-loop thread. 'Barrier' is the newest sequence
+ * of a window destroyed event that has been dispatched.
+ */
+internal uint32_t Barrier;
+internal uint64_t BarrierDispatched;
+internal uint64_t BarrierViolations;
+internal uint32_t volatile BarrierPending;
+
+internal void
+CheckBarrierOrder(chunk_event *Event)
+{
+    if (BarrierDispatched && ((int32_t) (Event->Sequence - Barrier) < 0)) {
+        ++BarrierViolations;
+    }
+
+    if ((Event->Type == ChunkWM_WindowDestroyed) &&
+        ((!BarrierDispatched) || ((int32_t) (Event->Sequence - Barrier) > 0))) {
+        Barrier = Event->Sequence;
+    }
+
+    ++BarrierDispatched;
+    __sync_fetch_and_sub(&BarrierPending, 1);
+}
+
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowDestroyed)    { CheckBarrierOrder(Event); }
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowCreated)      { CheckBarrierOrder(Event); }
+CHUNKWM_CALLBACK(Callback_ChunkWM_WindowMoved)        { CheckBarrierOrder(Event); }
+CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationActivated) { CheckBarrierOrder(Event); }
+
+internal void *
+BarrierThreadProc(void *)
+{
+    for (uint32_t Index = 1; Index <= BARRIER_EVENTS; ++Index) {
+        if ((Index % BARRIER_INTERVAL) == 0) {
+            ConstructEvent(ChunkWM_WindowDestroyed, NULL);
+        } else if ((Index % 3) == 0) {
+            ConstructEvent(ChunkWM_WindowCreated, NULL);
+        } else if ((Index % 3) == 1) {
+            ConstructEvent(ChunkWM_WindowMoved, NULL);
+        } else {
+            ConstructEvent(ChunkWM_ApplicationActivated, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+internal bool
+RunBarrierBenchmark()
+{
+    BarrierDispatched = 0;
+    BarrierViolations = 0;
+    BarrierPending = BARRIER_PRODUCERS * BARRIER_EVENTS;
+
+    pthread_t Threads[BARRIER_PRODUCERS];
+    uint64_t Begin = BenchNanoseconds();
+    StartEventLoop();
+    for (int Index = 0; Index < BARRIER_PRODUCERS; ++Index) {
+        pthread_create(Threads + Index, NULL, &BarrierThreadProc, NULL);
+    }
+
+    for (int Index = 0; Index < BARRIER_PRODUCERS; ++Index) {
+        pthread_join(Threads[Index], NULL);
+    }
+
+    while (BarrierPending) {
+        sched_yield();
+    }
+
+    StopEventLoop();
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    bool Result = (BarrierViolations == 0) && (BarrierDispatched == BARRIER_PRODUCERS * BARRIER_EVENTS);
+    printf("%-28s %d producers  %llu events  %.1f ns/event  out of order %llu  %s\n",
+           "barrier order",
+           BARRIER_PRODUCERS,
+           (unsigned long long) BarrierDispatched,
+           (double) Elapsed / BarrierDispatched,
+           (unsigned long long) BarrierViolations,
+           Result ? "ok" : "FAILED");
+    return Result;
+}
+
+internal void *
+FloodThreadProc(void *)
+{
+    while (Flooding) {
+        ConstructEvent(ChunkWM_WindowTitleChanged, NULL);
+    }
+
+    return NULL;
+}
+
+internal void
+RunBenchmark(const char *Label, event_priority FocusPriority, uint32_t DurationMs)
+{
+    SetEventPriority(ChunkWM_WindowFocused, FocusPriority);
+    ResetEventLatency();
+    FocusDispatched = 0;
+    Flooding = true;
+
+    pthread_t FloodThread;
+    StartEventLoop();
+    pthread_create(&FloodThread, NULL, &FloodThreadProc, NULL);
+
+    uint32_t FocusCount = (DurationMs * 1000) / FOCUS_INTERVAL_US;
+    if (FocusCount > MAX_FOCUS_EVENTS) FocusCount = MAX_FOCUS_EVENTS;
+
+    for (uint32_t Index = 0; Index < FocusCount; ++Index) {
+        usleep(FOCUS_INTERVAL_US);
+        QueuedAt[Index] = BenchNanoseconds();
+        ConstructEvent(ChunkWM_WindowFocused, (void *)(uintptr_t) Index);
+    }
+
+    Flooding = false;
+    pthread_join(FloodThread, NULL);
+
+    while (FocusDispatched != FocusCount) {
+        sched_yield();
+    }
+
+    StopEventLoop();
+
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, FocusCount);
+    for (uint32_t Index = 0; Index < FocusCount; ++Index) {
+        BenchAddSample(&Samples, DispatchedAt[Index] - QueuedAt[Index]);
+    }
+
+    BenchPrintLatency(Label, &Samples);
+    BenchEndSamples(&Samples);
+
+    latency_histogram *QueueWait = &EventLatency(ChunkWM_WindowFocused)->QueueWait;
+    printf("%-28s p50 %8llu ns  p99 %8llu ns  max %8llu ns\n",
+           "  core::stats queue wait",
+           (unsigned long long) HistogramPercentile(QueueWait, 50.0),
+           (unsigned long long) HistogramPercentile(QueueWait, 99.0),
+           (unsigned long long) HistogramMax(QueueWait));
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t DurationMs = 1000;
+    if (Count > 1) {
+        sscanf(Args[1], "%u", &DurationMs);
+    }
+
+    c_log_active_level = C_LOG_LEVEL_NONE;
+    if (!BeginEventLoop()) {
+        fprintf(stderr, "priority: could not initialize event-loop!\n");
+        return EXIT_FAILURE;
+    }
+
+    RunBenchmark("focus latency (fifo)", Event_Priority_Background, DurationMs);
+    RunBenchmark("focus latency (lanes)", Event_Priority_Interactive, DurationMs);
+    bool Result = RunBarrierBenchmark();
+
+    EndEventLoop();
+    return Result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,193 @@
+/*
+ * NOTE(koekeishiya): Compares the named POSIX semaphore that used to park the event-loop
+ * and work-queue threads against the process-private wakeup that replaced it.
+ *
+ *   parked     time from a post until a thread that was parked for 200us is running again
+ *   ping-pong  half of a round-trip between two threads that wake each other
+ *   post       cost of a post when no thread is waiting, e.g. a burst of queued events
+ *
+ *   make && ./bin/wakeup [iterations]
+ */
+
+#include "bench.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#include "../core/wakeup.cpp"
+
+#define internal static
+
+#define PARKED_INTERVAL_US 200
+#define POST_COUNT 1000000
+
+enum wakeup_kind
+{
+    Wakeup_Semaphore,
+    Wakeup_Private,
+};
+
+struct wakeup_pair
+{
+    wakeup_kind Kind;
+    sem_t *Semaphores[2];
+    wakeup Wakeups[2];
+};
+
+internal wakeup_pair Pair;
+internal uint64_t volatile PostedAt;
+internal uint32_t Iterations;
+
+internal inline void
+Post(int Index)
+{
+    if (Pair.Kind == Wakeup_Semaphore) {
+        sem_post(Pair.Semaphores[Index]);
+    } else {
+        WakeupPost(Pair.Wakeups + Index);
+    }
+}
+
+internal inline void
+Wait(int Index)
+{
+    if (Pair.Kind == Wakeup_Semaphore) {
+        sem_wait(Pair.Semaphores[Index]);
+    } else {
+        WakeupWait(Pair.Wakeups + Index);
+    }
+}
+
+internal void *
+ParkedThreadProc(void *Data)
+{
+    bench_samples *Samples = (bench_samples *) Data;
+    for (uint32_t Index = 0; Index < Iterations; ++Index) {
+        Wait(0);
+        BenchAddSample(Samples, BenchNanoseconds() - PostedAt);
+        Post(1);
+    }
+
+    return NULL;
+}
+
+internal void *
+PingPongThreadProc(void *)
+{
+    for (uint32_t Index = 0; Index < Iterations; ++Index) {
+        Wait(0);
+        Post(1);
+    }
+
+    return NULL;
+}
+
+internal const char *
+KindName()
+{
+    return Pair.Kind == Wakeup_Semaphore ? "semaphore" : "wakeup";
+}
+
+internal void
+RunParked()
+{
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, Iterations);
+
+    pthread_t Thread;
+    pthread_create(&Thread, NULL, &ParkedThreadProc, &Samples);
+
+    for (uint32_t Index = 0; Index < Iterations; ++Index) {
+        usleep(PARKED_INTERVAL_US);
+        PostedAt = BenchNanoseconds();
+        Post(0);
+        Wait(1);
+    }
+
+    pthread_join(Thread, NULL);
+
+    char Label[64];
+    snprintf(Label, sizeof(Label), "%-9s parked", KindName());
+    BenchPrintLatency(Label, &Samples);
+    BenchEndSamples(&Samples);
+}
+
+internal void
+RunPingPong()
+{
+    bench_samples Samples;
+    BenchBeginSamples(&Samples, Iterations);
+
+    pthread_t Thread;
+    pthread_create(&Thread, NULL, &PingPongThreadProc, NULL);
+
+    for (uint32_t Index = 0; Index < Iterations; ++Index) {
+        uint64_t Begin = BenchNanoseconds();
+        Post(0);
+        Wait(1);
+        BenchAddSample(&Samples, (BenchNanoseconds() - Begin) / 2);
+    }
+
+    pthread_join(Thread, NULL);
+
+    char Label[64];
+    snprintf(Label, sizeof(Label), "%-9s ping-pong", KindName());
+    BenchPrintLatency(Label, &Samples);
+    BenchEndSamples(&Samples);
+}
+
+internal void
+RunPost()
+{
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < POST_COUNT; ++Index) {
+        Post(0);
+    }
+    uint64_t Elapsed = BenchNanoseconds() - Begin;
+
+    // NOTE(koekeishiya): Drain the posts again, so that the next run starts from zero.
+    for (uint32_t Index = 0; Index < POST_COUNT; ++Index) {
+        Wait(0);
+    }
+
+    printf("%-9s post %17.1f ns/post\n", KindName(), (double) Elapsed / POST_COUNT);
+}
+
+int main(int Count, char **Args)
+{
+    Iterations = 2000;
+    if (Count > 1) {
+        sscanf(Args[1], "%u", &Iterations);
+    }
+
+    const char *Names[2] = { "chunkwm_bench_semaphore_0", "chunkwm_bench_semaphore_1" };
+    for (int Index = 0; Index < 2; ++Index) {
+        sem_unlink(Names[Index]);
+        if ((Pair.Semaphores[Index] = sem_open(Names[Index], O_CREAT, 0644, 0)) == SEM_FAILED) {
+            fprintf(stderr, "wakeup: could not open semaphore!\n");
+            return EXIT_FAILURE;
+        }
+
+        WakeupInit(Pair.Wakeups + Index);
+    }
+
+    // NOTE(koekeishiya): Alternate between the two kinds, so that both see the same machine state.
+    wakeup_kind Kinds[] = { Wakeup_Semaphore, Wakeup_Private };
+    void (*Runs[])() = { &RunParked, &RunPingPong, &RunPost };
+    for (size_t Run = 0; Run < sizeof(Runs) / sizeof(*Runs); ++Run) {
+        for (size_t Index = 0; Index < sizeof(Kinds) / sizeof(*Kinds); ++Index) {
+            Pair.Kind = Kinds[Index];
+            Runs[Run]();
+        }
+    }
+
+    for (int Index = 0; Index < 2; ++Index) {
+        sem_close(Pair.Semaphores[Index]);
+        sem_unlink(Names[Index]);
+        WakeupDestroy(Pair.Wakeups + Index);
+    }
+
+    return EXIT_SUCCESS;
+}
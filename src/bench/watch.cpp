@@ -0,0 +1,207 @@
+/*
+ * NOTE(koekeishiya): Measures cvar watches, which replace the cvar reads that the tiling
+ * plugin does on every window moved event. A plugin 'Tiling' has a mailbox on the thread pool
+ * and watches 'window_region_locked', the same as the core. The main thread stands in for the
+ * event-loop: the hook sets a flag instead of posting 'ChunkWM_CVarChanged'.
+ *
+ *   read      cost per window moved event of checking the cvar by name, through a handle,
+ *             and of the copy that the watch keeps up to date
+ *   update    cost of 'UpdateCVar' for a cvar that is not watched and for one that is
+ *   coalesce  a writer updates the cvar 'updates' times between two rounds of the event-loop;
+ *             prints the number of hooks and notifications per update, and fails if the copy
+ *             of the plugin is not the newest value after a round
+ *
+ *   make && ./bin/watch [rounds] [updates]
+ */
+
+#define CHUNKWM_CORE
+
+#include "bench.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "../api/plugin_api.h"
+#include "../core/clog.h"
+#include "../core/clog.c"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+#include "../core/mailbox.cpp"
+#include "../core/cvar.cpp"
+#include "../core/watch.cpp"
+#include "../common/config/cvar.cpp"
+
+#define internal static
+
+#define DEFAULT_ROUNDS 2000
+#define DEFAULT_UPDATES 64
+#define READS 10000000
+#define PLUGIN_NAME "Tiling"
+#define WATCHED_CVAR "window_region_locked"
+#define UNWATCHED_CVAR "window_float_next"
+
+chunkwm_api API;
+
+internal thread_pool Pool;
+internal plugin Plugin;
+internal plugin_details Info;
+internal loaded_plugin Loaded;
+internal loaded_plugin_list LoadedPlugins;
+
+internal cvar *Watched;
+internal int volatile WatchedValue;
+internal uint64_t volatile Notifications;
+internal bool volatile ChangePending;
+internal uint64_t Hooks;
+
+loaded_plugin_list *BeginLoadedPluginList()
+{
+    return &LoadedPlugins;
+}
+
+void EndLoadedPluginList()
+{
+}
+
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data)
+{
+    if (Export == chunkwm_export_cvar_changed) {
+        RunCVarWatch(Node, Data);
+        return true;
+    }
+
+    return false;
+}
+
+internal
+CHUNKWM_API_CVAR_WATCH_FUNC(WatchedCVarChanged)
+{
+    WatchedValue = CVarIntegerValue(CVar);
+    __atomic_add_fetch(&Notifications, 1, __ATOMIC_RELAXED);
+}
+
+internal
+CVAR_CHANGED_HOOK(BenchCVarChanged)
+{
+    ++Hooks;
+    ChangePending = true;
+}
+
+// NOTE(koekeishiya): What 'Callback_ChunkWM_CVarChanged' and the end of the event round do.
+internal void
+RunEventLoopRound()
+{
+    if (!ChangePending) return;
+    ChangePending = false;
+    DispatchCVarWatches();
+    DrainPluginMailbox(Loaded.Mailbox);
+}
+
+internal double
+ReadNanoseconds(int Mode)
+{
+    int Sum = 0;
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < READS; ++Index) {
+        if (Mode == 0)      Sum += CVarIntegerValue(WATCHED_CVAR);
+        else if (Mode == 1) Sum += CVarIntegerValue(Watched);
+        else                Sum += WatchedValue;
+        __asm__ __volatile__("" : "+r"(Sum));
+    }
+    return (double) (BenchNanoseconds() - Begin) / READS;
+}
+
+internal double
+UpdateNanoseconds(cvar *CVar, uint32_t Updates)
+{
+    uint64_t Begin = BenchNanoseconds();
+    for (uint32_t Index = 0; Index < Updates; ++Index) {
+        UpdateCVar(CVar, (int) Index);
+    }
+    double Result = (double) (BenchNanoseconds() - Begin) / Updates;
+    RunEventLoopRound();
+    return Result;
+}
+
+int main(int Count, char **Args)
+{
+    uint32_t Rounds = Count > 1 ? (uint32_t) atoi(Args[1]) : DEFAULT_ROUNDS;
+    uint32_t Updates = Count > 2 ? (uint32_t) atoi(Args[2]) : DEFAULT_UPDATES;
+    if (Rounds == 0 || Updates == 0) {
+        fprintf(stderr, "usage: watch [rounds] [updates]\n");
+        return EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_ERROR;
+
+    API.UpdateCVar = UpdateCVarAPI;
+    API.AcquireCVar = AcquireCVarAPI;
+    API.FindCVar = FindCVarAPI;
+    API.CVarInteger = CVarIntegerAPI;
+    API.ResolveCVar = ResolveCVarAPI;
+    API.UpdateCVarHandle = UpdateCVarHandleAPI;
+    API.CVarHandleInteger = CVarHandleIntegerAPI;
+    API.WatchCVar = WatchCVar;
+
+    if (!BeginCVars() || !BeginCVarWatches()) {
+        fprintf(stderr, "watch: could not initialize cvars!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!BeginThreadPool(&Pool, 1) || !BeginPluginMailboxes(&Pool)) {
+        fprintf(stderr, "watch: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    Info.PluginName = PLUGIN_NAME;
+    Loaded.Plugin = &Plugin;
+    Loaded.Info = &Info;
+    Loaded.Mailbox = CreatePluginMailbox(&Plugin, PLUGIN_NAME, false);
+    LoadedPlugins[PLUGIN_NAME] = &Loaded;
+
+    CreateCVar(WATCHED_CVAR, 0);
+    CreateCVar(UNWATCHED_CVAR, 0);
+    Watched = ResolveCVar(WATCHED_CVAR);
+    cvar *Unwatched = ResolveCVar(UNWATCHED_CVAR);
+
+    SetCVarWatchHook(&BenchCVarChanged);
+    API.WatchCVar(PLUGIN_NAME, WATCHED_CVAR, &WatchedCVarChanged);
+
+    printf("%-22s name %6.2f ns  handle %6.2f ns  watched %6.2f ns\n", "read",
+           ReadNanoseconds(0), ReadNanoseconds(1), ReadNanoseconds(2));
+
+    double UnwatchedCost = UpdateNanoseconds(Unwatched, Rounds * Updates);
+    double WatchedCost = UpdateNanoseconds(Watched, Rounds * Updates);
+    printf("%-22s unwatched %6.1f ns  watched %6.1f ns\n", "update", UnwatchedCost, WatchedCost);
+
+    Hooks = 0;
+    Notifications = 0;
+
+    bool Stale = false;
+    for (uint32_t Round = 0; Round < Rounds; ++Round) {
+        int Newest = 0;
+        for (uint32_t Index = 0; Index < Updates; ++Index) {
+            Newest = (int) (Round * Updates + Index);
+            UpdateCVar(Watched, Newest);
+        }
+
+        RunEventLoopRound();
+        if (WatchedValue != Newest) {
+            fprintf(stderr, "watch: round %u: plugin has %d, newest is %d!\n", Round, WatchedValue, Newest);
+            Stale = true;
+            break;
+        }
+    }
+
+    uint64_t Total = (uint64_t) Rounds * Updates;
+    printf("%-22s updates %llu  hooks %llu  notifications %llu (%.4f per update)\n", "coalesce",
+           (unsigned long long) Total,
+           (unsigned long long) Hooks,
+           (unsigned long long) Notifications,
+           (double) Notifications / Total);
+
+    DestroyPluginMailbox(Loaded.Mailbox);
+    return Stale ? EXIT_FAILURE : EXIT_SUCCESS;
+}
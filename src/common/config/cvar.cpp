@@ -19,6 +19,11 @@ bool CVarExists(const char *Name)
     return ChunkwmAPI->FindCVar(Name);
 }
 
+cvar *ResolveCVar(const char *Name)
+{
+    return ChunkwmAPI->ResolveCVar(Name);
+}
+
 void UpdateCVar(const char *Name, int Value)
 {
     char *String = (char *) malloc(256);
@@ -75,37 +80,100 @@ void CreateCVar(const char *Name, char *Value)
     UpdateCVar(Name, Value);
 }
 
+// NOTE(koekeishiya): chunkwm parses the value once when it is updated, see 'cvar'.
 int CVarIntegerValue(const char *Name)
 {
-    int Result = 0;
-    char *String = ChunkwmAPI->AcquireCVar(Name);
-    if (String) {
-        sscanf(String, "%d", &Result);
-    }
-    return Result;
+    return ChunkwmAPI->CVarInteger(Name);
 }
 
 int CVarUnsignedValue(const char *Name)
 {
-    unsigned Result = 0;
-    char *String = ChunkwmAPI->AcquireCVar(Name);
-    if (String) {
-        sscanf(String, "%x", &Result);
-    }
-    return Result;
+    return ChunkwmAPI->CVarUnsigned(Name);
 }
 
 float CVarFloatingPointValue(const char *Name)
 {
-    float Result = 0.0f;
-    char *String = ChunkwmAPI->AcquireCVar(Name);
-    if (String) {
-        sscanf(String, "%f", &Result);
-    }
+    return ChunkwmAPI->CVarFloatingPoint(Name);
+}
+
+internal inline bool
+CopyCVarString(const char *Value, char *Buffer, size_t Size)
+{
+    snprintf(Buffer, Size, "%s", Value ? Value : "");
+    return Value != NULL;
+}
+
+bool CVarStringValue(const char *Name, char *Buffer, size_t Size)
+{
+    uint64_t Read = ChunkwmAPI->BeginCVarRead();
+    bool Result = CopyCVarString(ChunkwmAPI->AcquireCVar(Name), Buffer, Size);
+    ChunkwmAPI->EndCVarRead(Read);
     return Result;
 }
 
-char *CVarStringValue(const char *Name)
+bool CVarStringEquals(const char *Name, const char *String)
+{
+    uint64_t Read = ChunkwmAPI->BeginCVarRead();
+    char *Value = ChunkwmAPI->AcquireCVar(Name);
+    bool Result = Value && strcmp(Value, String) == 0;
+    ChunkwmAPI->EndCVarRead(Read);
+    return Result;
+}
+
+void UpdateCVar(cvar *CVar, int Value)
+{
+    char String[256] = {};
+    snprintf(String, sizeof(String), "%d", Value);
+    ChunkwmAPI->UpdateCVarHandle(CVar, String);
+}
+
+void UpdateCVar(cvar *CVar, unsigned Value)
+{
+    char String[256] = {};
+    snprintf(String, sizeof(String), "%x", Value);
+    ChunkwmAPI->UpdateCVarHandle(CVar, String);
+}
+
+void UpdateCVar(cvar *CVar, float Value)
 {
-    return ChunkwmAPI->AcquireCVar(Name);
+    char String[256] = {};
+    snprintf(String, sizeof(String), "%f", Value);
+    ChunkwmAPI->UpdateCVarHandle(CVar, String);
+}
+
+void UpdateCVar(cvar *CVar, char *Value)
+{
+    ChunkwmAPI->UpdateCVarHandle(CVar, Value);
+}
+
+int CVarIntegerValue(cvar *CVar)
+{
+    return ChunkwmAPI->CVarHandleInteger(CVar);
+}
+
+int CVarUnsignedValue(cvar *CVar)
+{
+    return ChunkwmAPI->CVarHandleUnsigned(CVar);
+}
+
+float CVarFloatingPointValue(cvar *CVar)
+{
+    return ChunkwmAPI->CVarHandleFloatingPoint(CVar);
+}
+
+bool CVarStringValue(cvar *CVar, char *Buffer, size_t Size)
+{
+    uint64_t Read = ChunkwmAPI->BeginCVarRead();
+    bool Result = CopyCVarString(ChunkwmAPI->AcquireCVarHandle(CVar), Buffer, Size);
+    ChunkwmAPI->EndCVarRead(Read);
+    return Result;
+}
+
+bool CVarStringEquals(cvar *CVar, const char *String)
+{
+    uint64_t Read = ChunkwmAPI->BeginCVarRead();
+    char *Value = ChunkwmAPI->AcquireCVarHandle(CVar);
+    bool Result = Value && strcmp(Value, String) == 0;
+    ChunkwmAPI->EndCVarRead(Read);
+    return Result;
 }
@@ -1,10 +1,22 @@
 #ifndef CHUNKWM_COMMON_CVAR_H
 #define CHUNKWM_COMMON_CVAR_H
 
+#include <stddef.h>
+
+/*
+ * NOTE(koekeishiya): The string of a cvar is freed once the cvar has been updated and no read
+ * is in progress, so it is never returned. 'CVarStringValue' copies it into 'Buffer' within a
+ * read, and returns false, with an empty string, if the cvar does not exist. A value that does
+ * not fit is truncated; every value but a path fits in 'CVAR_STRING_SIZE'.
+ */
+#define CVAR_STRING_SIZE 256
+
 struct chunkwm_api;
+struct cvar;
 void BeginCVars(chunkwm_api *Api);
 
 bool CVarExists(const char *Name);
+cvar *ResolveCVar(const char *Name);
 
 void UpdateCVar(const char *Name, int Value);
 void UpdateCVar(const char *Name, unsigned Value);
@@ -19,6 +31,18 @@ void CreateCVar(const char *Name, char *Value);
 int CVarIntegerValue(const char *Name);
 int CVarUnsignedValue(const char *Name);
 float CVarFloatingPointValue(const char *Name);
-char *CVarStringValue(const char *Name);
+bool CVarStringValue(const char *Name, char *Buffer, size_t Size);
+bool CVarStringEquals(const char *Name, const char *String);
+
+void UpdateCVar(cvar *CVar, int Value);
+void UpdateCVar(cvar *CVar, unsigned Value);
+void UpdateCVar(cvar *CVar, float Value);
+void UpdateCVar(cvar *CVar, char *Value);
+
+int CVarIntegerValue(cvar *CVar);
+int CVarUnsignedValue(cvar *CVar);
+float CVarFloatingPointValue(cvar *CVar);
+bool CVarStringValue(cvar *CVar, char *Buffer, size_t Size);
+bool CVarStringEquals(cvar *CVar, const char *String);
 
 #endif
@@ -0,0 +1,39 @@
+#ifndef CHUNKWM_COMMON_TIMER_H
+#define CHUNKWM_COMMON_TIMER_H
+
+#include <stdint.h>
+
+#include <time.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+// NOTE(koekeishiya): Monotonic clock, only meaningful as a difference between two calls.
+inline uint64_t
+GetTimeNanoseconds()
+{
+#ifdef __APPLE__
+    static mach_timebase_info_data_t Timebase;
+    if (!Timebase.denom) {
+        mach_timebase_info(&Timebase);
+    }
+
+    return mach_absolute_time() * Timebase.numer / Timebase.denom;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (uint64_t) Time.tv_sec * 1000000000ULL + (uint64_t) Time.tv_nsec;
+#endif
+}
+
+// NOTE(koekeishiya): Processor time used by the calling thread.
+inline uint64_t
+GetThreadCpuNanoseconds()
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Time);
+    return (uint64_t) Time.tv_sec * 1000000000ULL + (uint64_t) Time.tv_nsec;
+}
+
+#endif
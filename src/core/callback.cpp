@@ -1,6 +1,9 @@
 #include "config.h"
 #include "plugin.h"
-#include "wqueue.h"
+#include "filter.h"
+#include "pool.h"
+#include "mailbox.h"
+#include "watch.h"
 #include "state.h"
 #include "clog.h"
 
@@ -8,6 +11,7 @@
 #include "dispatch/workspace.h"
 #include "dispatch/event.h"
 
+#include "../common/accessibility/application.h"
 #include "../common/accessibility/window.h"
 #include "../common/misc/assert.h"
 
@@ -16,129 +20,200 @@
 
 #define internal static
 
-#define ProcessPluginList(plugin_export, Context)          \
-    plugin_list *List = BeginPluginList(plugin_export);    \
-    for (plugin_list_iter It = List->begin();              \
-         It != List->end();                                \
-         ++It) {                                           \
-        plugin *Plugin = It->first;                        \
-        Plugin->Run(#plugin_export,                        \
-                    (void *) Context);                     \
-    }                                                      \
-    EndPluginList(plugin_export)
-
-#define ProcessPluginListThreaded(plugin_export, Context)  \
-    plugin_list *List = BeginPluginList(plugin_export);    \
-    plugin_work WorkArray[List->size()];                   \
-    int WorkCount = 0;                                     \
-    for (plugin_list_iter It = List->begin();              \
-         It != List->end();                                \
-         ++It) {                                           \
-        plugin_work *Work = WorkArray + WorkCount++;       \
-        Work->Plugin = It->first;                          \
-        Work->Export = (char *) #plugin_export;            \
-        Work->Data = (void *) Context;                     \
-        AddWorkQueueEntry(&Queue,                          \
-                          &PluginWorkCallback,             \
-                          Work);                           \
-    }                                                      \
-    EndPluginList(plugin_export);                          \
-    CompleteWorkQueue(&Queue)                              \
-
-struct plugin_work
-{
-    plugin *Plugin;
-    char *Export;
-    void *Data;
-};
+#define ProcessPluginList(plugin_export, Context)                   \
+    uint64_t Epoch;                                                 \
+    plugin_list *List = BeginPluginList(plugin_export, &Epoch);     \
+    for (uint32_t Index = 0; Index < List->Count; ++Index) {        \
+        plugin_subscriber *Subscriber = List->Subscribers + Index;  \
+        RunPlugin(Subscriber->Plugin, Subscriber->Mailbox->Legacy,  \
+                  plugin_export, 0, #plugin_export,                 \
+                  (void *) Context);                                \
+    }                                                               \
+    EndPluginList(Epoch)
 
-internal work_queue Queue;
+internal thread_pool Pool;
 
 internal
-WORK_QUEUE_CALLBACK(PluginWorkCallback)
+PLUGIN_PAYLOAD_DESTRUCTOR(FreePayloadData)
 {
-    plugin_work *Work = (plugin_work *) Data;
-    Work->Plugin->Run(Work->Export,
-                      Work->Data);
+    free(Data);
 }
 
-// NOTE(koekeishiya): We pass a pointer to this function to every plugin as they are loaded.
-void ChunkwmBroadcast(const char *PluginName, const char *EventName,
-                      void *PluginData, size_t Size)
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(FreePayloadContext)
 {
-    if (!PluginName || !EventName) {
-        return;
-    }
+    free(Context);
+}
+
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(DestroyWindowPayload)
+{
+    AXLibDestroyWindow((macos_window *) Data);
+}
 
-    void **Context = (void **) malloc(2 * sizeof(void *));
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(DestroyApplicationPayload)
+{
+    AXLibDestroyApplication((macos_application *) Data);
+}
+
+// NOTE(koekeishiya): The roles a window had before they were updated, see 'Callback_ChunkWM_WindowDeminimized'.
+struct window_roles
+{
+    CFStringRef Mainrole;
+    CFStringRef Subrole;
+};
 
-    size_t TotalLength = strlen(PluginName) + strlen(EventName) + 2;
-    char *Event = (char *) malloc(TotalLength);
-    snprintf(Event, TotalLength, "%s_%s", PluginName, EventName);
-    Context[0] = Event;
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(ReleaseWindowRoles)
+{
+    window_roles *Roles = (window_roles *) Context;
+    if (Roles->Mainrole) CFRelease(Roles->Mainrole);
+    if (Roles->Subrole) CFRelease(Roles->Subrole);
+    free(Roles);
+}
+
+internal inline bool
+SubscriberAccepts(plugin_subscriber *Subscriber, chunkwm_plugin_export Export, void *Data)
+{
+    return !Subscriber->Filter || PluginFilterAccepts(Subscriber->Filter, Export, Data);
+}
 
-    if (Size) {
-        void *Data = (void *) malloc(Size);
-        memcpy(Data, PluginData, Size);
-        Context[1] = Data;
+/*
+ * NOTE(koekeishiya): Post an event to the mailbox of every plugin that is subscribed to it,
+ * unless the filters of the plugin reject it. An event with a destructor is also posted to
+ * every other plugin, without an export, so that its data is not destroyed while a plugin
+ * is still processing an older event that refers to the same window or application.
+ */
+internal void
+PostPluginPayload(chunkwm_plugin_export Export, plugin_payload *Payload, bool Destroy)
+{
+    void *Data = Payload->Data;
+    const char *Node = chunkwm_plugin_export_str[Export];
+
+    uint64_t Epoch;
+    plugin_list *List = BeginPluginList(Export, &Epoch);
+    if (Destroy) {
+        // NOTE(koekeishiya): The list for plugin broadcasts holds every loaded plugin.
+        uint64_t LoadedEpoch;
+        plugin_list *LoadedList = BeginPluginList(chunkwm_export_plugin_broadcast, &LoadedEpoch);
+        for (uint32_t Index = 0; Index < LoadedList->Count; ++Index) {
+            plugin_subscriber *Subscriber = LoadedList->Subscribers + Index;
+            plugin_subscriber *Subscribed = FindPluginSubscriber(List, Subscriber->Plugin);
+            bool Accepted = Subscribed && SubscriberAccepts(Subscribed, Export, Data);
+            PostPluginMailbox(Subscriber->Mailbox, Export, 0, Accepted ? Node : NULL, Payload);
+        }
+        EndPluginList(LoadedEpoch);
     } else {
-        Context[1] = NULL;
+        for (uint32_t Index = 0; Index < List->Count; ++Index) {
+            plugin_subscriber *Subscriber = List->Subscribers + Index;
+            if (SubscriberAccepts(Subscriber, Export, Data)) {
+                PostPluginMailbox(Subscriber->Mailbox, Export, 0, Node, Payload);
+            }
+        }
     }
+    EndPluginList(Epoch);
 
-    c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s:%s\n", PluginName, EventName);
-    ConstructEvent(ChunkWM_PluginBroadcast, Context);
+    ReleasePluginPayload(Payload);
 }
 
-CHUNKWM_CALLBACK(Callback_ChunkWM_PluginBroadcast)
+internal inline void
+PostPluginList(chunkwm_plugin_export Export, void *Data,
+               plugin_payload_destructor *Destroy = NULL, void *Context = NULL)
 {
-    void **Context = (void **) Event->Context;
-
-    char *PluginEvent = (char *) Context[0];
-    void *EventData = (void *) Context[1];
+    PostPluginPayload(Export, CreatePluginPayload(Data, Destroy, Context), Destroy != NULL);
+}
 
-    loaded_plugin_list *List = BeginLoadedPluginList();
+/*
+ * NOTE(koekeishiya): Plugins run on the thread pool, while the event-loop goes on to update
+ * the 'Position', 'Size' and 'Flags' of the same window for the next event. Plugins are
+ * therefore given a copy of the window as it was when the event was posted. The copy shares
+ * 'Ref', 'Owner', 'Name' and the roles with the window. 'Ref' and 'Owner' outlive every posted
+ * event; a replaced title or role is released by the destructor of the event that replaced it,
+ * once every plugin has handled the events that were posted before it.
+ *
+ * The copy is kept inline in the payload, which leaves 'Destroy' free for the event.
+ */
+static_assert(sizeof(macos_window) <= PLUGIN_PAYLOAD_INLINE_SIZE, "macos_window must fit inline in a plugin_payload");
 
-    plugin_work WorkArray[List->size()];
-    int WorkCount = 0;
+internal inline void
+PostPluginWindow(chunkwm_plugin_export Export, macos_window *Window,
+                 plugin_payload_destructor *Destroy = NULL, void *Context = NULL)
+{
+    plugin_payload *Payload = CreatePluginPayloadCopy(Window, sizeof(macos_window), Context);
+    Payload->Destroy = Destroy;
+    PostPluginPayload(Export, Payload, Destroy != NULL);
+}
 
-    for (loaded_plugin_list_iter It = List->begin();
-         It != List->end();
-         ++It) {
-        loaded_plugin *LoadedPlugin = It->second;
-        if (strncmp(LoadedPlugin->Info->PluginName,
-                    PluginEvent,
-                    strlen(LoadedPlugin->Info->PluginName)) != 0) {
-            plugin_work *Work = WorkArray + WorkCount++;
-            Work->Plugin = LoadedPlugin->Plugin;
-            Work->Export = PluginEvent;
-            Work->Data = EventData;
-            AddWorkQueueEntry(&Queue, &PluginWorkCallback, Work);
-        }
+// NOTE(koekeishiya): We pass a pointer to this function to every plugin as they are loaded.
+void ChunkwmBroadcast(const char *PluginName, const char *EventName,
+                      void *PluginData, size_t Size)
+{
+    if (!PluginName || !EventName) {
+        return;
     }
 
-    EndLoadedPluginList();
-    CompleteWorkQueue(&Queue);
+    ChunkwmBroadcastTopic(InternTopic(PluginName, EventName), PluginData, Size);
+}
 
-    if (EventData) {
-        free(EventData);
+/*
+ * NOTE(koekeishiya): The data is copied once into a pooled payload, small messages do not
+ * allocate at all. The topic is carried in the payload context.
+ */
+CHUNKWM_API_BROADCAST_TOPIC_FUNC(ChunkwmBroadcastTopic)
+{
+    if (!Topic) {
+        return;
     }
 
-    free(PluginEvent);
-    free(Context);
+    plugin_payload *Payload = CreatePluginPayloadCopy(Data, Size, (void *) (uintptr_t) Topic);
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s\n", TopicName(Topic));
+    ConstructEvent(ChunkWM_PluginBroadcast, Payload);
 }
 
-bool BeginCallbackThreads(int Count)
+/*
+ * NOTE(koekeishiya): A broadcast is only posted to the plugins that subscribed to its topic.
+ * Plugins built against the legacy api can not subscribe, and still receive every broadcast
+ * that was not sent by themselves.
+ */
+CHUNKWM_CALLBACK(Callback_ChunkWM_PluginBroadcast)
 {
-    if ((Queue.Semaphore = sem_open("work_queue_semaphore", O_CREAT, 0644, 0)) == SEM_FAILED) {
-        return false;
+    plugin_payload *Payload = (plugin_payload *) Event->Context;
+    uint32_t Topic = (uint32_t) (uintptr_t) Payload->Context;
+    const char *Node = TopicName(Topic);
+
+    uint64_t Epoch;
+    plugin_list *List = BeginTopicList(Topic, &Epoch);
+    for (uint32_t Index = 0; Index < List->Count; ++Index) {
+        PostPluginMailbox(List->Subscribers[Index].Mailbox, chunkwm_export_plugin_broadcast, Topic, Node, Payload);
     }
-
-    pthread_t Thread[Count];
-    for (int Index = 0; Index < Count; ++Index) {
-        pthread_create(&Thread[Index], NULL, &WorkQueueThreadProc, &Queue);
+    EndPluginList(Epoch);
+
+    List = BeginPluginList(chunkwm_export_plugin_broadcast, &Epoch);
+    for (uint32_t Index = 0; Index < List->Count; ++Index) {
+        plugin_mailbox *Mailbox = List->Subscribers[Index].Mailbox;
+        if ((Mailbox->Legacy) &&
+            (strncmp(Mailbox->Name, Node, strlen(Mailbox->Name)) != 0)) {
+            PostPluginMailbox(Mailbox, chunkwm_export_plugin_broadcast, Topic, Node, Payload);
+        }
     }
+    EndPluginList(Epoch);
 
-    return true;
+    ReleasePluginPayload(Payload);
+}
+
+bool BeginCallbackThreads(uint32_t Count)
+{
+    bool Result = BeginThreadPool(&Pool, Count);
+    SetEventRoundHook(&FlushPluginMailboxes);
+    SetCVarWatchHook(&PostCVarChanged);
+    return BeginPluginMailboxes(&Pool) && Result;
+}
+
+// NOTE(koekeishiya): Must be called after 'BeginCallbackThreads', before the event-loop is started.
+void LoadStartupPlugins()
+{
+    LoadQueuedPlugins(&Pool);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_PluginLoad)
@@ -157,24 +232,52 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_PluginUnload)
     free(PluginFS);
 }
 
+internal
+CVAR_CHANGED_HOOK(PostCVarChanged)
+{
+    ConstructEvent(ChunkWM_CVarChanged, NULL);
+}
+
+// NOTE(koekeishiya): Posted for the first change to a cvar since the previous event, see watch.h.
+CHUNKWM_CALLBACK(Callback_ChunkWM_CVarChanged)
+{
+    DispatchCVarWatches();
+}
+
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(DestroyCommandPayload)
+{
+    chunkwm_delegate *Delegate = (chunkwm_delegate *) Context;
+    CloseSocket(Delegate->SockFD);
+    free(Delegate->Target);
+    free(Delegate->Command);
+    free((char *)(Delegate->Message));
+    free(Delegate);
+    free(Data);
+}
+
 CHUNKWM_CALLBACK(Callback_ChunkWM_PluginCommand)
 {
     chunkwm_delegate *Delegate = (chunkwm_delegate *) Event->Context;
     ASSERT(Delegate);
 
-    plugin *Plugin = GetPluginFromFilename(Delegate->Target);
-    if (Plugin) {
-        chunkwm_payload Payload = { Delegate->SockFD, Delegate->Command, Delegate->Message };
-        Plugin->Run("chunkwm_daemon_command", (void *) &Payload);
+    chunkwm_payload *Command = (chunkwm_payload *) malloc(sizeof(chunkwm_payload));
+    Command->SockFD = Delegate->SockFD;
+    Command->Command = Delegate->Command;
+    Command->Message = Delegate->Message;
+
+    // NOTE(koekeishiya): The socket is closed when the plugin has handled the command.
+    plugin_payload *Payload = CreatePluginPayload(Command, &DestroyCommandPayload, Delegate);
+
+    plugin_mailbox *Mailbox = GetPluginMailboxFromFilename(Delegate->Target);
+    if (Mailbox) {
+        PostPluginMailbox(Mailbox, chunkwm_export_daemon_command, 0,
+                          chunkwm_plugin_export_str[chunkwm_export_daemon_command], Payload);
     } else {
         c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' is not loaded.\n", Delegate->Target);
     }
 
-    CloseSocket(Delegate->SockFD);
-    free(Delegate->Target);
-    free(Delegate->Command);
-    free((char *)(Delegate->Message));
-    free(Delegate);
+    ReleasePluginPayload(Payload);
 }
 
 // NOTE(koekeishiya): Application-related callbacks.
@@ -189,7 +292,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationLaunched)
 #if 0
     ProcessPluginList(chunkwm_export_application_launched, Application);
 #else
-    ProcessPluginListThreaded(chunkwm_export_application_launched, Application);
+    PostPluginList(chunkwm_export_application_launched, Application);
 #endif
 
     /*
@@ -209,12 +312,13 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationTerminated)
     macos_application *Application = GetApplicationFromPID(Info->PID);
     if (Application) {
         c_log(C_LOG_LEVEL_DEBUG, "%d:%s terminated\n", Info->PID, Info->ProcessName);
+        RemoveApplicationFromCollection(Application);
 #if 0
         ProcessPluginList(chunkwm_export_application_terminated, Application);
+        AXLibDestroyApplication(Application);
 #else
-        ProcessPluginListThreaded(chunkwm_export_application_terminated, Application);
+        PostPluginList(chunkwm_export_application_terminated, Application, &DestroyApplicationPayload);
 #endif
-        RemoveAndDestroyApplication(Application);
     }
 
     EndCarbonApplicationDetails(Info);
@@ -231,7 +335,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationActivated)
 #if 0
         ProcessPluginList(chunkwm_export_application_activated, Application);
 #else
-        ProcessPluginListThreaded(chunkwm_export_application_activated, Application);
+        PostPluginList(chunkwm_export_application_activated, Application);
 #endif
     }
 
@@ -249,7 +353,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationDeactivated)
 #if 0
         ProcessPluginList(chunkwm_export_application_deactivated, Application);
 #else
-        ProcessPluginListThreaded(chunkwm_export_application_deactivated, Application);
+        PostPluginList(chunkwm_export_application_deactivated, Application);
 #endif
     }
 
@@ -267,7 +371,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationVisible)
 #if 0
         ProcessPluginList(chunkwm_export_application_unhidden, Application);
 #else
-        ProcessPluginListThreaded(chunkwm_export_application_unhidden, Application);
+        PostPluginList(chunkwm_export_application_unhidden, Application);
 #endif
     }
 
@@ -285,7 +389,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_ApplicationHidden)
 #if 0
         ProcessPluginList(chunkwm_export_application_hidden, Application);
 #else
-        ProcessPluginListThreaded(chunkwm_export_application_hidden, Application);
+        PostPluginList(chunkwm_export_application_hidden, Application);
 #endif
     }
 
@@ -307,7 +411,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_SpaceChanged)
 #if 0
     ProcessPluginList(chunkwm_export_space_changed, NULL);
 #else
-    ProcessPluginListThreaded(chunkwm_export_space_changed, NULL);
+    PostPluginList(chunkwm_export_space_changed, NULL);
 #endif
 }
 
@@ -320,11 +424,10 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayAdded)
     c_log(C_LOG_LEVEL_DEBUG, "%d: display added\n", *DisplayId);
 #if 0
     ProcessPluginList(chunkwm_export_display_added, DisplayId);
+    free(DisplayId);
 #else
-    ProcessPluginListThreaded(chunkwm_export_display_added, DisplayId);
+    PostPluginList(chunkwm_export_display_added, DisplayId, &FreePayloadData);
 #endif
-
-    free(DisplayId);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayRemoved)
@@ -335,11 +438,10 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayRemoved)
     c_log(C_LOG_LEVEL_DEBUG, "%d: display removed\n", *DisplayId);
 #if 0
     ProcessPluginList(chunkwm_export_display_removed, DisplayId);
+    free(DisplayId);
 #else
-    ProcessPluginListThreaded(chunkwm_export_display_removed, DisplayId);
+    PostPluginList(chunkwm_export_display_removed, DisplayId, &FreePayloadData);
 #endif
-
-    free(DisplayId);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayMoved)
@@ -350,11 +452,10 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayMoved)
     c_log(C_LOG_LEVEL_DEBUG, "%d: display moved\n", *DisplayId);
 #if 0
     ProcessPluginList(chunkwm_export_display_moved, DisplayId);
+    free(DisplayId);
 #else
-    ProcessPluginListThreaded(chunkwm_export_display_moved, DisplayId);
+    PostPluginList(chunkwm_export_display_moved, DisplayId, &FreePayloadData);
 #endif
-
-    free(DisplayId);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayResized)
@@ -365,11 +466,10 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayResized)
     c_log(C_LOG_LEVEL_DEBUG, "%d: display resolution changed\n", *DisplayId);
 #if 0
     ProcessPluginList(chunkwm_export_display_resized, DisplayId);
+    free(DisplayId);
 #else
-    ProcessPluginListThreaded(chunkwm_export_display_resized, DisplayId);
+    PostPluginList(chunkwm_export_display_resized, DisplayId, &FreePayloadData);
 #endif
-
-    free(DisplayId);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayChanged)
@@ -387,7 +487,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_DisplayChanged)
 #if 0
     ProcessPluginList(chunkwm_export_space_changed, NULL);
 #else
-    ProcessPluginListThreaded(chunkwm_export_display_changed, NULL);
+    PostPluginList(chunkwm_export_display_changed, NULL);
 #endif
 }
 
@@ -402,7 +502,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowCreated)
 #if 0
         ProcessPluginList(chunkwm_export_window_created, Window);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_created, Window);
+        PostPluginWindow(chunkwm_export_window_created, Window);
 #endif
         /*
          * NOTE(koekeishiya): When a new window is created, we incorrectly
@@ -425,10 +525,10 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowDestroyed)
     c_log(C_LOG_LEVEL_DEBUG, "%s:%s:%d window destroyed\n", Window->Owner->Name, Window->Name, Window->Id);
 #if 0
     ProcessPluginList(chunkwm_export_window_destroyed, Window);
+    AXLibDestroyWindow(Window);
 #else
-    ProcessPluginListThreaded(chunkwm_export_window_destroyed, Window);
+    PostPluginList(chunkwm_export_window_destroyed, Window, &DestroyWindowPayload);
 #endif
-    AXLibDestroyWindow(Window);
 }
 
 CHUNKWM_CALLBACK(Callback_ChunkWM_WindowFocused)
@@ -449,7 +549,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowFocused)
 #if 0
             ProcessPluginList(chunkwm_export_window_focused, Window);
 #else
-            ProcessPluginListThreaded(chunkwm_export_window_focused, Window);
+            PostPluginWindow(chunkwm_export_window_focused, Window);
 #endif
         }
     } else {
@@ -471,7 +571,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowMoved)
 #if 0
         ProcessPluginList(chunkwm_export_window_moved, Window);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_moved, Window);
+        PostPluginWindow(chunkwm_export_window_moved, Window);
 #endif
     } else {
         c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s: __sync_bool_compare_and_swap failed\n", __FUNCTION__);
@@ -493,7 +593,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowResized)
 #if 0
         ProcessPluginList(chunkwm_export_window_resized, Window);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_resized, Window);
+        PostPluginWindow(chunkwm_export_window_resized, Window);
 #endif
     } else {
         c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s: __sync_bool_compare_and_swap failed\n", __FUNCTION__);
@@ -514,7 +614,7 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowMinimized)
 #if 0
         ProcessPluginList(chunkwm_export_window_minimized, Window);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_minimized, Window);
+        PostPluginWindow(chunkwm_export_window_minimized, Window);
 #endif
     } else {
         c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s: __sync_bool_compare_and_swap failed\n", __FUNCTION__);
@@ -529,14 +629,21 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowDeminimized)
     uint32_t Flags = Window->Flags;
     bool Result = __sync_bool_compare_and_swap(&Window->Flags, Flags, Flags);
     if (Result && !AXLibHasFlags(Window, Window_Invalid)) {
+        /*
+         * NOTE(koekeishiya): Copies of the window that are still queued for a plugin share the
+         * previous roles, which are therefore released once every plugin has handled this event.
+         */
+        window_roles *Roles = NULL;
         if (AXLibHasFlags(Window, Window_Init_Minimized)) {
+            Roles = (window_roles *) malloc(sizeof(window_roles));
+            Roles->Mainrole = Window->Mainrole;
+            Roles->Subrole = Window->Subrole;
+
             if (Window->Mainrole) {
-                CFRelease(Window->Mainrole);
                 AXLibGetWindowRole(Window->Ref, &Window->Mainrole);
             }
 
             if (Window->Subrole) {
-                CFRelease(Window->Subrole);
                 AXLibGetWindowSubrole(Window->Ref, &Window->Subrole);
             }
             AXLibClearFlags(Window, Window_Init_Minimized);
@@ -547,8 +654,13 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowDeminimized)
         AXLibClearFlags(Window, Window_Minimized);
 #if 0
         ProcessPluginList(chunkwm_export_window_deminimized, Window);
+        if (Roles) ReleaseWindowRoles(NULL, Roles);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_deminimized, Window);
+        if (Roles) {
+            PostPluginWindow(chunkwm_export_window_deminimized, Window, &ReleaseWindowRoles, Roles);
+        } else {
+            PostPluginWindow(chunkwm_export_window_deminimized, Window);
+        }
 #endif
 
         /*
@@ -565,7 +677,8 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowDeminimized)
 /*
  * NOTE(koekeishiya): If a plugin has stored a pointer to our macos_window structs
  * and tries to access the 'name' member outside of 'PLUGIN_MAIN_FUNC', there will
- * be a race condition. Doing so is considered an error..
+ * be a race condition. Doing so is considered an error.. The previous title is freed
+ * once every plugin has processed this event, as a plugin may still be reading it.
  */
 CHUNKWM_CALLBACK(Callback_ChunkWM_WindowTitleChanged)
 {
@@ -575,13 +688,14 @@ CHUNKWM_CALLBACK(Callback_ChunkWM_WindowTitleChanged)
     uint32_t Flags = Window->Flags;
     bool Result = __sync_bool_compare_and_swap(&Window->Flags, Flags, Flags);
     if (Result && !AXLibHasFlags(Window, Window_Invalid)) {
-        UpdateWindowTitle(Window);
+        char *Title = UpdateWindowTitle(Window);
 
         c_log(C_LOG_LEVEL_DEBUG, "%s:%s:%d window title changed\n", Window->Owner->Name, Window->Name, Window->Id);
 #if 0
         ProcessPluginList(chunkwm_export_window_title_changed, Window);
+        free(Title);
 #else
-        ProcessPluginListThreaded(chunkwm_export_window_title_changed, Window);
+        PostPluginWindow(chunkwm_export_window_title_changed, Window, &FreePayloadContext, Title);
 #endif
     } else {
         c_log(C_LOG_LEVEL_DEBUG, "chunkwm:%s: __sync_bool_compare_and_swap failed\n", __FUNCTION__);
@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <limits.h>
 #include <getopt.h>
 
 #include <execinfo.h>
@@ -16,9 +18,19 @@
 #include "dispatch/event.h"
 
 #include "hotloader.h"
+#include "histogram.h"
+#include "recorder.h"
 #include "state.h"
 #include "plugin.h"
-#include "wqueue.h"
+#include "pool.h"
+#include "mailbox.h"
+#include "epoch.h"
+#include "filter.h"
+#include "method.h"
+#include "watch.h"
+#include "host.h"
+#include "wakeup.h"
+#include "config.h"
 #include "cvar.h"
 #include "constants.h"
 
@@ -39,6 +51,7 @@
 
 #include "dispatch/carbon.cpp"
 #include "dispatch/workspace.mm"
+#include "dispatch/ring.cpp"
 #include "dispatch/event.cpp"
 #include "dispatch/display.cpp"
 
@@ -46,9 +59,20 @@
 #include "state.cpp"
 #include "callback.cpp"
 #include "plugin.cpp"
-#include "wqueue.cpp"
+#include "pool.cpp"
+#include "mailbox.cpp"
+#include "epoch.cpp"
+#include "filter.cpp"
+#include "method.cpp"
+#include "watch.cpp"
+#include "shmring.cpp"
+#include "host.cpp"
+#include "wakeup.cpp"
 #include "config.cpp"
 #include "cvar.cpp"
+#include "histogram.cpp"
+#include "trace.cpp"
+#include "recorder.cpp"
 
 #define internal static
 #define local_persist static
@@ -189,6 +213,10 @@ int main(int Count, char **Args)
         Fail("chunkwm: could not initialize event-loop! abort..\n");
     }
 
+    if (!BeginEventRecorder()) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: could not initialize event recorder, tracing disabled..\n");
+    }
+
     NSApplicationLoad();
     AXUIElementSetMessagingTimeout(SystemWideElement(), 1.0);
 
@@ -201,17 +229,34 @@ int main(int Count, char **Args)
         Fail("chunkwm: config '%s' not found!\n", ConfigFile);
     }
 
-    // NOTE(koekeishiya): The config file is just an executable bash script!
-    ForkExecWait(ConfigFile);
+    if (IsNativeConfig(ConfigFile)) {
+        LoadNativeConfig(ConfigFile);
+    } else {
+        // NOTE(koekeishiya): The config file is just an executable bash script!
+        ForkExecWait(ConfigFile);
+    }
 
     if (!InitState()) {
         Fail("chunkwm: failed to initialize critical mutex! abort..\n");
     }
 
-    if (!BeginCallbackThreads(CHUNKWM_THREAD_COUNT)) {
-        c_log(C_LOG_LEVEL_WARN, "chunkwm: could not get semaphore, callback multi-threading disabled..\n");
+    // NOTE(koekeishiya): Read thread count from cvar, zero means one thread per processor.
+    int ThreadCount = CVarIntegerValue(CVAR_THREAD_COUNT);
+    if (ThreadCount <= 0) {
+        ThreadCount = ThreadPoolDefaultThreadCount();
     }
 
+    if (!BeginCallbackThreads(ThreadCount)) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: could not start all %d callback threads..\n", ThreadCount);
+    }
+
+    if (!BeginPluginWatchdog()) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: could not start plugin watchdog..\n");
+    }
+
+    // NOTE(koekeishiya): Load the plugins that the config-file queued, see 'QueueStartupPlugin'.
+    LoadStartupPlugins();
+
     if (!BeginCarbonEventHandler(&Carbon)) {
         Fail("chunkwm: failed to install carbon eventhandler! abort..\n");
     }
@@ -220,10 +265,11 @@ int main(int Count, char **Args)
         c_log(C_LOG_LEVEL_WARN, "chunkwm: could not register for display notifications..\n");
     }
 
-    // NOTE(koekeishiya): Read plugin directory from cvar.
-    char *PluginDirectory = CVarStringValue(CVAR_PLUGIN_DIR);
-    if (PluginDirectory && CVarIntegerValue(CVAR_PLUGIN_HOTLOAD)) {
-        HotloaderAddPath(PluginDirectory);
+    // NOTE(koekeishiya): Read plugin directory from cvar. The hotloader keeps the path until we exit.
+    char PluginDirectory[PATH_MAX];
+    if (CVarStringValue(CVAR_PLUGIN_DIR, PluginDirectory, sizeof(PluginDirectory)) &&
+        CVarIntegerValue(CVAR_PLUGIN_HOTLOAD)) {
+        HotloaderAddPath(strdup(PluginDirectory));
         HotloaderInit();
     }
 
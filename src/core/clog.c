@@ -15,12 +15,18 @@ void c_log(enum c_log_level level, const char *format, ...)
     va_list args;
     time_t time_epoch;
     char time_buffer[32];
-    struct tm *local_time;
+    struct tm local_time;
 
+    /*
+     * NOTE(koekeishiya): Plugins, the pool threads and the watchdog log concurrently.
+     * Keep the prefix and the message of a single line together.
+     */
     if (level >= c_log_active_level) {
         time_epoch = time(NULL);
-        local_time = localtime(&time_epoch);
-        time_buffer[strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", local_time)] = '\0';
+        localtime_r(&time_epoch, &local_time);
+        time_buffer[strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &local_time)] = '\0';
+
+        flockfile(c_log_output_file);
         fprintf(c_log_output_file, "%s %-5s: ", time_buffer, c_log_level_str[level]);
 
         va_start(args, format);
@@ -28,5 +34,6 @@ void c_log(enum c_log_level level, const char *format, ...)
         va_end(args);
 
         fflush(c_log_output_file);
+        funlockfile(c_log_output_file);
     }
 }
@@ -1,5 +1,7 @@
 #include "config.h"
 #include "plugin.h"
+#include "filter.h"
+#include "host.h"
 #include "clog.h"
 
 #include "../common/config/tokenize.h"
@@ -7,6 +9,7 @@
 #include "../common/ipc/daemon.h"
 
 #include "dispatch/event.h"
+#include "recorder.h"
 
 #include "constants.h"
 #include "cvar.h"
@@ -14,6 +17,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
 
 #define internal static
 
@@ -68,9 +78,9 @@ PopulatePluginPath(const char **Message, plugin_fs *PluginFs)
 {
     char *Absolutepath, *Filename;
     token Token = GetToken(Message);
-    char *Directory = CVarStringValue(CVAR_PLUGIN_DIR);
+    char Directory[PATH_MAX];
 
-    if (Directory) {
+    if (CVarStringValue(CVAR_PLUGIN_DIR, Directory, sizeof(Directory))) {
         Filename = TokenToString(Token);
         Absolutepath = PluginAbsolutepathFromDirectory(Filename, Directory);
         if (!Absolutepath) {
@@ -116,8 +126,271 @@ ChunkwmDaemonDelegate(const char *Message, chunkwm_delegate *Delegate)
 }
 
 internal void
+WriteCoalesceStats(int SockFD)
+{
+    char Buffer[256];
+    for (int Index = 0; Index < ChunkWM_EventTypeCount; ++Index) {
+        event_type Type = (event_type) Index;
+        if (!EventTypeCoalesces(Type)) continue;
+
+        event_coalesce_stats Stats = EventCoalesceStats(Type);
+        snprintf(Buffer, sizeof(Buffer), "%s queued %llu coalesced %llu\n",
+                 EventTypeName(Type),
+                 (unsigned long long) Stats.Queued,
+                 (unsigned long long) Stats.Coalesced);
+        WriteToSocket(Buffer, SockFD);
+    }
+}
+
+internal void
+WriteMailboxStats(int SockFD)
+{
+    char Buffer[256];
+    loaded_plugin_list *List = BeginLoadedPluginList();
+
+    for (loaded_plugin_list_iter It = List->begin();
+         It != List->end();
+         ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        plugin_mailbox_stats Stats = PluginMailboxStats(LoadedPlugin->Mailbox);
+        snprintf(Buffer, sizeof(Buffer), "%s depth %u max %u delivered %llu\n",
+                 LoadedPlugin->Info->PluginName,
+                 Stats.Depth,
+                 Stats.MaxDepth,
+                 (unsigned long long) Stats.Delivered);
+        WriteToSocket(Buffer, SockFD);
+    }
+
+    EndLoadedPluginList();
+}
+
+internal void
+WritePluginStats(int SockFD)
+{
+    char Buffer[256];
+    loaded_plugin_list *List = BeginLoadedPluginList();
+
+    for (loaded_plugin_list_iter It = List->begin();
+         It != List->end();
+         ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        snprintf(Buffer, sizeof(Buffer), "%s\n", LoadedPlugin->Info->PluginName);
+        WriteToSocket(Buffer, SockFD);
+
+        for (int Index = 0; Index < MAILBOX_STATS_COUNT; ++Index) {
+            plugin_export_stats Stats = PluginExportStats(LoadedPlugin->Mailbox, Index);
+            if (!Stats.Calls) continue;
+
+            snprintf(Buffer, sizeof(Buffer), "    %-40s calls %8llu  cpu %10.2fms  avg %10.1fus  max %10.1fus  over budget %llu\n",
+                     PluginExportStatsName(Index),
+                     (unsigned long long) Stats.Calls,
+                     Stats.CpuTime / 1000000.0,
+                     Stats.TotalLatency / 1000.0 / Stats.Calls,
+                     Stats.MaxLatency / 1000.0,
+                     (unsigned long long) Stats.OverBudget);
+            WriteToSocket(Buffer, SockFD);
+        }
+    }
+
+    EndLoadedPluginList();
+}
+
+internal void
+WriteHostStats(int SockFD)
+{
+    char Buffer[256];
+    loaded_plugin_list *List = BeginLoadedPluginList();
+
+    for (loaded_plugin_list_iter It = List->begin();
+         It != List->end();
+         ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        if (!LoadedPlugin->Host) continue;
+
+        plugin_host_stats Stats = PluginHostStats(LoadedPlugin->Host);
+        snprintf(Buffer, sizeof(Buffer), "%s pid %d posted %llu dropped %llu%s\n",
+                 LoadedPlugin->Info->PluginName,
+                 LoadedPlugin->Host->PID,
+                 (unsigned long long) Stats.Posted,
+                 (unsigned long long) Stats.Dropped,
+                 Stats.Exited ? " exited" : "");
+        WriteToSocket(Buffer, SockFD);
+    }
+
+    EndLoadedPluginList();
+}
+
+internal void
+WriteFilterStats(int SockFD)
+{
+    char Buffer[256];
+    loaded_plugin_list *List = BeginLoadedPluginList();
+
+    for (loaded_plugin_list_iter It = List->begin();
+         It != List->end();
+         ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        for (uint32_t Index = 0; Index < LoadedPlugin->FilterCount; ++Index) {
+            plugin_filter *Filter = LoadedPlugin->Filters + Index;
+            snprintf(Buffer, sizeof(Buffer), "%s %s hit %llu miss %llu\n",
+                     LoadedPlugin->Info->PluginName,
+                     chunkwm_plugin_export_str[Filter->Export],
+                     (unsigned long long) __atomic_load_n(&Filter->Hits, __ATOMIC_RELAXED),
+                     (unsigned long long) __atomic_load_n(&Filter->Misses, __ATOMIC_RELAXED));
+            WriteToSocket(Buffer, SockFD);
+        }
+    }
+
+    EndLoadedPluginList();
+}
+
+internal void
+WriteStartupTimeline(int SockFD)
+{
+    char Buffer[256];
+    plugin_load_timeline *Timeline = GetStartupTimeline();
+    if (!Timeline) {
+        WriteToSocket("plugins are still loading\n", SockFD);
+        return;
+    }
+
+    snprintf(Buffer, sizeof(Buffer), "loaded %u plugins in %.2fms\n",
+             Timeline->Count, Timeline->Elapsed / 1000000.0);
+    WriteToSocket(Buffer, SockFD);
+
+    for (uint32_t Index = 0; Index < Timeline->Count; ++Index) {
+        FormatPluginLoadTiming(Timeline->Plugins + Index, Buffer, sizeof(Buffer));
+        WriteToSocket(Buffer, SockFD);
+    }
+}
+
+internal void
+WriteHistogram(const char *Label, latency_histogram *Histogram, int SockFD)
+{
+    char Buffer[256];
+    snprintf(Buffer, sizeof(Buffer), "    %-10s p50 %10.1fus  p90 %10.1fus  p99 %10.1fus  max %10.1fus\n",
+             Label,
+             HistogramPercentile(Histogram, 50.0) / 1000.0,
+             HistogramPercentile(Histogram, 90.0) / 1000.0,
+             HistogramPercentile(Histogram, 99.0) / 1000.0,
+             HistogramMax(Histogram) / 1000.0);
+    WriteToSocket(Buffer, SockFD);
+}
+
+internal void
+WriteEventStats(int SockFD)
+{
+    char Buffer[256];
+    for (int Index = 0; Index < ChunkWM_EventTypeCount; ++Index) {
+        event_type Type = (event_type) Index;
+        event_latency *Latency = EventLatency(Type);
+
+        uint64_t Count = HistogramCount(&Latency->Total);
+        if (!Count) continue;
+
+        snprintf(Buffer, sizeof(Buffer), "%s count %llu\n", EventTypeName(Type), (unsigned long long) Count);
+        WriteToSocket(Buffer, SockFD);
+        WriteHistogram("queue", &Latency->QueueWait, SockFD);
+        WriteHistogram("handler", &Latency->Handler, SockFD);
+        WriteHistogram("total", &Latency->Total, SockFD);
+    }
+}
+
+internal void
+HandleStats(const char **Message, int SockFD)
+{
+    token Token = GetToken(Message);
+    if (TokenEquals(Token, "reset")) {
+        ResetEventLatency();
+    } else {
+        WriteEventStats(SockFD);
+    }
+}
+
+internal void
+HandleEventPriority(const char **Message)
+{
+    token TypeToken = GetToken(Message);
+    token PriorityToken = GetToken(Message);
+
+    char *Name = TokenToString(TypeToken);
+    event_type Type;
+
+    if (EventTypeFromName(Name, &Type)) {
+        if (TokenEquals(PriorityToken, "interactive")) {
+            SetEventPriority(Type, Event_Priority_Interactive);
+        } else if (TokenEquals(PriorityToken, "structural")) {
+            SetEventPriority(Type, Event_Priority_Structural);
+        } else if (TokenEquals(PriorityToken, "background")) {
+            SetEventPriority(Type, Event_Priority_Background);
+        } else {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: invalid event priority '%.*s'\n", PriorityToken.Length, PriorityToken.Text);
+        }
+    } else {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: invalid event type '%s'\n", Name);
+    }
+
+    free(Name);
+}
+
+// NOTE(koekeishiya): A hosted plugin runs in a plugin host from then on, see 'MarkPluginHosted'.
+internal void
+LoadPluginFromMessage(const char **Message, bool Hosted)
+{
+    plugin_fs *PluginFS = (plugin_fs *) malloc(sizeof(plugin_fs));
+    if (PopulatePluginPath(Message, PluginFS)) {
+        struct stat Buffer;
+        if (lstat(PluginFS->Absolutepath, &Buffer) == 0) {
+            if (S_ISLNK(Buffer.st_mode)) {
+                char *ResolvedPath = (char *) malloc(PATH_MAX);
+                realpath(PluginFS->Absolutepath, ResolvedPath);
+                free(PluginFS->Absolutepath);
+                PluginFS->Absolutepath = ResolvedPath;
+            }
+            if (Hosted) {
+                MarkPluginHosted(PluginFS->Filename);
+            }
+            if (!QueueStartupPlugin(PluginFS)) {
+                ConstructEvent(ChunkWM_PluginLoad, PluginFS);
+            }
+        } else {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' not found..\n", PluginFS->Absolutepath);
+            DestroyPluginFS(PluginFS);
+            free(PluginFS);
+        }
+    } else {
+        free(PluginFS);
+    }
+}
+
+internal void
+HandleTrace(const char **Message, int SockFD)
+{
+    token Token = GetToken(Message);
+    if (TokenEquals(Token, "start")) {
+        token PathToken = GetToken(Message);
+        if (PathToken.Length > 0) {
+            char *Path = TokenToString(PathToken);
+            if (!StartEventRecording(Path)) {
+                WriteToSocket("could not open trace file\n", SockFD);
+            }
+            free(Path);
+        } else {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: missing path for 'core::trace start'\n");
+        }
+    } else if (TokenEquals(Token, "stop")) {
+        char Buffer[64];
+        snprintf(Buffer, sizeof(Buffer), "%llu events recorded\n", (unsigned long long) StopEventRecording());
+        WriteToSocket(Buffer, SockFD);
+    } else {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: invalid command 'core::trace %.*s'\n", Token.Length, Token.Text);
+    }
+}
+
+internal bool
 HandleCore(chunkwm_delegate *Delegate)
 {
+    bool Result = true;
     if (StringEquals(Delegate->Command, CVAR_PLUGIN_DIR)) {
         token Token = GetToken(&Delegate->Message);
         char *Directory = TokenToString(Token);
@@ -127,6 +400,15 @@ HandleCore(chunkwm_delegate *Delegate)
         token Token = GetToken(&Delegate->Message);
         int Status = TokenToInt(Token);
         UpdateCVar(CVAR_PLUGIN_HOTLOAD, Status);
+    } else if (StringEquals(Delegate->Command, CVAR_THREAD_COUNT)) {
+        token Token = GetToken(&Delegate->Message);
+        int Count = TokenToInt(Token);
+        UpdateCVar(CVAR_THREAD_COUNT, Count);
+    } else if (StringEquals(Delegate->Command, CVAR_PLUGIN_BUDGET)) {
+        token Token = GetToken(&Delegate->Message);
+        int Budget = TokenToInt(Token);
+        UpdateCVar(CVAR_PLUGIN_BUDGET, Budget);
+        SetPluginBudget(Budget > 0 ? Budget : 0);
     } else if (StringEquals(Delegate->Command, CVAR_LOG_FILE)) {
         if (c_log_output_file == stdout) {
             token Token = GetToken(&Delegate->Message);
@@ -154,26 +436,15 @@ HandleCore(chunkwm_delegate *Delegate)
         } else if (TokenEquals(Token, "error")) {
             c_log_active_level = C_LOG_LEVEL_ERROR;
         }
+    } else if (StringEquals(Delegate->Command, CVAR_PLUGIN_HOST)) {
+        token Token = GetToken(&Delegate->Message);
+        char *Path = TokenToString(Token);
+        UpdateCVar(CVAR_PLUGIN_HOST, Path);
+        free(Path);
     } else if (StringEquals(Delegate->Command, "load")) {
-        plugin_fs *PluginFS = (plugin_fs *) malloc(sizeof(plugin_fs));
-        if (PopulatePluginPath(&Delegate->Message, PluginFS)) {
-            struct stat Buffer;
-            if (lstat(PluginFS->Absolutepath, &Buffer) == 0) {
-                if (S_ISLNK(Buffer.st_mode)) {
-                    char *ResolvedPath = (char *) malloc(PATH_MAX);
-                    realpath(PluginFS->Absolutepath, ResolvedPath);
-                    free(PluginFS->Absolutepath);
-                    PluginFS->Absolutepath = ResolvedPath;
-                }
-                ConstructEvent(ChunkWM_PluginLoad, PluginFS);
-            } else {
-                c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' not found..\n", PluginFS->Absolutepath);
-                DestroyPluginFS(PluginFS);
-                free(PluginFS);
-            }
-        } else {
-            free(PluginFS);
-        }
+        LoadPluginFromMessage(&Delegate->Message, false);
+    } else if (StringEquals(Delegate->Command, "load_hosted")) {
+        LoadPluginFromMessage(&Delegate->Message, true);
     } else if (StringEquals(Delegate->Command, "unload")) {
         plugin_fs *PluginFS = (plugin_fs *) malloc(sizeof(plugin_fs));
         if (PopulatePluginPath(&Delegate->Message, PluginFS)) {
@@ -181,14 +452,34 @@ HandleCore(chunkwm_delegate *Delegate)
         } else {
             free(PluginFS);
         }
+    } else if (StringEquals(Delegate->Command, "coalesce_stats")) {
+        WriteCoalesceStats(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "mailbox_stats")) {
+        WriteMailboxStats(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "plugin_stats")) {
+        WritePluginStats(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "filter_stats")) {
+        WriteFilterStats(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "host_stats")) {
+        WriteHostStats(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "startup_timeline")) {
+        WriteStartupTimeline(Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "stats")) {
+        HandleStats(&Delegate->Message, Delegate->SockFD);
+    } else if (StringEquals(Delegate->Command, "event_priority")) {
+        HandleEventPriority(&Delegate->Message);
+    } else if (StringEquals(Delegate->Command, "trace")) {
+        HandleTrace(&Delegate->Message, Delegate->SockFD);
     } else {
         c_log(C_LOG_LEVEL_WARN, "chunkwm: invalid command '%s::%s'\n", Delegate->Target, Delegate->Command);
+        Result = false;
     }
 
     CloseSocket(Delegate->SockFD);
     free(Delegate->Target);
     free(Delegate->Command);
     free(Delegate);
+    return Result;
 }
 
 internal inline bool
@@ -198,56 +489,66 @@ ValidToken(token *Token)
     return Result;
 }
 
-internal void
+internal bool
 SetCVar(const char **Message)
 {
     token NameToken = GetToken(Message);
-    if (ValidToken(&NameToken)) {
-        token ValueToken = GetToken(Message);
-        if (ValidToken(&ValueToken)) {
-            char *Name = TokenToString(NameToken);
-            char *Value = TokenToString(ValueToken);
-            UpdateCVar(Name, Value);
-            free(Name);
-            free(Value);
-        } else {
-            c_log(C_LOG_LEVEL_WARN, "chunkwm: missing value for cvar '%.*s'.\n", NameToken.Length, NameToken.Length);
-        }
-    } else {
+    if (!ValidToken(&NameToken)) {
         c_log(C_LOG_LEVEL_WARN, "chunkwm: missing cvar name.\n");
+        return false;
     }
+
+    token ValueToken = GetToken(Message);
+    if (!ValidToken(&ValueToken)) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: missing value for cvar '%.*s'.\n", NameToken.Length, NameToken.Text);
+        return false;
+    }
+
+    char *Name = TokenToString(NameToken);
+    char *Value = TokenToString(ValueToken);
+    UpdateCVar(Name, Value);
+    free(Name);
+    free(Value);
+    return true;
 }
 
-internal void
+internal bool
 GetCVar(const char **Message, int SockFD)
 {
     token NameToken = GetToken(Message);
-    if (ValidToken(&NameToken)) {
-        char *Name = TokenToString(NameToken);
-        char *Value = CVarStringValue(Name);
-        WriteToSocket(Value, SockFD);
-        free(Name);
-    } else {
+    if (!ValidToken(&NameToken)) {
         c_log(C_LOG_LEVEL_WARN, "chunkwm: missing cvar name.\n");
+        return false;
     }
+
+    char *Name = TokenToString(NameToken);
+    uint64_t Read = BeginCVarReadAPI();
+    WriteToSocket(AcquireCVarAPI(Name), SockFD);
+    EndCVarReadAPI(Read);
+    free(Name);
+    return true;
 }
 
-internal void
+internal bool
 HandleCVar(chunkwm_delegate *Delegate, const char **Message)
 {
+    bool Result = false;
     token Type = GetToken(Message);
     if (TokenEquals(Type, "set")) {
-        SetCVar(Message);
+        Result = SetCVar(Message);
     } else if (TokenEquals(Type, "get")) {
-        GetCVar(Message, Delegate->SockFD);
+        Result = GetCVar(Message, Delegate->SockFD);
     } else {
         c_log(C_LOG_LEVEL_WARN, "chunkwm: invalid command '%.*s %s'\n", Type.Length, Type.Text, *Message);
     }
     CloseSocket(Delegate->SockFD);
     free(Delegate);
+    return Result;
 }
 
-DAEMON_CALLBACK(DaemonCallback)
+// NOTE(koekeishiya): Returns false if the message is not a command, a cvar get or a cvar set.
+internal bool
+HandleDaemonMessage(const char *Message, int SockFD)
 {
     chunkwm_delegate *Delegate = (chunkwm_delegate *) malloc(sizeof(chunkwm_delegate));
     memset(Delegate, 0, sizeof(chunkwm_delegate));
@@ -255,11 +556,251 @@ DAEMON_CALLBACK(DaemonCallback)
 
     if (ChunkwmDaemonDelegate(Message, Delegate)) {
         if (StringEquals(Delegate->Target, "core")) {
-            HandleCore(Delegate);
+            return HandleCore(Delegate);
         } else {
             ConstructEvent(ChunkWM_PluginCommand, Delegate);
+            return true;
         }
     } else {
-        HandleCVar(Delegate, &Message);
+        return HandleCVar(Delegate, &Message);
+    }
+}
+
+DAEMON_CALLBACK(DaemonCallback)
+{
+    HandleDaemonMessage(Message, SockFD);
+}
+
+// NOTE(koekeishiya): Caller is responsible for freeing memory of returned pointer
+internal char *
+ReadConfigFile(const char *ConfigFile)
+{
+    FILE *Handle = fopen(ConfigFile, "r");
+    if (!Handle) return NULL;
+
+    fseek(Handle, 0, SEEK_END);
+    long Length = ftell(Handle);
+    fseek(Handle, 0, SEEK_SET);
+
+    char *Contents = NULL;
+    if (Length >= 0) {
+        Contents = (char *) malloc(Length + 1);
+        size_t BytesRead = fread(Contents, 1, Length, Handle);
+        Contents[BytesRead] = '\0';
+    }
+
+    fclose(Handle);
+    return Contents;
+}
+
+internal void
+TrimConfigLine(char *Line)
+{
+    size_t Length = strlen(Line);
+    while (Length && (Line[Length - 1] == ' ' || Line[Length - 1] == '\t' ||
+                      Line[Length - 1] == '\r' || Line[Length - 1] == '\n')) {
+        Line[--Length] = '\0';
+    }
+}
+
+bool IsNativeConfig(const char *ConfigFile)
+{
+    FILE *Handle = fopen(ConfigFile, "r");
+    if (!Handle) return false;
+
+    char Line[MAX_LEN];
+    bool Result = fgets(Line, sizeof(Line), Handle) != NULL;
+    if (Result) {
+        TrimConfigLine(Line);
+        Result = StringEquals(Line, CHUNKWM_NATIVE_CONFIG);
+    }
+
+    fclose(Handle);
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): A line of a native config is given one end of a socket pair in place of the
+ * connection of chunkc, and whatever it answers is logged with its line number once the end has
+ * been closed. Core commands and cvars close it before 'HandleDaemonMessage' returns, plugin
+ * commands when the plugin has handled them, after the event-loop has started.
+ */
+struct config_response
+{
+    int SockFD;
+    int Line;
+    char *Text;
+    size_t Length;
+};
+
+struct config_responses
+{
+    char *ConfigFile;
+    config_response *Responses;
+    int Count;
+};
+
+internal bool
+CreateConfigResponse(int *Ends)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, Ends) == -1) return false;
+    fcntl(Ends[0], F_SETFD, FD_CLOEXEC);
+    fcntl(Ends[1], F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+internal void
+LogConfigResponse(const char *ConfigFile, config_response *Response)
+{
+    if (Response->Text) {
+        while (Response->Length && Response->Text[Response->Length - 1] == '\n') {
+            --Response->Length;
+        }
+
+        if (Response->Length) {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: config '%s' line %d: %.*s\n",
+                  ConfigFile, Response->Line, (int) Response->Length, Response->Text);
+        }
+
+        free(Response->Text);
+    }
+
+    close(Response->SockFD);
+}
+
+internal void
+DestroyConfigResponses(config_responses *Responses)
+{
+    free(Responses->ConfigFile);
+    free(Responses->Responses);
+    free(Responses);
+}
+
+internal void *
+LogConfigResponses(void *Context)
+{
+    config_responses *Responses = (config_responses *) Context;
+    struct pollfd *Fds = (struct pollfd *) malloc(sizeof(struct pollfd) * Responses->Count);
+    for (int Index = 0; Index < Responses->Count; ++Index) {
+        Fds[Index].fd = Responses->Responses[Index].SockFD;
+        Fds[Index].events = POLLIN;
+        Fds[Index].revents = 0;
+    }
+
+    int Open = Responses->Count;
+    while (Open) {
+        if (poll(Fds, Responses->Count, -1) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int Index = 0; Index < Responses->Count; ++Index) {
+            if ((Fds[Index].fd == -1) || (!Fds[Index].revents)) continue;
+
+            config_response *Response = Responses->Responses + Index;
+            char Buffer[512];
+            ssize_t BytesRead = recv(Response->SockFD, Buffer, sizeof(Buffer), 0);
+            if (BytesRead > 0) {
+                Response->Text = (char *) realloc(Response->Text, Response->Length + BytesRead);
+                memcpy(Response->Text + Response->Length, Buffer, BytesRead);
+                Response->Length += BytesRead;
+            } else if ((BytesRead == 0) || (errno != EINTR)) {
+                LogConfigResponse(Responses->ConfigFile, Response);
+                Fds[Index].fd = -1;
+                --Open;
+            }
+        }
     }
+
+    for (int Index = 0; Index < Responses->Count; ++Index) {
+        if (Fds[Index].fd != -1) LogConfigResponse(Responses->ConfigFile, Responses->Responses + Index);
+    }
+
+    free(Fds);
+    DestroyConfigResponses(Responses);
+    return NULL;
+}
+
+internal void
+BeginConfigResponses(config_responses *Responses)
+{
+    pthread_t Thread;
+    if (Responses->Count && pthread_create(&Thread, NULL, &LogConfigResponses, Responses) == 0) {
+        pthread_detach(Thread);
+        return;
+    }
+
+    for (int Index = 0; Index < Responses->Count; ++Index) {
+        close(Responses->Responses[Index].SockFD);
+    }
+    DestroyConfigResponses(Responses);
+}
+
+/*
+ * NOTE(koekeishiya): Each line goes through 'HandleDaemonMessage', so the config-file can do
+ * anything chunkc can. Answers are logged, see 'config_response', and lines that are not a
+ * command or a cvar are reported. Plugin commands are queued as events, and are delivered once
+ * the event-loop starts, after the plugins are loaded.
+ */
+bool LoadNativeConfig(const char *ConfigFile)
+{
+    char *Contents = ReadConfigFile(ConfigFile);
+    if (!Contents) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not read config '%s'!\n", ConfigFile);
+        return false;
+    }
+
+    int LineCount = 1;
+    for (char *Cursor = Contents; *Cursor; ++Cursor) {
+        if (*Cursor == '\n') ++LineCount;
+    }
+
+    config_responses *Responses = (config_responses *) malloc(sizeof(config_responses));
+    Responses->ConfigFile = strdup(ConfigFile);
+    Responses->Responses = (config_response *) malloc(sizeof(config_response) * LineCount);
+    Responses->Count = 0;
+
+    int Count = 0;
+    int Failed = 0;
+    int LineNumber = 0;
+    char *Line = Contents;
+    while (Line) {
+        char *Next = strchr(Line, '\n');
+        if (Next) *Next++ = '\0';
+        ++LineNumber;
+
+        while (*Line == ' ' || *Line == '\t') ++Line;
+        TrimConfigLine(Line);
+
+        if (*Line && *Line != '#') {
+            int Ends[2];
+            if (!CreateConfigResponse(Ends)) {
+                c_log(C_LOG_LEVEL_ERROR, "chunkwm: config '%s' line %d: could not create socket, skipped!\n",
+                      ConfigFile, LineNumber);
+                ++Failed;
+            } else {
+                config_response *Response = Responses->Responses + Responses->Count++;
+                Response->SockFD = Ends[0];
+                Response->Line = LineNumber;
+                Response->Text = NULL;
+                Response->Length = 0;
+
+                if (HandleDaemonMessage(Line, Ends[1])) {
+                    ++Count;
+                } else {
+                    c_log(C_LOG_LEVEL_WARN, "chunkwm: config '%s' line %d: could not parse '%s'\n",
+                          ConfigFile, LineNumber, Line);
+                    ++Failed;
+                }
+            }
+        }
+
+        Line = Next;
+    }
+
+    BeginConfigResponses(Responses);
+
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: applied %d lines of config '%s', %d failed\n", Count, ConfigFile, Failed);
+    free(Contents);
+    return true;
 }
@@ -9,4 +9,13 @@ struct chunkwm_delegate
     const char *Message;
 };
 
+/*
+ * NOTE(koekeishiya): A config-file that starts with the line '#chunkwm' is read by chunkwm
+ * itself, instead of being run by bash. Every other line is a message the way chunkc sends it,
+ * e.g. 'core::load tiling.so' or 'set global_desktop_mode bsp', and is applied in order, as if
+ * it was received by the daemon. Empty lines and lines that start with '#' are skipped.
+ */
+bool IsNativeConfig(const char *ConfigFile);
+bool LoadNativeConfig(const char *ConfigFile);
+
 #endif
@@ -7,14 +7,18 @@
 #define CHUNKWM_MINOR           3
 #define CHUNKWM_PATCH           3
 
-#define CHUNKWM_THREAD_COUNT    4
-
 #define CHUNKWM_CONFIG          ".chunkwmrc"
+#define CHUNKWM_NATIVE_CONFIG   "#chunkwm"
 #define CHUNKWM_PORT            3920
 
 #define CVAR_PLUGIN_DIR         "plugin_dir"
 #define CVAR_PLUGIN_HOTLOAD     "hotload"
 #define CVAR_LOG_LEVEL          "log_level"
 #define CVAR_LOG_FILE           "log_file"
+#define CVAR_THREAD_COUNT       "thread_count"
+#define CVAR_PLUGIN_BUDGET      "plugin_budget"
+#define CVAR_PLUGIN_HOST        "plugin_host"
+
+#define PLUGIN_HOST_DEFAULT     "chunkwm-host"
 
 #endif
@@ -1,22 +1,124 @@
 #include "cvar.h"
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <pthread.h>
 
+#include <vector>
+
 #include "../common/misc/assert.h"
 
 #define internal static
 
 extern chunkwm_api API;
 
-internal cvar_map CVars;
+#define CVAR_TABLE_CAPACITY 128
+
+internal cvar_table *volatile CVars;
+internal cvar_table *RetiredCVarTables;
 internal pthread_mutex_t CVarsLock;
+internal epoch_domain CVarEpoch;
+internal cvar_changed_hook *volatile CVarChangedHook;
+internal std::vector<cvar *> ChangedCVars;
+
+// NOTE(koekeishiya): FNV-1a
+internal uint32_t
+_HashCVarName(const char *Name)
+{
+    uint32_t Hash = 2166136261u;
+    while (*Name) {
+        Hash ^= (uint8_t) *Name++;
+        Hash *= 16777619u;
+    }
+    return Hash;
+}
 
+internal cvar_table *
+_CreateCVarTable(uint32_t Capacity)
+{
+    cvar_table *Table = (cvar_table *) malloc(sizeof(cvar_table) + Capacity * sizeof(cvar *));
+    Table->Capacity = Capacity;
+    Table->Count = 0;
+    Table->Slots = (cvar *volatile *) (Table + 1);
+    Table->Retired = NULL;
+    memset((void *) Table->Slots, 0, Capacity * sizeof(cvar *));
+    return Table;
+}
+
+// NOTE(koekeishiya): Slots are only ever filled, never cleared, so a probe ends at the first empty one.
 internal cvar *
 _FindCVar(const char *Name)
 {
-    cvar_map_it It = CVars.find(Name);
-    return It != CVars.end() ? It->second : NULL;
+    cvar_table *Table = __atomic_load_n(&CVars, __ATOMIC_ACQUIRE);
+    uint32_t Hash = _HashCVarName(Name);
+    uint32_t Mask = Table->Capacity - 1;
+
+    for (uint32_t Index = Hash & Mask;; Index = (Index + 1) & Mask) {
+        cvar *Var = __atomic_load_n(&Table->Slots[Index], __ATOMIC_ACQUIRE);
+        if (!Var) return NULL;
+        if ((Var->Hash == Hash) && (strcmp(Var->Name, Name) == 0)) return Var;
+    }
+}
+
+// NOTE(koekeishiya): Must be called with 'CVarsLock' held, or before the table is published.
+internal void
+_PlaceCVar(cvar_table *Table, cvar *Var)
+{
+    uint32_t Mask = Table->Capacity - 1;
+    uint32_t Index = Var->Hash & Mask;
+    while (Table->Slots[Index]) {
+        Index = (Index + 1) & Mask;
+    }
+
+    __atomic_store_n(&Table->Slots[Index], Var, __ATOMIC_RELEASE);
+    ++Table->Count;
+}
+
+/*
+ * NOTE(koekeishiya): Parses the value the same way as the CVar*Value functions used to, on
+ * every read. Must be called with 'CVarsLock' held, or before the cvar is published.
+ */
+internal void
+_StoreCVarNumbers(cvar *Var, const char *String)
+{
+    int Integer = 0;
+    unsigned Unsigned = 0;
+    float FloatingPoint = 0.0f;
+
+    sscanf(String, "%d", &Integer);
+    sscanf(String, "%x", &Unsigned);
+    sscanf(String, "%f", &FloatingPoint);
+
+    uint32_t Sequence = Var->Sequence;
+    __atomic_store_n(&Var->Sequence, Sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&Var->Integer, Integer, __ATOMIC_RELAXED);
+    __atomic_store_n(&Var->Unsigned, Unsigned, __ATOMIC_RELAXED);
+    __atomic_store(&Var->FloatingPoint, &FloatingPoint, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&Var->Sequence, Sequence + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * NOTE(koekeishiya): Retries while an update is writing the numbers. Updates are rare and
+ * short, and never wait for readers, so a reader retries at most a few times.
+ */
+internal void
+_LoadCVarNumbers(cvar *Var, int *Integer, unsigned *Unsigned, float *FloatingPoint)
+{
+    for (;;) {
+        uint32_t Sequence = __atomic_load_n(&Var->Sequence, __ATOMIC_ACQUIRE);
+        if (Sequence & 1) continue;
+
+        *Integer = __atomic_load_n(&Var->Integer, __ATOMIC_RELAXED);
+        *Unsigned = __atomic_load_n(&Var->Unsigned, __ATOMIC_RELAXED);
+        __atomic_load(&Var->FloatingPoint, FloatingPoint, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&Var->Sequence, __ATOMIC_RELAXED) == Sequence) break;
+    }
 }
 
 internal cvar *
@@ -25,62 +127,248 @@ _CreateCVar(const char *Name, char *Value)
     cvar *Var = (cvar *) malloc(sizeof(cvar));
 
     Var->Name = strdup(Name);
+    Var->Hash = _HashCVarName(Name);
     Var->Value = strdup(Value);
+    Var->Sequence = 0;
+    _StoreCVarNumbers(Var, Value);
 
     return Var;
 }
 
+/*
+ * NOTE(koekeishiya): Must be called with 'CVarsLock' held. A reader may still be probing the
+ * old table after it has been replaced. Cvars are only created by the config-file and when
+ * plugins are initialized, so old tables are kept until 'EndCVars' instead of being reclaimed,
+ * and looking up a cvar does not have to enter an epoch.
+ */
+internal void
+_InsertCVar(cvar *Var)
+{
+    cvar_table *Table = CVars;
+    if ((Table->Count + 1) * 4 > Table->Capacity * 3) {
+        cvar_table *Old = Table;
+        Table = _CreateCVarTable(Old->Capacity * 2);
+
+        for (uint32_t Index = 0; Index < Old->Capacity; ++Index) {
+            if (Old->Slots[Index]) _PlaceCVar(Table, Old->Slots[Index]);
+        }
+
+        _PlaceCVar(Table, Var);
+        __atomic_store_n(&CVars, Table, __ATOMIC_RELEASE);
+
+        Old->Retired = RetiredCVarTables;
+        RetiredCVarTables = Old;
+    } else {
+        _PlaceCVar(Table, Var);
+    }
+}
+
 bool BeginCVars()
 {
     BeginCVars(&API);
-    return pthread_mutex_init(&CVarsLock, NULL) == 0;
+    CVars = _CreateCVarTable(CVAR_TABLE_CAPACITY);
+    return ((pthread_mutex_init(&CVarsLock, NULL) == 0) &&
+            (BeginEpochDomain(&CVarEpoch)));
 }
 
 void EndCVars()
 {
-    for (cvar_map_it It = CVars.begin(); It != CVars.end(); ++It) {
-        cvar *Var = It->second;
+    EpochSynchronize(&CVarEpoch);
+
+    cvar_table *Table = CVars;
+    for (uint32_t Index = 0; Index < Table->Capacity; ++Index) {
+        cvar *Var = Table->Slots[Index];
+        if (!Var) continue;
 
         free((char *) Var->Name);
         free(Var->Value);
         free(Var);
     }
 
-    CVars.clear();
+    free(Table);
+    CVars = NULL;
+
+    while (RetiredCVarTables) {
+        Table = RetiredCVarTables;
+        RetiredCVarTables = Table->Retired;
+        free(Table);
+    }
+
     pthread_mutex_destroy(&CVarsLock);
 }
 
+// NOTE(koekeishiya): Must be called with 'CVarsLock' held.
+internal void
+_UpdateCVarValue(cvar *Var, char *Value)
+{
+    char *Old = Var->Value;
+    ASSERT(Old);
+    __atomic_store_n(&Var->Value, strdup(Value), __ATOMIC_RELEASE);
+    _StoreCVarNumbers(Var, Value);
+    EpochRetire(&CVarEpoch, Old);
+}
+
+/*
+ * NOTE(koekeishiya): Must be called with 'CVarsLock' held. A cvar is only recorded once until
+ * the changes are taken, which is what coalesces a burst of updates. Returns true for the first
+ * change after the previous ones were taken, at which point the hook should be called.
+ */
+internal bool
+_RecordChangedCVar(cvar *Var)
+{
+    if (!CVarChangedHook) return false;
+
+    for (size_t Index = 0; Index < ChangedCVars.size(); ++Index) {
+        if (ChangedCVars[Index] == Var) return false;
+    }
+
+    ChangedCVars.push_back(Var);
+    return ChangedCVars.size() == 1;
+}
+
+// NOTE(koekeishiya): The hook is called outside of 'CVarsLock', so that it may read cvars.
+void SetCVarChangedHook(cvar_changed_hook *Hook)
+{
+    __atomic_store_n(&CVarChangedHook, Hook, __ATOMIC_RELEASE);
+}
+
+void TakeChangedCVars(std::vector<cvar *> *Changed)
+{
+    pthread_mutex_lock(&CVarsLock);
+    Changed->swap(ChangedCVars);
+    ChangedCVars.clear();
+    pthread_mutex_unlock(&CVarsLock);
+}
+
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 void UpdateCVarAPI(const char *Name, char *Value)
 {
     pthread_mutex_lock(&CVarsLock);
     cvar *Var = _FindCVar(Name);
     if (Var) {
-        ASSERT(Var->Value);
-        free(Var->Value);
-        Var->Value = strdup(Value);
+        _UpdateCVarValue(Var, Value);
     } else {
-        cvar *Var = _CreateCVar(Name, Value);
-        CVars[Var->Name] = Var;
+        Var = _CreateCVar(Name, Value);
+        _InsertCVar(Var);
     }
+    bool Notify = _RecordChangedCVar(Var);
     pthread_mutex_unlock(&CVarsLock);
+
+    if (Notify) CVarChangedHook();
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_BEGIN_CVAR_READ_FUNC(BeginCVarReadAPI)
+{
+    return EpochEnter(&CVarEpoch);
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_END_CVAR_READ_FUNC(EndCVarReadAPI)
+{
+    EpochLeave(&CVarEpoch, Read);
 }
 
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 char *AcquireCVarAPI(const char *Name)
 {
-    pthread_mutex_lock(&CVarsLock);
-    cvar *CVar = _FindCVar(Name);
-    char *Result = CVar ? CVar->Value : NULL;
-    pthread_mutex_unlock(&CVarsLock);
-    return Result;
+    return AcquireCVarHandleAPI(_FindCVar(Name));
 }
 
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 bool FindCVarAPI(const char *Name)
 {
+    return _FindCVar(Name) != NULL;
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_INTEGER_FUNC(CVarIntegerAPI)
+{
+    return CVarHandleIntegerAPI(_FindCVar(Name));
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_UNSIGNED_FUNC(CVarUnsignedAPI)
+{
+    return CVarHandleUnsignedAPI(_FindCVar(Name));
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_FLOATING_POINT_FUNC(CVarFloatingPointAPI)
+{
+    return CVarHandleFloatingPointAPI(_FindCVar(Name));
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_RESOLVE_CVAR_FUNC(ResolveCVarAPI)
+{
+    return _FindCVar(Name);
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_UPDATE_CVAR_HANDLE_FUNC(UpdateCVarHandleAPI)
+{
+    if (!CVar) return;
+
     pthread_mutex_lock(&CVarsLock);
-    cvar *CVar = _FindCVar(Name);
+    _UpdateCVarValue(CVar, Value);
+    bool Notify = _RecordChangedCVar(CVar);
     pthread_mutex_unlock(&CVarsLock);
-    return CVar != NULL;
+
+    if (Notify) CVarChangedHook();
+}
+
+/*
+ * NOTE(koekeishiya): API - Exposed to plugins through pointer
+ * The string is only kept alive by a read that the caller has begun, see 'BeginCVarReadAPI'.
+ */
+CHUNKWM_API_ACQUIRE_CVAR_HANDLE_FUNC(AcquireCVarHandleAPI)
+{
+    return CVar ? __atomic_load_n(&CVar->Value, __ATOMIC_ACQUIRE) : NULL;
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_INTEGER_FUNC(CVarHandleIntegerAPI)
+{
+    int Integer = 0;
+    unsigned Unsigned = 0;
+    float FloatingPoint = 0.0f;
+
+    if (CVar) _LoadCVarNumbers(CVar, &Integer, &Unsigned, &FloatingPoint);
+    return Integer;
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_UNSIGNED_FUNC(CVarHandleUnsignedAPI)
+{
+    int Integer = 0;
+    unsigned Unsigned = 0;
+    float FloatingPoint = 0.0f;
+
+    if (CVar) _LoadCVarNumbers(CVar, &Integer, &Unsigned, &FloatingPoint);
+    return Unsigned;
+}
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_FLOATING_POINT_FUNC(CVarHandleFloatingPointAPI)
+{
+    int Integer = 0;
+    unsigned Unsigned = 0;
+    float FloatingPoint = 0.0f;
+
+    if (CVar) _LoadCVarNumbers(CVar, &Integer, &Unsigned, &FloatingPoint);
+    return FloatingPoint;
+}
+
+// NOTE(koekeishiya): 'Callback' may read cvars, but must not update them.
+void EnumerateCVars(cvar_enumerate_func *Callback, void *Context)
+{
+    uint64_t Epoch = EpochEnter(&CVarEpoch);
+    cvar_table *Table = __atomic_load_n(&CVars, __ATOMIC_ACQUIRE);
+    for (uint32_t Index = 0; Index < Table->Capacity; ++Index) {
+        cvar *Var = __atomic_load_n(&Table->Slots[Index], __ATOMIC_ACQUIRE);
+        if (!Var) continue;
+        Callback(Var->Name, __atomic_load_n(&Var->Value, __ATOMIC_ACQUIRE), Context);
+    }
+    EpochLeave(&CVarEpoch, Epoch);
 }
@@ -1,24 +1,89 @@
 #ifndef CHUNKWM_CORE_CVAR_H
 #define CHUNKWM_CORE_CVAR_H
 
-#include <map>
+#include <stdint.h>
 
+#include <vector>
+
+#include "../api/plugin_cvar.h"
 #include "../common/config/cvar.h"
-#include "../common/misc/string.h"
+#include "epoch.h"
+
+/*
+ * NOTE(koekeishiya): Cvars are read without taking a lock. The table of cvars is an open
+ * addressed hash table over the interned names of the cvars. A new cvar is published into an
+ * empty slot, and the table is copied into a larger one when it is three quarters full; old
+ * tables are kept until 'EndCVars', as a reader may still be probing one. Updating a cvar
+ * writes its numbers under its sequence and swaps the pointer to its string; the old string
+ * is retired instead of freed, see epoch.h. Writers are serialized by a lock.
+ */
+struct cvar_table
+{
+    uint32_t Capacity;
+    uint32_t Count;
+    cvar *volatile *Slots;
+    cvar_table *Retired;
+};
 
-typedef std::map<const char *, cvar *, string_comparator> cvar_map;
-typedef cvar_map::iterator cvar_map_it;
+#define CVAR_ENUMERATE_FUNC(name) void name(const char *Name, const char *Value, void *Context)
+typedef CVAR_ENUMERATE_FUNC(cvar_enumerate_func);
+
+/*
+ * NOTE(koekeishiya): Called by the thread that updated a cvar, once for every set of changes
+ * that have not yet been taken with 'TakeChangedCVars'. Changes are only recorded once a hook
+ * has been set, see watch.h.
+ */
+#define CVAR_CHANGED_HOOK(name) void name()
+typedef CVAR_CHANGED_HOOK(cvar_changed_hook);
 
 bool BeginCVars();
 void EndCVars();
 
+void SetCVarChangedHook(cvar_changed_hook *Hook);
+void TakeChangedCVars(std::vector<cvar *> *Changed);
+
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 void UpdateCVarAPI(const char *Name, char *Value);
 
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 char *AcquireCVarAPI(const char *Name);
 
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_BEGIN_CVAR_READ_FUNC(BeginCVarReadAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_END_CVAR_READ_FUNC(EndCVarReadAPI);
+
 // NOTE(koekeishiya): API - Exposed to plugins through pointer
 bool FindCVarAPI(const char *Name);
 
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_INTEGER_FUNC(CVarIntegerAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_UNSIGNED_FUNC(CVarUnsignedAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_FLOATING_POINT_FUNC(CVarFloatingPointAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_RESOLVE_CVAR_FUNC(ResolveCVarAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_UPDATE_CVAR_HANDLE_FUNC(UpdateCVarHandleAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_ACQUIRE_CVAR_HANDLE_FUNC(AcquireCVarHandleAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_INTEGER_FUNC(CVarHandleIntegerAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_UNSIGNED_FUNC(CVarHandleUnsignedAPI);
+
+// NOTE(koekeishiya): API - Exposed to plugins through pointer
+CHUNKWM_API_CVAR_HANDLE_FLOATING_POINT_FUNC(CVarHandleFloatingPointAPI);
+
+void EnumerateCVars(cvar_enumerate_func *Callback, void *Context);
+
 #endif
@@ -1,87 +1,493 @@
 #include "event.h"
 #include "../clog.h"
+#include "../../common/misc/timer.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include <vector>
+#include <algorithm>
 
 #define internal static
 
 internal event_loop EventLoop = {};
 
-/* NOTE(koekeishiya): Must be thread-safe! Called through ConstructEvent macro */
+internal const char *EventTypeNames[] =
+{
+    "ChunkWM_ApplicationLaunched",
+    "ChunkWM_ApplicationTerminated",
+    "ChunkWM_ApplicationActivated",
+    "ChunkWM_ApplicationDeactivated",
+    "ChunkWM_ApplicationVisible",
+    "ChunkWM_ApplicationHidden",
+
+    "ChunkWM_DisplayAdded",
+    "ChunkWM_DisplayRemoved",
+    "ChunkWM_DisplayMoved",
+    "ChunkWM_DisplayResized",
+    "ChunkWM_DisplayChanged",
+    "ChunkWM_SpaceChanged",
+
+    "ChunkWM_WindowCreated",
+    "ChunkWM_WindowDestroyed",
+    "ChunkWM_WindowFocused",
+    "ChunkWM_WindowMoved",
+    "ChunkWM_WindowResized",
+    "ChunkWM_WindowMinimized",
+    "ChunkWM_WindowDeminimized",
+    "ChunkWM_WindowTitleChanged",
+
+    "ChunkWM_PluginCommand",
+    "ChunkWM_PluginBroadcast",
+    "ChunkWM_PluginLoad",
+    "ChunkWM_PluginUnload",
+    "ChunkWM_CVarChanged",
+};
+
+internal event_priority DefaultEventPriority[] =
+{
+    Event_Priority_Structural,   // ChunkWM_ApplicationLaunched
+    Event_Priority_Structural,   // ChunkWM_ApplicationTerminated
+    Event_Priority_Interactive,  // ChunkWM_ApplicationActivated
+    Event_Priority_Interactive,  // ChunkWM_ApplicationDeactivated
+    Event_Priority_Structural,   // ChunkWM_ApplicationVisible
+    Event_Priority_Structural,   // ChunkWM_ApplicationHidden
+
+    Event_Priority_Structural,   // ChunkWM_DisplayAdded
+    Event_Priority_Structural,   // ChunkWM_DisplayRemoved
+    Event_Priority_Structural,   // ChunkWM_DisplayMoved
+    Event_Priority_Structural,   // ChunkWM_DisplayResized
+    Event_Priority_Interactive,  // ChunkWM_DisplayChanged
+    Event_Priority_Interactive,  // ChunkWM_SpaceChanged
+
+    Event_Priority_Structural,   // ChunkWM_WindowCreated
+    Event_Priority_Structural,   // ChunkWM_WindowDestroyed
+    Event_Priority_Interactive,  // ChunkWM_WindowFocused
+    Event_Priority_Background,   // ChunkWM_WindowMoved
+    Event_Priority_Background,   // ChunkWM_WindowResized
+    Event_Priority_Structural,   // ChunkWM_WindowMinimized
+    Event_Priority_Structural,   // ChunkWM_WindowDeminimized
+    Event_Priority_Background,   // ChunkWM_WindowTitleChanged
+
+    Event_Priority_Interactive,  // ChunkWM_PluginCommand
+    Event_Priority_Structural,   // ChunkWM_PluginBroadcast
+    Event_Priority_Structural,   // ChunkWM_PluginLoad
+    Event_Priority_Structural,   // ChunkWM_PluginUnload
+    Event_Priority_Structural,   // ChunkWM_CVarChanged
+};
+
+const char *EventTypeName(event_type Type)
+{
+    return EventTypeNames[Type];
+}
+
+bool EventTypeFromName(const char *Name, event_type *Type)
+{
+    for (int Index = 0; Index < ChunkWM_EventTypeCount; ++Index) {
+        if (strcmp(EventTypeNames[Index], Name) == 0) {
+            *Type = (event_type) Index;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+event_priority EventPriority(event_type Type)
+{
+    return EventLoop.Priority[Type];
+}
+
+/*
+ * NOTE(koekeishiya): Events that are already queued stay in their current lane.
+ * Only events constructed after this call are affected.
+ */
+void SetEventPriority(event_type Type, event_priority Priority)
+{
+    EventLoop.Priority[Type] = Priority;
+}
+
+internal inline int
+CoalesceIndex(event_type Type)
+{
+    switch (Type) {
+    case ChunkWM_WindowMoved:        return 0;
+    case ChunkWM_WindowResized:      return 1;
+    case ChunkWM_WindowTitleChanged: return 2;
+    default:                         return -1;
+    }
+}
+
+internal inline uint64_t volatile *
+CoalesceSlot(chunk_event *Event)
+{
+    uint32_t Hash = (Event->Key * 2654435761u) % EVENT_COALESCE_SLOTS;
+    return &EventLoop.Pending[CoalesceIndex(Event->Type)][Hash];
+}
+
+bool EventTypeCoalesces(event_type Type)
+{
+    return CoalesceIndex(Type) != -1;
+}
+
+event_coalesce_stats EventCoalesceStats(event_type Type)
+{
+    event_coalesce_stats Result;
+    Result.Queued = __atomic_load_n(&EventLoop.Stats[Type].Queued, __ATOMIC_RELAXED);
+    Result.Coalesced = __atomic_load_n(&EventLoop.Stats[Type].Coalesced, __ATOMIC_RELAXED);
+    return Result;
+}
+
+event_latency *EventLatency(event_type Type)
+{
+    return EventLoop.Latency + Type;
+}
+
+void ResetEventLatency()
+{
+    for (int Index = 0; Index < ChunkWM_EventTypeCount; ++Index) {
+        event_latency *Latency = EventLoop.Latency + Index;
+        HistogramReset(&Latency->QueueWait);
+        HistogramReset(&Latency->Handler);
+        HistogramReset(&Latency->Total);
+    }
+}
+
+void SetEventTraceHook(event_trace_hook *Hook)
+{
+    EventLoop.TraceHook = Hook;
+}
+
+void SetEventRoundHook(event_round_hook *Hook)
+{
+    EventLoop.RoundHook = Hook;
+}
+
+internal inline void
+EndEventRound()
+{
+    event_round_hook *RoundHook = EventLoop.RoundHook;
+    if (RoundHook) {
+        (*RoundHook)();
+    }
+}
+
+/*
+ * NOTE(koekeishiya): The slot must be updated before the event is pushed. Otherwise the
+ * event-loop could process this event while the slot still holds an older sequence, and
+ * drop the newest event for this key.
+ *
+ * Two producers can take their sequence in one order and reach the slot in the other, so
+ * the slot only ever moves forward for the same key. A different key simply takes the slot.
+ */
+internal inline void
+MarkPendingEvent(chunk_event *Event)
+{
+    uint64_t volatile *Slot = CoalesceSlot(Event);
+    uint64_t Value = ((uint64_t) Event->Key << 32) | Event->Sequence;
+    uint64_t Old = __atomic_load_n(Slot, __ATOMIC_RELAXED);
+
+    do {
+        if ((((uint32_t) (Old >> 32)) == Event->Key) &&
+            ((int32_t) (Event->Sequence - (uint32_t) Old) <= 0)) {
+            break;
+        }
+    } while (!__atomic_compare_exchange_n(Slot, &Old, Value, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    __sync_fetch_and_add(&EventLoop.Stats[Event->Type].Queued, 1);
+}
+
+internal inline bool
+IsStaleEvent(chunk_event *Event)
+{
+    uint64_t Value = __atomic_load_n(CoalesceSlot(Event), __ATOMIC_ACQUIRE);
+    bool Result = (((uint32_t) (Value >> 32)) == Event->Key) &&
+                  (((uint32_t) Value) != Event->Sequence);
+    if (Result) {
+        __sync_fetch_and_add(&EventLoop.Stats[Event->Type].Coalesced, 1);
+    }
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): Must be thread-safe! Called through ConstructEvent macro.
+ *
+ * If the ring is full, producers yield until the event-loop has made room. The event-loop
+ * thread itself cannot wait for its own queue to drain, so events that it constructs while
+ * the ring is full are parked in a queue that only the event-loop thread touches. Once that
+ * queue holds an event, the event-loop thread parks every later event behind it as well, so
+ * that they are not pushed ahead of the events it parked earlier.
+ */
 void AddEvent(chunk_event Event)
 {
     if (Event.Handle) {
-        pthread_mutex_lock(&EventLoop.Lock);
-        EventLoop.Queue.push(Event);
-        pthread_mutex_unlock(&EventLoop.Lock);
+        uint64_t Epoch = EpochEnter(&EventLoop.Producers);
+        Event.Timestamp = GetTimeNanoseconds();
+        Event.Sequence = __sync_add_and_fetch(&EventLoop.Sequence, 1);
+        if (Event.Key && EventTypeCoalesces(Event.Type)) {
+            MarkPendingEvent(&Event);
+        } else {
+            Event.Key = 0;
+        }
+
+        event_priority Priority = EventLoop.Priority[Event.Type];
+        event_ring *Lane = EventLoop.Lanes + Priority;
+
+        bool LoopThread = EventLoop.Running && pthread_equal(pthread_self(), EventLoop.Thread);
+        if (LoopThread && !EventLoop.Overflow[Priority].empty()) {
+            EventLoop.Overflow[Priority].push(Event);
+        } else if (!EventRingPush(Lane, &Event)) {
+            if (LoopThread) {
+                EventLoop.Overflow[Priority].push(Event);
+            } else {
+                c_log(C_LOG_LEVEL_WARN, "chunkwm: event queue is full, waiting for event-loop..\n");
+                while (!EventRingPush(Lane, &Event)) {
+                    sched_yield();
+                }
+            }
+        }
+
+        EpochLeave(&EventLoop.Producers, Epoch);
 
         if (EventLoop.Running) {
-            sem_post(EventLoop.Semaphore);
+            WakeupPost(&EventLoop.Wakeup);
+        }
+    }
+}
+
+internal void
+RequeueOverflowEvents()
+{
+    for (int Priority = 0; Priority < Event_Priority_Count; ++Priority) {
+        std::queue<chunk_event> *Overflow = EventLoop.Overflow + Priority;
+        while (!Overflow->empty()) {
+            if (!EventRingPush(EventLoop.Lanes + Priority, &Overflow->front())) break;
+            Overflow->pop();
+        }
+    }
+}
+
+/*
+ * NOTE(koekeishiya): These events release the window or application that pending events
+ * in other lanes may still refer to. Before one is dispatched, every event that took an
+ * earlier sequence, in any lane, is dispatched first.
+ */
+internal inline bool
+IsBarrierEvent(chunk_event *Event)
+{
+    return ((Event->Type == ChunkWM_WindowDestroyed) ||
+            (Event->Type == ChunkWM_ApplicationTerminated));
+}
+
+internal inline bool
+IsEarlierEvent(const chunk_event &A, const chunk_event &B)
+{
+    return (int32_t) (A.Sequence - B.Sequence) < 0;
+}
+
+internal void DispatchEvent(chunk_event *Event);
+
+internal void
+DrainLanes(std::vector<chunk_event> *Drained)
+{
+    chunk_event Events[EVENT_RING_BATCH];
+    for (int Index = 0; Index < Event_Priority_Count; ++Index) {
+        uint32_t Count;
+        while ((Count = EventRingPopBatch(EventLoop.Lanes + Index, Events, EVENT_RING_BATCH))) {
+            Drained[Index].insert(Drained[Index].end(), Events, Events + Count);
+        }
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Producers take their sequence before they push, so an earlier event can
+ * sit behind a later one in a lane, or not be pushed yet at all. We wait until every producer
+ * that could hold an earlier sequence has queued its event, and keep draining the lanes so
+ * that a producer that waits for room in a full ring can finish. The earlier events, and those
+ * in the overflow queues, are dispatched in sequence order; the others are parked in the
+ * overflow queue of their lane, in the order they were queued, see 'RequeueOverflowEvents'.
+ */
+internal void
+DispatchEarlierEvents(uint32_t Sequence)
+{
+    std::vector<chunk_event> Drained[Event_Priority_Count];
+    uint64_t Target = EpochSynchronizeTarget(&EventLoop.Producers);
+
+    DrainLanes(Drained);
+    while (!EpochTrySynchronize(&EventLoop.Producers, Target)) {
+        sched_yield();
+        DrainLanes(Drained);
+    }
+    DrainLanes(Drained);
+
+    std::vector<chunk_event> Earlier;
+    for (int Index = 0; Index < Event_Priority_Count; ++Index) {
+        std::queue<chunk_event> *Overflow = EventLoop.Overflow + Index;
+        std::queue<chunk_event> Later;
+
+        for (size_t Event = 0; Event < Drained[Index].size(); ++Event) {
+            if ((int32_t) (Drained[Index][Event].Sequence - Sequence) < 0) {
+                Earlier.push_back(Drained[Index][Event]);
+            } else {
+                Later.push(Drained[Index][Event]);
+            }
+        }
+
+        for (; !Overflow->empty(); Overflow->pop()) {
+            if ((int32_t) (Overflow->front().Sequence - Sequence) < 0) {
+                Earlier.push_back(Overflow->front());
+            } else {
+                Later.push(Overflow->front());
+            }
         }
+
+        Overflow->swap(Later);
+    }
+
+    std::stable_sort(Earlier.begin(), Earlier.end(), IsEarlierEvent);
+    for (size_t Index = 0; Index < Earlier.size(); ++Index) {
+        DispatchEvent(&Earlier[Index]);
+    }
+}
+
+internal void
+DispatchEvent(chunk_event *Event)
+{
+    if (Event->Key && IsStaleEvent(Event)) return;
+
+    if (IsBarrierEvent(Event)) {
+        DispatchEarlierEvents(Event->Sequence);
+    }
+
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: processing event of type '%s'\n", Event->Name);
+
+    event_trace_hook *TraceHook = EventLoop.TraceHook;
+    if (TraceHook) {
+        (*TraceHook)(Event);
+    }
+
+    event_latency *Latency = EventLoop.Latency + Event->Type;
+    uint64_t Dispatched = GetTimeNanoseconds();
+    (*Event->Handle)(Event);
+    uint64_t Completed = GetTimeNanoseconds();
+
+    HistogramRecord(&Latency->QueueWait, Dispatched - Event->Timestamp);
+    HistogramRecord(&Latency->Handler, Completed - Dispatched);
+    HistogramRecord(&Latency->Total, Completed - Event->Timestamp);
+}
+
+/*
+ * NOTE(koekeishiya): Select the highest non-empty lane, unless a lower lane has been
+ * passed over too many times in a row. Returns Event_Priority_Count if all lanes are empty.
+ */
+internal int
+SelectLane()
+{
+    int Result = Event_Priority_Count;
+    int Starved = Event_Priority_Count;
+
+    for (int Index = 0; Index < Event_Priority_Count; ++Index) {
+        if (!EventRingPeek(EventLoop.Lanes + Index)) continue;
+
+        if (Result == Event_Priority_Count) {
+            Result = Index;
+        } else if ((++EventLoop.Skipped[Index] >= EVENT_STARVATION_LIMIT) &&
+                   (Starved == Event_Priority_Count)) {
+            Starved = Index;
+        }
+    }
+
+    if (Starved != Event_Priority_Count) {
+        Result = Starved;
     }
+
+    if (Result != Event_Priority_Count) {
+        EventLoop.Skipped[Result] = 0;
+    }
+
+    return Result;
 }
 
 internal void *
 ProcessEventQueue(void *)
 {
+    chunk_event Events[EVENT_RING_BATCH];
+    uint64_t Window = EVENT_ROUND_WINDOW_MS * 1000000ULL;
+
     while (EventLoop.Running) {
-        pthread_mutex_lock(&EventLoop.Lock);
-        bool HasWork = !EventLoop.Queue.empty();
-        pthread_mutex_unlock(&EventLoop.Lock);
+        int Lane;
+        uint64_t RoundBegin = GetTimeNanoseconds();
 
-        while (HasWork) {
-            pthread_mutex_lock(&EventLoop.Lock);
-            chunk_event Event = EventLoop.Queue.front();
-            EventLoop.Queue.pop();
+        while ((Lane = SelectLane()) != Event_Priority_Count) {
+            /*
+             * NOTE(koekeishiya): Lower lanes are drained in small batches, so that newly
+             * queued interactive events do not have to wait for a full batch to finish.
+             */
+            uint32_t Limit = Lane == Event_Priority_Interactive ? EVENT_RING_BATCH : EVENT_LOW_PRIORITY_BATCH;
+            uint32_t Count = EventRingPopBatch(EventLoop.Lanes + Lane, Events, Limit);
 
-            HasWork = !EventLoop.Queue.empty();
-            pthread_mutex_unlock(&EventLoop.Lock);
+            // NOTE(koekeishiya): A barrier must not be dispatched before an earlier event of its own batch.
+            std::stable_sort(Events, Events + Count, IsEarlierEvent);
 
-            c_log(C_LOG_LEVEL_DEBUG, "chunkwm: processing event of type '%s'\n", Event.Name);
-            (*Event.Handle)(&Event);
-        }
+            for (uint32_t Index = 0; Index < Count; ++Index) {
+                DispatchEvent(Events + Index);
+            }
 
-        int Result = sem_wait(EventLoop.Semaphore);
-        if (Result) {
-            uint64_t ID;
-            pthread_threadid_np(NULL, &ID);
-            c_log(C_LOG_LEVEL_DEBUG, "%lld: sem_wait(..) failed\n", ID);
+            RequeueOverflowEvents();
+
+            uint64_t Now = GetTimeNanoseconds();
+            if (Now - RoundBegin >= Window) {
+                EndEventRound();
+                RoundBegin = Now;
+            }
         }
+
+        EndEventRound();
+        WakeupWaitAll(&EventLoop.Wakeup);
     }
 
     return NULL;
 }
 
-/* NOTE(koekeishiya): Initialize required mutexes and semaphore for the eventloop */
+/* NOTE(koekeishiya): Initialize the event ring and wakeup for the eventloop */
 bool BeginEventLoop()
 {
     bool Result = true;
 
-    if ((EventLoop.Semaphore = sem_open("eventloop_semaphore", O_CREAT, 0644, 0)) == SEM_FAILED) {
-        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not initialize semaphore!");
-        goto sem_err;
+    if (!WakeupInit(&EventLoop.Wakeup)) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not initialize event-loop wakeup!");
+        goto wakeup_err;
+    }
+
+    if (!BeginEpochDomain(&EventLoop.Producers)) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not initialize event-loop producers!");
+        goto epoch_err;
+    }
+
+    for (int Index = 0; Index < Event_Priority_Count; ++Index) {
+        EventRingInit(EventLoop.Lanes + Index);
     }
 
-    if (pthread_mutex_init(&EventLoop.Lock, NULL) != 0) {
-        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not initialize work mutex!");
-        goto work_err;
+    for (int Index = 0; Index < ChunkWM_EventTypeCount; ++Index) {
+        EventLoop.Priority[Index] = DefaultEventPriority[Index];
     }
 
     goto out;
 
-work_err:
-    sem_destroy(EventLoop.Semaphore);
+epoch_err:
+    WakeupDestroy(&EventLoop.Wakeup);
 
-sem_err:
+wakeup_err:
     Result = false;
 
 out:
     return Result;
 }
 
-/* NOTE(koekeishiya): Destroy mutexes and condition used by the event-loop */
+/* NOTE(koekeishiya): Destroy wakeup used by the event-loop */
 void EndEventLoop()
 {
-    pthread_mutex_destroy(&EventLoop.Lock);
-    sem_destroy(EventLoop.Semaphore);
+    WakeupDestroy(&EventLoop.Wakeup);
 }
 
 void StartEventLoop()
@@ -96,6 +502,7 @@ void StopEventLoop()
 {
     if (EventLoop.Running) {
         EventLoop.Running = false;
+        WakeupPost(&EventLoop.Wakeup);
         pthread_join(EventLoop.Thread, NULL);
     }
 }
@@ -1,10 +1,14 @@
 #ifndef CHUNKWM_OSX_EVENT_H
 #define CHUNKWM_OSX_EVENT_H
 
+#include <stdint.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <queue>
 
+#include "../histogram.h"
+#include "../wakeup.h"
+#include "../epoch.h"
+
 struct chunk_event;
 #define CHUNKWM_CALLBACK(name) void name(chunk_event *Event)
 typedef CHUNKWM_CALLBACK(chunkwm_callback);
@@ -39,6 +43,7 @@ extern CHUNKWM_CALLBACK(Callback_ChunkWM_PluginCommand);
 extern CHUNKWM_CALLBACK(Callback_ChunkWM_PluginBroadcast);
 extern CHUNKWM_CALLBACK(Callback_ChunkWM_PluginLoad);
 extern CHUNKWM_CALLBACK(Callback_ChunkWM_PluginUnload);
+extern CHUNKWM_CALLBACK(Callback_ChunkWM_CVarChanged);
 
 enum event_type
 {
@@ -70,22 +75,139 @@ enum event_type
     // NOTE(koekeishiya): This property is not exposed to plugins
     ChunkWM_PluginCommand,
     ChunkWM_PluginBroadcast,
+    ChunkWM_PluginLoad,
+    ChunkWM_PluginUnload,
+    ChunkWM_CVarChanged,
+
+    ChunkWM_EventTypeCount
 };
 
+/*
+ * NOTE(koekeishiya): Events with a non-zero 'Key' can be coalesced. If a newer event
+ * of the same type and key is queued before this one is processed, this one is dropped.
+ * 'Sequence' is assigned by 'AddEvent' and gives a total order across all priority lanes.
+ */
 struct chunk_event
 {
     chunkwm_callback *Handle;
     void *Context;
     const char *Name;
+    event_type Type;
+    uint32_t Key;
+    uint32_t Sequence;
+    uint64_t Timestamp;
+};
+
+/*
+ * NOTE(koekeishiya): Bounded multi-producer / single-consumer ring. Every cell carries a
+ * sequence number that tells a producer whether the cell is free for the position it
+ * claimed, and tells the consumer whether the producer has finished writing the event.
+ * Producers only contend on the 'Head' counter; the consumer owns 'Tail' exclusively.
+ */
+#define EVENT_RING_SIZE 4096
+#define EVENT_RING_MASK (EVENT_RING_SIZE - 1)
+#define EVENT_RING_BATCH 64
+
+struct event_ring_cell
+{
+    uint32_t volatile Sequence;
+    chunk_event Event;
 };
 
+struct event_ring
+{
+    event_ring_cell Cells[EVENT_RING_SIZE];
+
+    uint8_t Pad0[64];
+    uint32_t volatile Head;
+    uint8_t Pad1[64];
+    uint32_t Tail;
+    uint8_t Pad2[64];
+};
+
+void EventRingInit(event_ring *Ring);
+bool EventRingPush(event_ring *Ring, chunk_event *Event);
+chunk_event *EventRingPeek(event_ring *Ring);
+uint32_t EventRingPopBatch(event_ring *Ring, chunk_event *Events, uint32_t Count);
+
+/*
+ * NOTE(koekeishiya): Every event type is assigned to a priority lane. The event-loop always
+ * drains the highest non-empty lane first. A lower lane that has been passed over
+ * EVENT_STARVATION_LIMIT times in a row is served once before returning to the higher lanes.
+ */
+enum event_priority
+{
+    Event_Priority_Interactive,
+    Event_Priority_Structural,
+    Event_Priority_Background,
+
+    Event_Priority_Count
+};
+
+#define EVENT_STARVATION_LIMIT 16
+#define EVENT_LOW_PRIORITY_BATCH 4
+
+#define EVENT_COALESCE_TYPES 3
+#define EVENT_COALESCE_SLOTS 1024
+
+struct event_coalesce_stats
+{
+    uint64_t volatile Queued;
+    uint64_t volatile Coalesced;
+};
+
+// NOTE(koekeishiya): Nanoseconds spent waiting in a lane, running the handler, and in total.
+struct event_latency
+{
+    latency_histogram QueueWait;
+    latency_histogram Handler;
+    latency_histogram Total;
+};
+
+/*
+ * NOTE(koekeishiya): Called on the event-loop thread for every event that is about to be
+ * dispatched, before the handler runs and possibly releases the event context.
+ */
+#define EVENT_TRACE_HOOK(name) void name(chunk_event *Event)
+typedef EVENT_TRACE_HOOK(event_trace_hook);
+
+/*
+ * NOTE(koekeishiya): Called on the event-loop thread at the end of a dispatch round; when
+ * every lane is empty, or when EVENT_ROUND_WINDOW_MS have passed since the round began
+ * and events are still arriving. Events dispatched in one round are grouped together.
+ */
+#define EVENT_ROUND_HOOK(name) void name()
+typedef EVENT_ROUND_HOOK(event_round_hook);
+
+#define EVENT_ROUND_WINDOW_MS 4
+
 struct event_loop
 {
     bool Running;
     pthread_t Thread;
-    sem_t *Semaphore;
-    pthread_mutex_t Lock;
-    std::queue<chunk_event> Queue;
+    wakeup Wakeup;
+
+    event_ring Lanes[Event_Priority_Count];
+    uint32_t Skipped[Event_Priority_Count];
+    event_priority volatile Priority[ChunkWM_EventTypeCount];
+
+    /*
+     * NOTE(koekeishiya): Newest pending (Key << 32 | Sequence) for every coalescable
+     * event type. Two keys may hash to the same slot; the loser is then dispatched
+     * normally, so a collision can only cost us a redundant event, never a lost one.
+     */
+    uint32_t volatile Sequence;
+    uint64_t volatile Pending[EVENT_COALESCE_TYPES][EVENT_COALESCE_SLOTS];
+    event_coalesce_stats Stats[ChunkWM_EventTypeCount];
+    event_latency Latency[ChunkWM_EventTypeCount];
+    event_trace_hook *volatile TraceHook;
+    event_round_hook *volatile RoundHook;
+
+    // NOTE(koekeishiya): Only touched by the event-loop thread, see 'AddEvent'.
+    std::queue<chunk_event> Overflow[Event_Priority_Count];
+
+    // NOTE(koekeishiya): Entered by 'AddEvent' from taking a sequence until the event is queued.
+    epoch_domain Producers;
 };
 
 bool BeginEventLoop();
@@ -99,12 +221,41 @@ void ResumeEventLoop();
 
 void AddEvent(chunk_event Event);
 
+const char *EventTypeName(event_type Type);
+bool EventTypeFromName(const char *Name, event_type *Type);
+bool EventTypeCoalesces(event_type Type);
+
+event_priority EventPriority(event_type Type);
+void SetEventPriority(event_type Type, event_priority Priority);
+event_coalesce_stats EventCoalesceStats(event_type Type);
+
+event_latency *EventLatency(event_type Type);
+void ResetEventLatency();
+
+void SetEventTraceHook(event_trace_hook *Hook);
+void SetEventRoundHook(event_round_hook *Hook);
+
 /* NOTE(koekeishiya): Construct a chunk_event with the appropriate callback through macro expansion. */
 #define ConstructEvent(EventType, EventContext) \
     do { chunk_event Event = {}; \
          Event.Context = EventContext; \
          Event.Handle = &Callback_##EventType; \
          Event.Name = #EventType; \
+         Event.Type = EventType; \
+         AddEvent(Event); \
+       } while(0)
+
+/*
+ * NOTE(koekeishiya): Same as above, but only the newest pending event with the given key
+ * will be processed. Used for bursts of window notifications, keyed by window id.
+ */
+#define ConstructCoalescedEvent(EventType, EventContext, EventKey) \
+    do { chunk_event Event = {}; \
+         Event.Context = EventContext; \
+         Event.Handle = &Callback_##EventType; \
+         Event.Name = #EventType; \
+         Event.Type = EventType; \
+         Event.Key = EventKey; \
          AddEvent(Event); \
        } while(0)
 
@@ -0,0 +1,71 @@
+#include "event.h"
+
+void EventRingInit(event_ring *Ring)
+{
+    for (uint32_t Index = 0; Index < EVENT_RING_SIZE; ++Index) {
+        Ring->Cells[Index].Sequence = Index;
+    }
+
+    Ring->Head = 0;
+    Ring->Tail = 0;
+}
+
+/* NOTE(koekeishiya): Must be thread-safe! Returns false if the ring is full. */
+bool EventRingPush(event_ring *Ring, chunk_event *Event)
+{
+    event_ring_cell *Cell;
+    uint32_t Position = __atomic_load_n(&Ring->Head, __ATOMIC_RELAXED);
+
+    for (;;) {
+        Cell = Ring->Cells + (Position & EVENT_RING_MASK);
+        uint32_t Sequence = __atomic_load_n(&Cell->Sequence, __ATOMIC_ACQUIRE);
+        int32_t Difference = (int32_t) (Sequence - Position);
+
+        if (Difference == 0) {
+            if (__atomic_compare_exchange_n(&Ring->Head, &Position, Position + 1,
+                                            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (Difference < 0) {
+            return false;
+        } else {
+            Position = __atomic_load_n(&Ring->Head, __ATOMIC_RELAXED);
+        }
+    }
+
+    Cell->Event = *Event;
+    __atomic_store_n(&Cell->Sequence, Position + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// NOTE(koekeishiya): Must only be called from the consumer thread.
+chunk_event *EventRingPeek(event_ring *Ring)
+{
+    event_ring_cell *Cell = Ring->Cells + (Ring->Tail & EVENT_RING_MASK);
+    uint32_t Sequence = __atomic_load_n(&Cell->Sequence, __ATOMIC_ACQUIRE);
+    return Sequence == Ring->Tail + 1 ? &Cell->Event : NULL;
+}
+
+/*
+ * NOTE(koekeishiya): Must only be called from the consumer thread. Copies up to 'Count'
+ * events into 'Events' and returns the number of events that were removed from the ring.
+ * Stops at the first cell that a producer has claimed but not yet published.
+ */
+uint32_t EventRingPopBatch(event_ring *Ring, chunk_event *Events, uint32_t Count)
+{
+    uint32_t Result = 0;
+    uint32_t Position = Ring->Tail;
+
+    while (Result < Count) {
+        event_ring_cell *Cell = Ring->Cells + (Position & EVENT_RING_MASK);
+        uint32_t Sequence = __atomic_load_n(&Cell->Sequence, __ATOMIC_ACQUIRE);
+        if (Sequence != Position + 1) break;
+
+        Events[Result++] = Cell->Event;
+        __atomic_store_n(&Cell->Sequence, Position + EVENT_RING_SIZE, __ATOMIC_RELEASE);
+        ++Position;
+    }
+
+    Ring->Tail = Position;
+    return Result;
+}
@@ -0,0 +1,129 @@
+#include "epoch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#define internal static
+
+bool BeginEpochDomain(epoch_domain *Domain)
+{
+    memset(Domain, 0, sizeof(epoch_domain));
+    Domain->RetiredTail = &Domain->Retired;
+    return pthread_mutex_init(&Domain->Lock, NULL) == 0;
+}
+
+/*
+ * NOTE(koekeishiya): If the epoch advanced between the load and the increment, we may be
+ * counted in an epoch that is already being waited on. Back out and try again.
+ */
+uint64_t EpochEnter(epoch_domain *Domain)
+{
+    for (;;) {
+        uint64_t Epoch = __atomic_load_n(&Domain->Epoch, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&Domain->Readers[Epoch & 1], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&Domain->Epoch, __ATOMIC_SEQ_CST) == Epoch) {
+            return Epoch;
+        }
+        __atomic_sub_fetch(&Domain->Readers[Epoch & 1], 1, __ATOMIC_RELEASE);
+    }
+}
+
+void EpochLeave(epoch_domain *Domain, uint64_t Epoch)
+{
+    __atomic_sub_fetch(&Domain->Readers[Epoch & 1], 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * NOTE(koekeishiya): Must be called with the domain locked. The epoch can move from E to
+ * E + 1 once no reader is left in E - 1, which shares a counter with E + 1.
+ */
+internal bool
+TryAdvanceEpoch(epoch_domain *Domain)
+{
+    uint64_t Epoch = Domain->Epoch;
+    if (__atomic_load_n(&Domain->Readers[(Epoch + 1) & 1], __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    __atomic_store_n(&Domain->Epoch, Epoch + 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+// NOTE(koekeishiya): Must be called with the domain locked.
+internal void
+ReclaimRetired(epoch_domain *Domain)
+{
+    while (Domain->Retired && Domain->Retired->Epoch + 2 <= Domain->Epoch) {
+        epoch_retired *Retired = Domain->Retired;
+        Domain->Retired = Retired->Next;
+        free(Retired->Memory);
+        free(Retired);
+    }
+
+    if (!Domain->Retired) {
+        Domain->RetiredTail = &Domain->Retired;
+    }
+}
+
+// NOTE(koekeishiya): 'Memory' must already be unreachable for new readers, and is released with free.
+void EpochRetire(epoch_domain *Domain, void *Memory)
+{
+    epoch_retired *Retired = (epoch_retired *) malloc(sizeof(epoch_retired));
+    Retired->Memory = Memory;
+
+    pthread_mutex_lock(&Domain->Lock);
+
+    Retired->Epoch = __atomic_load_n(&Domain->Epoch, __ATOMIC_SEQ_CST);
+    Retired->Next = NULL;
+    *Domain->RetiredTail = Retired;
+    Domain->RetiredTail = &Retired->Next;
+
+    TryAdvanceEpoch(Domain);
+    ReclaimRetired(Domain);
+
+    pthread_mutex_unlock(&Domain->Lock);
+}
+
+/*
+ * NOTE(koekeishiya): Returns once every reader that entered before the call has left, and
+ * frees everything that has been retired. Readers hold the epoch for a short while only, so
+ * we yield instead of parking. Must not be called from inside a read-side section.
+ */
+void EpochSynchronize(epoch_domain *Domain)
+{
+    pthread_mutex_lock(&Domain->Lock);
+
+    uint64_t Target = Domain->Epoch + 2;
+    while (Domain->Epoch < Target) {
+        if (!TryAdvanceEpoch(Domain)) {
+            sched_yield();
+        }
+    }
+
+    ReclaimRetired(Domain);
+    pthread_mutex_unlock(&Domain->Lock);
+}
+
+/*
+ * NOTE(koekeishiya): Same as 'EpochSynchronize', for a caller that has to keep working while
+ * it waits, e.g. because the readers may be waiting on it. 'EpochSynchronizeTarget' is taken
+ * once, and 'EpochTrySynchronize' returns true once every reader that entered before it was
+ * taken has left. Retired memory is not freed.
+ */
+uint64_t EpochSynchronizeTarget(epoch_domain *Domain)
+{
+    pthread_mutex_lock(&Domain->Lock);
+    uint64_t Result = Domain->Epoch + 2;
+    pthread_mutex_unlock(&Domain->Lock);
+    return Result;
+}
+
+bool EpochTrySynchronize(epoch_domain *Domain, uint64_t Target)
+{
+    pthread_mutex_lock(&Domain->Lock);
+    while ((Domain->Epoch < Target) && TryAdvanceEpoch(Domain));
+    bool Result = Domain->Epoch >= Target;
+    pthread_mutex_unlock(&Domain->Lock);
+    return Result;
+}
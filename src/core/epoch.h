@@ -0,0 +1,46 @@
+#ifndef CHUNKWM_CORE_EPOCH_H
+#define CHUNKWM_CORE_EPOCH_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+ * NOTE(koekeishiya): Epoch-based reclamation for data that is read without a lock and
+ * replaced by publishing a new copy. A reader enters the current epoch before it loads a
+ * published pointer and leaves once it is done with it. Memory that has been unpublished is
+ * retired at the current epoch, and freed once the epoch has advanced twice; at that point
+ * every reader that could have loaded the pointer has left.
+ *
+ * Readers only touch the counter of their epoch, and never block. Retire and reclaim are
+ * serialized by 'Lock' and are expected to be rare, e.g. when a plugin is loaded. Retired
+ * memory is kept oldest first, so reclaiming stops at the first entry that is still in use.
+ */
+struct epoch_retired
+{
+    void *Memory;
+    uint64_t Epoch;
+    epoch_retired *Next;
+};
+
+struct epoch_domain
+{
+    uint64_t volatile Epoch;
+    uint32_t volatile Readers[2];
+
+    pthread_mutex_t Lock;
+    epoch_retired *Retired;
+    epoch_retired **RetiredTail;
+};
+
+bool BeginEpochDomain(epoch_domain *Domain);
+
+uint64_t EpochEnter(epoch_domain *Domain);
+void EpochLeave(epoch_domain *Domain, uint64_t Epoch);
+
+void EpochRetire(epoch_domain *Domain, void *Memory);
+void EpochSynchronize(epoch_domain *Domain);
+
+uint64_t EpochSynchronizeTarget(epoch_domain *Domain);
+bool EpochTrySynchronize(epoch_domain *Domain, uint64_t Target);
+
+#endif
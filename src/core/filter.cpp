@@ -0,0 +1,209 @@
+#include "filter.h"
+#include "clog.h"
+
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define internal static
+
+internal bool
+IsWindowExport(chunkwm_plugin_export Export)
+{
+    switch (Export) {
+    case chunkwm_export_window_created:
+    case chunkwm_export_window_destroyed:
+    case chunkwm_export_window_focused:
+    case chunkwm_export_window_moved:
+    case chunkwm_export_window_resized:
+    case chunkwm_export_window_minimized:
+    case chunkwm_export_window_deminimized:
+    case chunkwm_export_window_title_changed:
+        return true;
+    default:
+        return false;
+    }
+}
+
+internal bool
+IsApplicationExport(chunkwm_plugin_export Export)
+{
+    switch (Export) {
+    case chunkwm_export_application_launched:
+    case chunkwm_export_application_terminated:
+    case chunkwm_export_application_activated:
+    case chunkwm_export_application_deactivated:
+    case chunkwm_export_application_hidden:
+    case chunkwm_export_application_unhidden:
+        return true;
+    default:
+        return false;
+    }
+}
+
+internal bool
+IsFilterSupported(chunkwm_plugin_export Export, chunkwm_filter_type Type)
+{
+    if (IsWindowExport(Export)) {
+        return (unsigned) Type < chunkwm_filter_type_count;
+    }
+
+    if (IsApplicationExport(Export)) {
+        return ((Type == chunkwm_filter_owner) ||
+                (Type == chunkwm_filter_changed));
+    }
+
+    return false;
+}
+
+internal inline bool
+IsStringFilter(chunkwm_filter *Filter)
+{
+    return ((Filter->String) &&
+            ((Filter->Type == chunkwm_filter_role) ||
+             (Filter->Type == chunkwm_filter_subrole)));
+}
+
+plugin_filter *FindPluginFilter(plugin_filter *Filters, uint32_t Count, chunkwm_plugin_export Export)
+{
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        if (Filters[Index].Export == Export) {
+            return Filters + Index;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * NOTE(koekeishiya): Returns one entry per export that the plugin listed filters for. A filter
+ * that can not be checked for its export is ignored, and a warning is logged.
+ */
+plugin_filter *CreatePluginFilters(plugin *Plugin, const char *Name, uint32_t *Count)
+{
+    plugin_filter *Result = NULL;
+    *Count = 0;
+
+    for (unsigned Index = 0; Index < Plugin->FilterCount; ++Index) {
+        chunkwm_filter *Filter = Plugin->Filters + Index;
+        if ((unsigned) Filter->Export >= chunkwm_export_count) {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' has a filter for unknown export %u, ignored!\n",
+                  Name, (unsigned) Filter->Export);
+            continue;
+        }
+
+        if (!IsFilterSupported(Filter->Export, Filter->Type)) {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' has a filter that is not supported for '%s', ignored!\n",
+                  Name, chunkwm_plugin_export_str[Filter->Export]);
+            continue;
+        }
+
+        plugin_filter *Entry = FindPluginFilter(Result, *Count, Filter->Export);
+        if (!Entry) {
+            Result = (plugin_filter *) realloc(Result, (*Count + 1) * sizeof(plugin_filter));
+            Entry = Result + (*Count)++;
+            memset(Entry, 0, sizeof(plugin_filter));
+            Entry->Export = Filter->Export;
+        }
+
+        Entry->Filters = (chunkwm_filter *) realloc(Entry->Filters, (Entry->Count + 1) * sizeof(chunkwm_filter));
+        Entry->Strings = (CFStringRef *) realloc(Entry->Strings, (Entry->Count + 1) * sizeof(CFStringRef));
+        Entry->Filters[Entry->Count] = *Filter;
+        Entry->Strings[Entry->Count] = IsStringFilter(Filter)
+                                     ? CFStringCreateWithCString(NULL, Filter->String, kCFStringEncodingUTF8)
+                                     : NULL;
+        ++Entry->Count;
+    }
+
+    return Result;
+}
+
+void DestroyPluginFilters(plugin_filter *Filters, uint32_t Count)
+{
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        plugin_filter *Filter = Filters + Index;
+        for (uint32_t StringIndex = 0; StringIndex < Filter->Count; ++StringIndex) {
+            if (Filter->Strings[StringIndex]) {
+                CFRelease(Filter->Strings[StringIndex]);
+            }
+        }
+
+        free(Filter->Strings);
+        free(Filter->Filters);
+    }
+
+    free(Filters);
+}
+
+internal bool
+FilterMatches(plugin_filter *Filter, uint32_t Index, macos_window *Window,
+              macos_application *Application, uint32_t Id)
+{
+    chunkwm_filter *Entry = Filter->Filters + Index;
+    CFStringRef String = Filter->Strings[Index];
+
+    switch (Entry->Type) {
+    case chunkwm_filter_owner:
+        return ((Application) &&
+                (Application->Name) &&
+                (Entry->String) &&
+                (strcmp(Application->Name, Entry->String) == 0));
+    case chunkwm_filter_level:
+        return Window->Level == (uint32_t) Entry->Integer;
+    case chunkwm_filter_role:
+        return String && Window->Mainrole && CFEqual(Window->Mainrole, String);
+    case chunkwm_filter_subrole:
+        return String && Window->Subrole && CFEqual(Window->Subrole, String);
+    case chunkwm_filter_changed:
+        return Id != Filter->LastId;
+    default:
+        return true;
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Filters of the same type are alternatives, and every type that is listed
+ * must have a match. The id used by 'chunkwm_filter_changed' is only updated for events that
+ * are delivered.
+ */
+bool PluginFilterAccepts(plugin_filter *Filter, chunkwm_plugin_export Export, void *Data)
+{
+    if (!Data) return true;
+
+    macos_window *Window = NULL;
+    macos_application *Application = NULL;
+    uint32_t Id;
+
+    if (IsWindowExport(Export)) {
+        Window = (macos_window *) Data;
+        Application = Window->Owner;
+        Id = Window->Id;
+    } else {
+        Application = (macos_application *) Data;
+        Id = (uint32_t) Application->PID;
+    }
+
+    uint32_t Listed = 0;
+    uint32_t Matched = 0;
+
+    for (uint32_t Index = 0; Index < Filter->Count; ++Index) {
+        uint32_t Type = 1 << Filter->Filters[Index].Type;
+        Listed |= Type;
+
+        if (!(Matched & Type) && FilterMatches(Filter, Index, Window, Application, Id)) {
+            Matched |= Type;
+        }
+    }
+
+    bool Result = Listed == Matched;
+    if (Result) {
+        Filter->LastId = Id;
+        __atomic_add_fetch(&Filter->Hits, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_add_fetch(&Filter->Misses, 1, __ATOMIC_RELAXED);
+    }
+
+    return Result;
+}
@@ -0,0 +1,33 @@
+#ifndef CHUNKWM_CORE_FILTER_H
+#define CHUNKWM_CORE_FILTER_H
+
+#include <stdint.h>
+#include <Carbon/Carbon.h>
+
+#include "../api/plugin_api.h"
+
+/*
+ * NOTE(koekeishiya): The filters that a plugin listed for one export, built when the plugin
+ * is hooked. Strings for role and subrole are converted once, so that checking an event does
+ * not allocate. Filters are only checked on the thread that dispatches events; the counters
+ * are also read by 'core::filter_stats'.
+ */
+struct plugin_filter
+{
+    chunkwm_plugin_export Export;
+    chunkwm_filter *Filters;
+    CFStringRef *Strings;
+    uint32_t Count;
+
+    uint32_t LastId;
+    uint64_t volatile Hits;
+    uint64_t volatile Misses;
+};
+
+plugin_filter *CreatePluginFilters(plugin *Plugin, const char *Name, uint32_t *Count);
+void DestroyPluginFilters(plugin_filter *Filters, uint32_t Count);
+plugin_filter *FindPluginFilter(plugin_filter *Filters, uint32_t Count, chunkwm_plugin_export Export);
+
+bool PluginFilterAccepts(plugin_filter *Filter, chunkwm_plugin_export Export, void *Data);
+
+#endif
@@ -0,0 +1,95 @@
+#include "histogram.h"
+
+#define internal static
+
+internal inline uint32_t
+HistogramBucketIndex(uint64_t Value)
+{
+    if (Value < HISTOGRAM_SUB_BUCKETS) {
+        return (uint32_t) Value;
+    }
+
+    uint32_t HighestBit = 63 - __builtin_clzll(Value);
+    uint32_t Magnitude = HighestBit - HISTOGRAM_SUB_BUCKET_BITS + 1;
+    if (Magnitude >= HISTOGRAM_MAGNITUDES) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+
+    uint32_t SubBucket = (uint32_t) (Value >> (HighestBit - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return Magnitude * HISTOGRAM_SUB_BUCKETS + SubBucket;
+}
+
+// NOTE(koekeishiya): Returns the largest value that maps to the given bucket.
+internal inline uint64_t
+HistogramBucketValue(uint32_t Index)
+{
+    uint32_t Magnitude = Index / HISTOGRAM_SUB_BUCKETS;
+    uint64_t SubBucket = Index % HISTOGRAM_SUB_BUCKETS;
+
+    if (Magnitude == 0) {
+        return SubBucket;
+    }
+
+    uint64_t Lower = (HISTOGRAM_SUB_BUCKETS + SubBucket) << (Magnitude - 1);
+    return Lower + (1ULL << (Magnitude - 1)) - 1;
+}
+
+void HistogramRecord(latency_histogram *Histogram, uint64_t Value)
+{
+    __sync_fetch_and_add(&Histogram->Buckets[HistogramBucketIndex(Value)], 1);
+
+    uint64_t Max = Histogram->Max;
+    while (Value > Max) {
+        uint64_t Previous = __sync_val_compare_and_swap(&Histogram->Max, Max, Value);
+        if (Previous == Max) break;
+        Max = Previous;
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Values recorded concurrently with a reset may survive it;
+ * that is fine for a statistics counter.
+ */
+void HistogramReset(latency_histogram *Histogram)
+{
+    for (uint32_t Index = 0; Index < HISTOGRAM_BUCKETS; ++Index) {
+        __atomic_store_n(&Histogram->Buckets[Index], 0, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&Histogram->Max, 0, __ATOMIC_RELAXED);
+}
+
+uint64_t HistogramCount(latency_histogram *Histogram)
+{
+    uint64_t Result = 0;
+    for (uint32_t Index = 0; Index < HISTOGRAM_BUCKETS; ++Index) {
+        Result += __atomic_load_n(&Histogram->Buckets[Index], __ATOMIC_RELAXED);
+    }
+    return Result;
+}
+
+uint64_t HistogramMax(latency_histogram *Histogram)
+{
+    return __atomic_load_n(&Histogram->Max, __ATOMIC_RELAXED);
+}
+
+uint64_t HistogramPercentile(latency_histogram *Histogram, double Percentile)
+{
+    uint64_t Count = HistogramCount(Histogram);
+    if (!Count) return 0;
+
+    uint64_t Target = (uint64_t) ((Percentile / 100.0) * Count + 0.5);
+    if (Target < 1) Target = 1;
+
+    uint64_t Seen = 0;
+    for (uint32_t Index = 0; Index < HISTOGRAM_BUCKETS; ++Index) {
+        Seen += __atomic_load_n(&Histogram->Buckets[Index], __ATOMIC_RELAXED);
+        if (Seen >= Target) {
+            uint64_t Result = HistogramBucketValue(Index);
+            uint64_t Max = HistogramMax(Histogram);
+            return Result < Max ? Result : Max;
+        }
+    }
+
+    return HistogramMax(Histogram);
+}
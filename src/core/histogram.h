@@ -0,0 +1,30 @@
+#ifndef CHUNKWM_CORE_HISTOGRAM_H
+#define CHUNKWM_CORE_HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * NOTE(koekeishiya): Log-linear latency histogram in the style of HdrHistogram. Values
+ * below 16ns are stored exactly; above that every power of two is split into 16 buckets,
+ * which bounds the relative error of a reported percentile to 1/16. Recording is a couple
+ * of atomic adds, so it is safe to use from any thread without a lock.
+ */
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAGNITUDES 40
+#define HISTOGRAM_BUCKETS (HISTOGRAM_MAGNITUDES * HISTOGRAM_SUB_BUCKETS)
+
+struct latency_histogram
+{
+    uint64_t volatile Max;
+    uint64_t volatile Buckets[HISTOGRAM_BUCKETS];
+};
+
+void HistogramRecord(latency_histogram *Histogram, uint64_t Value);
+void HistogramReset(latency_histogram *Histogram);
+
+uint64_t HistogramCount(latency_histogram *Histogram);
+uint64_t HistogramMax(latency_histogram *Histogram);
+uint64_t HistogramPercentile(latency_histogram *Histogram, double Percentile);
+
+#endif
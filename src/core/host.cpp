@@ -0,0 +1,694 @@
+#include "host.h"
+#include "mailbox.h"
+#include "plugin.h"
+#include "trace.h"
+#include "cvar.h"
+#include "clog.h"
+
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+#include "../common/accessibility/element.h"
+#include "../common/ipc/daemon.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define internal static
+
+extern char **environ;
+
+CHUNKWM_API_BROADCAST_TOPIC_FUNC(ChunkwmBroadcastTopic);
+
+internal uint32_t volatile PluginHostCounter;
+
+internal void
+PluginHostDeadline(struct timespec *Deadline, int Milliseconds)
+{
+    struct timeval Now;
+    gettimeofday(&Now, NULL);
+
+    uint64_t Nanoseconds = (uint64_t) Now.tv_usec * 1000 + (uint64_t) Milliseconds * 1000000;
+    Deadline->tv_sec = Now.tv_sec + Nanoseconds / 1000000000;
+    Deadline->tv_nsec = Nanoseconds % 1000000000;
+}
+
+/*
+ * NOTE(koekeishiya): The host inherits the pipes as file descriptors 3 and 4. A pipe that
+ * already had one of those numbers would be closed by the dup2 of the other, so every end
+ * is moved above them first.
+ *
+ * Hosts are started concurrently while the plugins of the config-file load, so the ends must
+ * be close-on-exec from the moment they exist. A host that inherits the command pipe of another
+ * host keeps it open after that host has crashed, and the thread reading it never sees EOF.
+ * macOS has no 'pipe2', which is why 'SpawnPluginHost' also closes everything it did not dup2.
+ */
+internal bool
+CreatePluginHostPipe(int *Pipe)
+{
+    int Ends[2];
+#ifdef __APPLE__
+    if (pipe(Ends) != 0) {
+        return false;
+    }
+#else
+    if (pipe2(Ends, O_CLOEXEC) != 0) {
+        return false;
+    }
+#endif
+
+    for (int Index = 0; Index < 2; ++Index) {
+        Pipe[Index] = fcntl(Ends[Index], F_DUPFD_CLOEXEC, PLUGIN_HOST_COMMAND_FD + 1);
+        close(Ends[Index]);
+    }
+
+    if (Pipe[0] == -1 || Pipe[1] == -1) {
+        if (Pipe[0] != -1) close(Pipe[0]);
+        if (Pipe[1] != -1) close(Pipe[1]);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): On macOS the host only inherits stdin, stdout, stderr and its own pipes,
+ * so that it cannot hold on to the pipes of a host that is being started at the same time.
+ */
+internal bool
+SpawnPluginHost(pid_t *PID, const char *HostPath, char **Args, int EventFD, int CommandFD)
+{
+    posix_spawn_file_actions_t Actions;
+    posix_spawnattr_t Attributes;
+
+    posix_spawn_file_actions_init(&Actions);
+    posix_spawn_file_actions_adddup2(&Actions, EventFD, PLUGIN_HOST_EVENT_FD);
+    posix_spawn_file_actions_adddup2(&Actions, CommandFD, PLUGIN_HOST_COMMAND_FD);
+
+    posix_spawnattr_init(&Attributes);
+#ifdef __APPLE__
+    posix_spawn_file_actions_addinherit_np(&Actions, STDIN_FILENO);
+    posix_spawn_file_actions_addinherit_np(&Actions, STDOUT_FILENO);
+    posix_spawn_file_actions_addinherit_np(&Actions, STDERR_FILENO);
+    posix_spawnattr_setflags(&Attributes, POSIX_SPAWN_CLOEXEC_DEFAULT);
+#endif
+
+    bool Result = posix_spawnp(PID, HostPath, &Actions, &Attributes, Args, environ) == 0;
+
+    posix_spawnattr_destroy(&Attributes);
+    posix_spawn_file_actions_destroy(&Actions);
+    return Result;
+}
+
+internal inline void
+SetNonBlocking(int FD)
+{
+    fcntl(FD, F_SETFL, fcntl(FD, F_GETFL) | O_NONBLOCK);
+}
+
+internal bool
+ReadPluginHostInfo(trace_buffer *Buffer, plugin_host_info *Info)
+{
+    uint32_t ApiVersion, Count;
+    if (!TraceReadU32(Buffer, &ApiVersion) ||
+        !TraceReadString(Buffer, &Info->PluginName) ||
+        !TraceReadString(Buffer, &Info->PluginVersion) ||
+        !TraceReadU32(Buffer, &Count)) {
+        return false;
+    }
+
+    Info->ApiVersion = ApiVersion;
+    Info->SubscriptionCount = Count;
+    Info->Subscriptions = (chunkwm_plugin_export *) calloc(Count ? Count : 1, sizeof(chunkwm_plugin_export));
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        uint32_t Export;
+        if (!TraceReadU32(Buffer, &Export) || Export >= chunkwm_export_count) return false;
+        Info->Subscriptions[Index] = (chunkwm_plugin_export) Export;
+    }
+
+    if (!TraceReadU32(Buffer, &Count)) return false;
+    Info->FilterCount = Count;
+    Info->Filters = Count ? (chunkwm_filter *) calloc(Count, sizeof(chunkwm_filter)) : NULL;
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        chunkwm_filter *Filter = Info->Filters + Index;
+        uint32_t Export, Type, Integer;
+        char *String;
+        if (!TraceReadU32(Buffer, &Export) ||
+            !TraceReadU32(Buffer, &Type) ||
+            !TraceReadString(Buffer, &String) ||
+            !TraceReadU32(Buffer, &Integer)) {
+            return false;
+        }
+
+        if (Export >= chunkwm_export_count) {
+            free(String);
+            return false;
+        }
+
+        Filter->Export = (chunkwm_plugin_export) Export;
+        Filter->Type = (chunkwm_filter_type) Type;
+        Filter->String = String;
+        Filter->Integer = (int) Integer;
+    }
+
+    if (!TraceReadU32(Buffer, &Count) || Count > PLUGIN_TOPIC_COUNT) return false;
+    Info->LoadAfter = Count ? (const char **) calloc(Count + 1, sizeof(char *)) : NULL;
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        char *Name;
+        if (!TraceReadString(Buffer, &Name)) return false;
+        Info->LoadAfter[Index] = Name;
+    }
+
+    return true;
+}
+
+internal void
+FreePluginHostInfo(plugin_host_info *Info)
+{
+    free(Info->PluginName);
+    free(Info->PluginVersion);
+    free(Info->Subscriptions);
+
+    for (uint32_t Index = 0; Info->Filters && Index < Info->FilterCount; ++Index) {
+        free((char *) Info->Filters[Index].String);
+    }
+    free(Info->Filters);
+
+    for (const char **Name = Info->LoadAfter; Name && *Name; ++Name) {
+        free((char *) *Name);
+    }
+    free(Info->LoadAfter);
+
+    memset(Info, 0, sizeof(plugin_host_info));
+}
+
+// NOTE(koekeishiya): Writes the output of the plugin to the socket of the daemon command.
+internal void
+ReplyPluginHostCommand(plugin_host *Host, trace_buffer *Buffer)
+{
+    uint32_t Command, Last;
+    char *Text;
+    if (!TraceReadU32(Buffer, &Command) ||
+        !TraceReadU32(Buffer, &Last) ||
+        !TraceReadString(Buffer, &Text)) {
+        return;
+    }
+
+    plugin_payload *Payload = NULL;
+    pthread_mutex_lock(&Host->Lock);
+    std::map<uint32_t, plugin_payload *>::iterator It = Host->Replies.find(Command);
+    if (It != Host->Replies.end()) {
+        Payload = It->second;
+        if (Last) Host->Replies.erase(It);
+    }
+    pthread_mutex_unlock(&Host->Lock);
+
+    if (Payload) {
+        chunkwm_payload *Delegate = (chunkwm_payload *) Payload->Data;
+        if (*Text) WriteToSocket(Text, Delegate->SockFD);
+        if (Last) ReleasePluginPayload(Payload);
+    }
+
+    free(Text);
+}
+
+internal void
+HandlePluginHostMessage(plugin_host *Host, uint32_t Type, trace_buffer *Buffer)
+{
+    switch (Type) {
+    case host_message_hello: {
+        plugin_host_info Info = {};
+        if (!ReadPluginHostInfo(Buffer, &Info)) {
+            c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin host %d sent an invalid hello!\n", Host->PID);
+            FreePluginHostInfo(&Info);
+            break;
+        }
+
+        pthread_mutex_lock(&Host->Lock);
+        bool First = !Host->Hello;
+        if (First) {
+            Host->Info = Info;
+            Host->Hello = true;
+        }
+        pthread_cond_broadcast(&Host->Condition);
+        pthread_mutex_unlock(&Host->Lock);
+
+        if (!First) FreePluginHostInfo(&Info);
+    } break;
+    case host_message_init_result: {
+        uint32_t Success = 0;
+        TraceReadU32(Buffer, &Success);
+
+        pthread_mutex_lock(&Host->Lock);
+        Host->InitResult = Success ? 1 : 0;
+        pthread_cond_broadcast(&Host->Condition);
+        pthread_mutex_unlock(&Host->Lock);
+    } break;
+    case host_message_log: {
+        uint32_t Level;
+        char *Message;
+        if (TraceReadU32(Buffer, &Level) && TraceReadString(Buffer, &Message)) {
+            c_log((c_log_level) Level, "%s", Message);
+            free(Message);
+        }
+    } break;
+    case host_message_update_cvar: {
+        char *Name, *Value;
+        if (TraceReadString(Buffer, &Name)) {
+            if (TraceReadString(Buffer, &Value)) {
+                UpdateCVarAPI(Name, Value);
+                free(Value);
+            }
+            free(Name);
+        }
+    } break;
+    case host_message_broadcast: {
+        char *Plugin, *Event;
+        uint32_t Size;
+        if (TraceReadString(Buffer, &Plugin)) {
+            if (TraceReadString(Buffer, &Event)) {
+                if (TraceReadU32(Buffer, &Size) && Size <= Buffer->Size - Buffer->Cursor) {
+                    ChunkwmBroadcastTopic(InternTopic(Plugin, Event), Buffer->Data + Buffer->Cursor, Size);
+                }
+                free(Event);
+            }
+            free(Plugin);
+        }
+    } break;
+    case host_message_subscribe: {
+        char *Subscriber, *Plugin, *Event;
+        if (TraceReadString(Buffer, &Subscriber)) {
+            if (TraceReadString(Buffer, &Plugin)) {
+                if (TraceReadString(Buffer, &Event)) {
+                    SubscribeTopic(Subscriber, Plugin, Event);
+                    free(Event);
+                }
+                free(Plugin);
+            }
+            free(Subscriber);
+        }
+    } break;
+    case host_message_reply: {
+        ReplyPluginHostCommand(Host, Buffer);
+    } break;
+    }
+}
+
+internal void
+DrainPluginHostCommands(plugin_host *Host, trace_buffer *Buffer)
+{
+    uint32_t Type;
+    while (SharedRingRead(&Host->Commands, &Type, Buffer->Data, &Buffer->Size, TRACE_MAX_PAYLOAD)) {
+        Buffer->Cursor = 0;
+        Buffer->Overflow = false;
+        HandlePluginHostMessage(Host, Type, Buffer);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Serves the commands of a single host until it exits. The command pipe
+ * reaches end-of-file when the host exits for whatever reason, including a crash. The daemon
+ * commands it did not answer are closed, and events posted afterwards are dropped.
+ */
+internal void *
+PluginHostThreadProc(void *Context)
+{
+    plugin_host *Host = (plugin_host *) Context;
+    trace_buffer Buffer;
+
+    do {
+        DrainPluginHostCommands(Host, &Buffer);
+    } while (SharedRingWait(&Host->Commands, -1));
+    DrainPluginHostCommands(Host, &Buffer);
+
+    pthread_mutex_lock(&Host->Lock);
+    __atomic_store_n(&Host->Exited, true, __ATOMIC_RELEASE);
+    std::map<uint32_t, plugin_payload *> Replies;
+    Replies.swap(Host->Replies);
+    bool Stopping = Host->Stopping;
+    pthread_cond_broadcast(&Host->Condition);
+    pthread_mutex_unlock(&Host->Lock);
+
+    for (std::map<uint32_t, plugin_payload *>::iterator It = Replies.begin(); It != Replies.end(); ++It) {
+        ReleasePluginPayload(It->second);
+    }
+
+    if (Host->Hello && !Stopping) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin host %d of '%s' exited!\n", Host->PID, Host->Info.PluginName);
+    }
+
+    return NULL;
+}
+
+internal void
+DestroyPluginHost(plugin_host *Host, bool Graceful)
+{
+    pthread_mutex_lock(&Host->Lock);
+    Host->Stopping = true;
+    pthread_mutex_unlock(&Host->Lock);
+
+    if (Graceful && !__atomic_load_n(&Host->Exited, __ATOMIC_ACQUIRE)) {
+        SharedRingWrite(&Host->Events, host_message_deinit, NULL, 0);
+
+        struct timespec Deadline;
+        PluginHostDeadline(&Deadline, PLUGIN_HOST_TIMEOUT_MS);
+
+        pthread_mutex_lock(&Host->Lock);
+        while (!Host->Exited) {
+            if (pthread_cond_timedwait(&Host->Condition, &Host->Lock, &Deadline) == ETIMEDOUT) break;
+        }
+        pthread_mutex_unlock(&Host->Lock);
+    }
+
+    if (!__atomic_load_n(&Host->Exited, __ATOMIC_ACQUIRE)) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin host %d did not exit, killing it..\n", Host->PID);
+        kill(Host->PID, SIGKILL);
+    }
+
+    // NOTE(koekeishiya): The exit of the host, or the kill above, ends the thread.
+    pthread_join(Host->Thread, NULL);
+    waitpid(Host->PID, NULL, 0);
+
+    close(Host->Events.WakeFD);
+    close(Host->Commands.WaitFD);
+    munmap(Host->Memory, Host->MemorySize);
+
+    FreePluginHostInfo(&Host->Info);
+    pthread_cond_destroy(&Host->Condition);
+    pthread_mutex_destroy(&Host->Lock);
+    delete Host;
+}
+
+/*
+ * NOTE(koekeishiya): Spawns the host for the plugin at 'PluginPath' and waits for it to
+ * report the plugin. 'HostPath' is looked up in PATH unless it contains a slash. The plugin
+ * is not initialized yet, see 'InitPluginHost'.
+ */
+plugin_host *StartPluginHost(const char *HostPath, const char *PluginPath)
+{
+    int EventPipe[2], CommandPipe[2];
+    int Descriptor;
+    char *Args[4];
+    struct timespec Deadline;
+    bool Hello;
+    size_t EventSize = SharedRingMemorySize(PLUGIN_HOST_EVENT_RING_SIZE);
+
+    plugin_host *Host = new plugin_host();
+    Host->InitResult = -1;
+    snprintf(Host->SharedName, sizeof(Host->SharedName), "/chunkwm-%d-%u",
+             getpid(), __atomic_add_fetch(&PluginHostCounter, 1, __ATOMIC_RELAXED));
+
+    // NOTE(koekeishiya): A host that dies must not take chunkwm down when we write to its pipe.
+    signal(SIGPIPE, SIG_IGN);
+
+    Descriptor = shm_open(Host->SharedName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (Descriptor == -1) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not create shared memory for plugin host!\n");
+        goto shm_err;
+    }
+
+    Host->MemorySize = EventSize + SharedRingMemorySize(PLUGIN_HOST_COMMAND_RING_SIZE);
+    if (ftruncate(Descriptor, Host->MemorySize) != 0) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not size shared memory for plugin host!\n");
+        goto map_err;
+    }
+
+    Host->Memory = mmap(NULL, Host->MemorySize, PROT_READ | PROT_WRITE, MAP_SHARED, Descriptor, 0);
+    if (Host->Memory == MAP_FAILED) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not map shared memory for plugin host!\n");
+        goto map_err;
+    }
+    close(Descriptor);
+
+    if (!CreatePluginHostPipe(EventPipe)) {
+        goto event_pipe_err;
+    }
+
+    if (!CreatePluginHostPipe(CommandPipe)) {
+        goto command_pipe_err;
+    }
+
+    SetNonBlocking(EventPipe[1]);
+    SetNonBlocking(CommandPipe[1]);
+    SharedRingInit(&Host->Events, Host->Memory, PLUGIN_HOST_EVENT_RING_SIZE, -1, EventPipe[1]);
+    SharedRingInit(&Host->Commands, (uint8_t *) Host->Memory + EventSize, PLUGIN_HOST_COMMAND_RING_SIZE, CommandPipe[0], -1);
+
+    Args[0] = (char *) HostPath;
+    Args[1] = Host->SharedName;
+    Args[2] = (char *) PluginPath;
+    Args[3] = NULL;
+
+    if (!SpawnPluginHost(&Host->PID, HostPath, Args, EventPipe[0], CommandPipe[1])) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not spawn plugin host '%s'!\n", HostPath);
+        goto spawn_err;
+    }
+
+    close(EventPipe[0]);
+    close(CommandPipe[1]);
+
+    pthread_mutex_init(&Host->Lock, NULL);
+    pthread_cond_init(&Host->Condition, NULL);
+    if (pthread_create(&Host->Thread, NULL, &PluginHostThreadProc, Host) != 0) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not create thread for plugin host!\n");
+        kill(Host->PID, SIGKILL);
+        waitpid(Host->PID, NULL, 0);
+        close(EventPipe[1]);
+        close(CommandPipe[0]);
+        pthread_cond_destroy(&Host->Condition);
+        pthread_mutex_destroy(&Host->Lock);
+        goto shared_err;
+    }
+
+    PluginHostDeadline(&Deadline, PLUGIN_HOST_TIMEOUT_MS);
+    pthread_mutex_lock(&Host->Lock);
+    while (!Host->Hello && !Host->Exited) {
+        if (pthread_cond_timedwait(&Host->Condition, &Host->Lock, &Deadline) == ETIMEDOUT) break;
+    }
+    Hello = Host->Hello;
+    pthread_mutex_unlock(&Host->Lock);
+
+    // NOTE(koekeishiya): The host has mapped the memory once it says hello; nothing else may open it.
+    shm_unlink(Host->SharedName);
+
+    if (!Hello) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin host for '%s' did not start!\n", PluginPath);
+        DestroyPluginHost(Host, false);
+        return NULL;
+    }
+
+    return Host;
+
+spawn_err:
+    close(CommandPipe[0]);
+    close(CommandPipe[1]);
+
+command_pipe_err:
+    close(EventPipe[0]);
+    close(EventPipe[1]);
+
+event_pipe_err:
+shared_err:
+    munmap(Host->Memory, Host->MemorySize);
+    shm_unlink(Host->SharedName);
+    delete Host;
+    return NULL;
+
+map_err:
+    close(Descriptor);
+    shm_unlink(Host->SharedName);
+
+shm_err:
+    delete Host;
+    return NULL;
+}
+
+internal
+CVAR_ENUMERATE_FUNC(SendPluginHostCVar)
+{
+    plugin_host *Host = (plugin_host *) Context;
+
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteString(&Buffer, Name);
+    TraceWriteString(&Buffer, Value);
+    if (!Buffer.Overflow) {
+        SharedRingWrite(&Host->Events, host_message_cvar, Buffer.Data, Buffer.Size);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Hands the host a copy of every cvar, then calls the init function of
+ * the plugin. Returns false if the plugin failed to initialize or the host did not answer.
+ */
+bool InitPluginHost(plugin_host *Host)
+{
+    EnumerateCVars(&SendPluginHostCVar, Host);
+    SharedRingWrite(&Host->Events, host_message_init, NULL, 0);
+
+    struct timespec Deadline;
+    PluginHostDeadline(&Deadline, PLUGIN_HOST_TIMEOUT_MS);
+
+    pthread_mutex_lock(&Host->Lock);
+    while (Host->InitResult == -1 && !Host->Exited) {
+        if (pthread_cond_timedwait(&Host->Condition, &Host->Lock, &Deadline) == ETIMEDOUT) break;
+    }
+    bool Result = Host->InitResult == 1;
+    pthread_mutex_unlock(&Host->Lock);
+
+    return Result;
+}
+
+// NOTE(koekeishiya): Calls the deinit function of the plugin, and waits for the host to exit.
+void StopPluginHost(plugin_host *Host)
+{
+    DestroyPluginHost(Host, true);
+}
+
+internal char *
+CopyHostWindowRole(CFStringRef Role)
+{
+    return Role ? CopyCFStringToC(Role) : NULL;
+}
+
+/*
+ * NOTE(koekeishiya): The snapshot is taken from the window as it is, without asking the
+ * accessibility API, so that posting an event stays cheap. The handlers in callback.cpp
+ * refresh the window before the event is posted, and post a copy of it, see 'PostPluginWindow'.
+ */
+internal void
+WriteHostWindow(trace_buffer *Buffer, macos_window *Window)
+{
+    trace_window Snapshot = {};
+    Snapshot.Id = Window->Id;
+    Snapshot.Flags = Window->Flags;
+    Snapshot.Level = Window->Level;
+    Snapshot.PID = Window->Owner->PID;
+    Snapshot.X = Window->Position.x;
+    Snapshot.Y = Window->Position.y;
+    Snapshot.Width = Window->Size.width;
+    Snapshot.Height = Window->Size.height;
+    Snapshot.Owner = Window->Owner->Name;
+    Snapshot.Name = Window->Name;
+    Snapshot.Role = CopyHostWindowRole(Window->Mainrole);
+    Snapshot.Subrole = CopyHostWindowRole(Window->Subrole);
+
+    TraceWriteWindow(Buffer, &Snapshot);
+
+    free(Snapshot.Role);
+    free(Snapshot.Subrole);
+}
+
+// NOTE(koekeishiya): Returns the id that the replies of the host refer to, see 'ReplyPluginHostCommand'.
+internal uint32_t
+RetainPluginHostCommand(plugin_host *Host, plugin_payload *Payload)
+{
+    RetainPluginPayload(Payload);
+
+    pthread_mutex_lock(&Host->Lock);
+    uint32_t Command = ++Host->NextCommand;
+    Host->Replies[Command] = Payload;
+    pthread_mutex_unlock(&Host->Lock);
+
+    return Command;
+}
+
+internal void
+ReleasePluginHostCommand(plugin_host *Host, uint32_t Command)
+{
+    plugin_payload *Payload = NULL;
+
+    pthread_mutex_lock(&Host->Lock);
+    std::map<uint32_t, plugin_payload *>::iterator It = Host->Replies.find(Command);
+    if (It != Host->Replies.end()) {
+        Payload = It->second;
+        Host->Replies.erase(It);
+    }
+    pthread_mutex_unlock(&Host->Lock);
+
+    if (Payload) ReleasePluginPayload(Payload);
+}
+
+/*
+ * NOTE(koekeishiya): Must only be called by the thread that services the mailbox of the
+ * plugin. Serializes the event and writes it to the ring; never blocks. Returns false if
+ * the event was dropped, because the ring is full or the host has exited.
+ */
+bool PostPluginHost(plugin_host *Host, mailbox_message *Message)
+{
+    if (__atomic_load_n(&Host->Exited, __ATOMIC_ACQUIRE)) {
+        goto dropped;
+    }
+
+    {
+        trace_buffer Buffer;
+        TraceBufferReset(&Buffer);
+        TraceWriteU32(&Buffer, Message->Export);
+        TraceWriteU32(&Buffer, Message->Topic);
+
+        void *Data = Message->Payload->Data;
+        uint32_t Command = 0;
+
+        switch (HostPayloadForExport(Message->Export)) {
+        case host_payload_window: {
+            WriteHostWindow(&Buffer, (macos_window *) Data);
+        } break;
+        case host_payload_application: {
+            macos_application *Application = (macos_application *) Data;
+            trace_application Snapshot = { Application->PID, Application->Name };
+            TraceWriteApplication(&Buffer, &Snapshot);
+        } break;
+        case host_payload_display: {
+            TraceWriteU32(&Buffer, Data ? *(uint32_t *) Data : 0);
+        } break;
+        case host_payload_broadcast: {
+            TraceWriteString(&Buffer, Message->Node);
+            TraceWriteU32(&Buffer, Message->Payload->Size);
+            TraceWriteBytes(&Buffer, Data, Message->Payload->Size);
+        } break;
+        case host_payload_command: {
+            chunkwm_payload *Delegate = (chunkwm_payload *) Data;
+            Command = RetainPluginHostCommand(Host, Message->Payload);
+            TraceWriteU32(&Buffer, Command);
+            TraceWriteString(&Buffer, Delegate->Command);
+            TraceWriteString(&Buffer, Delegate->Message);
+        } break;
+        case host_payload_none: {
+        } break;
+        }
+
+        if (Buffer.Overflow) {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: '%s' is too large for plugin host %d, dropped!\n",
+                  Message->Node, Host->PID);
+        } else if (SharedRingWrite(&Host->Events, host_message_event, Buffer.Data, Buffer.Size)) {
+            __atomic_add_fetch(&Host->Posted, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+
+        if (Command) ReleasePluginHostCommand(Host, Command);
+    }
+
+dropped:
+    __atomic_add_fetch(&Host->Dropped, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+MAILBOX_DELIVER_FUNC(DeliverPluginHostMessage)
+{
+    PostPluginHost((plugin_host *) Context, Message);
+}
+
+plugin_host_stats PluginHostStats(plugin_host *Host)
+{
+    plugin_host_stats Result;
+    Result.Posted = __atomic_load_n(&Host->Posted, __ATOMIC_RELAXED);
+    Result.Dropped = __atomic_load_n(&Host->Dropped, __ATOMIC_RELAXED);
+    Result.Exited = __atomic_load_n(&Host->Exited, __ATOMIC_ACQUIRE);
+    return Result;
+}
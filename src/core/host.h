@@ -0,0 +1,186 @@
+#ifndef CHUNKWM_CORE_HOST_H
+#define CHUNKWM_CORE_HOST_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <map>
+
+#include "shmring.h"
+#include "mailbox.h"
+#include "../api/plugin_api.h"
+
+/*
+ * NOTE(koekeishiya): A plugin loaded with 'chunkc core::load_hosted' runs in a separate
+ * process, the plugin host (src/host), so that a plugin that blocks or crashes does not take
+ * chunkwm down with it. The core and the host share two rings, see shmring.h:
+ *
+ *   events     core -> host, the events posted to the mailbox of the plugin
+ *   commands   host -> core, the calls the plugin makes through 'chunkwm_api'
+ *
+ * Every message is a record whose type is a 'host_message', and whose payload is written with
+ * the trace functions, see trace.h. Windows and applications are sent as the same snapshots
+ * that are recorded by 'core::trace', and rebuilt by the host.
+ *
+ * The host is passed the name of the shared memory and the plugin as arguments, and the read
+ * end of the event pipe and the write end of the command pipe as file descriptors 3 and 4.
+ */
+#define PLUGIN_HOST_EVENT_FD 3
+#define PLUGIN_HOST_COMMAND_FD 4
+
+#define PLUGIN_HOST_EVENT_RING_SIZE (1 << 20)
+#define PLUGIN_HOST_COMMAND_RING_SIZE (1 << 18)
+
+#define PLUGIN_HOST_TIMEOUT_MS 5000
+
+/*
+ *   event ring
+ *     host_message_cvar           string Name, string Value
+ *     host_message_init
+ *     host_message_event          u32 Export, u32 Topic, payload of the export
+ *     host_message_deinit
+ *
+ *   command ring
+ *     host_message_hello          u32 ApiVersion, string Name, string Version,
+ *                                 u32 Count, u32 Export..,
+ *                                 u32 Count, (u32 Export, u32 Type, string String, u32 Integer)..,
+ *                                 u32 Count, string LoadAfter..
+ *     host_message_init_result    u32 Success
+ *     host_message_log            u32 Level, string Message
+ *     host_message_update_cvar    string Name, string Value
+ *     host_message_broadcast      string Plugin, string Event, u32 Size, Data
+ *     host_message_subscribe      string Subscriber, string Plugin, string Event
+ *     host_message_reply          u32 Command, u32 Last, string Text
+ *
+ * The payload of an event is a trace_window for window exports, a trace_application for
+ * application exports, a u32 display id for display exports, 'string Node, u32 Size, Data'
+ * for a broadcast, and 'u32 Command, string Command, string Message' for a daemon command.
+ * The host answers a daemon command with one or more replies, the last one closes the socket.
+ */
+enum host_message
+{
+    host_message_cvar,
+    host_message_init,
+    host_message_event,
+    host_message_deinit,
+
+    host_message_hello,
+    host_message_init_result,
+    host_message_log,
+    host_message_update_cvar,
+    host_message_broadcast,
+    host_message_subscribe,
+    host_message_reply,
+};
+
+// NOTE(koekeishiya): The payload that is written after the export and topic of an event.
+enum host_payload
+{
+    host_payload_none,
+    host_payload_window,
+    host_payload_application,
+    host_payload_display,
+    host_payload_broadcast,
+    host_payload_command,
+};
+
+inline host_payload
+HostPayloadForExport(chunkwm_plugin_export Export)
+{
+    switch (Export) {
+    case chunkwm_export_window_created:
+    case chunkwm_export_window_destroyed:
+    case chunkwm_export_window_focused:
+    case chunkwm_export_window_moved:
+    case chunkwm_export_window_resized:
+    case chunkwm_export_window_minimized:
+    case chunkwm_export_window_deminimized:
+    case chunkwm_export_window_title_changed:
+        return host_payload_window;
+    case chunkwm_export_application_launched:
+    case chunkwm_export_application_terminated:
+    case chunkwm_export_application_activated:
+    case chunkwm_export_application_deactivated:
+    case chunkwm_export_application_hidden:
+    case chunkwm_export_application_unhidden:
+        return host_payload_application;
+    case chunkwm_export_display_added:
+    case chunkwm_export_display_removed:
+    case chunkwm_export_display_moved:
+    case chunkwm_export_display_resized:
+        return host_payload_display;
+    case chunkwm_export_plugin_broadcast:
+        return host_payload_broadcast;
+    case chunkwm_export_daemon_command:
+        return host_payload_command;
+    default:
+        return host_payload_none;
+    }
+}
+
+// NOTE(koekeishiya): What the plugin reported about itself, see 'host_message_hello'.
+struct plugin_host_info
+{
+    int ApiVersion;
+    char *PluginName;
+    char *PluginVersion;
+
+    chunkwm_plugin_export *Subscriptions;
+    uint32_t SubscriptionCount;
+
+    chunkwm_filter *Filters;
+    uint32_t FilterCount;
+
+    const char **LoadAfter;
+};
+
+/*
+ * NOTE(koekeishiya): Events are posted by the thread that services the mailbox of the plugin,
+ * so there is only ever one producer. An event that does not fit in the ring is dropped; the
+ * core never waits for the host. 'Replies' holds on to the daemon commands that the host has
+ * not answered yet, so that their socket stays open.
+ */
+struct plugin_host
+{
+    pid_t PID;
+    char SharedName[64];
+    void *Memory;
+    size_t MemorySize;
+
+    shared_ring Events;
+    shared_ring Commands;
+    pthread_t Thread;
+
+    pthread_mutex_t Lock;
+    pthread_cond_t Condition;
+    bool Hello;
+    bool Exited;
+    bool Stopping;
+    int InitResult;
+
+    plugin_host_info Info;
+
+    std::map<uint32_t, plugin_payload *> Replies;
+    uint32_t NextCommand;
+
+    uint64_t volatile Posted;
+    uint64_t volatile Dropped;
+};
+
+struct plugin_host_stats
+{
+    uint64_t Posted;
+    uint64_t Dropped;
+    bool Exited;
+};
+
+plugin_host *StartPluginHost(const char *HostPath, const char *PluginPath);
+bool InitPluginHost(plugin_host *Host);
+void StopPluginHost(plugin_host *Host);
+
+bool PostPluginHost(plugin_host *Host, mailbox_message *Message);
+MAILBOX_DELIVER_FUNC(DeliverPluginHostMessage);
+plugin_host_stats PluginHostStats(plugin_host *Host);
+
+#endif
@@ -0,0 +1,514 @@
+#include "mailbox.h"
+#include "plugin.h"
+
+#include "clog.h"
+
+#include "../api/plugin_api.h"
+#include "../common/misc/timer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define internal static
+
+internal thread_pool *MailboxPool;
+internal pthread_mutex_t PayloadPoolLock;
+internal plugin_payload *PayloadPool;
+internal uint32_t PayloadPoolCount;
+internal pthread_mutex_t HeldLock;
+internal plugin_mailbox *HeldMailboxes;
+internal uint64_t volatile PluginBudget;
+
+internal inline void
+AddStat(uint64_t volatile *Stat, uint64_t Value)
+{
+    __atomic_store_n(Stat, __atomic_load_n(Stat, __ATOMIC_RELAXED) + Value, __ATOMIC_RELAXED);
+}
+
+internal
+PLUGIN_PAYLOAD_DESTRUCTOR(FreePayloadCopy)
+{
+    free(Data);
+}
+
+internal plugin_payload *
+AllocatePluginPayload()
+{
+    pthread_mutex_lock(&PayloadPoolLock);
+
+    plugin_payload *Payload = PayloadPool;
+    if (Payload) {
+        PayloadPool = Payload->Next;
+        --PayloadPoolCount;
+    }
+
+    pthread_mutex_unlock(&PayloadPoolLock);
+
+    if (!Payload) {
+        Payload = (plugin_payload *) malloc(sizeof(plugin_payload));
+    }
+
+    return Payload;
+}
+
+internal void
+FreePluginPayload(plugin_payload *Payload)
+{
+    pthread_mutex_lock(&PayloadPoolLock);
+
+    bool Pooled = PayloadPoolCount < PLUGIN_PAYLOAD_POOL_SIZE;
+    if (Pooled) {
+        Payload->Next = PayloadPool;
+        PayloadPool = Payload;
+        ++PayloadPoolCount;
+    }
+
+    pthread_mutex_unlock(&PayloadPoolLock);
+
+    if (!Pooled) {
+        free(Payload);
+    }
+}
+
+plugin_payload *CreatePluginPayload(void *Data, plugin_payload_destructor *Destroy, void *Context)
+{
+    plugin_payload *Payload = AllocatePluginPayload();
+    Payload->RefCount = 1;
+    Payload->Data = Data;
+    Payload->Size = 0;
+    Payload->Context = Context;
+    Payload->Destroy = Destroy;
+    return Payload;
+}
+
+// NOTE(koekeishiya): A payload of zero bytes has no data.
+plugin_payload *CreatePluginPayloadCopy(void *Data, size_t Size, void *Context)
+{
+    plugin_payload *Payload = AllocatePluginPayload();
+    Payload->RefCount = 1;
+    Payload->Size = Size;
+    Payload->Context = Context;
+
+    if (!Size) {
+        Payload->Data = NULL;
+        Payload->Destroy = NULL;
+    } else if (Size <= PLUGIN_PAYLOAD_INLINE_SIZE) {
+        Payload->Data = Payload->Inline;
+        Payload->Destroy = NULL;
+        memcpy(Payload->Inline, Data, Size);
+    } else {
+        Payload->Data = malloc(Size);
+        Payload->Destroy = &FreePayloadCopy;
+        memcpy(Payload->Data, Data, Size);
+    }
+
+    return Payload;
+}
+
+void RetainPluginPayload(plugin_payload *Payload)
+{
+    __atomic_add_fetch(&Payload->RefCount, 1, __ATOMIC_RELAXED);
+}
+
+void ReleasePluginPayload(plugin_payload *Payload)
+{
+    if (__atomic_sub_fetch(&Payload->RefCount, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (Payload->Destroy) {
+            Payload->Destroy(Payload->Data, Payload->Context);
+        }
+
+        FreePluginPayload(Payload);
+    }
+}
+
+// NOTE(koekeishiya): Must be called with the mailbox locked.
+internal void
+GrowMailbox(plugin_mailbox *Mailbox)
+{
+    uint32_t Capacity = Mailbox->Capacity * 2;
+    mailbox_message *Messages = (mailbox_message *) malloc(Capacity * sizeof(mailbox_message));
+
+    for (uint32_t Index = 0; Index < Mailbox->Count; ++Index) {
+        Messages[Index] = Mailbox->Messages[(Mailbox->Head + Index) % Mailbox->Capacity];
+    }
+
+    free(Mailbox->Messages);
+    Mailbox->Messages = Messages;
+    Mailbox->Capacity = Capacity;
+    Mailbox->Head = 0;
+}
+
+/*
+ * NOTE(koekeishiya): Only the thread that services the mailbox writes to its stats, but
+ * 'core::plugin_stats' and the watchdog read them while a plugin is running.
+ */
+internal inline uint64_t
+BeginPluginCall(plugin_mailbox *Mailbox, int ExportIndex)
+{
+    __atomic_store_n(&Mailbox->CallExport, ExportIndex, __ATOMIC_RELAXED);
+    uint64_t Begin = GetTimeNanoseconds();
+    __atomic_store_n(&Mailbox->CallBegin, Begin, __ATOMIC_RELEASE);
+    return Begin;
+}
+
+internal void
+EndPluginCall(plugin_mailbox *Mailbox, int ExportIndex, uint64_t Begin, uint64_t CpuBegin)
+{
+    uint64_t Latency = GetTimeNanoseconds() - Begin;
+    uint64_t CpuTime = GetThreadCpuNanoseconds() - CpuBegin;
+    __atomic_store_n(&Mailbox->CallBegin, 0, __ATOMIC_RELEASE);
+
+    plugin_export_stats *Stats = Mailbox->Exports + ExportIndex;
+    AddStat(&Stats->Calls, 1);
+    AddStat(&Stats->CpuTime, CpuTime);
+    AddStat(&Stats->TotalLatency, Latency);
+    if (Latency > Stats->MaxLatency) {
+        __atomic_store_n(&Stats->MaxLatency, Latency, __ATOMIC_RELAXED);
+    }
+
+    uint64_t Budget = __atomic_load_n(&PluginBudget, __ATOMIC_RELAXED);
+    if (Budget && Latency > Budget) {
+        AddStat(&Stats->OverBudget, 1);
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' spent %.1fms in '%s', budget is %.1fms\n",
+              Mailbox->Name, Latency / 1000000.0, PluginExportStatsName(ExportIndex), Budget / 1000000.0);
+    }
+}
+
+internal void
+DeliverPluginMessage(plugin_mailbox *Mailbox, mailbox_message *Message)
+{
+    uint64_t CpuBegin = GetThreadCpuNanoseconds();
+    uint64_t Begin = BeginPluginCall(Mailbox, Message->Export);
+
+    if (Mailbox->Deliver) {
+        Mailbox->Deliver(Mailbox->DeliverContext, Message);
+    } else {
+        RunPlugin(Mailbox->Plugin, Mailbox->Legacy, Message->Export,
+                  Message->Topic, Message->Node, Message->Payload->Data);
+    }
+
+    EndPluginCall(Mailbox, Message->Export, Begin, CpuBegin);
+}
+
+internal void
+DeliverPluginBatch(plugin_mailbox *Mailbox, chunkwm_event *Events, uint32_t Count)
+{
+    uint64_t CpuBegin = GetThreadCpuNanoseconds();
+    uint64_t Begin = BeginPluginCall(Mailbox, MAILBOX_BATCH_STATS);
+
+    Mailbox->RunBatch(Events, Count);
+
+    EndPluginCall(Mailbox, MAILBOX_BATCH_STATS, Begin, CpuBegin);
+}
+
+/*
+ * NOTE(koekeishiya): Deliver up to 'MAILBOX_BATCH_SIZE' messages. If there are more, the
+ * mailbox stays scheduled and is submitted to the pool again, so that a busy plugin does
+ * not keep a thread to itself while the mailboxes of other plugins are waiting.
+ */
+internal bool
+RunPluginMailbox(plugin_mailbox *Mailbox)
+{
+    for (int Index = 0; Index < MAILBOX_BATCH_SIZE; ++Index) {
+        pthread_mutex_lock(&Mailbox->Lock);
+
+        if (!Mailbox->Count) {
+            Mailbox->Scheduled = false;
+            pthread_mutex_unlock(&Mailbox->Lock);
+            return false;
+        }
+
+        mailbox_message Message = Mailbox->Messages[Mailbox->Head];
+        Mailbox->Head = (Mailbox->Head + 1) % Mailbox->Capacity;
+        --Mailbox->Count;
+
+        pthread_mutex_unlock(&Mailbox->Lock);
+
+        if (Message.Node) {
+            DeliverPluginMessage(Mailbox, &Message);
+            __atomic_add_fetch(&Mailbox->Delivered, 1, __ATOMIC_RELAXED);
+        }
+
+        ReleasePluginPayload(Message.Payload);
+        __atomic_sub_fetch(&Mailbox->Depth, 1, __ATOMIC_RELAXED);
+    }
+
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): Takes up to 'MAILBOX_BATCH_SIZE' messages at once and passes them to
+ * 'RunBatch' in a single call. Fence posts are released, but not passed to the plugin.
+ * The callback of a cvar watch is run on its own, see watch.h.
+ */
+internal bool
+RunPluginMailboxBatch(plugin_mailbox *Mailbox)
+{
+    mailbox_message Messages[MAILBOX_BATCH_SIZE];
+    chunkwm_event Events[MAILBOX_BATCH_SIZE];
+    uint32_t EventCount = 0;
+
+    pthread_mutex_lock(&Mailbox->Lock);
+
+    uint32_t Count = Mailbox->Count < MAILBOX_BATCH_SIZE ? Mailbox->Count : MAILBOX_BATCH_SIZE;
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        Messages[Index] = Mailbox->Messages[Mailbox->Head];
+        Mailbox->Head = (Mailbox->Head + 1) % Mailbox->Capacity;
+    }
+    Mailbox->Count -= Count;
+
+    pthread_mutex_unlock(&Mailbox->Lock);
+
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        mailbox_message *Message = Messages + Index;
+        if (Message->Node && Message->Export == chunkwm_export_cvar_changed) {
+            /*
+             * NOTE(koekeishiya): The callback of a cvar watch is not part of a batch. The events
+             * before it are delivered first, so that the plugin still sees everything in order.
+             */
+            if (EventCount) {
+                DeliverPluginBatch(Mailbox, Events, EventCount);
+                __atomic_add_fetch(&Mailbox->Delivered, EventCount, __ATOMIC_RELAXED);
+                EventCount = 0;
+            }
+
+            DeliverPluginMessage(Mailbox, Message);
+            __atomic_add_fetch(&Mailbox->Delivered, 1, __ATOMIC_RELAXED);
+        } else if (Message->Node) {
+            chunkwm_event *Event = Events + EventCount++;
+            Event->Export = Message->Export;
+            Event->Topic = Message->Topic;
+            Event->Node = Message->Node;
+            Event->Data = Message->Payload->Data;
+        }
+    }
+
+    if (EventCount) {
+        DeliverPluginBatch(Mailbox, Events, EventCount);
+        __atomic_add_fetch(&Mailbox->Delivered, EventCount, __ATOMIC_RELAXED);
+    }
+
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        ReleasePluginPayload(Messages[Index].Payload);
+    }
+    __atomic_sub_fetch(&Mailbox->Depth, Count, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&Mailbox->Lock);
+    bool Result = Mailbox->Count != 0;
+    if (!Result) {
+        Mailbox->Scheduled = false;
+    }
+    pthread_mutex_unlock(&Mailbox->Lock);
+
+    return Result;
+}
+
+internal inline bool
+RunPluginMailboxOnce(plugin_mailbox *Mailbox)
+{
+    return Mailbox->RunBatch ? RunPluginMailboxBatch(Mailbox) : RunPluginMailbox(Mailbox);
+}
+
+internal
+THREAD_POOL_CALLBACK(PluginMailboxCallback)
+{
+    plugin_mailbox *Mailbox = (plugin_mailbox *) Data;
+    if (RunPluginMailboxOnce(Mailbox)) {
+        ThreadPoolSubmit(MailboxPool, &Mailbox->Group, &PluginMailboxCallback, Mailbox);
+    }
+}
+
+// NOTE(koekeishiya): Without a pool, messages are delivered on the thread that posts them.
+bool BeginPluginMailboxes(thread_pool *Pool)
+{
+    MailboxPool = Pool;
+    return ((pthread_mutex_init(&PayloadPoolLock, NULL) == 0) &&
+            (pthread_mutex_init(&HeldLock, NULL) == 0));
+}
+
+plugin_mailbox *CreatePluginMailbox(plugin *Plugin, const char *Name, bool Legacy)
+{
+    plugin_mailbox *Mailbox = (plugin_mailbox *) malloc(sizeof(plugin_mailbox));
+    memset(Mailbox, 0, sizeof(plugin_mailbox));
+
+    if (pthread_mutex_init(&Mailbox->Lock, NULL) != 0) {
+        goto lock_err;
+    }
+
+    Mailbox->Messages = (mailbox_message *) malloc(MAILBOX_INITIAL_SIZE * sizeof(mailbox_message));
+    Mailbox->Capacity = MAILBOX_INITIAL_SIZE;
+    Mailbox->Plugin = Plugin;
+    Mailbox->Name = Name;
+    Mailbox->Legacy = Legacy;
+    Mailbox->RunBatch = Legacy ? NULL : Plugin->RunBatch;
+    goto out;
+
+lock_err:
+    free(Mailbox);
+    Mailbox = NULL;
+
+out:
+    return Mailbox;
+}
+
+/*
+ * NOTE(koekeishiya): Returns when every message that has been posted is delivered. The
+ * caller must make sure that nothing new is posted in the meantime, e.g. by unsubscribing.
+ */
+void DrainPluginMailbox(plugin_mailbox *Mailbox)
+{
+    FlushPluginMailboxes();
+    if (MailboxPool) {
+        ThreadPoolWait(MailboxPool, &Mailbox->Group);
+    }
+}
+
+void DestroyPluginMailbox(plugin_mailbox *Mailbox)
+{
+    for (uint32_t Index = 0; Index < Mailbox->Count; ++Index) {
+        ReleasePluginPayload(Mailbox->Messages[(Mailbox->Head + Index) % Mailbox->Capacity].Payload);
+    }
+
+    pthread_mutex_destroy(&Mailbox->Lock);
+    free(Mailbox->Messages);
+    free(Mailbox);
+}
+
+// NOTE(koekeishiya): Must only be called by whoever set 'Scheduled'.
+internal void
+SchedulePluginMailbox(plugin_mailbox *Mailbox)
+{
+    if (MailboxPool && MailboxPool->ThreadCount) {
+        ThreadPoolSubmit(MailboxPool, &Mailbox->Group, &PluginMailboxCallback, Mailbox);
+    } else {
+        while (RunPluginMailboxOnce(Mailbox));
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Takes a new reference to 'Payload'. With no pool threads, the message is
+ * delivered right away, unless the mailbox is held for a batch.
+ */
+void PostPluginMailbox(plugin_mailbox *Mailbox, chunkwm_plugin_export Export, uint32_t Topic,
+                       const char *Node, plugin_payload *Payload)
+{
+    RetainPluginPayload(Payload);
+
+    uint32_t Depth = __atomic_add_fetch(&Mailbox->Depth, 1, __ATOMIC_RELAXED);
+
+    // NOTE(koekeishiya): 'MaxDepth' is only written under the lock, so concurrent posts can not lose the maximum.
+    pthread_mutex_lock(&Mailbox->Lock);
+    if (Depth > Mailbox->MaxDepth) {
+        __atomic_store_n(&Mailbox->MaxDepth, Depth, __ATOMIC_RELAXED);
+    }
+
+    if (Mailbox->Count == Mailbox->Capacity) {
+        GrowMailbox(Mailbox);
+    }
+
+    mailbox_message *Message = Mailbox->Messages + ((Mailbox->Head + Mailbox->Count) % Mailbox->Capacity);
+    Message->Export = Export;
+    Message->Topic = Topic;
+    Message->Node = Node;
+    Message->Payload = Payload;
+    ++Mailbox->Count;
+
+    bool Hold = Mailbox->RunBatch && !Mailbox->Scheduled && !Mailbox->Held;
+    bool Schedule = !Mailbox->RunBatch && !Mailbox->Scheduled;
+    if (Hold) {
+        Mailbox->Held = true;
+    } else if (Schedule) {
+        Mailbox->Scheduled = true;
+    }
+
+    pthread_mutex_unlock(&Mailbox->Lock);
+
+    if (Hold) {
+        pthread_mutex_lock(&HeldLock);
+        Mailbox->NextHeld = HeldMailboxes;
+        HeldMailboxes = Mailbox;
+        pthread_mutex_unlock(&HeldLock);
+    } else if (Schedule) {
+        SchedulePluginMailbox(Mailbox);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Schedules every mailbox that has been held since the last call. Called
+ * by the event-loop at the end of every dispatch round, see 'SetEventRoundHook'.
+ */
+void FlushPluginMailboxes()
+{
+    pthread_mutex_lock(&HeldLock);
+    plugin_mailbox *Mailbox = HeldMailboxes;
+    HeldMailboxes = NULL;
+    pthread_mutex_unlock(&HeldLock);
+
+    while (Mailbox) {
+        plugin_mailbox *Next = Mailbox->NextHeld;
+
+        pthread_mutex_lock(&Mailbox->Lock);
+        bool Schedule = !Mailbox->Scheduled && Mailbox->Count;
+        Mailbox->Held = false;
+        Mailbox->Scheduled = Mailbox->Scheduled || Schedule;
+        pthread_mutex_unlock(&Mailbox->Lock);
+
+        if (Schedule) {
+            SchedulePluginMailbox(Mailbox);
+        }
+
+        Mailbox = Next;
+    }
+}
+
+plugin_mailbox_stats PluginMailboxStats(plugin_mailbox *Mailbox)
+{
+    plugin_mailbox_stats Stats;
+    Stats.Depth = __atomic_load_n(&Mailbox->Depth, __ATOMIC_RELAXED);
+    Stats.MaxDepth = __atomic_load_n(&Mailbox->MaxDepth, __ATOMIC_RELAXED);
+    Stats.Delivered = __atomic_load_n(&Mailbox->Delivered, __ATOMIC_RELAXED);
+    return Stats;
+}
+
+plugin_export_stats PluginExportStats(plugin_mailbox *Mailbox, int ExportIndex)
+{
+    plugin_export_stats *Source = Mailbox->Exports + ExportIndex;
+    plugin_export_stats Stats;
+    Stats.Calls = __atomic_load_n(&Source->Calls, __ATOMIC_RELAXED);
+    Stats.CpuTime = __atomic_load_n(&Source->CpuTime, __ATOMIC_RELAXED);
+    Stats.TotalLatency = __atomic_load_n(&Source->TotalLatency, __ATOMIC_RELAXED);
+    Stats.MaxLatency = __atomic_load_n(&Source->MaxLatency, __ATOMIC_RELAXED);
+    Stats.OverBudget = __atomic_load_n(&Source->OverBudget, __ATOMIC_RELAXED);
+    return Stats;
+}
+
+const char *PluginExportStatsName(int ExportIndex)
+{
+    return ExportIndex == MAILBOX_BATCH_STATS ? "(batches)" : chunkwm_plugin_export_str[ExportIndex];
+}
+
+// NOTE(koekeishiya): Zero disables the budget.
+void SetPluginBudget(uint32_t Milliseconds)
+{
+    __atomic_store_n(&PluginBudget, (uint64_t) Milliseconds * 1000000ULL, __ATOMIC_RELAXED);
+}
+
+/*
+ * NOTE(koekeishiya): Called by the watchdog, see 'BeginPluginWatchdog'. Reports a plugin that
+ * is still running past its budget, e.g. blocked on an unresponsive application, once per call.
+ */
+void CheckPluginBudget(plugin_mailbox *Mailbox)
+{
+    uint64_t Budget = __atomic_load_n(&PluginBudget, __ATOMIC_RELAXED);
+    uint64_t Begin = __atomic_load_n(&Mailbox->CallBegin, __ATOMIC_ACQUIRE);
+    if (!Budget || !Begin || Begin == Mailbox->ReportedCall) return;
+
+    uint64_t Elapsed = GetTimeNanoseconds() - Begin;
+    if (Elapsed <= Budget) return;
+
+    int ExportIndex = __atomic_load_n(&Mailbox->CallExport, __ATOMIC_RELAXED);
+    uint32_t Depth = __atomic_load_n(&Mailbox->Depth, __ATOMIC_RELAXED);
+    c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' has been in '%s' for %.1fms, budget is %.1fms; %u events waiting\n",
+          Mailbox->Name, PluginExportStatsName(ExportIndex), Elapsed / 1000000.0, Budget / 1000000.0, Depth ? Depth - 1 : 0);
+    Mailbox->ReportedCall = Begin;
+}
@@ -0,0 +1,140 @@
+#ifndef CHUNKWM_CORE_MAILBOX_H
+#define CHUNKWM_CORE_MAILBOX_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "pool.h"
+#include "../api/plugin_api.h"
+
+#define PLUGIN_PAYLOAD_DESTRUCTOR(name) void name(void *Data, void *Context)
+typedef PLUGIN_PAYLOAD_DESTRUCTOR(plugin_payload_destructor);
+
+/*
+ * NOTE(koekeishiya): The data passed to plugins for a single event. Every mailbox that the
+ * event is posted to holds a reference, and 'Destroy' runs when the last one is released.
+ * 'Context' is only seen by the destructor, e.g. the previous title of a window.
+ *
+ * Payloads are recycled through a free-list of up to 'PLUGIN_PAYLOAD_POOL_SIZE' entries.
+ * A payload created by 'CreatePluginPayloadCopy' keeps a copy of up to 'Inline' bytes in
+ * place, so that a plugin broadcast does not allocate at all. 'Size' is only known for a copy.
+ */
+#define PLUGIN_PAYLOAD_INLINE_SIZE 128
+#define PLUGIN_PAYLOAD_POOL_SIZE 256
+
+struct plugin_payload
+{
+    uint32_t volatile RefCount;
+    void *Data;
+    void *Context;
+    plugin_payload_destructor *Destroy;
+
+    size_t Size;
+
+    plugin_payload *Next;
+    uint64_t Inline[PLUGIN_PAYLOAD_INLINE_SIZE / sizeof(uint64_t)];
+};
+
+plugin_payload *CreatePluginPayload(void *Data, plugin_payload_destructor *Destroy, void *Context);
+plugin_payload *CreatePluginPayloadCopy(void *Data, size_t Size, void *Context);
+void RetainPluginPayload(plugin_payload *Payload);
+void ReleasePluginPayload(plugin_payload *Payload);
+
+/*
+ * NOTE(koekeishiya): A message without a node is not delivered. It only holds on to its
+ * payload until the plugin has processed every message that was posted before it. The
+ * node is the name of the export, or the name of the event for a plugin broadcast.
+ */
+struct mailbox_message
+{
+    chunkwm_plugin_export Export;
+    uint32_t Topic;
+    const char *Node;
+    plugin_payload *Payload;
+};
+
+// NOTE(koekeishiya): Times are in nanoseconds; 'Latency' is wall-clock time spent in the plugin.
+struct plugin_export_stats
+{
+    uint64_t volatile Calls;
+    uint64_t volatile CpuTime;
+    uint64_t volatile TotalLatency;
+    uint64_t volatile MaxLatency;
+    uint64_t volatile OverBudget;
+};
+
+/*
+ * NOTE(koekeishiya): Every loaded plugin has a mailbox that is serviced by at most one
+ * thread of the pool at a time, so a plugin never runs concurrently with itself and sees
+ * its events in the order they were posted. The ring doubles in size when full.
+ *
+ * The mailbox of a plugin that has a 'RunBatch' function is not scheduled when a message is
+ * posted, but held until 'FlushPluginMailboxes' is called at the end of a dispatch round.
+ * Its messages are then delivered up to 'MAILBOX_BATCH_SIZE' at a time. The stats of those
+ * calls are kept under 'MAILBOX_BATCH_STATS'.
+ *
+ * A mailbox that has a 'Deliver' function passes its messages to it instead of the plugin,
+ * e.g. to send them to a plugin host, see host.h.
+ */
+#define MAILBOX_DELIVER_FUNC(name) void name(void *Context, mailbox_message *Message)
+typedef MAILBOX_DELIVER_FUNC(mailbox_deliver_func);
+
+#define MAILBOX_INITIAL_SIZE 64
+#define MAILBOX_BATCH_SIZE 32
+#define MAILBOX_BATCH_STATS chunkwm_export_message_count
+#define MAILBOX_STATS_COUNT (MAILBOX_BATCH_STATS + 1)
+
+struct plugin_mailbox
+{
+    plugin *Plugin;
+    const char *Name;
+    bool Legacy;
+    plugin_batch_func *RunBatch;
+    mailbox_deliver_func *Deliver;
+    void *DeliverContext;
+
+    pthread_mutex_t Lock;
+    mailbox_message *Messages;
+    uint32_t Capacity;
+    uint32_t Head;
+    uint32_t Count;
+    bool Scheduled;
+    bool Held;
+    plugin_mailbox *NextHeld;
+
+    task_group Group;
+
+    uint32_t volatile Depth;
+    uint32_t volatile MaxDepth;
+    uint64_t volatile Delivered;
+
+    int volatile CallExport;
+    uint64_t volatile CallBegin;
+    uint64_t ReportedCall;
+    plugin_export_stats Exports[MAILBOX_STATS_COUNT];
+};
+
+struct plugin_mailbox_stats
+{
+    uint32_t Depth;
+    uint32_t MaxDepth;
+    uint64_t Delivered;
+};
+
+bool BeginPluginMailboxes(thread_pool *Pool);
+
+plugin_mailbox *CreatePluginMailbox(plugin *Plugin, const char *Name, bool Legacy);
+void DrainPluginMailbox(plugin_mailbox *Mailbox);
+void DestroyPluginMailbox(plugin_mailbox *Mailbox);
+
+void PostPluginMailbox(plugin_mailbox *Mailbox, chunkwm_plugin_export Export, uint32_t Topic,
+                       const char *Node, plugin_payload *Payload);
+void FlushPluginMailboxes();
+plugin_mailbox_stats PluginMailboxStats(plugin_mailbox *Mailbox);
+plugin_export_stats PluginExportStats(plugin_mailbox *Mailbox, int ExportIndex);
+const char *PluginExportStatsName(int ExportIndex);
+
+void SetPluginBudget(uint32_t Milliseconds);
+void CheckPluginBudget(plugin_mailbox *Mailbox);
+
+#endif
@@ -0,0 +1,170 @@
+#include "method.h"
+#include "epoch.h"
+#include "clog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define internal static
+
+internal pthread_mutex_t MethodTableLock;
+internal plugin_method_table *volatile MethodTable;
+internal plugin_method_table EmptyMethodTable;
+internal epoch_domain MethodEpoch;
+
+internal int
+ComparePluginMethod(plugin_method *Method, const char *Plugin, const char *Name)
+{
+    int Result = strcmp(Method->Plugin, Plugin);
+    return Result ? Result : strcmp(Method->Name, Name);
+}
+
+// NOTE(koekeishiya): Returns the index of the method, or of the first method that sorts after it.
+internal uint32_t
+LowerBoundPluginMethod(plugin_method_table *Table, const char *Plugin, const char *Name)
+{
+    uint32_t First = 0;
+    uint32_t Count = Table->Count;
+    while (Count > 0) {
+        uint32_t Step = Count / 2;
+        if (ComparePluginMethod(Table->Methods + First + Step, Plugin, Name) < 0) {
+            First += Step + 1;
+            Count -= Step + 1;
+        } else {
+            Count = Step;
+        }
+    }
+
+    return First;
+}
+
+internal plugin_method *
+FindPluginMethod(plugin_method_table *Table, const char *Plugin, const char *Name)
+{
+    uint32_t Index = LowerBoundPluginMethod(Table, Plugin, Name);
+    if ((Index < Table->Count) &&
+        (ComparePluginMethod(Table->Methods + Index, Plugin, Name) == 0)) {
+        return Table->Methods + Index;
+    }
+
+    return NULL;
+}
+
+internal plugin_method_table *
+AllocatePluginMethodTable(uint32_t Count)
+{
+    plugin_method_table *Table = (plugin_method_table *) malloc(sizeof(plugin_method_table) + Count * sizeof(plugin_method));
+    Table->Count = Count;
+    Table->Methods = (plugin_method *) (Table + 1);
+    return Table;
+}
+
+/*
+ * NOTE(koekeishiya): Must be called with 'MethodTableLock' held. A call may still be reading
+ * the old table, so it is retired instead of freed.
+ */
+internal void
+PublishPluginMethodTable(plugin_method_table *Table)
+{
+    plugin_method_table *Old = MethodTable;
+    __atomic_store_n(&MethodTable, Table, __ATOMIC_SEQ_CST);
+
+    if (Old != &EmptyMethodTable) {
+        EpochRetire(&MethodEpoch, Old);
+    }
+}
+
+CHUNKWM_API_REGISTER_METHOD_FUNC(RegisterPluginMethod)
+{
+    bool Result = false;
+    pthread_mutex_lock(&MethodTableLock);
+
+    plugin_method_table *Old = MethodTable;
+    uint32_t Index = LowerBoundPluginMethod(Old, Plugin, Method);
+    if ((Index < Old->Count) &&
+        (ComparePluginMethod(Old->Methods + Index, Plugin, Method) == 0)) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' already registered method '%s'!\n", Plugin, Method);
+        goto out;
+    }
+
+    plugin_method_table *Table;
+    Table = AllocatePluginMethodTable(Old->Count + 1);
+    memcpy(Table->Methods, Old->Methods, Index * sizeof(plugin_method));
+    memcpy(Table->Methods + Index + 1, Old->Methods + Index, (Old->Count - Index) * sizeof(plugin_method));
+    Table->Methods[Index].Plugin = strdup(Plugin);
+    Table->Methods[Index].Name = strdup(Method);
+    Table->Methods[Index].Function = Function;
+    PublishPluginMethodTable(Table);
+
+    c_log(C_LOG_LEVEL_DEBUG, "Plugin '%s' registered method '%s'\n", Plugin, Method);
+    Result = true;
+
+out:
+    pthread_mutex_unlock(&MethodTableLock);
+    return Result;
+}
+
+CHUNKWM_API_CALL_METHOD_FUNC(CallPluginMethod)
+{
+    chunkwm_call_result Result = chunkwm_call_not_found;
+
+    uint64_t Epoch = EpochEnter(&MethodEpoch);
+    plugin_method_table *Table = __atomic_load_n(&MethodTable, __ATOMIC_ACQUIRE);
+    plugin_method *Found = FindPluginMethod(Table, Plugin, Method);
+    if (Found) {
+        Result = Found->Function(Request, RequestSize, Response, ResponseSize);
+    }
+    EpochLeave(&MethodEpoch, Epoch);
+
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): Returns once the calls that may still be running a method of the plugin
+ * have returned. Must not be called from inside a method.
+ */
+void RemovePluginMethods(const char *Plugin)
+{
+    pthread_mutex_lock(&MethodTableLock);
+
+    plugin_method_table *Old = MethodTable;
+    uint32_t First = LowerBoundPluginMethod(Old, Plugin, "");
+    uint32_t Last = First;
+    while ((Last < Old->Count) && (strcmp(Old->Methods[Last].Plugin, Plugin) == 0)) {
+        ++Last;
+    }
+
+    if (First == Last) {
+        pthread_mutex_unlock(&MethodTableLock);
+        return;
+    }
+
+    uint32_t Removed = Last - First;
+    plugin_method *Methods = (plugin_method *) malloc(Removed * sizeof(plugin_method));
+    memcpy(Methods, Old->Methods + First, Removed * sizeof(plugin_method));
+
+    plugin_method_table *Table = AllocatePluginMethodTable(Old->Count - Removed);
+    memcpy(Table->Methods, Old->Methods, First * sizeof(plugin_method));
+    memcpy(Table->Methods + First, Old->Methods + Last, (Old->Count - Last) * sizeof(plugin_method));
+    PublishPluginMethodTable(Table);
+
+    pthread_mutex_unlock(&MethodTableLock);
+
+    // NOTE(koekeishiya): A call that found one of these methods may still be running it, or comparing its name.
+    EpochSynchronize(&MethodEpoch);
+
+    for (uint32_t Index = 0; Index < Removed; ++Index) {
+        c_log(C_LOG_LEVEL_DEBUG, "Plugin '%s' removed method '%s'\n", Plugin, Methods[Index].Name);
+        free(Methods[Index].Plugin);
+        free(Methods[Index].Name);
+    }
+    free(Methods);
+}
+
+bool BeginPluginMethods()
+{
+    MethodTable = &EmptyMethodTable;
+    return ((pthread_mutex_init(&MethodTableLock, NULL) == 0) &&
+            (BeginEpochDomain(&MethodEpoch)));
+}
@@ -0,0 +1,34 @@
+#ifndef CHUNKWM_CORE_METHOD_H
+#define CHUNKWM_CORE_METHOD_H
+
+#include <stdint.h>
+
+#include "../api/plugin_api.h"
+
+/*
+ * NOTE(koekeishiya): The methods that plugins registered, as an immutable array sorted by
+ * plugin and method name. Registering or removing a method publishes a new table, and a call
+ * looks up and runs the method without taking a lock, see epoch.h. A method is called while
+ * the reader holds the epoch, so removing the methods of a plugin waits for calls that are
+ * still running before the plugin is deinitialized.
+ */
+struct plugin_method
+{
+    char *Plugin;
+    char *Name;
+    plugin_method_func *Function;
+};
+
+struct plugin_method_table
+{
+    uint32_t Count;
+    plugin_method *Methods;
+};
+
+bool BeginPluginMethods();
+
+CHUNKWM_API_REGISTER_METHOD_FUNC(RegisterPluginMethod);
+CHUNKWM_API_CALL_METHOD_FUNC(CallPluginMethod);
+void RemovePluginMethods(const char *Plugin);
+
+#endif
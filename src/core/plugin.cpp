@@ -1,7 +1,15 @@
 #include "plugin.h"
+#include "filter.h"
+#include "pool.h"
 #include "cvar.h"
+#include "host.h"
+#include "method.h"
+#include "watch.h"
+#include "constants.h"
 #include "clog.h"
 
+#include "../common/misc/timer.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -9,6 +17,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <dirent.h>
+#include <limits.h>
 #include <map>
 
 #define internal static
@@ -16,18 +25,123 @@
 internal std::map<const char *, loaded_plugin *, string_comparator> LoadedPlugins;
 internal pthread_mutex_t LoadedPluginLock;
 
-internal pthread_mutex_t Mutexes[chunkwm_export_count];
-internal plugin_list ExportedPlugins[chunkwm_export_count];
+internal pthread_mutex_t PluginListLock;
+internal plugin_list *volatile PluginLists[PLUGIN_LIST_COUNT];
+internal plugin_list EmptyPluginList;
+internal epoch_domain PluginListEpoch;
+
+internal std::map<const char *, uint32_t, string_comparator> Topics;
+internal const char *TopicNames[PLUGIN_TOPIC_COUNT];
+internal plugin_list *volatile TopicLists[PLUGIN_TOPIC_COUNT];
+internal std::vector<topic_subscription> TopicSubscriptions;
+internal pthread_mutex_t TopicLock;
+
+internal std::vector<plugin_fs *> StartupPlugins;
+internal bool StartupQueueOpen;
+internal pthread_mutex_t StartupLock;
+internal plugin_load_timeline StartupTimeline;
 
-internal chunkwm_api API = { UpdateCVarAPI,  AcquireCVarAPI, FindCVarAPI, ChunkwmBroadcast, (chunkwm_log*)c_log };
+internal std::map<const char *, chunkwm_state, string_comparator> PluginStates;
+internal pthread_mutex_t PluginStateLock;
+
+internal std::map<const char *, bool, string_comparator> HostedPlugins;
+
+internal chunkwm_api API =
+{
+    UpdateCVarAPI,
+    AcquireCVarAPI,
+    FindCVarAPI,
+    ChunkwmBroadcast,
+    (chunkwm_log*)c_log,
+    InternTopic,
+    ChunkwmBroadcastTopic,
+    SubscribeTopic,
+    RegisterPluginMethod,
+    CallPluginMethod,
+    CVarIntegerAPI,
+    CVarUnsignedAPI,
+    CVarFloatingPointAPI,
+    BeginCVarReadAPI,
+    EndCVarReadAPI,
+    ResolveCVarAPI,
+    UpdateCVarHandleAPI,
+    AcquireCVarHandleAPI,
+    CVarHandleIntegerAPI,
+    CVarHandleUnsignedAPI,
+    CVarHandleFloatingPointAPI,
+    WatchCVar
+};
 
 internal bool
 VerifyPluginABI(plugin_details *Info)
 {
-    bool Result = (Info->ApiVersion == CHUNKWM_PLUGIN_API_VERSION);
+    bool Result = ((Info->ApiVersion == CHUNKWM_PLUGIN_API_VERSION) ||
+                   (Info->ApiVersion == CHUNKWM_LEGACY_PLUGIN_API_VERSION));
     return Result;
 }
 
+// NOTE(koekeishiya): Topics are never released, the set of events that plugins broadcast is small.
+CHUNKWM_API_INTERN_TOPIC_FUNC(InternTopic)
+{
+    size_t TotalLength = strlen(Plugin) + strlen(Event) + 2;
+    char Topic[TotalLength];
+    snprintf(Topic, TotalLength, "%s_%s", Plugin, Event);
+
+    pthread_mutex_lock(&TopicLock);
+
+    uint32_t Result;
+    std::map<const char *, uint32_t, string_comparator>::iterator It = Topics.find(Topic);
+    if (It != Topics.end()) {
+        Result = It->second;
+    } else if (Topics.size() + 1 < PLUGIN_TOPIC_COUNT) {
+        Result = Topics.size() + 1;
+        TopicNames[Result] = strdup(Topic);
+        Topics[TopicNames[Result]] = Result;
+    } else {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not create topic '%s', there are already %d!\n",
+              Topic, PLUGIN_TOPIC_COUNT - 1);
+        Result = 0;
+    }
+
+    pthread_mutex_unlock(&TopicLock);
+    return Result;
+}
+
+// NOTE(koekeishiya): The name is set before the id is handed out, and never changes.
+const char *TopicName(uint32_t Topic)
+{
+    return TopicNames[Topic];
+}
+
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data)
+{
+    // NOTE(koekeishiya): The callback of a cvar watch runs in place of the main function, see watch.h.
+    if (Export == chunkwm_export_cvar_changed) {
+        RunCVarWatch(Node, Data);
+        return true;
+    }
+
+    if (Legacy) {
+        plugin_legacy_main_func *Run = (plugin_legacy_main_func *) Plugin->Run;
+        return Run(Node, Data);
+    }
+
+    return Plugin->Run(Export, Topic, Node, Data);
+}
+
+internal bool
+InitPlugin(plugin *Plugin, bool Legacy)
+{
+    if (Legacy) {
+        chunkwm_legacy_api LegacyAPI = { API.UpdateCVar, API.AcquireCVar, API.FindCVar, API.Broadcast, API.Log };
+        plugin_legacy_bool_func *Init = (plugin_legacy_bool_func *) Plugin->Init;
+        return Init(LegacyAPI);
+    }
+
+    return Plugin->Init(API);
+}
+
 internal void
 PrintPluginDetails(plugin_details *Info)
 {
@@ -43,47 +157,196 @@ PrintPluginDetails(plugin_details *Info)
            Info->PluginVersion);
 }
 
-plugin_list *BeginPluginList(chunkwm_plugin_export Export)
+// NOTE(koekeishiya): The list stays valid until 'EndPluginList' is called with the returned epoch.
+plugin_list *BeginPluginList(chunkwm_plugin_export Export, uint64_t *Epoch)
 {
-    pthread_mutex_lock(&Mutexes[Export]);
-    return &ExportedPlugins[Export];
+    *Epoch = EpochEnter(&PluginListEpoch);
+    return __atomic_load_n(&PluginLists[Export], __ATOMIC_ACQUIRE);
 }
 
-void EndPluginList(chunkwm_plugin_export Export)
+void EndPluginList(uint64_t Epoch)
 {
-    pthread_mutex_unlock(&Mutexes[Export]);
+    EpochLeave(&PluginListEpoch, Epoch);
+}
+
+plugin_subscriber *FindPluginSubscriber(plugin_list *List, plugin *Plugin)
+{
+    for (uint32_t Index = 0; Index < List->Count; ++Index) {
+        if (List->Subscribers[Index].Plugin == Plugin) {
+            return List->Subscribers + Index;
+        }
+    }
+
+    return NULL;
+}
+
+bool PluginListContains(plugin_list *List, plugin *Plugin)
+{
+    return FindPluginSubscriber(List, Plugin) != NULL;
+}
+
+internal plugin_list *
+AllocatePluginList(uint32_t Count)
+{
+    plugin_list *List = (plugin_list *) malloc(sizeof(plugin_list) + Count * sizeof(plugin_subscriber));
+    List->Count = Count;
+    List->Subscribers = (plugin_subscriber *) (List + 1);
+    return List;
+}
+
+/*
+ * NOTE(koekeishiya): Must be called with 'PluginListLock' held. Dispatch may still be reading
+ * the old list, so it is retired instead of freed.
+ */
+internal void
+PublishPluginList(plugin_list *volatile *Slot, plugin_list *List)
+{
+    plugin_list *Old = *Slot;
+    __atomic_store_n(Slot, List, __ATOMIC_SEQ_CST);
+
+    if (Old != &EmptyPluginList) {
+        EpochRetire(&PluginListEpoch, Old);
+    }
+}
+
+internal void
+AddPluginListSubscriber(plugin_list *volatile *Slot, plugin *Plugin, plugin_mailbox *Mailbox,
+                        plugin_filter *Filter = NULL)
+{
+    pthread_mutex_lock(&PluginListLock);
+
+    plugin_list *Old = *Slot;
+    if (!PluginListContains(Old, Plugin)) {
+        plugin_list *List = AllocatePluginList(Old->Count + 1);
+        memcpy(List->Subscribers, Old->Subscribers, Old->Count * sizeof(plugin_subscriber));
+        List->Subscribers[Old->Count].Plugin = Plugin;
+        List->Subscribers[Old->Count].Mailbox = Mailbox;
+        List->Subscribers[Old->Count].Filter = Filter;
+        PublishPluginList(Slot, List);
+    }
+
+    pthread_mutex_unlock(&PluginListLock);
 }
 
 internal void
-SubscribeToEvent(plugin *Plugin, chunkwm_plugin_export Export)
+RemovePluginListSubscriber(plugin_list *volatile *Slot, plugin *Plugin)
 {
-    plugin_list *List = BeginPluginList(Export);
+    pthread_mutex_lock(&PluginListLock);
 
-    plugin_list_iter It = List->find(Plugin);
-    if (It == List->end()) {
-       (*List)[Plugin] = true;
+    plugin_list *Old = *Slot;
+    if (PluginListContains(Old, Plugin)) {
+        plugin_list *List = AllocatePluginList(Old->Count - 1);
+        uint32_t Count = 0;
+        for (uint32_t Index = 0; Index < Old->Count; ++Index) {
+            if (Old->Subscribers[Index].Plugin != Plugin) {
+                List->Subscribers[Count++] = Old->Subscribers[Index];
+            }
+        }
+        PublishPluginList(Slot, List);
     }
 
-    EndPluginList(Export);
+    pthread_mutex_unlock(&PluginListLock);
+}
+
+internal void
+SubscribeToEvent(plugin *Plugin, plugin_mailbox *Mailbox, chunkwm_plugin_export Export,
+                 plugin_filter *Filter = NULL)
+{
+    AddPluginListSubscriber(PluginLists + Export, Plugin, Mailbox, Filter);
 }
 
 internal void
 UnsubscribeFromEvent(plugin *Plugin, chunkwm_plugin_export Export)
 {
-    plugin_list *List = BeginPluginList(Export);
+    RemovePluginListSubscriber(PluginLists + Export, Plugin);
+}
+
+plugin_list *BeginTopicList(uint32_t Topic, uint64_t *Epoch)
+{
+    *Epoch = EpochEnter(&PluginListEpoch);
+    return __atomic_load_n(&TopicLists[Topic], __ATOMIC_ACQUIRE);
+}
+
+// NOTE(koekeishiya): The topics that the plugin named 'Subscriber' has subscribed to.
+internal std::vector<uint32_t>
+SubscribedTopics(const char *Subscriber)
+{
+    std::vector<uint32_t> Result;
+    pthread_mutex_lock(&TopicLock);
+
+    for (size_t Index = 0; Index < TopicSubscriptions.size(); ++Index) {
+        if (strcmp(TopicSubscriptions[Index].Subscriber, Subscriber) == 0) {
+            Result.push_back(TopicSubscriptions[Index].Topic);
+        }
+    }
+
+    pthread_mutex_unlock(&TopicLock);
+    return Result;
+}
+
+internal void
+RemoveTopicSubscriptions(const char *Subscriber)
+{
+    pthread_mutex_lock(&TopicLock);
+
+    for (size_t Index = 0; Index < TopicSubscriptions.size();) {
+        if (strcmp(TopicSubscriptions[Index].Subscriber, Subscriber) == 0) {
+            free(TopicSubscriptions[Index].Subscriber);
+            TopicSubscriptions.erase(TopicSubscriptions.begin() + Index);
+        } else {
+            ++Index;
+        }
+    }
+
+    pthread_mutex_unlock(&TopicLock);
+}
+
+/*
+ * NOTE(koekeishiya): A plugin that is already hooked is subscribed right away. The loaded
+ * plugin list stays locked while we do, so that it can not be unhooked in the meantime.
+ */
+CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(SubscribeTopic)
+{
+    if (!Subscriber || !Plugin || !Event) {
+        return 0;
+    }
 
-    plugin_list_iter It = List->find(Plugin);
-    if (It != List->end()) {
-        List->erase(It);
+    uint32_t Topic = InternTopic(Plugin, Event);
+    if (!Topic) {
+        return 0;
     }
 
-    EndPluginList(Export);
+    topic_subscription Subscription = { strdup(Subscriber), Topic };
+    pthread_mutex_lock(&TopicLock);
+    TopicSubscriptions.push_back(Subscription);
+    pthread_mutex_unlock(&TopicLock);
+
+    loaded_plugin_list *List = BeginLoadedPluginList();
+    for (loaded_plugin_list_iter It = List->begin();
+         It != List->end();
+         ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        if (strcmp(LoadedPlugin->Info->PluginName, Subscriber) == 0) {
+            AddPluginListSubscriber(TopicLists + Topic, LoadedPlugin->Plugin, LoadedPlugin->Mailbox);
+        }
+    }
+    EndLoadedPluginList();
+
+    c_log(C_LOG_LEVEL_DEBUG, "Plugin '%s' subscribed to '%s'\n", Subscriber, TopicName(Topic));
+    return Topic;
 }
 
 internal void
 HookPlugin(loaded_plugin *LoadedPlugin)
 {
     plugin *Plugin = LoadedPlugin->Plugin;
+
+    // NOTE(koekeishiya): The plugin struct of api version 6 does not have any filters.
+    if (!LoadedPlugin->Legacy && Plugin->Filters) {
+        LoadedPlugin->Filters = CreatePluginFilters(Plugin, LoadedPlugin->Info->PluginName,
+                                                    &LoadedPlugin->FilterCount);
+    }
+
     if (Plugin->Subscriptions) {
         for (int Index = 0; Index < Plugin->SubscriptionCount; ++Index) {
             chunkwm_plugin_export *Export = Plugin->Subscriptions + Index;
@@ -91,10 +354,26 @@ HookPlugin(loaded_plugin *LoadedPlugin)
                   "Plugin '%s' subscribed to '%s'\n",
                   LoadedPlugin->Info->PluginName,
                   chunkwm_plugin_export_str[*Export]);
-            SubscribeToEvent(Plugin, *Export);
+            plugin_filter *Filter = FindPluginFilter(LoadedPlugin->Filters, LoadedPlugin->FilterCount, *Export);
+            SubscribeToEvent(Plugin, LoadedPlugin->Mailbox, *Export, Filter);
         }
     }
-    Plugin->Run("chunkwm_events_subscribed", NULL);
+    SubscribeToEvent(Plugin, LoadedPlugin->Mailbox, chunkwm_export_plugin_broadcast);
+
+    std::vector<uint32_t> Subscribed = SubscribedTopics(LoadedPlugin->Info->PluginName);
+    for (size_t Index = 0; Index < Subscribed.size(); ++Index) {
+        AddPluginListSubscriber(TopicLists + Subscribed[Index], Plugin, LoadedPlugin->Mailbox);
+    }
+
+    if (LoadedPlugin->Host) {
+        plugin_payload *Payload = CreatePluginPayload(NULL, NULL, NULL);
+        PostPluginMailbox(LoadedPlugin->Mailbox, chunkwm_export_events_subscribed, 0,
+                          chunkwm_plugin_export_str[chunkwm_export_events_subscribed], Payload);
+        ReleasePluginPayload(Payload);
+    } else {
+        RunPlugin(Plugin, LoadedPlugin->Legacy, chunkwm_export_events_subscribed, 0,
+                  chunkwm_plugin_export_str[chunkwm_export_events_subscribed], NULL);
+    }
 }
 
 internal void
@@ -111,6 +390,13 @@ UnhookPlugin(loaded_plugin *LoadedPlugin)
             UnsubscribeFromEvent(Plugin, *Export);
         }
     }
+    UnsubscribeFromEvent(Plugin, chunkwm_export_plugin_broadcast);
+
+    std::vector<uint32_t> Subscribed = SubscribedTopics(LoadedPlugin->Info->PluginName);
+    for (size_t Index = 0; Index < Subscribed.size(); ++Index) {
+        RemovePluginListSubscriber(TopicLists + Subscribed[Index], Plugin);
+    }
+    RemoveTopicSubscriptions(LoadedPlugin->Info->PluginName);
 }
 
 internal void
@@ -166,6 +452,25 @@ plugin *GetPluginFromFilename(const char *Filename)
     return Result;
 }
 
+plugin_mailbox *GetPluginMailboxFromFilename(const char *Filename)
+{
+    BeginLoadedPluginList();
+
+    int Length = strlen(Filename) + 3 + 1;
+    char FilenameWithExtension[Length];
+    snprintf(FilenameWithExtension, Length, "%s.so", Filename);
+
+    plugin_mailbox *Result;
+    if (LoadedPlugins.find(FilenameWithExtension) != LoadedPlugins.end()) {
+        Result = LoadedPlugins[FilenameWithExtension]->Mailbox;
+    } else {
+        Result = NULL;
+    }
+
+    EndLoadedPluginList();
+    return Result;
+}
+
 loaded_plugin_list *BeginLoadedPluginList()
 {
     pthread_mutex_lock(&LoadedPluginLock);
@@ -177,24 +482,137 @@ void EndLoadedPluginList()
     pthread_mutex_unlock(&LoadedPluginLock);
 }
 
-bool LoadPlugin(const char *Absolutepath, const char *Filename)
+/*
+ * NOTE(koekeishiya): A plugin that has been loaded with 'core::load_hosted' is always loaded
+ * in a plugin host from then on, also when it is reloaded by the plugin watcher.
+ */
+void MarkPluginHosted(const char *Filename)
+{
+    BeginLoadedPluginList();
+    if (HostedPlugins.find(Filename) == HostedPlugins.end()) {
+        HostedPlugins[strdup(Filename)] = true;
+    }
+    EndLoadedPluginList();
+}
+
+internal bool
+IsPluginHosted(const char *Filename)
+{
+    BeginLoadedPluginList();
+    bool Result = HostedPlugins.find(Filename) != HostedPlugins.end();
+    EndLoadedPluginList();
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): The plugin struct and details of a hosted plugin are built from what the
+ * host reported. They have no functions; events are delivered to the host by the mailbox.
+ */
+internal loaded_plugin *
+OpenHostedPlugin(const char *Absolutepath, const char *Filename)
+{
+    plugin *Plugin;
+    plugin_details *Info;
+    loaded_plugin *LoadedPlugin = NULL;
+    char HostPath[PATH_MAX];
+    bool HasHostPath = CVarStringValue(CVAR_PLUGIN_HOST, HostPath, sizeof(HostPath));
+
+    plugin_host *Host = StartPluginHost(HasHostPath ? HostPath : PLUGIN_HOST_DEFAULT, Absolutepath);
+    if (!Host) {
+        goto out;
+    }
+
+    if (Host->Info.ApiVersion != CHUNKWM_PLUGIN_API_VERSION) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' ABI mismatch; expected %d, was %d\n",
+              Host->Info.PluginName, CHUNKWM_PLUGIN_API_VERSION, Host->Info.ApiVersion);
+        StopPluginHost(Host);
+        goto out;
+    }
+
+    Plugin = (plugin *) calloc(1, sizeof(plugin));
+    Plugin->Subscriptions = Host->Info.Subscriptions;
+    Plugin->SubscriptionCount = Host->Info.SubscriptionCount;
+    Plugin->Filters = Host->Info.Filters;
+    Plugin->FilterCount = Host->Info.FilterCount;
+
+    Info = (plugin_details *) calloc(1, sizeof(plugin_details));
+    Info->ApiVersion = Host->Info.ApiVersion;
+    Info->PluginName = Host->Info.PluginName;
+    Info->PluginVersion = Host->Info.PluginVersion;
+
+    LoadedPlugin = (loaded_plugin *) malloc(sizeof(loaded_plugin));
+    LoadedPlugin->Filename = strdup(Filename);
+    LoadedPlugin->Handle = NULL;
+    LoadedPlugin->Host = Host;
+    LoadedPlugin->Plugin = Plugin;
+    LoadedPlugin->Info = Info;
+    LoadedPlugin->Mailbox = NULL;
+    LoadedPlugin->Legacy = false;
+    LoadedPlugin->Filters = NULL;
+    LoadedPlugin->FilterCount = 0;
+    LoadedPlugin->StateHandoff = NULL;
+    Info->FileName = LoadedPlugin->Filename;
+
+    PrintPluginDetails(Info);
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' runs in plugin host %d\n", Info->PluginName, Host->PID);
+
+out:
+    return LoadedPlugin;
+}
+
+// NOTE(koekeishiya): Returns true if the shared library of the plugin was closed.
+internal bool
+ClosePlugin(loaded_plugin *LoadedPlugin)
 {
     bool Result = true;
+    if (LoadedPlugin->Host) {
+        StopPluginHost(LoadedPlugin->Host);
+        free(LoadedPlugin->Plugin);
+        free(LoadedPlugin->Info);
+    } else {
+        Result = dlclose(LoadedPlugin->Handle) == 0;
+    }
+
+    free(LoadedPlugin->Filename);
+    free(LoadedPlugin);
+    return Result;
+}
+
+internal const char **
+PluginLoadAfter(loaded_plugin *LoadedPlugin)
+{
+    if (LoadedPlugin->Host) {
+        return LoadedPlugin->Host->Info.LoadAfter;
+    }
 
+    return (const char **) dlsym(LoadedPlugin->Handle, "LoadAfter");
+}
+
+/*
+ * NOTE(koekeishiya): Opens the plugin and creates its instance, but does not call into it.
+ * Plugins that are loaded when chunkwm starts are opened in parallel, see 'LoadQueuedPlugins'.
+ */
+internal loaded_plugin *
+OpenPlugin(const char *Absolutepath, const char *Filename)
+{
     void *Handle;
     plugin_details *Info;
-    plugin *Plugin;
-    loaded_plugin *LoadedPlugin;
+    loaded_plugin *LoadedPlugin = NULL;
 
     if (IsPluginLoaded(Filename)) {
         c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' is already running!\n", Absolutepath);
-        goto already_loaded;
+        goto out;
+    }
+
+    if (IsPluginHosted(Filename)) {
+        LoadedPlugin = OpenHostedPlugin(Absolutepath, Filename);
+        goto out;
     }
 
     Handle = dlopen(Absolutepath, RTLD_LAZY);
     if (!Handle) {
         c_log(C_LOG_LEVEL_ERROR, "chunkwm: dlopen '%s' failed!\n", Absolutepath);
-        goto handle_err;
+        goto out;
     }
 
     Info = (plugin_details *) dlsym(Handle, "Exports");
@@ -209,52 +627,427 @@ bool LoadPlugin(const char *Absolutepath, const char *Filename)
         goto abi_err;
     }
 
-    Plugin = Info->Initialize();
     PrintPluginDetails(Info);
 
     LoadedPlugin = (loaded_plugin *) malloc(sizeof(loaded_plugin));
+    LoadedPlugin->Filename = strdup(Filename);
     LoadedPlugin->Handle = Handle;
-    LoadedPlugin->Plugin = Plugin;
+    LoadedPlugin->Host = NULL;
+    LoadedPlugin->Plugin = Info->Initialize();
     LoadedPlugin->Info = Info;
+    LoadedPlugin->Mailbox = NULL;
+    LoadedPlugin->Legacy = Info->ApiVersion == CHUNKWM_LEGACY_PLUGIN_API_VERSION;
+    LoadedPlugin->Filters = NULL;
+    LoadedPlugin->FilterCount = 0;
+    LoadedPlugin->StateHandoff = (plugin_state_handoff *) dlsym(Handle, "StateHandoff");
 
-    if (!Plugin->Init(API)) {
-        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' init failed!\n", Info->PluginName);
-        goto plugin_init_err;
+    if (LoadedPlugin->Legacy) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' uses the deprecated api version %d\n",
+              Info->PluginName, Info->ApiVersion);
     }
 
-    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' loaded!\n", Filename);
-    LoadedPlugin->Filename = strdup(Filename);
-    StoreLoadedPlugin(LoadedPlugin);
-    HookPlugin(LoadedPlugin);
     goto out;
 
-plugin_init_err:
-    free(LoadedPlugin);
-
 abi_err:
 info_err:
     dlclose(Handle);
 
-handle_err:
-already_loaded:
-    Result = false;
-
 out:
+    return LoadedPlugin;
+}
+
+/*
+ * NOTE(koekeishiya): Called before the plugin is deinitialized. A state that was saved by an
+ * earlier instance and never restored is replaced.
+ */
+internal void
+SavePluginState(loaded_plugin *LoadedPlugin)
+{
+    plugin_state_handoff *Handoff = LoadedPlugin->StateHandoff;
+    if (!Handoff || !Handoff->Save) return;
+
+    chunkwm_state State = {};
+    uint64_t Begin = GetTimeNanoseconds();
+    if (!Handoff->Save(&State) || !State.Data) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' did not save its state!\n", LoadedPlugin->Info->PluginName);
+        free(State.Data);
+        return;
+    }
+
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' saved %zu bytes of state in %.3fms\n",
+          LoadedPlugin->Info->PluginName, State.Size, (GetTimeNanoseconds() - Begin) / 1000000.0);
+
+    pthread_mutex_lock(&PluginStateLock);
+    std::map<const char *, chunkwm_state, string_comparator>::iterator It = PluginStates.find(LoadedPlugin->Filename);
+    if (It != PluginStates.end()) {
+        free(It->second.Data);
+        It->second = State;
+    } else {
+        PluginStates[strdup(LoadedPlugin->Filename)] = State;
+    }
+    pthread_mutex_unlock(&PluginStateLock);
+}
+
+// NOTE(koekeishiya): Called before the plugin is initialized. The state is released either way.
+internal void
+RestorePluginState(loaded_plugin *LoadedPlugin)
+{
+    chunkwm_state State;
+    const char *Key;
+
+    pthread_mutex_lock(&PluginStateLock);
+    std::map<const char *, chunkwm_state, string_comparator>::iterator It = PluginStates.find(LoadedPlugin->Filename);
+    if (It == PluginStates.end()) {
+        pthread_mutex_unlock(&PluginStateLock);
+        return;
+    }
+    State = It->second;
+    Key = It->first;
+    PluginStates.erase(It);
+    pthread_mutex_unlock(&PluginStateLock);
+
+    plugin_state_handoff *Handoff = LoadedPlugin->StateHandoff;
+    if (Handoff && Handoff->Restore) {
+        uint64_t Begin = GetTimeNanoseconds();
+        if (Handoff->Restore(&State)) {
+            c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' restored %zu bytes of state in %.3fms\n",
+                  LoadedPlugin->Info->PluginName, State.Size, (GetTimeNanoseconds() - Begin) / 1000000.0);
+        } else {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' could not restore its state, starting fresh!\n",
+                  LoadedPlugin->Info->PluginName);
+        }
+    }
+
+    free(State.Data);
+    free((char *) Key);
+}
+
+// NOTE(koekeishiya): Calls the init function of the plugin. The plugin is closed if this fails.
+internal bool
+InitLoadedPlugin(loaded_plugin *LoadedPlugin)
+{
+    plugin *Plugin = LoadedPlugin->Plugin;
+    plugin_details *Info = LoadedPlugin->Info;
+
+    if (LoadedPlugin->Host) {
+        if (!InitPluginHost(LoadedPlugin->Host)) {
+            c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' init failed!\n", Info->PluginName);
+            goto plugin_init_err;
+        }
+    } else {
+        RestorePluginState(LoadedPlugin);
+        if (!InitPlugin(Plugin, LoadedPlugin->Legacy)) {
+            c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' init failed!\n", Info->PluginName);
+            goto plugin_init_err;
+        }
+    }
+
+    LoadedPlugin->Mailbox = CreatePluginMailbox(Plugin, Info->PluginName, LoadedPlugin->Legacy);
+    if (!LoadedPlugin->Mailbox) {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' mailbox could not be created!\n", Info->PluginName);
+        goto mailbox_err;
+    }
+
+    if (LoadedPlugin->Host) {
+        LoadedPlugin->Mailbox->Deliver = &DeliverPluginHostMessage;
+        LoadedPlugin->Mailbox->DeliverContext = LoadedPlugin->Host;
+    }
+
+    return true;
+
+mailbox_err:
+    RemovePluginMethods(Info->PluginName);
+    RemoveCVarWatches(Info->PluginName);
+    RemoveTopicSubscriptions(Info->PluginName);
+    if (!LoadedPlugin->Host) Plugin->DeInit();
+    ClosePlugin(LoadedPlugin);
+    return false;
+
+plugin_init_err:
+    RemovePluginMethods(Info->PluginName);
+    RemoveCVarWatches(Info->PluginName);
+    RemoveTopicSubscriptions(Info->PluginName);
+    ClosePlugin(LoadedPlugin);
+    return false;
+}
+
+internal void
+PublishLoadedPlugin(loaded_plugin *LoadedPlugin)
+{
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' loaded!\n", LoadedPlugin->Filename);
+    StoreLoadedPlugin(LoadedPlugin);
+    HookPlugin(LoadedPlugin);
+}
+
+bool LoadPlugin(const char *Absolutepath, const char *Filename)
+{
+    loaded_plugin *LoadedPlugin = OpenPlugin(Absolutepath, Filename);
+    if (!LoadedPlugin || !InitLoadedPlugin(LoadedPlugin)) {
+        return false;
+    }
+
+    PublishLoadedPlugin(LoadedPlugin);
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): 'PluginName' is a copy of the name of the plugin, taken once it has been
+ * opened. Init functions of a round run while the next round is decided, and a plugin whose
+ * init fails is closed, so only 'PluginName' and 'Failed' are read of other loads.
+ */
+struct plugin_load
+{
+    plugin_fs *PluginFS;
+    loaded_plugin *LoadedPlugin;
+    char *PluginName;
+    const char **LoadAfter;
+    bool Running;
+    bool Failed;
+    bool Done;
+    plugin_load_timing *Timing;
+    uint64_t Begin;
+};
+
+internal
+THREAD_POOL_CALLBACK(OpenPluginTask)
+{
+    plugin_load *Load = (plugin_load *) Data;
+    Load->Timing->OpenBegin = GetTimeNanoseconds() - Load->Begin;
+
+    Load->LoadedPlugin = OpenPlugin(Load->PluginFS->Absolutepath, Load->PluginFS->Filename);
+    if (Load->LoadedPlugin) {
+        Load->PluginName = strdup(Load->LoadedPlugin->Info->PluginName);
+        Load->LoadAfter = PluginLoadAfter(Load->LoadedPlugin);
+    } else {
+        Load->Done = true;
+    }
+
+    Load->Timing->OpenEnd = GetTimeNanoseconds() - Load->Begin;
+}
+
+internal
+THREAD_POOL_CALLBACK(InitPluginTask)
+{
+    plugin_load *Load = (plugin_load *) Data;
+    Load->Timing->InitBegin = GetTimeNanoseconds() - Load->Begin;
+
+    if (!InitLoadedPlugin(Load->LoadedPlugin)) {
+        Load->Failed = true;
+    }
+
+    Load->Timing->InitEnd = GetTimeNanoseconds() - Load->Begin;
+}
+
+// NOTE(koekeishiya): A plugin is ready once no plugin that it is listed to load after is still pending.
+internal bool
+IsPluginLoadReady(plugin_load *Loads, uint32_t Count, plugin_load *Load)
+{
+    if (!Load->LoadAfter) return true;
+
+    for (const char **Name = Load->LoadAfter; *Name; ++Name) {
+        for (uint32_t Index = 0; Index < Count; ++Index) {
+            plugin_load *Other = Loads + Index;
+            if ((Other != Load) &&
+                (!Other->Done) &&
+                (strcmp(Other->PluginName, *Name) == 0)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): Submits the init function of every pending plugin that is ready. The
+ * round is decided before any init function is submitted.
+ */
+internal uint32_t
+SubmitReadyPlugins(thread_pool *Pool, task_group *Group, plugin_load *Loads, uint32_t Count)
+{
+    std::vector<plugin_load *> Ready;
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        plugin_load *Load = Loads + Index;
+        if (!Load->Done && IsPluginLoadReady(Loads, Count, Load)) {
+            Ready.push_back(Load);
+        }
+    }
+
+    uint32_t Result = 0;
+    for (size_t Index = 0; Index < Ready.size(); ++Index) {
+        Ready[Index]->Running = true;
+        ThreadPoolSubmit(Pool, Group, &InitPluginTask, Ready[Index]);
+        ++Result;
+    }
+
+    /*
+     * NOTE(koekeishiya): Every pending plugin waits for another one, so they were listed in a
+     * cycle. Break it at the plugin that was loaded first in the config.
+     */
+    for (uint32_t Index = 0; !Result && Index < Count; ++Index) {
+        plugin_load *Load = Loads + Index;
+        if (!Load->Done) {
+            c_log(C_LOG_LEVEL_WARN, "chunkwm: plugin '%s' has a cyclic load order, loading it now..\n",
+                  Load->PluginName);
+            Load->Running = true;
+            ThreadPoolSubmit(Pool, Group, &InitPluginTask, Load);
+            ++Result;
+        }
+    }
+
     return Result;
 }
 
+internal bool
+IsPluginQueued(plugin_load *Loads, uint32_t Count, const char *Filename)
+{
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        if (strcmp(Loads[Index].PluginFS->Filename, Filename) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * NOTE(koekeishiya): Plugins loaded by the config-file are queued until the config has been
+ * executed, so that they can be loaded together. Returns false once the queue is closed;
+ * the plugin should then be loaded through the event-loop.
+ */
+bool QueueStartupPlugin(plugin_fs *PluginFS)
+{
+    pthread_mutex_lock(&StartupLock);
+
+    bool Result = StartupQueueOpen;
+    if (Result) {
+        StartupPlugins.push_back(PluginFS);
+    }
+
+    pthread_mutex_unlock(&StartupLock);
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): Loads the queued plugins and closes the queue. Every plugin is opened
+ * in parallel on the pool. The init functions then run in rounds: a round contains every
+ * plugin that is not listed to load after a plugin that is still pending, and plugins are
+ * hooked in the order of the config-file once their round is done. dyld serializes most of
+ * dlopen, so the time saved is mostly that of the init functions.
+ */
+void LoadQueuedPlugins(thread_pool *Pool)
+{
+    pthread_mutex_lock(&StartupLock);
+    StartupQueueOpen = false;
+    std::vector<plugin_fs *> Queued;
+    Queued.swap(StartupPlugins);
+    pthread_mutex_unlock(&StartupLock);
+
+    uint32_t Count = Queued.size();
+    plugin_load *Loads = (plugin_load *) calloc(Count ? Count : 1, sizeof(plugin_load));
+    plugin_load_timing *Timings = (plugin_load_timing *) calloc(Count ? Count : 1, sizeof(plugin_load_timing));
+    uint64_t Begin = GetTimeNanoseconds();
+
+    task_group Group = {};
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        plugin_load *Load = Loads + Index;
+        Load->PluginFS = Queued[Index];
+        Load->Timing = Timings + Index;
+        Load->Timing->Filename = strdup(Load->PluginFS->Filename);
+        Load->Begin = Begin;
+
+        if (IsPluginQueued(Loads, Index, Load->PluginFS->Filename)) {
+            c_log(C_LOG_LEVEL_ERROR, "chunkwm: plugin '%s' is already running!\n", Load->PluginFS->Absolutepath);
+            Load->Done = true;
+        } else {
+            ThreadPoolSubmit(Pool, &Group, &OpenPluginTask, Load);
+        }
+    }
+    ThreadPoolWait(Pool, &Group);
+
+    for (;;) {
+        task_group Round = {};
+        if (!SubmitReadyPlugins(Pool, &Round, Loads, Count)) {
+            break;
+        }
+        ThreadPoolWait(Pool, &Round);
+
+        for (uint32_t Index = 0; Index < Count; ++Index) {
+            plugin_load *Load = Loads + Index;
+            if (Load->Running && !Load->Done) {
+                Load->Done = true;
+                if (!Load->Failed) {
+                    Load->Timing->Loaded = true;
+                    PublishLoadedPlugin(Load->LoadedPlugin);
+                }
+            }
+        }
+    }
+
+    StartupTimeline.Count = Count;
+    StartupTimeline.Plugins = Timings;
+    StartupTimeline.Elapsed = GetTimeNanoseconds() - Begin;
+    __atomic_store_n(&StartupTimeline.Complete, true, __ATOMIC_RELEASE);
+
+    char Buffer[256];
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        FormatPluginLoadTiming(Timings + Index, Buffer, sizeof(Buffer));
+        c_log(C_LOG_LEVEL_DEBUG, "chunkwm: %s", Buffer);
+        DestroyPluginFS(Loads[Index].PluginFS);
+        free(Loads[Index].PluginFS);
+        free(Loads[Index].PluginName);
+    }
+    c_log(C_LOG_LEVEL_DEBUG, "chunkwm: loaded %u plugins in %.2fms\n", Count, StartupTimeline.Elapsed / 1000000.0);
+
+    free(Loads);
+}
+
+// NOTE(koekeishiya): Returns NULL until the plugins queued at startup have been loaded.
+plugin_load_timeline *GetStartupTimeline()
+{
+    return __atomic_load_n(&StartupTimeline.Complete, __ATOMIC_ACQUIRE) ? &StartupTimeline : NULL;
+}
+
+void FormatPluginLoadTiming(plugin_load_timing *Timing, char *Buffer, size_t Size)
+{
+    if (Timing->Loaded) {
+        snprintf(Buffer, Size, "%-24s open %9.2f - %9.2fms  init %9.2f - %9.2fms\n",
+                 Timing->Filename,
+                 Timing->OpenBegin / 1000000.0,
+                 Timing->OpenEnd / 1000000.0,
+                 Timing->InitBegin / 1000000.0,
+                 Timing->InitEnd / 1000000.0);
+    } else {
+        snprintf(Buffer, Size, "%-24s failed\n", Timing->Filename);
+    }
+}
+
 bool UnloadPlugin(const char *Absolutepath, const char *Filename)
 {
     bool Result = false;
 
     loaded_plugin *LoadedPlugin = RemoveLoadedPlugin(Filename);
-    if (LoadedPlugin && LoadedPlugin->Handle) {
+    if (LoadedPlugin) {
         UnhookPlugin(LoadedPlugin);
+        RemovePluginMethods(LoadedPlugin->Info->PluginName);
+        RemoveCVarWatches(LoadedPlugin->Info->PluginName);
+
+        /*
+         * NOTE(koekeishiya): The plugin is no longer subscribed to anything, but an event that
+         * is being dispatched may have read a list that still has its mailbox. Once every such
+         * reader is done, deliver what is queued before the plugin is deinitialized.
+         */
+        EpochSynchronize(&PluginListEpoch);
+        DrainPluginMailbox(LoadedPlugin->Mailbox);
 
-        plugin *Plugin = LoadedPlugin->Plugin;
-        Plugin->DeInit();
+        // NOTE(koekeishiya): A hosted plugin is deinitialized by its host, see 'StopPluginHost'.
+        if (!LoadedPlugin->Host) {
+            SavePluginState(LoadedPlugin);
+            LoadedPlugin->Plugin->DeInit();
+        }
 
-        Result = dlclose(LoadedPlugin->Handle) == 0;
+        DestroyPluginMailbox(LoadedPlugin->Mailbox);
+        DestroyPluginFilters(LoadedPlugin->Filters, LoadedPlugin->FilterCount);
 
 #if 0
         /*
@@ -276,24 +1069,60 @@ bool UnloadPlugin(const char *Absolutepath, const char *Filename)
          */
 #endif
 
+        Result = ClosePlugin(LoadedPlugin);
         c_log(C_LOG_LEVEL_DEBUG, "chunkwm: plugin '%s' unloaded!\n", Filename);
-
-        free(LoadedPlugin->Filename);
-        free(LoadedPlugin);
     }
 
     return Result;
 }
 
-bool BeginPlugins()
+internal void *
+PluginWatchdogThreadProc(void *)
 {
-    for (int Index = 0; Index < chunkwm_export_count; ++Index) {
-        if (pthread_mutex_init(&Mutexes[Index], NULL) != 0) {
-            return false;
+    for (;;) {
+        usleep(PLUGIN_WATCHDOG_INTERVAL_MS * 1000);
+
+        loaded_plugin_list *List = BeginLoadedPluginList();
+        for (loaded_plugin_list_iter It = List->begin();
+             It != List->end();
+             ++It) {
+            CheckPluginBudget(It->second->Mailbox);
         }
+        EndLoadedPluginList();
+    }
+
+    return NULL;
+}
+
+// NOTE(koekeishiya): Periodically reports plugins that are stuck past their budget, see 'CheckPluginBudget'.
+bool BeginPluginWatchdog()
+{
+    pthread_t Thread;
+    return pthread_create(&Thread, NULL, &PluginWatchdogThreadProc, NULL) == 0;
+}
+
+bool BeginPlugins()
+{
+    for (int Index = 0; Index < PLUGIN_LIST_COUNT; ++Index) {
+        PluginLists[Index] = &EmptyPluginList;
+    }
+
+    for (int Index = 0; Index < PLUGIN_TOPIC_COUNT; ++Index) {
+        TopicLists[Index] = &EmptyPluginList;
+    }
+
+    if ((pthread_mutex_init(&PluginListLock, NULL) != 0) ||
+        (!BeginEpochDomain(&PluginListEpoch))) {
+        return false;
     }
 
-    return (pthread_mutex_init(&LoadedPluginLock, NULL) == 0);
+    StartupQueueOpen = true;
+    return ((pthread_mutex_init(&LoadedPluginLock, NULL) == 0) &&
+            (pthread_mutex_init(&TopicLock, NULL) == 0) &&
+            (pthread_mutex_init(&StartupLock, NULL) == 0) &&
+            (pthread_mutex_init(&PluginStateLock, NULL) == 0) &&
+            (BeginPluginMethods()) &&
+            (BeginCVarWatches()));
 }
 
 void DestroyPluginFS(plugin_fs *PluginFS)
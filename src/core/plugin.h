@@ -3,8 +3,15 @@
 
 #include "../api/plugin_api.h"
 #include "../common/misc/string.h"
+#include "mailbox.h"
+#include "epoch.h"
 
 #include <map>
+#include <vector>
+
+struct plugin_filter;
+struct plugin_host;
+struct thread_pool;
 
 struct plugin_fs
 {
@@ -16,21 +23,116 @@ struct loaded_plugin
 {
     char *Filename;
     void *Handle;
+    plugin_host *Host;
     plugin *Plugin;
     plugin_details *Info;
+    plugin_mailbox *Mailbox;
+    bool Legacy;
+
+    plugin_filter *Filters;
+    uint32_t FilterCount;
+
+    plugin_state_handoff *StateHandoff;
+};
+
+/*
+ * NOTE(koekeishiya): Plugins built against api version 6 are still loaded. They receive
+ * events by name, and their init function is passed a 'chunkwm_api' without 'InternTopic'.
+ */
+#define CHUNKWM_LEGACY_PLUGIN_API_VERSION 6
+
+struct chunkwm_legacy_api
+{
+    chunkwm_update_cvar_func *UpdateCVar;
+    chunkwm_acquire_cvar_func *AcquireCVar;
+    chunkwm_find_cvar_func *FindCVar;
+    plugin_broadcast_func *Broadcast;
+    chunkwm_log *Log;
+};
+
+typedef bool plugin_legacy_bool_func(chunkwm_legacy_api ChunkwmAPI);
+typedef bool plugin_legacy_main_func(const char *Node, void *Data);
+
+// NOTE(koekeishiya): 'Filter' is NULL if the plugin did not list any filters for the export.
+struct plugin_subscriber
+{
+    plugin *Plugin;
+    plugin_mailbox *Mailbox;
+    plugin_filter *Filter;
+};
+
+/*
+ * NOTE(koekeishiya): The plugins subscribed to an export, as an immutable array. Subscribing
+ * or unsubscribing publishes a new list, and dispatch reads the current one without taking a
+ * lock, see epoch.h. The list for 'chunkwm_export_plugin_broadcast' holds every loaded plugin;
+ * broadcasts are only sent to the legacy plugins in it, the others subscribe to a topic.
+ */
+struct plugin_list
+{
+    uint32_t Count;
+    plugin_subscriber *Subscribers;
 };
 
-typedef std::map<plugin *, bool>  plugin_list;
-typedef plugin_list::iterator plugin_list_iter;
+#define PLUGIN_LIST_COUNT (chunkwm_export_plugin_broadcast + 1)
+
+/*
+ * NOTE(koekeishiya): Every broadcast topic has its own list of subscribers, published in the
+ * same way. A plugin subscribes through 'chunkwm_api.SubscribeTopic', usually in its init
+ * function; the subscription takes effect once the plugin is hooked, and ends when it is unloaded.
+ */
+#define PLUGIN_TOPIC_COUNT 256
+
+struct topic_subscription
+{
+    char *Subscriber;
+    uint32_t Topic;
+};
+
+#define PLUGIN_WATCHDOG_INTERVAL_MS 100
+
+// NOTE(koekeishiya): Nanoseconds since the plugins queued at startup began loading.
+struct plugin_load_timing
+{
+    char *Filename;
+    uint64_t OpenBegin;
+    uint64_t OpenEnd;
+    uint64_t InitBegin;
+    uint64_t InitEnd;
+    bool Loaded;
+};
+
+struct plugin_load_timeline
+{
+    uint32_t Count;
+    plugin_load_timing *Plugins;
+    uint64_t Elapsed;
+    bool volatile Complete;
+};
 
 bool BeginPlugins();
+bool BeginPluginWatchdog();
+
+plugin_list *BeginPluginList(chunkwm_plugin_export Export, uint64_t *Epoch);
+void EndPluginList(uint64_t Epoch);
+plugin_subscriber *FindPluginSubscriber(plugin_list *List, plugin *Plugin);
+bool PluginListContains(plugin_list *List, plugin *Plugin);
+plugin_list *BeginTopicList(uint32_t Topic, uint64_t *Epoch);
+const char *TopicName(uint32_t Topic);
 
-plugin_list *BeginPluginList(chunkwm_plugin_export Export);
-void EndPluginList(chunkwm_plugin_export Export);
+bool RunPlugin(plugin *Plugin, bool Legacy, chunkwm_plugin_export Export,
+               uint32_t Topic, const char *Node, void *Data);
+CHUNKWM_API_INTERN_TOPIC_FUNC(InternTopic);
+CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(SubscribeTopic);
 
+void MarkPluginHosted(const char *Filename);
 bool LoadPlugin(const char *Absolutepath, const char *Filename);
 bool UnloadPlugin(const char *Absolutepath, const char *Filename);
 
+bool QueueStartupPlugin(plugin_fs *PluginFS);
+void LoadQueuedPlugins(thread_pool *Pool);
+plugin_load_timeline *GetStartupTimeline();
+void FormatPluginLoadTiming(plugin_load_timing *Timing, char *Buffer, size_t Size);
+
 typedef std::map<const char *, loaded_plugin *, string_comparator> loaded_plugin_list;
 typedef loaded_plugin_list::iterator loaded_plugin_list_iter;
 
@@ -38,6 +140,7 @@ loaded_plugin_list *BeginLoadedPluginList();
 void EndLoadedPluginList();
 
 plugin *GetPluginFromFilename(const char *Filename);
+plugin_mailbox *GetPluginMailboxFromFilename(const char *Filename);
 
 void DestroyPluginFS(plugin_fs *PluginFS);
 
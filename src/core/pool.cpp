@@ -0,0 +1,257 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define internal static
+
+uint32_t ThreadPoolDefaultThreadCount()
+{
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+    return Count > 0 ? (uint32_t) Count : 1;
+}
+
+internal bool
+BeginDeque(pool_deque *Deque)
+{
+    Deque->Tasks = (pool_task *) malloc(POOL_DEQUE_INITIAL_SIZE * sizeof(pool_task));
+    Deque->Capacity = POOL_DEQUE_INITIAL_SIZE;
+    Deque->Head = 0;
+    Deque->Count = 0;
+
+    return Deque->Tasks && pthread_mutex_init(&Deque->Lock, NULL) == 0;
+}
+
+internal void
+EndDeque(pool_deque *Deque)
+{
+    pthread_mutex_destroy(&Deque->Lock);
+    free(Deque->Tasks);
+}
+
+// NOTE(koekeishiya): Must be called with the deque locked.
+internal void
+GrowDeque(pool_deque *Deque)
+{
+    uint32_t Capacity = Deque->Capacity * 2;
+    pool_task *Tasks = (pool_task *) malloc(Capacity * sizeof(pool_task));
+
+    for (uint32_t Index = 0; Index < Deque->Count; ++Index) {
+        Tasks[Index] = Deque->Tasks[(Deque->Head + Index) % Deque->Capacity];
+    }
+
+    free(Deque->Tasks);
+    Deque->Tasks = Tasks;
+    Deque->Capacity = Capacity;
+    Deque->Head = 0;
+}
+
+internal void
+PushBack(pool_deque *Deque, pool_task *Task)
+{
+    pthread_mutex_lock(&Deque->Lock);
+
+    if (Deque->Count == Deque->Capacity) {
+        GrowDeque(Deque);
+    }
+
+    Deque->Tasks[(Deque->Head + Deque->Count) % Deque->Capacity] = *Task;
+    __atomic_store_n(&Deque->Count, Deque->Count + 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&Deque->Lock);
+}
+
+internal bool
+PopBack(pool_deque *Deque, pool_task *Task)
+{
+    if (!__atomic_load_n(&Deque->Count, __ATOMIC_RELAXED)) return false;
+
+    pthread_mutex_lock(&Deque->Lock);
+
+    bool Result = Deque->Count > 0;
+    if (Result) {
+        __atomic_store_n(&Deque->Count, Deque->Count - 1, __ATOMIC_RELAXED);
+        *Task = Deque->Tasks[(Deque->Head + Deque->Count) % Deque->Capacity];
+    }
+
+    pthread_mutex_unlock(&Deque->Lock);
+    return Result;
+}
+
+internal bool
+PopFront(pool_deque *Deque, pool_task *Task)
+{
+    if (!__atomic_load_n(&Deque->Count, __ATOMIC_RELAXED)) return false;
+
+    pthread_mutex_lock(&Deque->Lock);
+
+    bool Result = Deque->Count > 0;
+    if (Result) {
+        *Task = Deque->Tasks[Deque->Head];
+        Deque->Head = (Deque->Head + 1) % Deque->Capacity;
+        __atomic_store_n(&Deque->Count, Deque->Count - 1, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&Deque->Lock);
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): The group may go out of scope as soon as its last task is done, so
+ * we must not touch it after the decrement. The waiter is woken through the pool instead.
+ */
+internal void
+RunTask(thread_pool *Pool, pool_task *Task)
+{
+    Task->Callback(Task->Data);
+
+    if (__atomic_sub_fetch(&Task->Group->Pending, 1, __ATOMIC_SEQ_CST) == TASK_GROUP_WAITING) {
+        pthread_mutex_lock(&Pool->CompletionLock);
+        pthread_cond_broadcast(&Pool->Completion);
+        pthread_mutex_unlock(&Pool->CompletionLock);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Run a single task, preferably from the deque at 'Own'. Returns false
+ * if every deque was empty. Threads that do not own a deque steal from all of them.
+ */
+internal bool
+RunNextTask(thread_pool *Pool, uint32_t Own, bool Owner)
+{
+    pool_task Task;
+    if (Owner && PopBack(Pool->Deques + Own, &Task)) {
+        RunTask(Pool, &Task);
+        return true;
+    }
+
+    for (uint32_t Index = 0; Index < Pool->DequeCount; ++Index) {
+        pool_deque *Deque = Pool->Deques + ((Own + Index) % Pool->DequeCount);
+        if (PopFront(Deque, &Task)) {
+            RunTask(Pool, &Task);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+internal void *
+ThreadPoolWorkerProc(void *Data)
+{
+    pool_worker *Worker = (pool_worker *) Data;
+    thread_pool *Pool = Worker->Pool;
+
+    while (__atomic_load_n(&Pool->Running, __ATOMIC_ACQUIRE)) {
+        if (!RunNextTask(Pool, Worker->Index, true)) {
+            WakeupWait(&Pool->Wakeup);
+        }
+    }
+
+    return NULL;
+}
+
+bool BeginThreadPool(thread_pool *Pool, uint32_t ThreadCount)
+{
+    memset(Pool, 0, sizeof(thread_pool));
+    Pool->ThreadCount = ThreadCount;
+    Pool->DequeCount = ThreadCount ? ThreadCount : 1;
+
+    if (!WakeupInit(&Pool->Wakeup)) {
+        return false;
+    }
+
+    if (pthread_mutex_init(&Pool->CompletionLock, NULL) != 0 ||
+        pthread_cond_init(&Pool->Completion, NULL) != 0) {
+        return false;
+    }
+
+    Pool->Deques = (pool_deque *) calloc(Pool->DequeCount, sizeof(pool_deque));
+    for (uint32_t Index = 0; Index < Pool->DequeCount; ++Index) {
+        if (!BeginDeque(Pool->Deques + Index)) {
+            return false;
+        }
+    }
+
+    Pool->Running = true;
+    Pool->Workers = (pool_worker *) calloc(Pool->DequeCount, sizeof(pool_worker));
+
+    for (uint32_t Index = 0; Index < ThreadCount; ++Index) {
+        pool_worker *Worker = Pool->Workers + Index;
+        Worker->Pool = Pool;
+        Worker->Index = Index;
+
+        if (pthread_create(&Worker->Thread, NULL, &ThreadPoolWorkerProc, Worker) != 0) {
+            Pool->ThreadCount = Index;
+            break;
+        }
+    }
+
+    return Pool->ThreadCount == ThreadCount;
+}
+
+// NOTE(koekeishiya): Tasks that are still queued are dropped.
+void EndThreadPool(thread_pool *Pool)
+{
+    __atomic_store_n(&Pool->Running, false, __ATOMIC_RELEASE);
+    for (uint32_t Index = 0; Index < Pool->ThreadCount; ++Index) {
+        WakeupPost(&Pool->Wakeup);
+    }
+
+    for (uint32_t Index = 0; Index < Pool->ThreadCount; ++Index) {
+        pthread_join(Pool->Workers[Index].Thread, NULL);
+    }
+
+    for (uint32_t Index = 0; Index < Pool->DequeCount; ++Index) {
+        EndDeque(Pool->Deques + Index);
+    }
+
+    pthread_cond_destroy(&Pool->Completion);
+    pthread_mutex_destroy(&Pool->CompletionLock);
+    WakeupDestroy(&Pool->Wakeup);
+    free(Pool->Deques);
+    free(Pool->Workers);
+}
+
+// NOTE(koekeishiya): Must be thread-safe! Tasks are spread round-robin over the deques.
+void ThreadPoolSubmit(thread_pool *Pool, task_group *Group, thread_pool_callback *Callback, void *Data)
+{
+    pool_task Task = { Callback, Data, Group };
+    __atomic_add_fetch(&Group->Pending, 1, __ATOMIC_RELAXED);
+
+    uint32_t Index = __atomic_fetch_add(&Pool->NextDeque, 1, __ATOMIC_RELAXED) % Pool->DequeCount;
+    PushBack(Pool->Deques + Index, &Task);
+
+    if (Pool->ThreadCount) {
+        WakeupPost(&Pool->Wakeup);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Returns when every task in the group has completed. The calling thread
+ * runs queued tasks while there are any, so a batch completes even if every worker is busy.
+ * When the remaining tasks are all running on other threads, it parks until the last one is
+ * done, instead of burning a processor while a plugin waits on an unresponsive application.
+ */
+void ThreadPoolWait(thread_pool *Pool, task_group *Group)
+{
+    uint32_t Start = 0;
+    while (__atomic_load_n(&Group->Pending, __ATOMIC_ACQUIRE)) {
+        if (!RunNextTask(Pool, Start++ % Pool->DequeCount, false)) {
+            break;
+        }
+    }
+
+    // NOTE(koekeishiya): Pairs with the decrement in 'RunTask'; either the last task sees
+    // the waiting bit and signals, or we see that the count has already reached zero.
+    if (!(__atomic_fetch_or(&Group->Pending, TASK_GROUP_WAITING, __ATOMIC_SEQ_CST) & ~TASK_GROUP_WAITING)) {
+        return;
+    }
+
+    pthread_mutex_lock(&Pool->CompletionLock);
+    while (__atomic_load_n(&Group->Pending, __ATOMIC_ACQUIRE) & ~TASK_GROUP_WAITING) {
+        pthread_cond_wait(&Pool->Completion, &Pool->CompletionLock);
+    }
+    pthread_mutex_unlock(&Pool->CompletionLock);
+}
@@ -0,0 +1,83 @@
+#ifndef CHUNKWM_CORE_POOL_H
+#define CHUNKWM_CORE_POOL_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "wakeup.h"
+
+#define THREAD_POOL_CALLBACK(name) void name(void *Data)
+typedef THREAD_POOL_CALLBACK(thread_pool_callback);
+
+/*
+ * NOTE(koekeishiya): A batch of tasks that is waited on as a whole, see 'ThreadPoolWait'.
+ * Lives on the stack of the thread that submits the batch. 'Pending' is the number of
+ * unfinished tasks; the top bit is set once the waiting thread is about to park.
+ */
+#define TASK_GROUP_WAITING 0x80000000
+
+struct task_group
+{
+    uint32_t volatile Pending;
+};
+
+struct pool_task
+{
+    thread_pool_callback *Callback;
+    void *Data;
+    task_group *Group;
+};
+
+/*
+ * NOTE(koekeishiya): Every worker owns a deque. New tasks are spread over the deques,
+ * a worker takes tasks from the back of its own deque and steals from the front of the
+ * others when it runs dry. A full deque doubles in size, so submitting never fails.
+ */
+#define POOL_DEQUE_INITIAL_SIZE 64
+
+struct pool_deque
+{
+    pthread_mutex_t Lock;
+    pool_task *Tasks;
+    uint32_t Capacity;
+    uint32_t Head;
+    uint32_t Count;
+
+    uint8_t Pad[64];
+};
+
+struct pool_worker
+{
+    struct thread_pool *Pool;
+    uint32_t Index;
+    pthread_t Thread;
+};
+
+/*
+ * NOTE(koekeishiya): With zero threads there is still one deque, and every task is run
+ * by the thread that waits for its group.
+ */
+struct thread_pool
+{
+    bool volatile Running;
+    uint32_t ThreadCount;
+    uint32_t DequeCount;
+    uint32_t volatile NextDeque;
+
+    pool_deque *Deques;
+    pool_worker *Workers;
+    wakeup Wakeup;
+
+    pthread_mutex_t CompletionLock;
+    pthread_cond_t Completion;
+};
+
+uint32_t ThreadPoolDefaultThreadCount();
+
+bool BeginThreadPool(thread_pool *Pool, uint32_t ThreadCount);
+void EndThreadPool(thread_pool *Pool);
+
+void ThreadPoolSubmit(thread_pool *Pool, task_group *Group, thread_pool_callback *Callback, void *Data);
+void ThreadPoolWait(thread_pool *Pool, task_group *Group);
+
+#endif
@@ -0,0 +1,189 @@
+#include "recorder.h"
+#include "trace.h"
+#include "clog.h"
+
+#include "dispatch/event.h"
+#include "dispatch/workspace.h"
+
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+#include "../common/accessibility/element.h"
+#include "../common/misc/carbon.h"
+#include "../common/misc/timer.h"
+
+#include <pthread.h>
+
+#define internal static
+
+internal trace_writer Writer;
+internal pthread_mutex_t WriterLock;
+
+internal char *
+CopyWindowRole(CFStringRef Role)
+{
+    return Role ? CopyCFStringToC(Role) : NULL;
+}
+
+/*
+ * NOTE(koekeishiya): The event is recorded before its handler runs. The handlers for
+ * moved, resized and title changed events refresh the window from the accessibility API,
+ * so we take the same values here, otherwise the snapshot would be one event behind.
+ */
+internal void
+SerializeWindow(chunk_event *Event, trace_buffer *Buffer)
+{
+    macos_window *Window = (macos_window *) Event->Context;
+
+    trace_window Snapshot = {};
+    Snapshot.Id = Window->Id;
+    Snapshot.Flags = Window->Flags;
+    Snapshot.Level = Window->Level;
+    Snapshot.PID = Window->Owner->PID;
+    Snapshot.X = Window->Position.x;
+    Snapshot.Y = Window->Position.y;
+    Snapshot.Width = Window->Size.width;
+    Snapshot.Height = Window->Size.height;
+    Snapshot.Owner = Window->Owner->Name;
+    Snapshot.Name = Window->Name;
+
+    bool Valid = !AXLibHasFlags(Window, Window_Invalid);
+    if (Valid && (Event->Type == ChunkWM_WindowMoved || Event->Type == ChunkWM_WindowResized)) {
+        CGPoint Position = AXLibGetWindowPosition(Window->Ref);
+        CGSize Size = AXLibGetWindowSize(Window->Ref);
+        Snapshot.X = Position.x;
+        Snapshot.Y = Position.y;
+        Snapshot.Width = Size.width;
+        Snapshot.Height = Size.height;
+    }
+
+    char *Title = NULL;
+    if (Valid && Event->Type == ChunkWM_WindowTitleChanged) {
+        Title = AXLibGetWindowTitle(Window->Ref);
+        Snapshot.Name = Title;
+    }
+
+    char *Role = CopyWindowRole(Window->Mainrole);
+    char *Subrole = CopyWindowRole(Window->Subrole);
+    Snapshot.Role = Role;
+    Snapshot.Subrole = Subrole;
+
+    TraceWriteWindow(Buffer, &Snapshot);
+
+    if (Title) free(Title);
+    if (Role) free(Role);
+    if (Subrole) free(Subrole);
+}
+
+/*
+ * NOTE(koekeishiya): Plugin commands, broadcasts and plugin (un)loading are not recorded.
+ * Broadcasts are generated by the plugins themselves, and will be sent again during replay.
+ * Returns false for events that should not be recorded.
+ */
+internal bool
+SerializeEvent(chunk_event *Event, trace_buffer *Buffer)
+{
+    switch (Event->Type) {
+    case ChunkWM_ApplicationLaunched:
+    case ChunkWM_ApplicationTerminated: {
+        carbon_application_details *Info = (carbon_application_details *) Event->Context;
+        trace_application Snapshot = { Info->PID, Info->ProcessName };
+        TraceWriteApplication(Buffer, &Snapshot);
+    } break;
+    case ChunkWM_ApplicationActivated:
+    case ChunkWM_ApplicationDeactivated:
+    case ChunkWM_ApplicationVisible:
+    case ChunkWM_ApplicationHidden: {
+        workspace_application_details *Info = (workspace_application_details *) Event->Context;
+        trace_application Snapshot = { Info->PID, Info->ProcessName };
+        TraceWriteApplication(Buffer, &Snapshot);
+    } break;
+    case ChunkWM_DisplayAdded:
+    case ChunkWM_DisplayRemoved:
+    case ChunkWM_DisplayMoved:
+    case ChunkWM_DisplayResized: {
+        CGDirectDisplayID *DisplayId = (CGDirectDisplayID *) Event->Context;
+        TraceWriteU32(Buffer, *DisplayId);
+    } break;
+    case ChunkWM_DisplayChanged:
+    case ChunkWM_SpaceChanged: {
+    } break;
+    case ChunkWM_WindowCreated:
+    case ChunkWM_WindowDestroyed:
+    case ChunkWM_WindowFocused:
+    case ChunkWM_WindowMoved:
+    case ChunkWM_WindowResized:
+    case ChunkWM_WindowMinimized:
+    case ChunkWM_WindowDeminimized:
+    case ChunkWM_WindowTitleChanged: {
+        SerializeWindow(Event, Buffer);
+    } break;
+    default: {
+        return false;
+    } break;
+    }
+
+    return true;
+}
+
+internal
+EVENT_TRACE_HOOK(RecordEvent)
+{
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+
+    if (!SerializeEvent(Event, &Buffer)) {
+        return;
+    }
+
+    if (Buffer.Overflow) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm: trace payload for '%s' is too large, recording empty event\n", Event->Name);
+    }
+
+    pthread_mutex_lock(&WriterLock);
+    if (Writer.Handle) {
+        if (!TraceWriteRecord(&Writer, Event->Type, Event->Timestamp, &Buffer)) {
+            c_log(C_LOG_LEVEL_ERROR, "chunkwm: failed to write event trace, recording stopped!\n");
+            SetEventTraceHook(NULL);
+            EndTraceWriter(&Writer);
+        }
+    }
+    pthread_mutex_unlock(&WriterLock);
+}
+
+bool BeginEventRecorder()
+{
+    return pthread_mutex_init(&WriterLock, NULL) == 0;
+}
+
+// NOTE(koekeishiya): A recording that is already in progress is stopped first.
+bool StartEventRecording(const char *Path)
+{
+    pthread_mutex_lock(&WriterLock);
+
+    EndTraceWriter(&Writer);
+    bool Result = BeginTraceWriter(&Writer, Path, GetTimeNanoseconds());
+    SetEventTraceHook(Result ? &RecordEvent : NULL);
+
+    pthread_mutex_unlock(&WriterLock);
+
+    if (Result) {
+        c_log(C_LOG_LEVEL_DEBUG, "chunkwm: recording events to '%s'\n", Path);
+    } else {
+        c_log(C_LOG_LEVEL_ERROR, "chunkwm: could not open trace file '%s'\n", Path);
+    }
+
+    return Result;
+}
+
+// NOTE(koekeishiya): Returns the number of events that were recorded.
+uint64_t StopEventRecording()
+{
+    pthread_mutex_lock(&WriterLock);
+
+    SetEventTraceHook(NULL);
+    uint64_t Result = Writer.Handle ? Writer.Records : 0;
+    EndTraceWriter(&Writer);
+
+    pthread_mutex_unlock(&WriterLock);
+    return Result;
+}
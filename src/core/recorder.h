@@ -0,0 +1,11 @@
+#ifndef CHUNKWM_CORE_RECORDER_H
+#define CHUNKWM_CORE_RECORDER_H
+
+#include <stdint.h>
+
+bool BeginEventRecorder();
+
+bool StartEventRecording(const char *Path);
+uint64_t StopEventRecording();
+
+#endif
@@ -0,0 +1,187 @@
+#include "shmring.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+
+#define internal static
+
+internal inline void
+SharedRingPause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+internal inline uint32_t
+SharedRingRecordSize(uint32_t Size)
+{
+    return (sizeof(shared_ring_record) + Size + 7) & ~7;
+}
+
+// NOTE(koekeishiya): 'Capacity' must be a power of two, and 'Memory' aligned to a cache line.
+size_t SharedRingMemorySize(uint32_t Capacity)
+{
+    return sizeof(shared_ring_header) + Capacity;
+}
+
+// NOTE(koekeishiya): Called by the process that creates the shared memory, before the other one attaches.
+void SharedRingInit(shared_ring *Ring, void *Memory, uint32_t Capacity, int WaitFD, int WakeFD)
+{
+    memset(Memory, 0, sizeof(shared_ring_header));
+    Ring->Header = (shared_ring_header *) Memory;
+    Ring->Header->Magic = SHARED_RING_MAGIC;
+    Ring->Header->Capacity = Capacity;
+    Ring->Data = (uint8_t *) Memory + sizeof(shared_ring_header);
+    Ring->WaitFD = WaitFD;
+    Ring->WakeFD = WakeFD;
+}
+
+bool SharedRingAttach(shared_ring *Ring, void *Memory, int WaitFD, int WakeFD)
+{
+    shared_ring_header *Header = (shared_ring_header *) Memory;
+    if ((Header->Magic != SHARED_RING_MAGIC) ||
+        (Header->Capacity == 0) ||
+        (Header->Capacity & (Header->Capacity - 1))) {
+        return false;
+    }
+
+    Ring->Header = Header;
+    Ring->Data = (uint8_t *) Memory + sizeof(shared_ring_header);
+    Ring->WaitFD = WaitFD;
+    Ring->WakeFD = WakeFD;
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): Must only be called by the producer. Returns false if the record was
+ * dropped, because the consumer has not caught up or the record is larger than half the ring.
+ */
+bool SharedRingWrite(shared_ring *Ring, uint32_t Type, const void *Data, uint32_t Size)
+{
+    shared_ring_header *Header = Ring->Header;
+    uint32_t Capacity = Header->Capacity;
+    uint32_t Needed = SharedRingRecordSize(Size);
+
+    uint64_t Tail = Header->Tail;
+    uint64_t Head = __atomic_load_n(&Header->Head, __ATOMIC_ACQUIRE);
+    uint32_t Offset = Tail & (Capacity - 1);
+    uint32_t Contiguous = Capacity - Offset;
+    uint32_t Skip = Contiguous < Needed ? Contiguous : 0;
+
+    if ((Needed > Capacity / 2) ||
+        (Tail + Skip + Needed - Head > Capacity)) {
+        __atomic_store_n(&Header->Dropped, Header->Dropped + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    if (Skip) {
+        shared_ring_record *Record = (shared_ring_record *) (Ring->Data + Offset);
+        Record->Type = SHARED_RING_SKIP;
+        Record->Size = Skip - sizeof(shared_ring_record);
+        Tail += Skip;
+        Offset = 0;
+    }
+
+    shared_ring_record *Record = (shared_ring_record *) (Ring->Data + Offset);
+    Record->Type = Type;
+    Record->Size = Size;
+    if (Size) memcpy(Record + 1, Data, Size);
+
+    __atomic_store_n(&Header->Tail, Tail + Needed, __ATOMIC_RELEASE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&Header->Sleeping, __ATOMIC_RELAXED)) {
+        char Byte = 0;
+        ssize_t Unused = write(Ring->WakeFD, &Byte, 1);
+        (void) Unused;
+    }
+
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): Must only be called by the consumer. Returns false if the ring is empty.
+ * A record that is larger than 'Capacity' is skipped. The other process may have crashed
+ * half-way through, or written garbage, so a record that does not fit in the ring empties it.
+ */
+bool SharedRingRead(shared_ring *Ring, uint32_t *Type, void *Data, uint32_t *Size, uint32_t Capacity)
+{
+    shared_ring_header *Header = Ring->Header;
+    uint32_t RingCapacity = Header->Capacity;
+
+    for (;;) {
+        uint64_t Head = Header->Head;
+        uint64_t Tail = __atomic_load_n(&Header->Tail, __ATOMIC_ACQUIRE);
+        if (Head == Tail) return false;
+
+        uint32_t Offset = Head & (RingCapacity - 1);
+        shared_ring_record *Record = (shared_ring_record *) (Ring->Data + Offset);
+        uint32_t RecordSize = Record->Size;
+
+        if ((RecordSize > RingCapacity) ||
+            (Offset + SharedRingRecordSize(RecordSize) > RingCapacity) ||
+            (Tail - Head < SharedRingRecordSize(RecordSize))) {
+            __atomic_store_n(&Header->Head, Tail, __ATOMIC_RELEASE);
+            return false;
+        }
+
+        uint32_t RecordType = Record->Type;
+        if ((RecordType != SHARED_RING_SKIP) && (RecordSize <= Capacity)) {
+            *Type = RecordType;
+            *Size = RecordSize;
+            if (RecordSize) memcpy(Data, Record + 1, RecordSize);
+            __atomic_store_n(&Header->Head, Head + SharedRingRecordSize(RecordSize), __ATOMIC_RELEASE);
+            return true;
+        }
+
+        __atomic_store_n(&Header->Head, Head + SharedRingRecordSize(RecordSize), __ATOMIC_RELEASE);
+    }
+}
+
+internal inline bool
+SharedRingHasData(shared_ring_header *Header)
+{
+    return __atomic_load_n(&Header->Tail, __ATOMIC_SEQ_CST) != Header->Head;
+}
+
+/*
+ * NOTE(koekeishiya): Must only be called by the consumer. Spins for a short while, then parks
+ * on the pipe. Returns false if the producer exited, or the time ran out; -1 waits forever.
+ */
+bool SharedRingWait(shared_ring *Ring, int Milliseconds)
+{
+    shared_ring_header *Header = Ring->Header;
+
+    for (int Index = 0; Index < SHARED_RING_SPIN_COUNT; ++Index) {
+        if (SharedRingHasData(Header)) return true;
+        SharedRingPause();
+    }
+
+    __atomic_store_n(&Header->Sleeping, 1, __ATOMIC_SEQ_CST);
+    if (SharedRingHasData(Header)) {
+        __atomic_store_n(&Header->Sleeping, 0, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    bool Result;
+    struct pollfd Poll = { Ring->WaitFD, POLLIN, 0 };
+    int Ready = poll(&Poll, 1, Milliseconds);
+    if (Ready > 0) {
+        char Buffer[64];
+        Result = read(Ring->WaitFD, Buffer, sizeof(Buffer)) != 0;
+    } else {
+        Result = SharedRingHasData(Header);
+    }
+
+    __atomic_store_n(&Header->Sleeping, 0, __ATOMIC_RELAXED);
+    return Result;
+}
+
+uint64_t SharedRingDropped(shared_ring *Ring)
+{
+    return __atomic_load_n(&Ring->Header->Dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,66 @@
+#ifndef CHUNKWM_CORE_SHMRING_H
+#define CHUNKWM_CORE_SHMRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * NOTE(koekeishiya): Single-producer single-consumer ring of variable sized records, placed in
+ * memory that is shared between two processes. A record is a shared_ring_record followed by
+ * 'Size' bytes, padded to 8 bytes. A record never wraps around the end of the ring; the space
+ * that is left is skipped with a record of type 'SHARED_RING_SKIP'.
+ *
+ * 'Head' is only written by the consumer and 'Tail' only by the producer, each on its own
+ * cache line. Writing never blocks: if the record does not fit, it is dropped and counted.
+ *
+ * The consumer parks on a pipe. It sets 'Sleeping' before it checks the ring one last time,
+ * and the producer only writes to the pipe if 'Sleeping' is set after it published a record,
+ * so a busy ring does not cost a system call per record. The pipe also tells the consumer
+ * that the producer has exited, because its end of the pipe is closed.
+ *
+ * This file does not depend on any macOS framework, so that it can be used on Linux.
+ */
+#define SHARED_RING_MAGIC 0x474e5253 // "SRNG" on little-endian hosts
+#define SHARED_RING_SKIP 0xffffffff
+#define SHARED_RING_SPIN_COUNT 256
+
+struct shared_ring_header
+{
+    uint32_t Magic;
+    uint32_t Capacity;
+    uint64_t volatile Dropped;
+    uint8_t Padding0[48];
+
+    uint64_t volatile Head;
+    uint32_t volatile Sleeping;
+    uint8_t Padding1[52];
+
+    uint64_t volatile Tail;
+    uint8_t Padding2[56];
+};
+
+struct shared_ring_record
+{
+    uint32_t Type;
+    uint32_t Size;
+};
+
+struct shared_ring
+{
+    shared_ring_header *Header;
+    uint8_t *Data;
+    int WaitFD;
+    int WakeFD;
+};
+
+size_t SharedRingMemorySize(uint32_t Capacity);
+void SharedRingInit(shared_ring *Ring, void *Memory, uint32_t Capacity, int WaitFD, int WakeFD);
+bool SharedRingAttach(shared_ring *Ring, void *Memory, int WaitFD, int WakeFD);
+
+bool SharedRingWrite(shared_ring *Ring, uint32_t Type, const void *Data, uint32_t Size);
+bool SharedRingRead(shared_ring *Ring, uint32_t *Type, void *Data, uint32_t *Size, uint32_t Capacity);
+bool SharedRingWait(shared_ring *Ring, int Milliseconds);
+
+uint64_t SharedRingDropped(shared_ring *Ring);
+
+#endif
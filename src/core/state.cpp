@@ -97,14 +97,15 @@ void RemoveWindowFromCollection(macos_window *Window)
     AXLibRemoveObserverNotification(&Window->Owner->Observer, Window->Ref, kAXWindowDeminiaturizedNotification);
 }
 
-// NOTE(koekeishiya): Caller is responsible for passing a valid window!
-void UpdateWindowTitle(macos_window *Window)
+/*
+ * NOTE(koekeishiya): Caller is responsible for passing a valid window!
+ * Caller is responsible for freeing memory of the returned previous title.
+ */
+char *UpdateWindowTitle(macos_window *Window)
 {
-    if (Window->Name) {
-        free(Window->Name);
-    }
-
+    char *Previous = Window->Name;
     Window->Name = AXLibGetWindowTitle(Window->Ref);
+    return Previous;
 }
 
 /*
@@ -220,13 +221,13 @@ OBSERVER_CALLBACK(ApplicationCallback)
         uint32_t WindowId = AXLibGetWindowID(Element);
         macos_window *Window = GetWindowByID(WindowId);
         if (Window) {
-            ConstructEvent(ChunkWM_WindowMoved, Window);
+            ConstructCoalescedEvent(ChunkWM_WindowMoved, Window, WindowId);
         }
     } else if (CFEqual(Notification, kAXWindowResizedNotification)) {
         uint32_t WindowId = AXLibGetWindowID(Element);
         macos_window *Window = GetWindowByID(WindowId);
         if (Window) {
-            ConstructEvent(ChunkWM_WindowResized, Window);
+            ConstructCoalescedEvent(ChunkWM_WindowResized, Window, WindowId);
         }
     } else if (CFEqual(Notification, kAXWindowMiniaturizedNotification)) {
         /*
@@ -253,7 +254,7 @@ OBSERVER_CALLBACK(ApplicationCallback)
         uint32_t WindowId = AXLibGetWindowID(Element);
         macos_window *Window = GetWindowByID(WindowId);
         if (Window) {
-            ConstructEvent(ChunkWM_WindowTitleChanged, Window);
+            ConstructCoalescedEvent(ChunkWM_WindowTitleChanged, Window, WindowId);
         }
     }
 }
@@ -308,14 +309,13 @@ void ConstructAndAddApplication(carbon_application_details *Info)
     ConstructAndAddApplicationDispatch(Application, Info, 0.0f);
 }
 
-void RemoveAndDestroyApplication(macos_application *Application)
+// NOTE(koekeishiya): Caller is responsible for destroying the application.
+void RemoveApplicationFromCollection(macos_application *Application)
 {
     macos_application_map_it It = Applications.find(Application->PID);
     if (It != Applications.end()) {
         Applications.erase(It);
     }
-
-    AXLibDestroyApplication(Application);
 }
 
 void UpdateWindowCollection()
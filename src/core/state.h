@@ -8,12 +8,12 @@ bool AddWindowToCollection(macos_window *Window);
 void RemoveWindowFromCollection(macos_window *Window);
 void UpdateWindowCollection();
 
-void UpdateWindowTitle(macos_window *Window);
+char *UpdateWindowTitle(macos_window *Window);
 
 struct macos_application;
 macos_application *GetApplicationFromPID(pid_t PID);
 void ConstructAndAddApplication(carbon_application_details *Info);
-void RemoveAndDestroyApplication(macos_application *Application);
+void RemoveApplicationFromCollection(macos_application *Application);
 
 bool InitState();
 
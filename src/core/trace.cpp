@@ -0,0 +1,240 @@
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define internal static
+
+void TraceBufferReset(trace_buffer *Buffer)
+{
+    Buffer->Size = 0;
+    Buffer->Cursor = 0;
+    Buffer->Overflow = false;
+}
+
+void TraceWriteBytes(trace_buffer *Buffer, const void *Data, uint32_t Size)
+{
+    if (!Size) return;
+
+    if (Buffer->Size + Size > TRACE_MAX_PAYLOAD) {
+        Buffer->Overflow = true;
+        return;
+    }
+
+    memcpy(Buffer->Data + Buffer->Size, Data, Size);
+    Buffer->Size += Size;
+}
+
+bool TraceReadBytes(trace_buffer *Buffer, void *Data, uint32_t Size)
+{
+    if (Buffer->Cursor + Size > Buffer->Size) {
+        Buffer->Overflow = true;
+        return false;
+    }
+
+    memcpy(Data, Buffer->Data + Buffer->Cursor, Size);
+    Buffer->Cursor += Size;
+    return true;
+}
+
+void TraceWriteU32(trace_buffer *Buffer, uint32_t Value)
+{
+    TraceWriteBytes(Buffer, &Value, sizeof(Value));
+}
+
+void TraceWriteF64(trace_buffer *Buffer, double Value)
+{
+    TraceWriteBytes(Buffer, &Value, sizeof(Value));
+}
+
+// NOTE(koekeishiya): A NULL string is written as an empty string.
+void TraceWriteString(trace_buffer *Buffer, const char *String)
+{
+    uint32_t Length = String ? strlen(String) : 0;
+    if (Length > TRACE_MAX_STRING) {
+        Length = TRACE_MAX_STRING;
+    }
+
+    TraceWriteU32(Buffer, Length);
+    TraceWriteBytes(Buffer, String, Length);
+}
+
+bool TraceReadU32(trace_buffer *Buffer, uint32_t *Value)
+{
+    return TraceReadBytes(Buffer, Value, sizeof(*Value));
+}
+
+bool TraceReadF64(trace_buffer *Buffer, double *Value)
+{
+    return TraceReadBytes(Buffer, Value, sizeof(*Value));
+}
+
+// NOTE(koekeishiya): Caller is responsible for freeing memory of the returned string.
+bool TraceReadString(trace_buffer *Buffer, char **String)
+{
+    uint32_t Length;
+    if (!TraceReadU32(Buffer, &Length)) return false;
+    if (Length > TRACE_MAX_STRING) return false;
+
+    char *Result = (char *) malloc(Length + 1);
+    if (!TraceReadBytes(Buffer, Result, Length)) {
+        free(Result);
+        return false;
+    }
+
+    Result[Length] = '\0';
+    *String = Result;
+    return true;
+}
+
+void TraceWriteWindow(trace_buffer *Buffer, trace_window *Window)
+{
+    TraceWriteU32(Buffer, Window->Id);
+    TraceWriteU32(Buffer, Window->Flags);
+    TraceWriteU32(Buffer, Window->Level);
+    TraceWriteU32(Buffer, (uint32_t) Window->PID);
+    TraceWriteF64(Buffer, Window->X);
+    TraceWriteF64(Buffer, Window->Y);
+    TraceWriteF64(Buffer, Window->Width);
+    TraceWriteF64(Buffer, Window->Height);
+    TraceWriteString(Buffer, Window->Name);
+    TraceWriteString(Buffer, Window->Owner);
+    TraceWriteString(Buffer, Window->Role);
+    TraceWriteString(Buffer, Window->Subrole);
+}
+
+bool TraceReadWindow(trace_buffer *Buffer, trace_window *Window)
+{
+    memset(Window, 0, sizeof(trace_window));
+
+    bool Result = TraceReadU32(Buffer, &Window->Id) &&
+                  TraceReadU32(Buffer, &Window->Flags) &&
+                  TraceReadU32(Buffer, &Window->Level) &&
+                  TraceReadU32(Buffer, (uint32_t *) &Window->PID) &&
+                  TraceReadF64(Buffer, &Window->X) &&
+                  TraceReadF64(Buffer, &Window->Y) &&
+                  TraceReadF64(Buffer, &Window->Width) &&
+                  TraceReadF64(Buffer, &Window->Height) &&
+                  TraceReadString(Buffer, &Window->Name) &&
+                  TraceReadString(Buffer, &Window->Owner) &&
+                  TraceReadString(Buffer, &Window->Role) &&
+                  TraceReadString(Buffer, &Window->Subrole);
+
+    if (!Result) {
+        TraceFreeWindow(Window);
+    }
+
+    return Result;
+}
+
+void TraceFreeWindow(trace_window *Window)
+{
+    free(Window->Name);
+    free(Window->Owner);
+    free(Window->Role);
+    free(Window->Subrole);
+    memset(Window, 0, sizeof(trace_window));
+}
+
+void TraceWriteApplication(trace_buffer *Buffer, trace_application *Application)
+{
+    TraceWriteU32(Buffer, (uint32_t) Application->PID);
+    TraceWriteString(Buffer, Application->Name);
+}
+
+bool TraceReadApplication(trace_buffer *Buffer, trace_application *Application)
+{
+    memset(Application, 0, sizeof(trace_application));
+    return TraceReadU32(Buffer, (uint32_t *) &Application->PID) &&
+           TraceReadString(Buffer, &Application->Name);
+}
+
+void TraceFreeApplication(trace_application *Application)
+{
+    free(Application->Name);
+    Application->Name = NULL;
+}
+
+bool BeginTraceWriter(trace_writer *Writer, const char *Path, uint64_t Origin)
+{
+    Writer->Handle = fopen(Path, "wb");
+    if (!Writer->Handle) {
+        return false;
+    }
+
+    trace_header Header = { TRACE_MAGIC, TRACE_VERSION, Origin };
+    if (fwrite(&Header, sizeof(Header), 1, Writer->Handle) != 1) {
+        fclose(Writer->Handle);
+        Writer->Handle = NULL;
+        return false;
+    }
+
+    Writer->Origin = Origin;
+    Writer->Records = 0;
+    return true;
+}
+
+/*
+ * NOTE(koekeishiya): A payload that did not fit in the buffer is written as an empty
+ * record, so that the trace still shows that the event happened.
+ */
+bool TraceWriteRecord(trace_writer *Writer, uint32_t Type, uint64_t Timestamp, trace_buffer *Payload)
+{
+    uint32_t Size = Payload && !Payload->Overflow ? Payload->Size : 0;
+    uint64_t Relative = Timestamp > Writer->Origin ? Timestamp - Writer->Origin : 0;
+    trace_record Record = { Type, Size, Relative };
+
+    bool Result = (fwrite(&Record, sizeof(Record), 1, Writer->Handle) == 1) &&
+                  (!Size || fwrite(Payload->Data, Size, 1, Writer->Handle) == 1);
+    if (Result) {
+        ++Writer->Records;
+    }
+
+    return Result;
+}
+
+void EndTraceWriter(trace_writer *Writer)
+{
+    if (Writer->Handle) {
+        fclose(Writer->Handle);
+        Writer->Handle = NULL;
+    }
+}
+
+bool BeginTraceReader(trace_reader *Reader, const char *Path)
+{
+    Reader->Handle = fopen(Path, "rb");
+    if (!Reader->Handle) {
+        return false;
+    }
+
+    bool Result = (fread(&Reader->Header, sizeof(trace_header), 1, Reader->Handle) == 1) &&
+                  (Reader->Header.Magic == TRACE_MAGIC) &&
+                  (Reader->Header.Version == TRACE_VERSION);
+    if (!Result) {
+        EndTraceReader(Reader);
+    }
+
+    return Result;
+}
+
+// NOTE(koekeishiya): Returns false at the end of the trace, or if the trace is truncated.
+bool TraceReadRecord(trace_reader *Reader, trace_record *Record, trace_buffer *Payload)
+{
+    TraceBufferReset(Payload);
+
+    if (fread(Record, sizeof(trace_record), 1, Reader->Handle) != 1) return false;
+    if (Record->Size > TRACE_MAX_PAYLOAD) return false;
+    if (Record->Size && fread(Payload->Data, Record->Size, 1, Reader->Handle) != 1) return false;
+
+    Payload->Size = Record->Size;
+    return true;
+}
+
+void EndTraceReader(trace_reader *Reader)
+{
+    if (Reader->Handle) {
+        fclose(Reader->Handle);
+        Reader->Handle = NULL;
+    }
+}
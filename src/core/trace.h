@@ -0,0 +1,113 @@
+#ifndef CHUNKWM_CORE_TRACE_H
+#define CHUNKWM_CORE_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * NOTE(koekeishiya): Binary event trace. A trace is an append-only file that starts with a
+ * trace_header, followed by one record per dispatched event:
+ *
+ *     uint32_t Type        event_type, see dispatch/event.h
+ *     uint32_t Size        number of payload bytes that follow
+ *     uint64_t Timestamp   nanoseconds since the header 'Origin', when the event was queued
+ *     uint8_t  Payload[Size]
+ *
+ * The payload is a snapshot of the window, application or display the event refers to, so
+ * that a trace can be replayed without access to the accessibility API. All integers are
+ * written in host byte order, and strings are stored as a uint32_t length and the bytes.
+ *
+ * This file does not depend on any macOS framework, so that traces can be read on Linux.
+ */
+#define TRACE_MAGIC 0x544d5743 // "CWMT" on little-endian hosts
+#define TRACE_VERSION 1
+
+#define TRACE_MAX_PAYLOAD 4096
+#define TRACE_MAX_STRING 1024
+
+struct trace_header
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint64_t Origin;
+};
+
+struct trace_record
+{
+    uint32_t Type;
+    uint32_t Size;
+    uint64_t Timestamp;
+};
+
+struct trace_buffer
+{
+    uint8_t Data[TRACE_MAX_PAYLOAD];
+    uint32_t Size;
+    uint32_t Cursor;
+    bool Overflow;
+};
+
+// NOTE(koekeishiya): Strings are owned by the snapshot, see 'TraceFreeWindow'.
+struct trace_window
+{
+    uint32_t Id;
+    uint32_t Flags;
+    uint32_t Level;
+    int32_t PID;
+
+    double X, Y;
+    double Width, Height;
+
+    char *Name;
+    char *Owner;
+    char *Role;
+    char *Subrole;
+};
+
+struct trace_application
+{
+    int32_t PID;
+    char *Name;
+};
+
+struct trace_writer
+{
+    FILE *Handle;
+    uint64_t Origin;
+    uint64_t Records;
+};
+
+struct trace_reader
+{
+    FILE *Handle;
+    trace_header Header;
+};
+
+void TraceBufferReset(trace_buffer *Buffer);
+void TraceWriteBytes(trace_buffer *Buffer, const void *Data, uint32_t Size);
+bool TraceReadBytes(trace_buffer *Buffer, void *Data, uint32_t Size);
+void TraceWriteU32(trace_buffer *Buffer, uint32_t Value);
+void TraceWriteF64(trace_buffer *Buffer, double Value);
+void TraceWriteString(trace_buffer *Buffer, const char *String);
+bool TraceReadU32(trace_buffer *Buffer, uint32_t *Value);
+bool TraceReadF64(trace_buffer *Buffer, double *Value);
+bool TraceReadString(trace_buffer *Buffer, char **String);
+
+void TraceWriteWindow(trace_buffer *Buffer, trace_window *Window);
+bool TraceReadWindow(trace_buffer *Buffer, trace_window *Window);
+void TraceFreeWindow(trace_window *Window);
+
+void TraceWriteApplication(trace_buffer *Buffer, trace_application *Application);
+bool TraceReadApplication(trace_buffer *Buffer, trace_application *Application);
+void TraceFreeApplication(trace_application *Application);
+
+bool BeginTraceWriter(trace_writer *Writer, const char *Path, uint64_t Origin);
+bool TraceWriteRecord(trace_writer *Writer, uint32_t Type, uint64_t Timestamp, trace_buffer *Payload);
+void EndTraceWriter(trace_writer *Writer);
+
+bool BeginTraceReader(trace_reader *Reader, const char *Path);
+bool TraceReadRecord(trace_reader *Reader, trace_record *Record, trace_buffer *Payload);
+void EndTraceReader(trace_reader *Reader);
+
+#endif
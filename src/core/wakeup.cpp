@@ -0,0 +1,138 @@
+#include "wakeup.h"
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#define internal static
+
+internal inline void
+WakeupPause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+/*
+ * NOTE(koekeishiya): Take one pending post, or all of them. The event-loop drains every
+ * lane before it waits again, so it has no use for the posts that arrived in the meantime.
+ */
+internal inline bool
+WakeupTryTake(wakeup *Wakeup, bool All)
+{
+    int32_t Count = __atomic_load_n(&Wakeup->Count, __ATOMIC_SEQ_CST);
+    while (Count > 0) {
+        int32_t Remaining = All ? 0 : Count - 1;
+        if (__atomic_compare_exchange_n(&Wakeup->Count, &Count, Remaining,
+                                        true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#ifdef __linux__
+internal inline void
+FutexWait(int32_t volatile *Address, int32_t Expected)
+{
+    syscall(SYS_futex, Address, FUTEX_WAIT_PRIVATE, Expected, NULL, NULL, 0);
+}
+
+internal inline void
+FutexWake(int32_t volatile *Address, int32_t Count)
+{
+    syscall(SYS_futex, Address, FUTEX_WAKE_PRIVATE, Count, NULL, NULL, 0);
+}
+#endif
+
+bool WakeupInit(wakeup *Wakeup)
+{
+    Wakeup->Count = 0;
+    Wakeup->Waiters = 0;
+    Wakeup->SpinCount = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? WAKEUP_SPIN_COUNT : 0;
+
+#ifdef __linux__
+    return true;
+#else
+    if (pthread_mutex_init(&Wakeup->Lock, NULL) != 0) {
+        return false;
+    }
+
+    if (pthread_cond_init(&Wakeup->Condition, NULL) != 0) {
+        pthread_mutex_destroy(&Wakeup->Lock);
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+void WakeupDestroy(wakeup *Wakeup)
+{
+#ifndef __linux__
+    pthread_cond_destroy(&Wakeup->Condition);
+    pthread_mutex_destroy(&Wakeup->Lock);
+#endif
+}
+
+/*
+ * NOTE(koekeishiya): The increment of 'Count' and the load of 'Waiters' are sequentially
+ * consistent, and so are the increment of 'Waiters' and the load of 'Count' in a waiter.
+ * Either the poster sees the parked waiter, or the waiter sees the new post before parking.
+ */
+void WakeupPost(wakeup *Wakeup)
+{
+    __atomic_add_fetch(&Wakeup->Count, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&Wakeup->Waiters, __ATOMIC_SEQ_CST)) {
+#ifdef __linux__
+        FutexWake(&Wakeup->Count, 1);
+#else
+        pthread_mutex_lock(&Wakeup->Lock);
+        pthread_cond_signal(&Wakeup->Condition);
+        pthread_mutex_unlock(&Wakeup->Lock);
+#endif
+    }
+}
+
+internal void
+WakeupWaitInternal(wakeup *Wakeup, bool All)
+{
+    for (uint32_t Spin = 0; Spin < Wakeup->SpinCount; ++Spin) {
+        if (WakeupTryTake(Wakeup, All)) return;
+        WakeupPause();
+    }
+
+    __atomic_add_fetch(&Wakeup->Waiters, 1, __ATOMIC_SEQ_CST);
+
+#ifdef __linux__
+    while (!WakeupTryTake(Wakeup, All)) {
+        FutexWait(&Wakeup->Count, 0);
+    }
+#else
+    pthread_mutex_lock(&Wakeup->Lock);
+    while (!WakeupTryTake(Wakeup, All)) {
+        pthread_cond_wait(&Wakeup->Condition, &Wakeup->Lock);
+    }
+    pthread_mutex_unlock(&Wakeup->Lock);
+#endif
+
+    __atomic_sub_fetch(&Wakeup->Waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+void WakeupWait(wakeup *Wakeup)
+{
+    WakeupWaitInternal(Wakeup, false);
+}
+
+void WakeupWaitAll(wakeup *Wakeup)
+{
+    WakeupWaitInternal(Wakeup, true);
+}
@@ -0,0 +1,39 @@
+#ifndef CHUNKWM_CORE_WAKEUP_H
+#define CHUNKWM_CORE_WAKEUP_H
+
+#include <stdint.h>
+
+#ifndef __linux__
+#include <pthread.h>
+#endif
+
+/*
+ * NOTE(koekeishiya): Process-private counting semaphore used to park the event-loop and
+ * the work-queue threads. 'Count' is the number of pending posts. A waiter spins for a
+ * short while before it parks, and a post only enters the kernel if a thread is parked.
+ * Spinning is disabled on a single processor, where it only delays the thread we wait for.
+ *
+ * On Linux a waiter parks on a futex on 'Count'; elsewhere on a condition variable.
+ */
+#define WAKEUP_SPIN_COUNT 128
+
+struct wakeup
+{
+    int32_t volatile Count;
+    uint32_t volatile Waiters;
+    uint32_t SpinCount;
+
+#ifndef __linux__
+    pthread_mutex_t Lock;
+    pthread_cond_t Condition;
+#endif
+};
+
+bool WakeupInit(wakeup *Wakeup);
+void WakeupDestroy(wakeup *Wakeup);
+
+void WakeupPost(wakeup *Wakeup);
+void WakeupWait(wakeup *Wakeup);
+void WakeupWaitAll(wakeup *Wakeup);
+
+#endif
@@ -0,0 +1,127 @@
+#include "watch.h"
+#include "cvar.h"
+#include "mailbox.h"
+#include "plugin.h"
+#include "clog.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <vector>
+
+#define internal static
+
+internal pthread_mutex_t CVarWatchLock;
+internal std::vector<cvar_watch> CVarWatches;
+internal cvar_changed_hook *CVarWatchHook;
+
+bool BeginCVarWatches()
+{
+    return pthread_mutex_init(&CVarWatchLock, NULL) == 0;
+}
+
+// NOTE(koekeishiya): Changes are only recorded once there is a hook, and a watch to deliver them to.
+void SetCVarWatchHook(cvar_changed_hook *Hook)
+{
+    pthread_mutex_lock(&CVarWatchLock);
+    CVarWatchHook = Hook;
+    if (!CVarWatches.empty()) SetCVarChangedHook(Hook);
+    pthread_mutex_unlock(&CVarWatchLock);
+}
+
+CHUNKWM_API_WATCH_CVAR_FUNC(WatchCVar)
+{
+    if (!Plugin || !Pattern || !Callback) {
+        return false;
+    }
+
+    cvar_watch Watch = { strdup(Plugin), strdup(Pattern), Callback };
+    pthread_mutex_lock(&CVarWatchLock);
+    CVarWatches.push_back(Watch);
+    if (CVarWatchHook) SetCVarChangedHook(CVarWatchHook);
+    pthread_mutex_unlock(&CVarWatchLock);
+    c_log(C_LOG_LEVEL_DEBUG, "Plugin '%s' watches cvar '%s'\n", Plugin, Pattern);
+    return true;
+}
+
+void RemoveCVarWatches(const char *Plugin)
+{
+    pthread_mutex_lock(&CVarWatchLock);
+    for (size_t Index = 0; Index < CVarWatches.size();) {
+        if (strcmp(CVarWatches[Index].Plugin, Plugin) == 0) {
+            free(CVarWatches[Index].Plugin);
+            free(CVarWatches[Index].Pattern);
+            CVarWatches.erase(CVarWatches.begin() + Index);
+        } else {
+            ++Index;
+        }
+    }
+    pthread_mutex_unlock(&CVarWatchLock);
+}
+
+// NOTE(koekeishiya): '*' matches any number of characters, everything else must match exactly.
+bool MatchCVarPattern(const char *Pattern, const char *Name)
+{
+    const char *Star = NULL;
+    const char *Resume = NULL;
+
+    while (*Name) {
+        if (*Pattern == '*') {
+            Star = Pattern++;
+            Resume = Name;
+        } else if (*Pattern == *Name) {
+            ++Pattern;
+            ++Name;
+        } else if (Star) {
+            Pattern = Star + 1;
+            Name = ++Resume;
+        } else {
+            return false;
+        }
+    }
+
+    while (*Pattern == '*') ++Pattern;
+    return *Pattern == '\0';
+}
+
+/*
+ * NOTE(koekeishiya): Called on the event-loop thread. The loaded plugin list stays locked while
+ * we post, so that a plugin can not be unloaded in the meantime; a plugin that has not yet been
+ * hooked is skipped, it reads the values it needs in its init function.
+ */
+void DispatchCVarWatches()
+{
+    std::vector<cvar *> Changed;
+    TakeChangedCVars(&Changed);
+
+    pthread_mutex_lock(&CVarWatchLock);
+    loaded_plugin_list *List = BeginLoadedPluginList();
+
+    for (size_t Index = 0; Index < Changed.size(); ++Index) {
+        cvar *Var = Changed[Index];
+        for (size_t WatchIndex = 0; WatchIndex < CVarWatches.size(); ++WatchIndex) {
+            cvar_watch *Watch = &CVarWatches[WatchIndex];
+            if (!MatchCVarPattern(Watch->Pattern, Var->Name)) continue;
+
+            for (loaded_plugin_list_iter It = List->begin(); It != List->end(); ++It) {
+                loaded_plugin *LoadedPlugin = It->second;
+                if (strcmp(LoadedPlugin->Info->PluginName, Watch->Plugin) != 0) continue;
+
+                cvar_watch_notification Notification = { Watch->Callback, Var };
+                plugin_payload *Payload = CreatePluginPayloadCopy(&Notification, sizeof(Notification), NULL);
+                PostPluginMailbox(LoadedPlugin->Mailbox, chunkwm_export_cvar_changed, 0, Var->Name, Payload);
+                ReleasePluginPayload(Payload);
+            }
+        }
+    }
+
+    EndLoadedPluginList();
+    pthread_mutex_unlock(&CVarWatchLock);
+}
+
+void RunCVarWatch(const char *Name, void *Data)
+{
+    cvar_watch_notification *Notification = (cvar_watch_notification *) Data;
+    Notification->Callback(Name, Notification->CVar);
+}
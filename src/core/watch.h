@@ -0,0 +1,40 @@
+#ifndef CHUNKWM_CORE_WATCH_H
+#define CHUNKWM_CORE_WATCH_H
+
+#include <stdint.h>
+
+#include "../api/plugin_api.h"
+#include "cvar.h"
+
+/*
+ * NOTE(koekeishiya): The cvars that plugins watch. Updating a cvar records it as changed, and
+ * the first change calls the hook, which posts a 'ChunkWM_CVarChanged' event. The event-loop
+ * then takes every cvar that changed in the meantime, and posts a message to the mailbox of
+ * each plugin that has a matching watch, which runs the callback of the watch, see
+ * 'RunCVarWatch'. Nothing is recorded until there is a hook and the first watch has been added.
+ */
+struct cvar_watch
+{
+    char *Plugin;
+    char *Pattern;
+    plugin_cvar_watch_func *Callback;
+};
+
+// NOTE(koekeishiya): The payload of a 'chunkwm_export_cvar_changed' message.
+struct cvar_watch_notification
+{
+    plugin_cvar_watch_func *Callback;
+    cvar *CVar;
+};
+
+bool BeginCVarWatches();
+void SetCVarWatchHook(cvar_changed_hook *Hook);
+
+CHUNKWM_API_WATCH_CVAR_FUNC(WatchCVar);
+void RemoveCVarWatches(const char *Plugin);
+
+bool MatchCVarPattern(const char *Pattern, const char *Name);
+void DispatchCVarWatches();
+void RunCVarWatch(const char *Name, void *Data);
+
+#endif
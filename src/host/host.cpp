@@ -0,0 +1,758 @@
+/*
+ * NOTE(koekeishiya): The plugin host. Loads a single plugin in its own process, for plugins
+ * that are loaded with 'chunkc core::load_hosted'. chunkwm spawns the host and talks to it
+ * through the rings in shared memory that are described in core/host.h.
+ *
+ * Windows and applications are rebuilt from the snapshots that chunkwm sends, like the
+ * replay driver does. Their 'Ref' is NULL, so a hosted plugin can not use the accessibility
+ * API through them. Cvars are a copy taken when the plugin is initialized.
+ *
+ *   chunkwm-host <shared memory> <plugin.so>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../api/plugin_api.h"
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+
+#include "../core/host.h"
+#include "../core/trace.h"
+#include "../core/shmring.cpp"
+#include "../core/trace.cpp"
+
+#define internal static
+
+#define HOST_REPLY_SIZE 1024
+
+struct host_topic
+{
+    std::string Name;
+    std::string Plugin;
+    std::string Event;
+};
+
+internal shared_ring Events;
+internal shared_ring Commands;
+internal pthread_mutex_t CommandLock;
+
+internal plugin_details *Info;
+internal plugin *Plugin;
+internal bool Initialized;
+
+internal std::map<std::string, std::string> CVars;
+internal std::map<std::string, cvar *> CVarHandles;
+internal pthread_mutex_t CVarLock;
+
+internal std::vector<host_topic> Topics;
+internal pthread_mutex_t TopicLock;
+
+internal std::map<pid_t, macos_application *> Applications;
+internal std::map<uint32_t, macos_window *> Windows;
+
+// NOTE(koekeishiya): Plugins may call the api from their own threads, the ring has a single producer.
+internal void
+SendCommand(host_message Type, trace_buffer *Buffer)
+{
+    if (Buffer && Buffer->Overflow) {
+        fprintf(stderr, "chunkwm-host: message %d is too large, dropped!\n", Type);
+        return;
+    }
+
+    pthread_mutex_lock(&CommandLock);
+    SharedRingWrite(&Commands, Type, Buffer ? Buffer->Data : NULL, Buffer ? Buffer->Size : 0);
+    pthread_mutex_unlock(&CommandLock);
+}
+
+internal
+CHUNKWM_API_UPDATE_CVAR_FUNC(HostUpdateCVar)
+{
+    pthread_mutex_lock(&CVarLock);
+    CVars[Name] = Value;
+    pthread_mutex_unlock(&CVarLock);
+
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteString(&Buffer, Name);
+    TraceWriteString(&Buffer, Value);
+    SendCommand(host_message_update_cvar, &Buffer);
+}
+
+// NOTE(koekeishiya): Same as chunkwm, the value stays valid until the cvar is updated.
+internal
+CHUNKWM_API_ACQUIRE_CVAR_FUNC(HostAcquireCVar)
+{
+    pthread_mutex_lock(&CVarLock);
+    std::map<std::string, std::string>::iterator It = CVars.find(Name);
+    char *Result = It != CVars.end() ? (char *) It->second.c_str() : NULL;
+    pthread_mutex_unlock(&CVarLock);
+    return Result;
+}
+
+internal
+CHUNKWM_API_FIND_CVAR_FUNC(HostFindCVar)
+{
+    pthread_mutex_lock(&CVarLock);
+    bool Result = CVars.find(Name) != CVars.end();
+    pthread_mutex_unlock(&CVarLock);
+    return Result;
+}
+
+// NOTE(koekeishiya): Cvars in the host are only updated by the plugin itself, a read does not have to keep them alive.
+internal
+CHUNKWM_API_BEGIN_CVAR_READ_FUNC(HostBeginCVarRead)
+{
+    return 0;
+}
+
+internal
+CHUNKWM_API_END_CVAR_READ_FUNC(HostEndCVarRead)
+{
+}
+
+internal
+CHUNKWM_API_CVAR_INTEGER_FUNC(HostCVarInteger)
+{
+    int Result = 0;
+    char *Value = HostAcquireCVar(Name);
+    if (Value) sscanf(Value, "%d", &Result);
+    return Result;
+}
+
+internal
+CHUNKWM_API_CVAR_UNSIGNED_FUNC(HostCVarUnsigned)
+{
+    unsigned Result = 0;
+    char *Value = HostAcquireCVar(Name);
+    if (Value) sscanf(Value, "%x", &Result);
+    return Result;
+}
+
+internal
+CHUNKWM_API_CVAR_FLOATING_POINT_FUNC(HostCVarFloatingPoint)
+{
+    float Result = 0.0f;
+    char *Value = HostAcquireCVar(Name);
+    if (Value) sscanf(Value, "%f", &Result);
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): A handle in the host only carries the name of the cvar, and is passed to the
+ * functions above. Handles are kept until the host exits, the same as in chunkwm.
+ */
+internal
+CHUNKWM_API_RESOLVE_CVAR_FUNC(HostResolveCVar)
+{
+    cvar *Result = NULL;
+
+    pthread_mutex_lock(&CVarLock);
+    if (CVars.find(Name) != CVars.end()) {
+        std::map<std::string, cvar *>::iterator It = CVarHandles.find(Name);
+        if (It != CVarHandles.end()) {
+            Result = It->second;
+        } else {
+            Result = (cvar *) calloc(1, sizeof(cvar));
+            Result->Name = strdup(Name);
+            CVarHandles[Name] = Result;
+        }
+    }
+    pthread_mutex_unlock(&CVarLock);
+
+    return Result;
+}
+
+internal
+CHUNKWM_API_UPDATE_CVAR_HANDLE_FUNC(HostUpdateCVarHandle)
+{
+    if (CVar) HostUpdateCVar(CVar->Name, Value);
+}
+
+internal
+CHUNKWM_API_ACQUIRE_CVAR_HANDLE_FUNC(HostAcquireCVarHandle)
+{
+    return CVar ? HostAcquireCVar(CVar->Name) : NULL;
+}
+
+internal
+CHUNKWM_API_CVAR_HANDLE_INTEGER_FUNC(HostCVarHandleInteger)
+{
+    return CVar ? HostCVarInteger(CVar->Name) : 0;
+}
+
+internal
+CHUNKWM_API_CVAR_HANDLE_UNSIGNED_FUNC(HostCVarHandleUnsigned)
+{
+    return CVar ? HostCVarUnsigned(CVar->Name) : 0;
+}
+
+internal
+CHUNKWM_API_CVAR_HANDLE_FLOATING_POINT_FUNC(HostCVarHandleFloatingPoint)
+{
+    return CVar ? HostCVarFloatingPoint(CVar->Name) : 0.0f;
+}
+
+internal
+CHUNKWM_API_LOG_FUNC(HostLog)
+{
+    char Message[TRACE_MAX_STRING + 1];
+
+    va_list Args;
+    va_start(Args, Format);
+    vsnprintf(Message, sizeof(Message), Format, Args);
+    va_end(Args);
+
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteU32(&Buffer, Level);
+    TraceWriteString(&Buffer, Message);
+    SendCommand(host_message_log, &Buffer);
+}
+
+internal void
+SendBroadcast(const char *PluginName, const char *EventName, void *Data, size_t Size)
+{
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteString(&Buffer, PluginName);
+    TraceWriteString(&Buffer, EventName);
+    TraceWriteU32(&Buffer, Size);
+    TraceWriteBytes(&Buffer, Data, Size);
+    SendCommand(host_message_broadcast, &Buffer);
+}
+
+internal
+CHUNKWM_API_BROADCAST_FUNC(HostBroadcast)
+{
+    if (Plugin && Event) {
+        SendBroadcast(Plugin, Event, Data, Size);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Topic ids are local to the host. A topic that is first seen as the node
+ * of a broadcast does not know its plugin and event yet, they are filled in when it is interned.
+ */
+internal uint32_t
+FindTopic(const char *Name, const char *PluginName, const char *EventName)
+{
+    pthread_mutex_lock(&TopicLock);
+
+    uint32_t Result = 0;
+    for (size_t Index = 0; Index < Topics.size(); ++Index) {
+        if (Topics[Index].Name == Name) {
+            Result = Index + 1;
+            break;
+        }
+    }
+
+    if (!Result) {
+        host_topic Topic;
+        Topic.Name = Name;
+        Topics.push_back(Topic);
+        Result = Topics.size();
+    }
+
+    if (PluginName && EventName) {
+        Topics[Result - 1].Plugin = PluginName;
+        Topics[Result - 1].Event = EventName;
+    }
+
+    pthread_mutex_unlock(&TopicLock);
+    return Result;
+}
+
+internal
+CHUNKWM_API_INTERN_TOPIC_FUNC(HostInternTopic)
+{
+    std::string Name = std::string(Plugin) + "_" + Event;
+    return FindTopic(Name.c_str(), Plugin, Event);
+}
+
+internal
+CHUNKWM_API_BROADCAST_TOPIC_FUNC(HostBroadcastTopic)
+{
+    pthread_mutex_lock(&TopicLock);
+    bool Valid = Topic && Topic <= Topics.size() && !Topics[Topic - 1].Plugin.empty();
+    std::string PluginName = Valid ? Topics[Topic - 1].Plugin : "";
+    std::string EventName = Valid ? Topics[Topic - 1].Event : "";
+    pthread_mutex_unlock(&TopicLock);
+
+    if (Valid) {
+        SendBroadcast(PluginName.c_str(), EventName.c_str(), Data, Size);
+    }
+}
+
+internal
+CHUNKWM_API_SUBSCRIBE_TOPIC_FUNC(HostSubscribeTopic)
+{
+    if (!Subscriber || !Plugin || !Event) {
+        return 0;
+    }
+
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteString(&Buffer, Subscriber);
+    TraceWriteString(&Buffer, Plugin);
+    TraceWriteString(&Buffer, Event);
+    SendCommand(host_message_subscribe, &Buffer);
+
+    return HostInternTopic(Plugin, Event);
+}
+
+// NOTE(koekeishiya): Methods are called in the process of the caller, so a hosted plugin can neither register nor call them.
+internal
+CHUNKWM_API_REGISTER_METHOD_FUNC(HostRegisterMethod)
+{
+    HostLog(C_LOG_LEVEL_WARN, "chunkwm-host: plugin '%s' cannot register method '%s' in a plugin host!\n", Plugin, Method);
+    return false;
+}
+
+internal
+CHUNKWM_API_CALL_METHOD_FUNC(HostCallMethod)
+{
+    return chunkwm_call_not_found;
+}
+
+// NOTE(koekeishiya): Cvars are only sent to the host when the plugin is initialized, so there is nothing to watch.
+internal
+CHUNKWM_API_WATCH_CVAR_FUNC(HostWatchCVar)
+{
+    HostLog(C_LOG_LEVEL_WARN, "chunkwm-host: plugin '%s' cannot watch cvar '%s' in a plugin host!\n", Plugin, Pattern);
+    return false;
+}
+
+internal chunkwm_api API =
+{
+    HostUpdateCVar,
+    HostAcquireCVar,
+    HostFindCVar,
+    HostBroadcast,
+    HostLog,
+    HostInternTopic,
+    HostBroadcastTopic,
+    HostSubscribeTopic,
+    HostRegisterMethod,
+    HostCallMethod,
+    HostCVarInteger,
+    HostCVarUnsigned,
+    HostCVarFloatingPoint,
+    HostBeginCVarRead,
+    HostEndCVarRead,
+    HostResolveCVar,
+    HostUpdateCVarHandle,
+    HostAcquireCVarHandle,
+    HostCVarHandleInteger,
+    HostCVarHandleUnsigned,
+    HostCVarHandleFloatingPoint,
+    HostWatchCVar
+};
+
+// NOTE(koekeishiya): Takes ownership of 'Role'. An empty role was NULL in chunkwm.
+internal CFStringRef
+CreateHostRole(char *Role)
+{
+    if (!Role || !*Role) {
+        free(Role);
+        return NULL;
+    }
+
+#ifdef __APPLE__
+    CFStringRef Result = CFStringCreateWithCString(NULL, Role, kCFStringEncodingUTF8);
+    free(Role);
+    return Result;
+#else
+    return Role;
+#endif
+}
+
+internal void
+DestroyHostRole(CFStringRef Role)
+{
+    if (!Role) return;
+#ifdef __APPLE__
+    CFRelease(Role);
+#else
+    free((char *) Role);
+#endif
+}
+
+internal macos_application *
+ApplicationFromSnapshot(int32_t PID, char *Name)
+{
+    macos_application *Application = Applications[PID];
+    if (!Application) {
+        Application = (macos_application *) calloc(1, sizeof(macos_application));
+        Application->PID = PID;
+        Applications[PID] = Application;
+    }
+
+    if (Name && (!Application->Name || strcmp(Application->Name, Name) != 0)) {
+        free(Application->Name);
+        Application->Name = Name;
+    } else {
+        free(Name);
+    }
+
+    return Application;
+}
+
+internal macos_window *
+WindowFromSnapshot(trace_window *Snapshot)
+{
+    macos_window *Window = Windows[Snapshot->Id];
+    if (!Window) {
+        Window = (macos_window *) calloc(1, sizeof(macos_window));
+        Window->Id = Snapshot->Id;
+        Windows[Snapshot->Id] = Window;
+    }
+
+    Window->Owner = ApplicationFromSnapshot(Snapshot->PID, Snapshot->Owner);
+    Window->Flags = Snapshot->Flags;
+    Window->Level = Snapshot->Level;
+    Window->Position.x = Snapshot->X;
+    Window->Position.y = Snapshot->Y;
+    Window->Size.width = Snapshot->Width;
+    Window->Size.height = Snapshot->Height;
+
+    // NOTE(koekeishiya): The window takes ownership of the strings in the snapshot.
+    free(Window->Name);
+    Window->Name = Snapshot->Name;
+    DestroyHostRole(Window->Mainrole);
+    DestroyHostRole(Window->Subrole);
+    Window->Mainrole = CreateHostRole(Snapshot->Role);
+    Window->Subrole = CreateHostRole(Snapshot->Subrole);
+
+    return Window;
+}
+
+internal void
+DestroyWindow(macos_window *Window)
+{
+    Windows.erase(Window->Id);
+    free(Window->Name);
+    DestroyHostRole(Window->Mainrole);
+    DestroyHostRole(Window->Subrole);
+    free(Window);
+}
+
+internal void
+DestroyApplication(macos_application *Application)
+{
+    for (std::map<uint32_t, macos_window *>::iterator It = Windows.begin(); It != Windows.end();) {
+        macos_window *Window = It->second;
+        ++It;
+
+        if (Window->Owner == Application) {
+            DestroyWindow(Window);
+        }
+    }
+
+    Applications.erase(Application->PID);
+    free(Application->Name);
+    free(Application);
+}
+
+internal void
+SendReply(uint32_t Command, bool Last, const char *Text)
+{
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteU32(&Buffer, Command);
+    TraceWriteU32(&Buffer, Last);
+    TraceWriteString(&Buffer, Text);
+    SendCommand(host_message_reply, &Buffer);
+}
+
+struct host_command
+{
+    uint32_t Command;
+    int SockFD;
+};
+
+// NOTE(koekeishiya): Forwards what the plugin writes to the socket while it runs, so that it never blocks.
+internal void *
+CommandReplyThreadProc(void *Context)
+{
+    host_command *Command = (host_command *) Context;
+    char Text[HOST_REPLY_SIZE + 1];
+
+    ssize_t Bytes;
+    while ((Bytes = read(Command->SockFD, Text, HOST_REPLY_SIZE)) > 0) {
+        Text[Bytes] = '\0';
+        SendReply(Command->Command, false, Text);
+    }
+
+    return NULL;
+}
+
+/*
+ * NOTE(koekeishiya): The plugin writes its output to a socket, as it would in chunkwm. The
+ * other end is read until the plugin is done, and the output is sent to chunkwm in pieces.
+ */
+internal void
+RunDaemonCommand(chunkwm_plugin_export Export, trace_buffer *Buffer)
+{
+    uint32_t Command;
+    char *Name, *Message;
+    if (!TraceReadU32(Buffer, &Command) ||
+        !TraceReadString(Buffer, &Name)) {
+        return;
+    }
+
+    if (!TraceReadString(Buffer, &Message)) {
+        free(Name);
+        return;
+    }
+
+    int Pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, Pair) == 0) {
+        host_command Reply = { Command, Pair[1] };
+        pthread_t Thread;
+        bool Forwarding = pthread_create(&Thread, NULL, &CommandReplyThreadProc, &Reply) == 0;
+
+        chunkwm_payload Payload = { Pair[0], Name, Message };
+        Plugin->Run(Export, 0, chunkwm_plugin_export_str[Export], &Payload);
+
+        shutdown(Pair[0], SHUT_RDWR);
+        if (Forwarding) pthread_join(Thread, NULL);
+        close(Pair[0]);
+        close(Pair[1]);
+    }
+
+    SendReply(Command, true, "");
+    free(Name);
+    free(Message);
+}
+
+internal void
+RunEvent(trace_buffer *Buffer)
+{
+    uint32_t Export, Topic;
+    if (!TraceReadU32(Buffer, &Export) ||
+        !TraceReadU32(Buffer, &Topic) ||
+        Export >= chunkwm_export_message_count) {
+        return;
+    }
+
+    chunkwm_plugin_export PluginExport = (chunkwm_plugin_export) Export;
+    const char *Node = chunkwm_plugin_export_str[Export];
+
+    switch (HostPayloadForExport(PluginExport)) {
+    case host_payload_window: {
+        trace_window Snapshot;
+        if (!TraceReadWindow(Buffer, &Snapshot)) break;
+
+        macos_window *Window = WindowFromSnapshot(&Snapshot);
+        Plugin->Run(PluginExport, 0, Node, Window);
+        if (PluginExport == chunkwm_export_window_destroyed) {
+            DestroyWindow(Window);
+        }
+    } break;
+    case host_payload_application: {
+        trace_application Snapshot;
+        if (!TraceReadApplication(Buffer, &Snapshot)) break;
+
+        macos_application *Application = ApplicationFromSnapshot(Snapshot.PID, Snapshot.Name);
+        Plugin->Run(PluginExport, 0, Node, Application);
+        if (PluginExport == chunkwm_export_application_terminated) {
+            DestroyApplication(Application);
+        }
+    } break;
+    case host_payload_display: {
+        uint32_t DisplayId;
+        if (TraceReadU32(Buffer, &DisplayId)) {
+            Plugin->Run(PluginExport, 0, Node, &DisplayId);
+        }
+    } break;
+    case host_payload_broadcast: {
+        char *Name;
+        uint32_t Size;
+        if (!TraceReadString(Buffer, &Name)) break;
+
+        // NOTE(koekeishiya): Copied, so that the plugin sees the data aligned as it would in chunkwm.
+        if (TraceReadU32(Buffer, &Size) && Size <= Buffer->Size - Buffer->Cursor) {
+            void *Data = Size ? malloc(Size) : NULL;
+            TraceReadBytes(Buffer, Data, Size);
+            Plugin->Run(PluginExport, FindTopic(Name, NULL, NULL), Name, Data);
+            free(Data);
+        }
+        free(Name);
+    } break;
+    case host_payload_command: {
+        RunDaemonCommand(PluginExport, Buffer);
+    } break;
+    case host_payload_none: {
+        Plugin->Run(PluginExport, Topic, Node, NULL);
+    } break;
+    }
+}
+
+// NOTE(koekeishiya): Returns false once chunkwm asks the host to exit.
+internal bool
+HandleEvent(uint32_t Type, trace_buffer *Buffer)
+{
+    switch (Type) {
+    case host_message_cvar: {
+        char *Name, *Value;
+        if (TraceReadString(Buffer, &Name)) {
+            if (TraceReadString(Buffer, &Value)) {
+                pthread_mutex_lock(&CVarLock);
+                CVars[Name] = Value;
+                pthread_mutex_unlock(&CVarLock);
+                free(Value);
+            }
+            free(Name);
+        }
+    } break;
+    case host_message_init: {
+        Initialized = Plugin && Plugin->Init(API);
+
+        trace_buffer Result;
+        TraceBufferReset(&Result);
+        TraceWriteU32(&Result, Initialized);
+        SendCommand(host_message_init_result, &Result);
+    } break;
+    case host_message_event: {
+        if (Initialized) RunEvent(Buffer);
+    } break;
+    case host_message_deinit: {
+        return false;
+    } break;
+    }
+
+    return true;
+}
+
+internal void
+SendHello(const char **LoadAfter)
+{
+    trace_buffer Buffer;
+    TraceBufferReset(&Buffer);
+    TraceWriteU32(&Buffer, Info->ApiVersion);
+    TraceWriteString(&Buffer, Info->PluginName);
+    TraceWriteString(&Buffer, Info->PluginVersion);
+
+    // NOTE(koekeishiya): A plugin with an unsupported api is only reported, chunkwm rejects it.
+    TraceWriteU32(&Buffer, Plugin ? Plugin->SubscriptionCount : 0);
+    for (unsigned Index = 0; Plugin && Index < Plugin->SubscriptionCount; ++Index) {
+        TraceWriteU32(&Buffer, Plugin->Subscriptions[Index]);
+    }
+
+    TraceWriteU32(&Buffer, Plugin ? Plugin->FilterCount : 0);
+    for (unsigned Index = 0; Plugin && Index < Plugin->FilterCount; ++Index) {
+        chunkwm_filter *Filter = Plugin->Filters + Index;
+        TraceWriteU32(&Buffer, Filter->Export);
+        TraceWriteU32(&Buffer, Filter->Type);
+        TraceWriteString(&Buffer, Filter->String);
+        TraceWriteU32(&Buffer, Filter->Integer);
+    }
+
+    uint32_t Count = 0;
+    for (const char **Name = LoadAfter; Name && *Name; ++Name) ++Count;
+    TraceWriteU32(&Buffer, Count);
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        TraceWriteString(&Buffer, LoadAfter[Index]);
+    }
+
+    SendCommand(host_message_hello, &Buffer);
+}
+
+internal void *
+MapSharedMemory(const char *Name, size_t Size)
+{
+    int Descriptor = shm_open(Name, O_RDWR, 0600);
+    if (Descriptor == -1) {
+        return NULL;
+    }
+
+    struct stat Buffer;
+    void *Result = NULL;
+    if ((fstat(Descriptor, &Buffer) == 0) && ((size_t) Buffer.st_size >= Size)) {
+        Result = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Descriptor, 0);
+        if (Result == MAP_FAILED) Result = NULL;
+    }
+
+    close(Descriptor);
+    return Result;
+}
+
+int main(int Count, char **Args)
+{
+    if (Count != 3) {
+        fprintf(stderr, "usage: chunkwm-host <shared memory> <plugin.so>\n"
+                        "the plugin host is started by chunkwm, see 'chunkc core::load_hosted'\n");
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    pthread_mutex_init(&CommandLock, NULL);
+    pthread_mutex_init(&CVarLock, NULL);
+    pthread_mutex_init(&TopicLock, NULL);
+
+    size_t EventSize = SharedRingMemorySize(PLUGIN_HOST_EVENT_RING_SIZE);
+    size_t MemorySize = EventSize + SharedRingMemorySize(PLUGIN_HOST_COMMAND_RING_SIZE);
+    uint8_t *Memory = (uint8_t *) MapSharedMemory(Args[1], MemorySize);
+    if (!Memory ||
+        !SharedRingAttach(&Events, Memory, PLUGIN_HOST_EVENT_FD, -1) ||
+        !SharedRingAttach(&Commands, Memory + EventSize, -1, PLUGIN_HOST_COMMAND_FD)) {
+        fprintf(stderr, "chunkwm-host: could not attach to shared memory '%s'!\n", Args[1]);
+        return EXIT_FAILURE;
+    }
+
+    void *Handle = dlopen(Args[2], RTLD_LAZY);
+    if (!Handle) {
+        fprintf(stderr, "chunkwm-host: dlopen '%s' failed: %s\n", Args[2], dlerror());
+        return EXIT_FAILURE;
+    }
+
+    Info = (plugin_details *) dlsym(Handle, "Exports");
+    if (!Info) {
+        fprintf(stderr, "chunkwm-host: dlsym '%s' plugin details missing!\n", Args[2]);
+        return EXIT_FAILURE;
+    }
+
+    // NOTE(koekeishiya): Plugins built against the legacy api are not supported by the host.
+    if (Info->ApiVersion == CHUNKWM_PLUGIN_API_VERSION) {
+        Plugin = Info->Initialize();
+    }
+
+    SendHello((const char **) dlsym(Handle, "LoadAfter"));
+
+    trace_buffer Buffer;
+    bool Running = true;
+    while (Running) {
+        uint32_t Type;
+        while (Running && SharedRingRead(&Events, &Type, Buffer.Data, &Buffer.Size, TRACE_MAX_PAYLOAD)) {
+            Buffer.Cursor = 0;
+            Buffer.Overflow = false;
+            Running = HandleEvent(Type, &Buffer);
+        }
+
+        // NOTE(koekeishiya): The event pipe reaches end-of-file when chunkwm exits.
+        if (Running && !SharedRingWait(&Events, -1)) {
+            Running = false;
+        }
+    }
+
+    if (Initialized) {
+        Plugin->DeInit();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -176,14 +176,18 @@ void *BarMainThreadProcedure(void*)
 
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if (strcmp(Node, "chunkwm_export_application_activated") == 0) {
+    switch (Export) {
+    case chunkwm_export_application_activated: {
         macos_application *application = (macos_application *) Data;
         text = strdup(application->Name);
         return true;
-    } else if (strcmp(Node, "chunkwm_export_window_focused") == 0) {
+    } break;
+    case chunkwm_export_window_focused: {
         macos_window *window = (macos_window *) Data;
         text = strdup(window->Name);
         return true;
+    } break;
+    default: break;
     }
     return false;
 }
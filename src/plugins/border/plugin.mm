@@ -21,11 +21,15 @@
 
 #define internal static
 
+internal const char *PluginName = "Border";
+internal const char *PluginVersion = "0.3.0";
+
 internal macos_application *Application;
 internal border_window *Border;
 internal bool SkipFloating;
 internal bool DrawBorder;
 internal chunkwm_api API;
+internal uint32_t TilingFocusedWindowFloatTopic;
 
 internal AXUIElementRef
 GetFocusedWindow()
@@ -322,46 +326,28 @@ TilingFocusedWindowFloatStatus(void *Data)
 
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if ((StringEquals(Node, "chunkwm_export_application_launched")) ||
-        (StringEquals(Node, "chunkwm_export_window_created")) ||
-        (StringEquals(Node, "chunkwm_export_application_unhidden")) ||
-        (StringEquals(Node, "chunkwm_export_window_deminimized"))) {
-        NewWindowHandler(NULL);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_activated")) {
-        ApplicationActivatedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_deactivated")) {
-        ApplicationDeactivatedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_destroyed")) {
-        WindowDestroyedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_focused")) {
-        WindowFocusedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_moved")) {
-        WindowMovedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_resized")) {
-        WindowResizedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_minimized")) {
-        WindowMinimizedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_space_changed")) {
-        SpaceChangedHandler();
-        return true;
-    } else if (StringEquals(Node, "chunkwm_daemon_command")) {
-        CommandHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_events_subscribed")) {
-        UpdateToFocusedWindow();
-        return true;
-    } else if ((StringEquals(Node, "Tiling_focused_window_float")) && (SkipFloating)) {
-        TilingFocusedWindowFloatStatus(Data);
-        return true;
-    }
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_application_launched)
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_window_created)
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_application_unhidden)
+    CHUNKWM_DISPATCH(chunkwm_export_window_deminimized, NewWindowHandler(NULL))
+    CHUNKWM_DISPATCH(chunkwm_export_application_activated, ApplicationActivatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_deactivated, ApplicationDeactivatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_destroyed, WindowDestroyedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_focused, WindowFocusedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_moved, WindowMovedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_resized, WindowResizedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_minimized, WindowMinimizedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_space_changed, SpaceChangedHandler())
+    CHUNKWM_DISPATCH(chunkwm_export_daemon_command, CommandHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_events_subscribed, UpdateToFocusedWindow())
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_plugin_broadcast) {
+        if ((Topic == TilingFocusedWindowFloatTopic) && (SkipFloating)) {
+            TilingFocusedWindowFloatStatus(Data);
+            return true;
+        }
+    } break;
+    CHUNKWM_DISPATCH_END()
 
     return false;
 }
@@ -369,6 +355,7 @@ PLUGIN_MAIN_FUNC(PluginMain)
 PLUGIN_BOOL_FUNC(PluginInit)
 {
     API = ChunkwmAPI;
+    TilingFocusedWindowFloatTopic = API.SubscribeTopic(PluginName, "Tiling", "focused_window_float");
     BeginCVars(&API);
 
     CreateCVar("focused_border_color", 0xffd5c4a1);
@@ -408,4 +395,4 @@ chunkwm_plugin_export Subscriptions[] =
     chunkwm_export_space_changed
 };
 CHUNKWM_PLUGIN_SUBSCRIBE(Subscriptions)
-CHUNKWM_PLUGIN("Border", "0.3.0")
+CHUNKWM_PLUGIN(PluginName, PluginVersion)
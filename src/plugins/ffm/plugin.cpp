@@ -24,12 +24,16 @@ extern "C" CGError CGSGetWindowLevel(const int cid, int wid, int *wlvl);
 extern "C" OSStatus CGSFindWindowByGeometry(int cid, int zero, int one, int zero_again, CGPoint *screen_point, CGPoint *window_coords_out, int *wid_out, int *cid_out);
 extern "C" CGError CGSConnectionGetPID(const int cid, pid_t *pid);
 
+internal const char *PluginName = "Focus Follows Mouse";
+internal const char *PluginVersion = "0.3.0";
+
 internal event_tap EventTap;
 internal uint32_t MouseModifier;
 internal bool volatile IsActive;
 internal uint32_t volatile FocusedWindowId;
 internal chunkwm_api API;
 internal AXUIElementRef SystemWideElement;
+internal uint32_t TilingWindowFloatTopic;
 
 internal bool
 IsWindowLevelAllowed(int WindowLevel)
@@ -165,22 +169,24 @@ SetMouseModifier(const char *Mod)
 
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if (strcmp(Node, "chunkwm_export_application_activated") == 0) {
-        ApplicationActivatedHandler(Data);
-        return true;
-    } else if (strcmp(Node, "chunkwm_export_window_focused") == 0) {
-        WindowFocusedHandler(Data);
-        return true;
-    } else if (strcmp(Node, "Tiling_focused_window_float") == 0) {
-        TilingWindowFloatHandler(Data);
-        return true;
-    }
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_application_activated, ApplicationActivatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_focused, WindowFocusedHandler(Data))
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_plugin_broadcast) {
+        if (Topic == TilingWindowFloatTopic) {
+            TilingWindowFloatHandler(Data);
+            return true;
+        }
+    } break;
+    CHUNKWM_DISPATCH_END()
+
     return false;
 }
 
 PLUGIN_BOOL_FUNC(PluginInit)
 {
     API = ChunkwmAPI;
+    TilingWindowFloatTopic = API.SubscribeTopic(PluginName, "Tiling", "focused_window_float");
     SystemWideElement = AXUIElementCreateSystemWide();
     if (!SystemWideElement) return false;
 
@@ -189,7 +195,9 @@ PLUGIN_BOOL_FUNC(PluginInit)
     bool Result = BeginEventTap(&EventTap, &EventTapCallback);
     BeginCVars(&API);
     CreateCVar("mouse_modifier", "fn");
-    SetMouseModifier(CVarStringValue("mouse_modifier"));
+    char Modifier[CVAR_STRING_SIZE];
+    CVarStringValue("mouse_modifier", Modifier, sizeof(Modifier));
+    SetMouseModifier(Modifier);
     return Result;
 }
 
@@ -205,5 +213,11 @@ chunkwm_plugin_export Subscriptions[] =
     chunkwm_export_application_activated,
     chunkwm_export_window_focused
 };
+
+/*
+ * NOTE(koekeishiya): 'FocusedWindowId' is also written when an application is activated, so
+ * a focus event for the window of the last focus event is not necessarily one we already
+ * know about. Focus events are therefore not filtered on 'chunkwm_filter_changed'.
+ */
 CHUNKWM_PLUGIN_SUBSCRIBE(Subscriptions)
-CHUNKWM_PLUGIN("Focus Follows Mouse", "0.3.0")
+CHUNKWM_PLUGIN(PluginName, PluginVersion)
@@ -36,40 +36,45 @@ ExtendedDockDisableWindowShadow(uint32_t WindowId)
     }
     CloseSocket(SockFD);
 }
-inline bool
-StringsAreEqual(const char *A, const char *B)
+
+internal void
+ApplicationLaunchedHandler(void *Data)
+{
+    macos_application *Application = (macos_application *) Data;
+    macos_window **WindowList = AXLibWindowListForApplication(Application);
+    if (WindowList) {
+        macos_window **List = WindowList;
+        macos_window *Window;
+        while ((Window = *List++)) {
+            ExtendedDockDisableWindowShadow(Window->Id);
+            AXLibDestroyWindow(Window);
+        }
+
+        free(WindowList);
+    }
+}
+
+internal void
+WindowCreatedHandler(void *Data)
 {
-    bool Result = (strcmp(A, B) == 0);
-    return Result;
+    macos_window *Window = (macos_window *) Data;
+    ExtendedDockDisableWindowShadow(Window->Id);
 }
 
 /*
  * NOTE(koekeishiya):
+ * parameter: chunkwm_plugin_export Export
+ * parameter: uint32_t Topic
  * parameter: const char *Node
  * parameter: void *Data
  * return: bool
  */
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if (StringsAreEqual(Node, "chunkwm_export_application_launched")) {
-        macos_application *Application = (macos_application *) Data;
-        macos_window **WindowList = AXLibWindowListForApplication(Application);
-        if (WindowList) {
-            macos_window **List = WindowList;
-            macos_window *Window;
-            while ((Window = *List++)) {
-                ExtendedDockDisableWindowShadow(Window->Id);
-                AXLibDestroyWindow(Window);
-            }
-
-            free(WindowList);
-        }
-        return true;
-    } else if (StringsAreEqual(Node, "chunkwm_export_window_created")) {
-        macos_window *Window = (macos_window *) Data;
-        ExtendedDockDisableWindowShadow(Window->Id);
-        return true;
-    }
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_application_launched, ApplicationLaunchedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_created, WindowCreatedHandler(Data))
+    CHUNKWM_DISPATCH_END()
 
     return false;
 }
@@ -10,28 +10,32 @@ internal const char *PluginName = "template";
 internal const char *PluginVersion = "0.1.0";
 internal chunkwm_api API;
 
-inline bool
-StringsAreEqual(const char *A, const char *B)
+internal void
+ApplicationLaunchedHandler(void *Data)
 {
-    bool Result = (strcmp(A, B) == 0);
-    return Result;
+    macos_application *Application = (macos_application *) Data;
+}
+
+internal void
+ApplicationTerminatedHandler(void *Data)
+{
+    macos_application *Application = (macos_application *) Data;
 }
 
 /*
  * NOTE(koekeishiya):
+ * parameter: chunkwm_plugin_export Export
+ * parameter: uint32_t Topic
  * parameter: const char *Node
  * parameter: void *Data
  * return: bool
  */
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if (StringsAreEqual(Node, "chunkwm_export_application_launched")) {
-        macos_application *Application = (macos_application *) Data;
-        return true;
-    } else if (StringsAreEqual(Node, "chunkwm_export_application_terminated")) {
-        macos_application *Application = (macos_application *) Data;
-        return true;
-    }
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_application_launched, ApplicationLaunchedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_terminated, ApplicationTerminatedHandler(Data))
+    CHUNKWM_DISPATCH_END()
 
     return false;
 }
@@ -473,6 +473,7 @@ query_func QueryCommandDispatch(char Flag)
     case 'm': return QueryMonitor;            break;
     case 'D': return QueryDesktopsForMonitor; break;
     case 'M': return QueryMonitorForDesktop;  break;
+    case 'C': return QueryDesktopConfig;      break;
 
     // NOTE(koekeishiya): silence compiler warning.
     default: return 0; break;
@@ -486,7 +487,7 @@ ParseQueryCommand(const char *Message, command *Chain)
 
     int Option;
     bool Success = true;
-    const char *Short = "w:d:m:D:M:";
+    const char *Short = "w:d:m:D:M:C:";
 
     struct option Long[] = {
         { "window", required_argument, NULL, 'w' },
@@ -494,6 +495,7 @@ ParseQueryCommand(const char *Message, command *Chain)
         { "monitor", required_argument, NULL, 'm' },
         { "desktops-for-monitor", required_argument, NULL, 'D' },
         { "monitor-for-desktop", required_argument, NULL, 'M' },
+        { "desktop-config", required_argument, NULL, 'C' },
         { NULL, 0, NULL, 0 }
     };
 
@@ -558,6 +560,20 @@ ParseQueryCommand(const char *Message, command *Chain)
                 goto End;
             }
         } break;
+        case 'C': {
+            int Integer;
+            if ((StringEquals(optarg, "all")) ||
+                (sscanf(optarg, "%d", &Integer) == 1)) {
+                command *Entry = ConstructCommand(Option, optarg);
+                Command->Next = Entry;
+                Command = Entry;
+            } else {
+                c_log(C_LOG_LEVEL_WARN, "    invalid selector '%s' for flag '%c'\n", optarg, Option);
+                Success = false;
+                FreeCommandChain(Chain);
+                goto End;
+            }
+        } break;
         case '?': {
             Success = false;
             FreeCommandChain(Chain);
@@ -676,15 +692,15 @@ void CommandCallback(int SockFD, const char *Type, const char *Message)
         command Chain = {};
         bool Success = ParseWindowCommand(Message, &Chain);
         if (Success) {
-            float Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+            float Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
             command *Command = &Chain;
             while ((Command = Command->Next)) {
                 c_log(C_LOG_LEVEL_DEBUG, "    command: '%c', arg: '%s'\n", Command->Flag, Command->Arg);
                 (*WindowCommandDispatch(Command->Flag))(Command->Arg);
             }
 
-            if (Ratio != CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO)) {
-                UpdateCVar(CVAR_BSP_SPLIT_RATIO, Ratio);
+            if (Ratio != CVarFloatingPointValue(TilingCVars.BspSplitRatio)) {
+                UpdateCVar(TilingCVars.BspSplitRatio, Ratio);
             }
 
             FreeCommandChain(&Chain);
@@ -72,4 +72,51 @@
 
 /*   ---------------------------------------------------------   */
 
+/*
+ * NOTE(koekeishiya): Handles of the cvars that are read while tiling windows and handling
+ * events. They are resolved once in 'PluginInit', after the cvars have been created.
+ */
+struct cvar;
+struct tiling_cvars
+{
+    cvar *SpaceMode;
+    cvar *SpaceOffsetTop;
+    cvar *SpaceOffsetBottom;
+    cvar *SpaceOffsetLeft;
+    cvar *SpaceOffsetRight;
+    cvar *SpaceOffsetGap;
+    cvar *BspSpawnLeft;
+    cvar *BspOptimalRatio;
+    cvar *BspSplitRatio;
+    cvar *BspSplitMode;
+    cvar *MouseFollowsFocus;
+    cvar *WindowFloatNext;
+    cvar *WindowRegionLocked;
+    cvar *PreselectBorderColor;
+    cvar *PreselectBorderWidth;
+    cvar *PreselectBorderRadius;
+    cvar *WindowFadeInactive;
+    cvar *WindowFadeAlpha;
+    cvar *WindowFadeDuration;
+    cvar *WindowCGSMove;
+    cvar *FocusedWindow;
+    cvar *BspInsertionPoint;
+    cvar *ActiveDesktop;
+    cvar *LastActiveDesktop;
+};
+
+extern tiling_cvars TilingCVars;
+
+/*
+ * NOTE(koekeishiya): Typed copies of the cvars that are checked on every window moved event and
+ * mouse drag. They are updated by 'TilingCVarChanged' when the core reports that they changed.
+ */
+struct tiling_watched_cvars
+{
+    int volatile WindowRegionLocked;
+    int volatile WindowCGSMove;
+};
+
+extern tiling_watched_cvars WatchedCVars;
+
 #endif
@@ -14,6 +14,7 @@
 #include "vspace.h"
 #include "misc.h"
 #include "constants.h"
+#include "methods.h"
 
 #include <math.h>
 #include <vector>
@@ -298,7 +299,8 @@ void FocusWindowInFullscreenSpace(macos_space *Space, char *Direction)
     macos_window *Window = GetFocusedWindow();
     if (!Window) return;
 
-    char *FocusCycleMode = CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE);
+    char FocusCycleMode[CVAR_STRING_SIZE];
+    CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE, FocusCycleMode, sizeof(FocusCycleMode));
     bool WrapMonitor = StringEquals(FocusCycleMode, Window_Focus_Cycle_All)
                      ? AXLibDisplayCount() == 1
                      : StringEquals(FocusCycleMode, Window_Focus_Cycle_Monitor);
@@ -308,7 +310,7 @@ void FocusWindowInFullscreenSpace(macos_space *Space, char *Direction)
         AXLibSetFocusedWindow(ClosestWindow->Ref);
         AXLibSetFocusedApplication(ClosestWindow->Owner->PSN);
 
-        if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+        if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
             CenterMouseInWindow(ClosestWindow);
         }
     }
@@ -321,7 +323,7 @@ void FocusWindow(char *Direction)
     macos_window *Window;
     virtual_space *VirtualSpace;
 
-    Window = GetWindowByID(CVarUnsignedValue(CVAR_BSP_INSERTION_POINT));
+    Window = GetWindowByID(CVarUnsignedValue(TilingCVars.BspInsertionPoint));
     Success = AXLibActiveSpace(&Space);
     ASSERT(Success);
 
@@ -356,13 +358,13 @@ void FocusWindow(char *Direction)
             AXLibSetFocusedWindow(Window->Ref);
             AXLibSetFocusedApplication(Window->Owner->PSN);
 
-            if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+            if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
                 CenterMouseInWindow(Window);
             }
         }
     } else if (VirtualSpace->Mode == Virtual_Space_Bsp) {
-        char *FocusCycleMode = CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE);
-        ASSERT(FocusCycleMode);
+        char FocusCycleMode[CVAR_STRING_SIZE];
+        CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE, FocusCycleMode, sizeof(FocusCycleMode));
 
         node *WindowNode = GetNodeWithId(VirtualSpace->Tree, Window->Id, VirtualSpace->Mode);
         ASSERT(WindowNode);
@@ -375,7 +377,7 @@ void FocusWindow(char *Direction)
                 AXLibSetFocusedWindow(ClosestWindow->Ref);
                 AXLibSetFocusedApplication(ClosestWindow->Owner->PSN);
 
-                if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+                if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
                     CenterMouseInWindow(ClosestWindow);
                 }
             } else if ((StringEquals(Direction, "east")) ||
@@ -393,14 +395,14 @@ void FocusWindow(char *Direction)
                 AXLibSetFocusedWindow(ClosestWindow->Ref);
                 AXLibSetFocusedApplication(ClosestWindow->Owner->PSN);
 
-                if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+                if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
                     CenterMouseInWindow(ClosestWindow);
                 }
             }
         }
     } else if (VirtualSpace->Mode == Virtual_Space_Monocle) {
-        char *FocusCycleMode = CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE);
-        ASSERT(FocusCycleMode);
+        char FocusCycleMode[CVAR_STRING_SIZE];
+        CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE, FocusCycleMode, sizeof(FocusCycleMode));
 
         node *WindowNode = GetNodeWithId(VirtualSpace->Tree, Window->Id, VirtualSpace->Mode);
         if (WindowNode) {
@@ -442,7 +444,7 @@ void FocusWindow(char *Direction)
                 AXLibSetFocusedWindow(FocusWindow->Ref);
                 AXLibSetFocusedApplication(FocusWindow->Owner->PSN);
 
-                if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+                if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
                     CenterMouseInWindow(FocusWindow);
                 }
             }
@@ -464,7 +466,7 @@ void SwapWindow(char *Direction)
     node *WindowNode, *ClosestNode;
     macos_window *Window, *ClosestWindow;
 
-    Window = GetWindowByID(CVarUnsignedValue(CVAR_BSP_INSERTION_POINT));
+    Window = GetWindowByID(CVarUnsignedValue(TilingCVars.BspInsertionPoint));
     if (!Window) {
         goto out;
     }
@@ -500,7 +502,7 @@ void SwapWindow(char *Direction)
         ResizeWindowToRegionSize(WindowNode);
         ResizeWindowToRegionSize(ClosestNode);
 
-        if (!StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Off)) {
+        if (!CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Off)) {
             CenterMouseInRegion(&ClosestNode->Region);
         }
     } else if (VirtualSpace->Mode == Virtual_Space_Monocle) {
@@ -544,7 +546,7 @@ void WarpWindow(char *Direction)
     macos_window *Window, *ClosestWindow;
     node *WindowNode, *ClosestNode, *FocusedNode;
 
-    Window = GetWindowByID(CVarUnsignedValue(CVAR_BSP_INSERTION_POINT));
+    Window = GetWindowByID(CVarUnsignedValue(TilingCVars.BspInsertionPoint));
     if (!Window) {
         goto out;
     }
@@ -583,16 +585,16 @@ void WarpWindow(char *Direction)
         } else {
             // NOTE(koekeishiya): Modify tree layout.
             UntileWindowFromSpace(Window, Space, VirtualSpace);
-            UpdateCVar(CVAR_BSP_INSERTION_POINT, ClosestWindow->Id);
+            UpdateCVar(TilingCVars.BspInsertionPoint, ClosestWindow->Id);
             TileWindowOnSpace(Window, Space, VirtualSpace);
-            UpdateCVar(CVAR_BSP_INSERTION_POINT, Window->Id);
+            UpdateCVar(TilingCVars.BspInsertionPoint, Window->Id);
 
             FocusedNode = GetNodeWithId(VirtualSpace->Tree, Window->Id, VirtualSpace->Mode);
         }
 
         ASSERT(FocusedNode);
 
-        if (!StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Off)) {
+        if (!CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Off)) {
             CenterMouseInRegion(&ClosestNode->Region);
         }
     } else if (VirtualSpace->Mode == Virtual_Space_Monocle) {
@@ -632,7 +634,7 @@ void TemporaryRatio(char *Ratio)
 {
     float FloatRatio;
     sscanf(Ratio, "%f", &FloatRatio);
-    UpdateCVar(CVAR_BSP_SPLIT_RATIO, FloatRatio);
+    UpdateCVar(TilingCVars.BspSplitRatio, FloatRatio);
 }
 
 void ExtendedDockSetWindowAlpha(uint32_t WindowId, float Value, float Duration)
@@ -648,8 +650,8 @@ void ExtendedDockSetWindowAlpha(uint32_t WindowId, float Value, float Duration)
 
 void EnableWindowFading(uint32_t FocusedWindowId)
 {
-    float Alpha = CVarFloatingPointValue(CVAR_WINDOW_FADE_ALPHA);
-    float Duration = CVarFloatingPointValue(CVAR_WINDOW_FADE_DURATION);
+    float Alpha = CVarFloatingPointValue(TilingCVars.WindowFadeAlpha);
+    float Duration = CVarFloatingPointValue(TilingCVars.WindowFadeDuration);
     macos_window_map Copy = CopyWindowCache();
 
     ExtendedDockSetWindowAlpha(FocusedWindowId, 1.0f, Duration);
@@ -659,12 +661,12 @@ void EnableWindowFading(uint32_t FocusedWindowId)
         ExtendedDockSetWindowAlpha(Window->Id, Alpha, Duration);
     }
 
-    UpdateCVar(CVAR_WINDOW_FADE_INACTIVE, 1);
+    UpdateCVar(TilingCVars.WindowFadeInactive, 1);
 }
 
 void DisableWindowFading()
 {
-    float Duration = CVarFloatingPointValue(CVAR_WINDOW_FADE_DURATION);
+    float Duration = CVarFloatingPointValue(TilingCVars.WindowFadeDuration);
     macos_window_map Copy = CopyWindowCache();
 
     for (macos_window_map_it It = Copy.begin(); It != Copy.end(); ++It) {
@@ -672,7 +674,7 @@ void DisableWindowFading()
         ExtendedDockSetWindowAlpha(Window->Id, 1.0f, Duration);
     }
 
-    UpdateCVar(CVAR_WINDOW_FADE_INACTIVE, 0);
+    UpdateCVar(TilingCVars.WindowFadeInactive, 0);
 }
 
 void ExtendedDockSetWindowPosition(uint32_t WindowId, int X, int Y)
@@ -739,7 +741,7 @@ ToggleWindowFade()
         return;
     }
 
-    if (CVarIntegerValue(CVAR_WINDOW_FADE_INACTIVE)) {
+    if (CVarIntegerValue(TilingCVars.WindowFadeInactive)) {
         DisableWindowFading();
     } else {
         EnableWindowFading(Window->Id);
@@ -953,7 +955,7 @@ ToggleWindowSplitMode()
         goto vspace_release;
     }
 
-    WindowId = CVarUnsignedValue(CVAR_BSP_INSERTION_POINT);
+    WindowId = CVarUnsignedValue(TilingCVars.BspInsertionPoint);
     Node = GetNodeWithId(VirtualSpace->Tree, WindowId, VirtualSpace->Mode);
     if (!Node || !Node->Parent) {
         goto vspace_release;
@@ -1065,8 +1067,8 @@ void UseInsertionPoint(char *Direction)
 
     VirtualSpace->Preselect->Node = Node;
     VirtualSpace->Preselect->Ratio = VirtualSpace->Preselect->SpawnLeft
-                                   ? CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO)
-                                   : 1 - CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+                                   ? CVarFloatingPointValue(TilingCVars.BspSplitRatio)
+                                   : 1 - CVarFloatingPointValue(TilingCVars.BspSplitRatio);
 
 
     if (VirtualSpace->Preselect->Split == Split_Vertical) {
@@ -1081,8 +1083,8 @@ void UseInsertionPoint(char *Direction)
                               VirtualSpace);
     }
 
-    PreselectBorderColor = CVarUnsignedValue(CVAR_PRE_BORDER_COLOR);
-    PreselectBorderWidth = CVarIntegerValue(CVAR_PRE_BORDER_WIDTH);
+    PreselectBorderColor = CVarUnsignedValue(TilingCVars.PreselectBorderColor);
+    PreselectBorderWidth = CVarIntegerValue(TilingCVars.PreselectBorderWidth);
 
     VirtualSpace->Preselect->Border = CreatePreselWindow(PreselectBorderType,
                                                          VirtualSpace->Preselect->Region.X,
@@ -1211,7 +1213,7 @@ void AdjustWindowRatio(char *Direction)
     macos_window *Window, *ClosestWindow;
     node *WindowNode, *ClosestNode, *Ancestor;
 
-    Window = GetWindowByID(CVarUnsignedValue(CVAR_BSP_INSERTION_POINT));
+    Window = GetWindowByID(CVarUnsignedValue(TilingCVars.BspInsertionPoint));
     if (!Window) {
         goto out;
     }
@@ -1249,7 +1251,7 @@ void AdjustWindowRatio(char *Direction)
         goto vspace_release;
     }
 
-    Offset = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+    Offset = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
     if (!(WindowNode == Ancestor->Left || IsNodeInTree(Ancestor->Left, WindowNode))) {
         Offset = -Offset;
     }
@@ -1775,7 +1777,7 @@ FocusMonitor(unsigned MonitorId)
     AXLibSetFocusedWindow(Window->Ref);
     AXLibSetFocusedApplication(Window->Owner->PSN);
 
-    if (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_Intr)) {
+    if (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_Intr)) {
         CenterMouseInWindow(Window);
     }
 
@@ -1827,8 +1829,8 @@ void FocusMonitor(char *Op)
     switch (Operation) {
     case -1: {
         if (!FocusMonitor(DestinationMonitor)) {
-            char *FocusCycleMode = CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE);
-            ASSERT(FocusCycleMode);
+            char FocusCycleMode[CVAR_STRING_SIZE];
+            CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE, FocusCycleMode, sizeof(FocusCycleMode));
             if ((StringEquals(FocusCycleMode, Window_Focus_Cycle_All)) ||
                 (CVarIntegerValue(CVAR_MONITOR_FOCUS_CYCLE))) {
                 DestinationMonitor = AXLibDisplayCount() - 1;
@@ -1841,8 +1843,8 @@ void FocusMonitor(char *Op)
     } break;
     case 1: {
         if (!FocusMonitor(DestinationMonitor)) {
-            char *FocusCycleMode = CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE);
-            ASSERT(FocusCycleMode);
+            char FocusCycleMode[CVAR_STRING_SIZE];
+            CVarStringValue(CVAR_WINDOW_FOCUS_CYCLE, FocusCycleMode, sizeof(FocusCycleMode));
             if ((StringEquals(FocusCycleMode, Window_Focus_Cycle_All)) ||
                 (CVarIntegerValue(CVAR_MONITOR_FOCUS_CYCLE))) {
                 DestinationMonitor = 0;
@@ -2327,3 +2329,142 @@ void QueryMonitorForDesktop(char *Op, int SockFD)
         WriteToSocket(Message, SockFD);
     }
 }
+
+internal size_t
+WriteDesktopConfig(char *Cursor, size_t BufferSize, unsigned DesktopId)
+{
+    virtual_space_config Config = GetVirtualSpaceConfig(DesktopId);
+    int BytesWritten = snprintf(Cursor, BufferSize, "%u %s %.1f %.1f %.1f %.1f %.1f %s\n",
+                                DesktopId,
+                                virtual_space_mode_str[Config.Mode],
+                                Config.Offset.Top,
+                                Config.Offset.Bottom,
+                                Config.Offset.Left,
+                                Config.Offset.Right,
+                                Config.Offset.Gap,
+                                Config.TreeLayout ? Config.TreeLayout : "-");
+    FreeVirtualSpaceConfig(&Config);
+
+    if (BytesWritten < 0) return 0;
+    return (size_t) BytesWritten < BufferSize ? (size_t) BytesWritten : BufferSize - 1;
+}
+
+/*
+ * NOTE(koekeishiya): Outputs the config a desktop gets when its virtual space is created, one
+ * line per desktop: '<desktop id> <mode> <top> <bottom> <left> <right> <gap> <tree | ->'.
+ */
+void QueryDesktopConfig(char *Op, int SockFD)
+{
+    char Message[4096];
+    char *Cursor = Message;
+    size_t BufferSize = sizeof(Message);
+    Message[0] = '\0';
+
+    int DesktopId;
+    if (sscanf(Op, "%d", &DesktopId) == 1) {
+        CGSSpaceID SpaceId;
+        unsigned Arrangement;
+        if ((DesktopId < 1) || (!AXLibCGSSpaceIDFromDesktopID(DesktopId, &Arrangement, &SpaceId))) {
+            c_log(C_LOG_LEVEL_WARN, "invalid desktop specified, desktop '%s' does not exist!\n", Op);
+            return;
+        }
+        WriteDesktopConfig(Cursor, BufferSize, DesktopId);
+    } else {
+        unsigned DisplayCount = AXLibDisplayCount();
+        for (unsigned Arrangement = 0; Arrangement < DisplayCount; ++Arrangement) {
+            CFStringRef DisplayRef = AXLibGetDisplayIdentifierFromArrangement(Arrangement);
+            if (!DisplayRef) continue;
+
+            int Count = 0;
+            int *Desktops = AXLibSpacesForDisplay(DisplayRef, &Count);
+            for (int Index = 0; Desktops && Index < Count; ++Index) {
+                size_t BytesWritten = WriteDesktopConfig(Cursor, BufferSize, Desktops[Index]);
+                Cursor += BytesWritten;
+                BufferSize -= BytesWritten;
+            }
+
+            free(Desktops);
+            CFRelease(DisplayRef);
+        }
+    }
+
+    // NOTE(koekeishiya): Overwrite trailing newline
+    size_t Length = strlen(Message);
+    if (Length) Message[Length - 1] = '\0';
+    WriteToSocket(Message, SockFD);
+}
+
+internal void
+WriteLayoutNode(tiling_layout_node *LayoutNode, node *Node)
+{
+    LayoutNode->WindowId = Node->WindowId;
+    LayoutNode->X = Node->Region.X;
+    LayoutNode->Y = Node->Region.Y;
+    LayoutNode->Width = Node->Region.Width;
+    LayoutNode->Height = Node->Region.Height;
+}
+
+/*
+ * NOTE(koekeishiya): Called by other plugins, on their own thread, see methods.h. The virtual
+ * space is locked while the tree is copied. Nodes that are written past the end of 'Response'
+ * are only counted, so that the caller learns the size it needs.
+ */
+CHUNKWM_API_METHOD_FUNC(DesktopLayoutMethod)
+{
+    macos_space *Space;
+    virtual_space *VirtualSpace;
+    unsigned DesktopId;
+    uint32_t Capacity;
+    size_t Size;
+
+    if (*ResponseSize < sizeof(tiling_desktop_layout)) {
+        *ResponseSize = sizeof(tiling_desktop_layout);
+        return chunkwm_call_too_small;
+    }
+
+    tiling_desktop_layout *Layout = (tiling_desktop_layout *) Response;
+    tiling_layout_node *Nodes = (tiling_layout_node *) (Layout + 1);
+    Capacity = (*ResponseSize - sizeof(tiling_desktop_layout)) / sizeof(tiling_layout_node);
+
+    if (!AXLibActiveSpace(&Space)) {
+        return chunkwm_call_failed;
+    }
+
+    if (!AXLibCGSSpaceIDToDesktopID(Space->Id, NULL, &DesktopId)) {
+        AXLibDestroySpace(Space);
+        return chunkwm_call_failed;
+    }
+
+    Layout->DesktopId = DesktopId;
+    Layout->Count = 0;
+
+    VirtualSpace = AcquireVirtualSpace(Space);
+    Layout->Mode = VirtualSpace->Mode;
+
+    if (VirtualSpace->Tree) {
+        if (VirtualSpace->Mode == Virtual_Space_Bsp) {
+            for (node *Node = GetFirstLeafNode(VirtualSpace->Tree); Node; Node = GetNextLeafNode(Node)) {
+                if (Node->WindowId == Node_PseudoLeaf) continue;
+                if (Layout->Count < Capacity) WriteLayoutNode(Nodes + Layout->Count, Node);
+                ++Layout->Count;
+            }
+        } else if (VirtualSpace->Mode == Virtual_Space_Monocle) {
+            for (node *Node = VirtualSpace->Tree; Node; Node = Node->Right) {
+                if (Layout->Count < Capacity) WriteLayoutNode(Nodes + Layout->Count, Node);
+                ++Layout->Count;
+            }
+        }
+    }
+
+    ReleaseVirtualSpace(VirtualSpace);
+    AXLibDestroySpace(Space);
+
+    Size = sizeof(tiling_desktop_layout) + Layout->Count * sizeof(tiling_layout_node);
+    if (Layout->Count > Capacity) {
+        *ResponseSize = Size;
+        return chunkwm_call_too_small;
+    }
+
+    *ResponseSize = Size;
+    return chunkwm_call_ok;
+}
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "../../api/plugin_cvar.h"
+
 struct macos_window;
 struct macos_space;
 struct virtual_space;
@@ -54,5 +56,8 @@ void QueryDesktop(char *Op, int SockFD);
 void QueryMonitor(char *Op, int SockFD);
 void QueryDesktopsForMonitor(char *Op, int SockFD);
 void QueryMonitorForDesktop(char *Op, int SockFD);
+void QueryDesktopConfig(char *Op, int SockFD);
+
+CHUNKWM_API_METHOD_FUNC(DesktopLayoutMethod);
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef PLUGIN_TILING_METHODS_H
+#define PLUGIN_TILING_METHODS_H
+
+#include <stdint.h>
+
+/*
+ * NOTE(koekeishiya): Methods that the tiling plugin registers for other plugins, see
+ * 'chunkwm_api.CallMethod'. A plugin that calls them includes this header.
+ *
+ *   desktop_layout   takes no request. The response is a 'tiling_desktop_layout' for the
+ *                    active desktop, followed by 'Count' 'tiling_layout_node' for its tiled
+ *                    windows, in the order of the tree. 'Mode' is a 'tiling_layout_mode'.
+ */
+#define TILING_PLUGIN_NAME "Tiling"
+#define TILING_METHOD_DESKTOP_LAYOUT "desktop_layout"
+
+enum tiling_layout_mode
+{
+    Tiling_Layout_Bsp,
+    Tiling_Layout_Monocle,
+    Tiling_Layout_Float,
+};
+
+struct tiling_desktop_layout
+{
+    uint32_t DesktopId;
+    uint32_t Mode;
+    uint32_t Count;
+};
+
+struct tiling_layout_node
+{
+    uint32_t WindowId;
+    float X, Y;
+    float Width, Height;
+};
+
+#endif
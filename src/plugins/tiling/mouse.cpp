@@ -118,9 +118,9 @@ MatchMouseBinding(mouse_binding *Binding, uint32_t Flags, uint32_t Button)
 internal resize_border
 CreateResizeBorder(node *Node)
 {
-    unsigned PreselectBorderColor = CVarUnsignedValue(CVAR_PRE_BORDER_COLOR);
-    int PreselectBorderWidth = CVarIntegerValue(CVAR_PRE_BORDER_WIDTH);
-    int PreselectBorderRadius = CVarIntegerValue(CVAR_PRE_BORDER_RADIUS);
+    unsigned PreselectBorderColor = CVarUnsignedValue(TilingCVars.PreselectBorderColor);
+    int PreselectBorderWidth = CVarIntegerValue(TilingCVars.PreselectBorderWidth);
+    int PreselectBorderRadius = CVarIntegerValue(TilingCVars.PreselectBorderRadius);
     int InvertY = FuckingMacOSMonitorBoundsChangingBetweenPrimaryAndMainMonitor(Node->Region.Y, Node->Region.Height);
     border_window *Border = CreateBorderWindow(Node->Region.X, InvertY,
                                                Node->Region.Width, Node->Region.Height,
@@ -331,13 +331,12 @@ MouseMoveWindowTick()
             }
         }
     } else if (ResizeState.Mode == Drag_Mode_Move_Floating) {
-        local_persist int UseCGSMove = CVarIntegerValue(CVAR_WINDOW_CGS_MOVE);
         local_persist float MinDiff = 2.5f;
         CGPoint Cursor = AXLibGetCursorPos();
         float DeltaX = Cursor.x - ResizeState.InitialCursor.x;
         float DeltaY = Cursor.y - ResizeState.InitialCursor.y;
         if (fabs(DeltaX) > MinDiff || fabs(DeltaY) > MinDiff) {
-            if (UseCGSMove) {
+            if (WatchedCVars.WindowCGSMove) {
                 ExtendedDockSetWindowPosition(ResizeState.Window->Id,
                                               (int)(ResizeState.InitialRatioH + DeltaX),
                                               (int)(ResizeState.InitialRatioV + DeltaY));
@@ -3,6 +3,7 @@
 #include "constants.h"
 
 #include "presel.h"
+#include "state.h"
 #include "../../common/config/tokenize.h"
 #include "../../common/config/cvar.h"
 #include "../../common/misc/assert.h"
@@ -12,6 +13,7 @@
 
 #include <queue>
 #include <map>
+#include <vector>
 
 #define internal static
 
@@ -32,7 +34,7 @@ node_ids AssignNodeIds(uint32_t ExistingId, uint32_t NewId, bool SpawnLeft)
 
 node_split OptimalSplitMode(node *Node)
 {
-    float OptimalRatio = CVarFloatingPointValue(CVAR_BSP_OPTIMAL_RATIO);
+    float OptimalRatio = CVarFloatingPointValue(TilingCVars.BspOptimalRatio);
     float NodeRatio = Node->Region.Width / Node->Region.Height;
     return NodeRatio >= OptimalRatio ? Split_Vertical : Split_Horizontal;
 }
@@ -55,7 +57,7 @@ node *CreateRootNode(uint32_t WindowId, macos_space *Space, virtual_space *Virtu
     Node->WindowId = WindowId;
     CreateNodeRegion(Node, Region_Full, Space, VirtualSpace);
     Node->Split = OptimalSplitMode(Node);
-    Node->Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+    Node->Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
 
     return Node;
 }
@@ -70,7 +72,7 @@ node *CreateLeafNode(node *Parent, uint32_t WindowId, region_type Type,
     Node->WindowId = WindowId;
     CreateNodeRegion(Node, Type, Space, VirtualSpace);
     Node->Split = OptimalSplitMode(Node);
-    Node->Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+    Node->Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
 
     return Node;
 }
@@ -80,9 +82,9 @@ void CreateLeafNodePair(node *Parent, uint32_t ExistingWindowId, uint32_t Spawne
 {
     Parent->WindowId = Node_Root;
     Parent->Split = Split;
-    Parent->Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+    Parent->Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
 
-    int SpawnLeft = CVarIntegerValue(CVAR_BSP_SPAWN_LEFT);
+    int SpawnLeft = CVarIntegerValue(TilingCVars.BspSpawnLeft);
     node_ids NodeIds = AssignNodeIds(ExistingWindowId, SpawnedWindowId, SpawnLeft);
 
     ASSERT(Split == Split_Vertical || Split == Split_Horizontal);
@@ -721,7 +723,7 @@ node *DeserializeNodeFromBuffer(char *Buffer)
 
             Leaf->WindowId = Node_PseudoLeaf;
             Leaf->Parent = Current;
-            Leaf->Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+            Leaf->Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
             Current->Left = Leaf;
         } else if (TokenEquals(Token, "right_leaf")) {
             node *Leaf = (node *) malloc(sizeof(node));
@@ -729,7 +731,7 @@ node *DeserializeNodeFromBuffer(char *Buffer)
 
             Leaf->WindowId = Node_PseudoLeaf;
             Leaf->Parent = Current;
-            Leaf->Ratio = CVarFloatingPointValue(CVAR_BSP_SPLIT_RATIO);
+            Leaf->Ratio = CVarFloatingPointValue(TilingCVars.BspSplitRatio);
             Current->Right = Leaf;
 
             // NOTE(koekeishiya): After parsing a right-leaf, we are done with this node
@@ -741,3 +743,133 @@ node *DeserializeNodeFromBuffer(char *Buffer)
 
     return Tree;
 }
+
+internal uint32_t
+NodeStateIndex(std::vector<node *> *Nodes, node *Node)
+{
+    for (size_t Index = 0; Index < Nodes->size(); ++Index) {
+        if ((*Nodes)[Index] == Node) {
+            return Index;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+internal void
+WriteNodeState(state_buffer *Buffer, node *Node, std::vector<node *> *Nodes)
+{
+    Nodes->push_back(Node);
+    WriteStateU32(Buffer, Node->WindowId);
+    WriteStateU32(Buffer, Node->Split);
+    WriteState(Buffer, &Node->Ratio, sizeof(float));
+    WriteState(Buffer, &Node->Region, sizeof(region));
+}
+
+internal void
+WriteBSPNodeState(state_buffer *Buffer, node *Node, std::vector<node *> *Nodes)
+{
+    WriteNodeState(Buffer, Node, Nodes);
+
+    uint32_t HasChildren = Node->Left && Node->Right;
+    WriteStateU32(Buffer, HasChildren);
+    if (HasChildren) {
+        WriteBSPNodeState(Buffer, Node->Left, Nodes);
+        WriteBSPNodeState(Buffer, Node->Right, Nodes);
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Unlike 'SerializeNodeToBuffer', this keeps the window ids, regions and
+ * zoom of the tree, so that the next instance of the plugin can take it over as it is. A bsp
+ * tree is written in pre-order, followed by the zoom of every node as an index in that
+ * order. A monocle space is a list linked through 'Right', and is written front to back.
+ */
+void WriteNodeTreeState(state_buffer *Buffer, node *Tree, virtual_space_mode VirtualSpaceMode)
+{
+    std::vector<node *> Nodes;
+
+    if (VirtualSpaceMode == Virtual_Space_Bsp) {
+        WriteBSPNodeState(Buffer, Tree, &Nodes);
+        for (size_t Index = 0; Index < Nodes.size(); ++Index) {
+            WriteStateU32(Buffer, NodeStateIndex(&Nodes, Nodes[Index]->Zoom));
+        }
+    } else {
+        uint32_t Count = 0;
+        for (node *Node = Tree; Node; Node = Node->Right) {
+            ++Count;
+        }
+
+        WriteStateU32(Buffer, Count);
+        for (node *Node = Tree; Node; Node = Node->Right) {
+            WriteNodeState(Buffer, Node, &Nodes);
+        }
+    }
+}
+
+internal node *
+ReadNodeState(state_buffer *Buffer, std::vector<node *> *Nodes)
+{
+    node *Node = (node *) malloc(sizeof(node));
+    memset(Node, 0, sizeof(node));
+    Nodes->push_back(Node);
+
+    Node->WindowId = ReadStateU32(Buffer);
+    Node->Split = (node_split) ReadStateU32(Buffer);
+    ReadState(Buffer, &Node->Ratio, sizeof(float));
+    ReadState(Buffer, &Node->Region, sizeof(region));
+    return Node;
+}
+
+internal node *
+ReadBSPNodeState(state_buffer *Buffer, node *Parent, std::vector<node *> *Nodes)
+{
+    node *Node = ReadNodeState(Buffer, Nodes);
+    Node->Parent = Parent;
+
+    if (ReadStateU32(Buffer)) {
+        Node->Left = ReadBSPNodeState(Buffer, Node, Nodes);
+        Node->Right = ReadBSPNodeState(Buffer, Node, Nodes);
+    }
+
+    return Node;
+}
+
+// NOTE(koekeishiya): Caller is responsible for memory, NULL if the buffer failed.
+node *ReadNodeTreeState(state_buffer *Buffer, virtual_space_mode VirtualSpaceMode)
+{
+    std::vector<node *> Nodes;
+    node *Tree;
+
+    if (VirtualSpaceMode == Virtual_Space_Bsp) {
+        Tree = ReadBSPNodeState(Buffer, NULL, &Nodes);
+        for (size_t Index = 0; Index < Nodes.size(); ++Index) {
+            uint32_t Zoom = ReadStateU32(Buffer);
+            if (Zoom < Nodes.size()) {
+                Nodes[Index]->Zoom = Nodes[Zoom];
+            }
+        }
+    } else {
+        uint32_t Count = ReadStateU32(Buffer);
+        node *Prev = Tree = NULL;
+        for (uint32_t Index = 0; !Buffer->Failed && Index < Count; ++Index) {
+            node *Node = ReadNodeState(Buffer, &Nodes);
+            if (Prev) {
+                Prev->Right = Node;
+                Node->Left = Prev;
+            } else {
+                Tree = Node;
+            }
+            Prev = Node;
+        }
+    }
+
+    if (Buffer->Failed) {
+        for (size_t Index = 0; Index < Nodes.size(); ++Index) {
+            free(Nodes[Index]);
+        }
+        Tree = NULL;
+    }
+
+    return Tree;
+}
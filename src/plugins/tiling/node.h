@@ -7,6 +7,7 @@
 #include "vspace.h"
 
 struct presel_window;
+struct state_buffer;
 
 enum node_type
 {
@@ -126,4 +127,7 @@ void SwapNodeIds(node *A, node *B);
 char *SerializeNodeToBuffer(node *Node);
 node *DeserializeNodeFromBuffer(char *Buffer);
 
+void WriteNodeTreeState(state_buffer *Buffer, node *Tree, virtual_space_mode VirtualSpaceMode);
+node *ReadNodeTreeState(state_buffer *Buffer, virtual_space_mode VirtualSpaceMode);
+
 #endif
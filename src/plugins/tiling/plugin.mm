@@ -44,6 +44,7 @@
 #include "mouse.h"
 #include "constants.h"
 #include "misc.h"
+#include "state.h"
 
 extern chunkwm_log *c_log;
 
@@ -91,6 +92,20 @@ internal macos_window_map Windows;
 internal pthread_mutex_t WindowsLock;
 internal event_tap EventTap;
 internal chunkwm_api API;
+internal uint32_t FocusedWindowFloatTopic;
+internal bool DeferNodeRegions;
+internal std::vector<virtual_space *> DeferredVirtualSpaces;
+tiling_cvars TilingCVars;
+tiling_watched_cvars WatchedCVars;
+
+struct restored_window_flags
+{
+    uint32_t Id;
+    uint32_t Flags;
+};
+
+#define RESTORED_WINDOW_FLAGS (Window_Float | Window_Sticky | Window_ForceTile)
+internal std::vector<restored_window_flags> RestoredWindowFlags;
 chunkwm_log *c_log;
 
 #if 0
@@ -128,8 +143,8 @@ macos_window_map CopyWindowCache()
 internal void
 FadeWindows(uint32_t FocusedWindowId)
 {
-    float Alpha = CVarFloatingPointValue(CVAR_WINDOW_FADE_ALPHA);
-    float Duration = CVarFloatingPointValue(CVAR_WINDOW_FADE_DURATION);
+    float Alpha = CVarFloatingPointValue(TilingCVars.WindowFadeAlpha);
+    float Duration = CVarFloatingPointValue(TilingCVars.WindowFadeDuration);
     macos_window_map Copy = CopyWindowCache();
 
     ExtendedDockSetWindowAlpha(FocusedWindowId, 1.0f, Duration);
@@ -284,14 +299,14 @@ internal void
 BroadcastFocusedWindowFloating()
 {
     uint32_t Data[2] = { 0, 0 };
-    API.Broadcast(PluginName, "focused_window_float", (char *) Data, sizeof(Data));
+    API.BroadcastTopic(FocusedWindowFloatTopic, (char *) Data, sizeof(Data));
 }
 
 void BroadcastFocusedWindowFloating(macos_window *Window)
 {
     uint32_t Status = (uint32_t) AXLibHasFlags(Window, Window_Float);
     uint32_t Data[2] = { Window->Id, Status };
-    API.Broadcast(PluginName, "focused_window_float", (char *) Data, sizeof(Data));
+    API.BroadcastTopic(FocusedWindowFloatTopic, (char *) Data, sizeof(Data));
 }
 
 bool IsWindowValid(macos_window *Window)
@@ -318,6 +333,41 @@ IsWindowFocusable(macos_window *Window)
     return Result;
 }
 
+/*
+ * NOTE(koekeishiya): While a batch of events is handled, windows that are tiled or untiled
+ * only update the tree of their space, and the tree is applied once the batch is done.
+ * Virtual spaces live until the plugin is unloaded, so we can hold on to the pointers.
+ */
+internal void
+ApplyNodeRegionOrDefer(node *Node, virtual_space *VirtualSpace)
+{
+    if (!DeferNodeRegions) {
+        ApplyNodeRegion(Node, VirtualSpace->Mode);
+        return;
+    }
+
+    for (size_t Index = 0; Index < DeferredVirtualSpaces.size(); ++Index) {
+        if (DeferredVirtualSpaces[Index] == VirtualSpace) return;
+    }
+
+    DeferredVirtualSpaces.push_back(VirtualSpace);
+}
+
+internal void
+ApplyDeferredNodeRegions()
+{
+    for (size_t Index = 0; Index < DeferredVirtualSpaces.size(); ++Index) {
+        virtual_space *VirtualSpace = DeferredVirtualSpaces[Index];
+        pthread_mutex_lock(&VirtualSpace->Lock);
+        if ((VirtualSpace->Tree) && (VirtualSpace->Mode == Virtual_Space_Bsp)) {
+            ApplyNodeRegionWithPotentialZoom(VirtualSpace->Tree, VirtualSpace);
+        }
+        pthread_mutex_unlock(&VirtualSpace->Lock);
+    }
+
+    DeferredVirtualSpaces.clear();
+}
+
 internal bool
 TileWindowPreValidation(macos_window *Window)
 {
@@ -330,15 +380,23 @@ TileWindowPreValidation(macos_window *Window)
         return false;
     }
 
-    if (CVarIntegerValue(CVAR_WINDOW_FLOAT_NEXT)) {
+    if (CVarIntegerValue(TilingCVars.WindowFloatNext)) {
         FloatWindow(Window);
-        UpdateCVar(CVAR_WINDOW_FLOAT_NEXT, 0);
+        UpdateCVar(TilingCVars.WindowFloatNext, 0);
         return false;
     }
 
     return true;
 }
 
+internal node_split
+BspSplitMode()
+{
+    char SplitMode[CVAR_STRING_SIZE];
+    CVarStringValue(TilingCVars.BspSplitMode, SplitMode, sizeof(SplitMode));
+    return NodeSplitFromString(SplitMode);
+}
+
 // NOTE(koekeishiya): Caller is responsible for making sure that the window is a valid window
 // that we can properly manage. The given macos_space must also be of type kCGSSpaceUser,
 // meaning that it is a space we can legally interact with.
@@ -369,7 +427,7 @@ void TileWindowOnSpace(macos_window *Window, macos_space *Space, virtual_space *
         }
 
         node *Node = NULL;
-        uint32_t InsertionPoint = CVarUnsignedValue(CVAR_BSP_INSERTION_POINT);
+        uint32_t InsertionPoint = CVarUnsignedValue(TilingCVars.BspInsertionPoint);
 
         if (VirtualSpace->Mode == Virtual_Space_Bsp) {
 
@@ -386,23 +444,23 @@ void TileWindowOnSpace(macos_window *Window, macos_space *Space, virtual_space *
                 CreateLeafNodePairPreselect(VirtualSpace->Preselect->Node,
                                             VirtualSpace->Preselect->Node->WindowId,
                                             Window->Id, Space, VirtualSpace);
-                ApplyNodeRegion(VirtualSpace->Preselect->Node, VirtualSpace->Mode);
+                ApplyNodeRegionOrDefer(VirtualSpace->Preselect->Node, VirtualSpace);
                 FreePreselectNode(VirtualSpace);
             } else {
                 Node = GetFirstMinDepthPseudoLeafNode(VirtualSpace->Tree);
                 if (Node) {
                     if (Node->Parent) {
-                        int SpawnLeft = CVarIntegerValue(CVAR_BSP_SPAWN_LEFT);
+                        int SpawnLeft = CVarIntegerValue(TilingCVars.BspSpawnLeft);
                         node_ids NodeIds = AssignNodeIds(Node->Parent->WindowId, Window->Id, SpawnLeft);
                         Node->Parent->WindowId = Node_Root;
                         Node->Parent->Left->WindowId = NodeIds.Left;
                         Node->Parent->Right->WindowId = NodeIds.Right;
                         CreateNodeRegionRecursive(Node->Parent, false, Space, VirtualSpace);
-                        ApplyNodeRegion(Node->Parent, VirtualSpace->Mode);
+                        ApplyNodeRegionOrDefer(Node->Parent, VirtualSpace);
                     } else {
                         Node->WindowId = Window->Id;
                         CreateNodeRegion(Node, Region_Full, Space, VirtualSpace);
-                        ApplyNodeRegion(Node, VirtualSpace->Mode);
+                        ApplyNodeRegionOrDefer(Node, VirtualSpace);
                     }
                     goto display_free;
                 }
@@ -416,13 +474,13 @@ void TileWindowOnSpace(macos_window *Window, macos_space *Space, virtual_space *
                     ASSERT(Node != NULL);
                 }
 
-                node_split Split = NodeSplitFromString(CVarStringValue(CVAR_BSP_SPLIT_MODE));
+                node_split Split = BspSplitMode();
                 if (Split == Split_Optimal) {
                     Split = OptimalSplitMode(Node);
                 }
 
                 CreateLeafNodePair(Node, Node->WindowId, Window->Id, Split, Space, VirtualSpace);
-                ApplyNodeRegion(Node, VirtualSpace->Mode);
+                ApplyNodeRegionOrDefer(Node, VirtualSpace);
             }
 
             // NOTE(koekeishiya): Reset fullscreen-zoom state.
@@ -559,7 +617,7 @@ UntileWindowFromSpace(uint32_t WindowId, macos_space *Space, virtual_space *Virt
              * NOTE(koekeishiya): Re-zoom window after spawned window closes.
              * see reference: https://github.com/koekeishiya/chunkwm/issues/20
              */
-            ApplyNodeRegion(NewLeaf, VirtualSpace->Mode);
+            ApplyNodeRegionOrDefer(NewLeaf, VirtualSpace);
             if (NewLeaf->Parent && NewLeaf->Parent->Zoom) {
                 ResizeWindowToExternalRegionSize(NewLeaf->Parent->Zoom,
                                                  NewLeaf->Parent->Region);
@@ -784,7 +842,7 @@ CreateWindowTreeForSpaceWithWindows(macos_space *Space, virtual_space *VirtualSp
             New = GetFirstMinDepthLeafNode(Root);
             ASSERT(New != NULL);
 
-            node_split Split = NodeSplitFromString(CVarStringValue(CVAR_BSP_SPLIT_MODE));
+            node_split Split = BspSplitMode();
             if (Split == Split_Optimal) {
                 Split = OptimalSplitMode(New);
             }
@@ -831,7 +889,7 @@ CreateDeserializedWindowTreeForSpaceWithWindows(macos_space *Space, virtual_spac
                 // NOTE(koekeishiya): This is an intermediate leaf node in the tree.
                 // We simulate the process of performing a new split, but use the
                 // existing node configuration.
-                int SpawnLeft = CVarIntegerValue(CVAR_BSP_SPAWN_LEFT);
+                int SpawnLeft = CVarIntegerValue(TilingCVars.BspSpawnLeft);
                 node_ids NodeIds = AssignNodeIds(Node->Parent->WindowId, Windows[Index], SpawnLeft);
                 Node->Parent->WindowId = Node_Root;
                 Node->Parent->Left->WindowId = NodeIds.Left;
@@ -847,7 +905,7 @@ CreateDeserializedWindowTreeForSpaceWithWindows(macos_space *Space, virtual_spac
             Node = GetFirstMinDepthLeafNode(Root);
             ASSERT(Node != NULL);
 
-            node_split Split = NodeSplitFromString(CVarStringValue(CVAR_BSP_SPLIT_MODE));
+            node_split Split = BspSplitMode();
             if (Split == Split_Optimal) {
                 Split = OptimalSplitMode(Node);
             }
@@ -892,6 +950,9 @@ void CreateDeserializedWindowTreeForSpace(macos_space *Space, virtual_space *Vir
     CreateDeserializedWindowTreeForSpaceWithWindows(Space, VirtualSpace, Windows);
 }
 
+internal void
+RebalanceWindowTreeForSpace(macos_space *Space, virtual_space *VirtualSpace);
+
 void CreateWindowTree()
 {
     macos_space *Space;
@@ -912,7 +973,16 @@ void CreateWindowTree()
 
     if (Space->Type == kCGSSpaceUser) {
         virtual_space *VirtualSpace = AcquireVirtualSpace(Space);
-        if (ShouldDeserializeVirtualSpace(VirtualSpace)) {
+        if (VirtualSpace->Tree) {
+            /*
+             * NOTE(koekeishiya): The tree was handed over by the previous instance of the plugin.
+             * Windows may have been opened or closed while we were reloaded.
+             */
+            RebalanceWindowTreeForSpace(Space, VirtualSpace);
+            if (VirtualSpace->Tree) {
+                VirtualSpaceRecreateRegions(Space, VirtualSpace);
+            }
+        } else if (ShouldDeserializeVirtualSpace(VirtualSpace)) {
             CreateDeserializedWindowTreeForSpace(Space, VirtualSpace);
         } else {
             CreateWindowTreeForSpace(Space, VirtualSpace);
@@ -1013,8 +1083,8 @@ space_free:
 internal void
 WindowFocusedHandler(uint32_t WindowId)
 {
-    uint32_t FocusedWindowId = CVarUnsignedValue(CVAR_FOCUSED_WINDOW);
-    UpdateCVar(CVAR_FOCUSED_WINDOW, WindowId);
+    uint32_t FocusedWindowId = CVarUnsignedValue(TilingCVars.FocusedWindow);
+    UpdateCVar(TilingCVars.FocusedWindow, WindowId);
     macos_window *Window = GetWindowByID(WindowId);
     if (Window && IsWindowFocusable(Window)) {
         __AppleGetDisplayIdentifierFromMacOSWindow(Window);
@@ -1032,17 +1102,17 @@ WindowFocusedHandler(uint32_t WindowId)
             goto space_free;
         }
 
-        if (CVarIntegerValue(CVAR_WINDOW_FADE_INACTIVE)) {
+        if (CVarIntegerValue(TilingCVars.WindowFadeInactive)) {
             FadeWindows(WindowId);
         }
 
         BroadcastFocusedWindowFloating(Window);
         if (!AXLibHasFlags(Window, Window_Float)) {
-            UpdateCVar(CVAR_BSP_INSERTION_POINT, Window->Id);
+            UpdateCVar(TilingCVars.BspInsertionPoint, Window->Id);
         }
 
         if ((FocusedWindowId != WindowId) &&
-            (StringEquals(CVarStringValue(CVAR_MOUSE_FOLLOWS_FOCUS), Mouse_Follows_Focus_All))) {
+            (CVarStringEquals(TilingCVars.MouseFollowsFocus, Mouse_Follows_Focus_All))) {
             CenterMouseInWindow(Window);
         }
 
@@ -1158,7 +1228,7 @@ WindowDestroyedHandler(void *Data)
     macos_window *Copy = RemoveWindowFromCollection(Window);
     if (Copy) {
         if (AXLibHasFlags(Copy, Window_Float)) {
-            unsigned FocusedWindowId = CVarUnsignedValue(CVAR_FOCUSED_WINDOW);
+            unsigned FocusedWindowId = CVarUnsignedValue(TilingCVars.FocusedWindow);
             if (Copy->Id == FocusedWindowId) {
                 BroadcastFocusedWindowFloating();
             }
@@ -1170,7 +1240,7 @@ WindowDestroyedHandler(void *Data)
             RebalanceWindowTree();
             uint32_t FocusedWindow = GetFocusedWindowId();
             if (FocusedWindow) {
-                UpdateCVar(CVAR_FOCUSED_WINDOW, FocusedWindow);
+                UpdateCVar(TilingCVars.FocusedWindow, FocusedWindow);
             }
         }
 
@@ -1244,7 +1314,7 @@ WindowMovedHandler(void *Data)
         if (Copy->Position != Window->Position) {
             Copy->Position = Window->Position;
 
-            if (CVarIntegerValue(CVAR_WINDOW_REGION_LOCKED)) {
+            if (WatchedCVars.WindowRegionLocked) {
                 ConstrainWindowToRegion(Copy);
             }
         }
@@ -1263,7 +1333,7 @@ WindowResizedHandler(void *Data)
             Copy->Position = Window->Position;
             Copy->Size = Window->Size;
 
-            if (CVarIntegerValue(CVAR_WINDOW_REGION_LOCKED)) {
+            if (WatchedCVars.WindowRegionLocked) {
                 ConstrainWindowToRegion(Copy);
             }
         }
@@ -1305,10 +1375,10 @@ SpaceAndDisplayChangedHandler(void *Data)
     Success = AXLibCGSSpaceIDToDesktopID(Space->Id, NULL, &DesktopId);
     ASSERT(Success);
 
-    CachedDesktopId = CVarIntegerValue(CVAR_ACTIVE_DESKTOP);
+    CachedDesktopId = CVarIntegerValue(TilingCVars.ActiveDesktop);
     if (CachedDesktopId != DesktopId) {
-        UpdateCVar(CVAR_LAST_ACTIVE_DESKTOP, (int)CachedDesktopId);
-        UpdateCVar(CVAR_ACTIVE_DESKTOP, (int)DesktopId);
+        UpdateCVar(TilingCVars.LastActiveDesktop, (int)CachedDesktopId);
+        UpdateCVar(TilingCVars.ActiveDesktop, (int)DesktopId);
     }
 
     Windows = GetAllVisibleWindowsForSpace(Space);
@@ -1516,80 +1586,121 @@ ChunkwmDaemonCommandHandler(void *Data)
     CommandCallback(Payload->SockFD, Payload->Command, Payload->Message);
 }
 
+internal void
+EventsSubscribedHandler()
+{
+    /* NOTE(koekeishiya): Tile windows visible on the current space using configured mode */
+    CreateWindowTree();
+
+    /* NOTE(koekeishiya): Set our initial insertion-point on launch. */
+    uint32_t WindowId = GetFocusedWindowId();
+    if (WindowId) {
+        if (CVarIntegerValue(TilingCVars.WindowFadeInactive)) {
+            FadeWindows(WindowId);
+        }
+        WindowFocusedHandler(WindowId);
+    }
+}
+
 PLUGIN_MAIN_FUNC(PluginMain)
 {
-    if (StringEquals(Node, "chunkwm_export_application_launched")) {
-        ApplicationLaunchedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_terminated")) {
-        ApplicationTerminatedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_hidden")) {
-        ApplicationHiddenHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_unhidden")) {
-        ApplicationUnhiddenHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_application_activated")) {
-        ApplicationActivatedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_created")) {
-        WindowCreatedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_destroyed")) {
-        WindowDestroyedHandler(Data);
-        return true;
-    } else if(StringEquals(Node, "chunkwm_export_window_minimized")) {
-        WindowMinimizedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_deminimized")) {
-        WindowDeminimizedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_focused")) {
-        WindowFocusedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_moved")) {
-        WindowMovedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_resized")) {
-        WindowResizedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_window_title_changed")) {
-        WindowTitleChangedHandler(Data);
-        return true;
-    } else if ((StringEquals(Node, "chunkwm_export_space_changed")) ||
-               (StringEquals(Node, "chunkwm_export_display_changed"))) {
-        SpaceAndDisplayChangedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_display_resized")) {
-        DisplayResizedHandler(Data);
-        return true;
+    CHUNKWM_DISPATCH_BEGIN(Export)
+    CHUNKWM_DISPATCH(chunkwm_export_application_launched, ApplicationLaunchedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_terminated, ApplicationTerminatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_hidden, ApplicationHiddenHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_unhidden, ApplicationUnhiddenHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_application_activated, ApplicationActivatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_created, WindowCreatedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_destroyed, WindowDestroyedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_minimized, WindowMinimizedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_deminimized, WindowDeminimizedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_focused, WindowFocusedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_moved, WindowMovedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_resized, WindowResizedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_window_title_changed, WindowTitleChangedHandler(Data))
+    CHUNKWM_DISPATCH_CASE(chunkwm_export_space_changed)
+    CHUNKWM_DISPATCH(chunkwm_export_display_changed, SpaceAndDisplayChangedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_display_resized, DisplayResizedHandler(Data))
 #if 0
-    } else if (StringEquals(Node, "chunkwm_export_display_added")) {
-        DisplayAddedHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_export_display_removed")) {
-        DisplayRemovedHandler(Data);
-        return true;
+    CHUNKWM_DISPATCH(chunkwm_export_display_added, DisplayAddedHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_display_removed, DisplayRemovedHandler(Data))
 #endif
-    } else if (StringEquals(Node, "chunkwm_daemon_command")) {
-        ChunkwmDaemonCommandHandler(Data);
-        return true;
-    } else if (StringEquals(Node, "chunkwm_events_subscribed")) {
-        /* NOTE(koekeishiya): Tile windows visible on the current space using configured mode */
-        CreateWindowTree();
-
-        /* NOTE(koekeishiya): Set our initial insertion-point on launch. */
-        uint32_t WindowId = GetFocusedWindowId();
-        if (WindowId) {
-            if (CVarIntegerValue(CVAR_WINDOW_FADE_INACTIVE)) {
-                FadeWindows(WindowId);
-            }
-            WindowFocusedHandler(WindowId);
+    CHUNKWM_DISPATCH(chunkwm_export_daemon_command, ChunkwmDaemonCommandHandler(Data))
+    CHUNKWM_DISPATCH(chunkwm_export_events_subscribed, EventsSubscribedHandler())
+    CHUNKWM_DISPATCH_END()
+
+    return false;
+}
+
+// NOTE(koekeishiya): Flags set by the user through 'chunkc tiling::window', see 'PluginRestoreState'.
+internal void
+ApplyRestoredWindowFlags()
+{
+    pthread_mutex_lock(&WindowsLock);
+    for (size_t Index = 0; Index < RestoredWindowFlags.size(); ++Index) {
+        macos_window *Window = _GetWindowByID(RestoredWindowFlags[Index].Id);
+        if (Window) {
+            AXLibClearFlags(Window, RESTORED_WINDOW_FLAGS);
+            AXLibAddFlags(Window, RestoredWindowFlags[Index].Flags);
         }
     }
+    pthread_mutex_unlock(&WindowsLock);
 
-    return false;
+    RestoredWindowFlags.clear();
+}
+
+internal void
+ResolveTilingCVars()
+{
+    TilingCVars.SpaceMode = ResolveCVar(CVAR_SPACE_MODE);
+    TilingCVars.SpaceOffsetTop = ResolveCVar(CVAR_SPACE_OFFSET_TOP);
+    TilingCVars.SpaceOffsetBottom = ResolveCVar(CVAR_SPACE_OFFSET_BOTTOM);
+    TilingCVars.SpaceOffsetLeft = ResolveCVar(CVAR_SPACE_OFFSET_LEFT);
+    TilingCVars.SpaceOffsetRight = ResolveCVar(CVAR_SPACE_OFFSET_RIGHT);
+    TilingCVars.SpaceOffsetGap = ResolveCVar(CVAR_SPACE_OFFSET_GAP);
+    TilingCVars.BspSpawnLeft = ResolveCVar(CVAR_BSP_SPAWN_LEFT);
+    TilingCVars.BspOptimalRatio = ResolveCVar(CVAR_BSP_OPTIMAL_RATIO);
+    TilingCVars.BspSplitRatio = ResolveCVar(CVAR_BSP_SPLIT_RATIO);
+    TilingCVars.BspSplitMode = ResolveCVar(CVAR_BSP_SPLIT_MODE);
+    TilingCVars.MouseFollowsFocus = ResolveCVar(CVAR_MOUSE_FOLLOWS_FOCUS);
+    TilingCVars.WindowFloatNext = ResolveCVar(CVAR_WINDOW_FLOAT_NEXT);
+    TilingCVars.WindowRegionLocked = ResolveCVar(CVAR_WINDOW_REGION_LOCKED);
+    TilingCVars.PreselectBorderColor = ResolveCVar(CVAR_PRE_BORDER_COLOR);
+    TilingCVars.PreselectBorderWidth = ResolveCVar(CVAR_PRE_BORDER_WIDTH);
+    TilingCVars.PreselectBorderRadius = ResolveCVar(CVAR_PRE_BORDER_RADIUS);
+    TilingCVars.WindowFadeInactive = ResolveCVar(CVAR_WINDOW_FADE_INACTIVE);
+    TilingCVars.WindowFadeAlpha = ResolveCVar(CVAR_WINDOW_FADE_ALPHA);
+    TilingCVars.WindowFadeDuration = ResolveCVar(CVAR_WINDOW_FADE_DURATION);
+    TilingCVars.WindowCGSMove = ResolveCVar(CVAR_WINDOW_CGS_MOVE);
+    TilingCVars.FocusedWindow = ResolveCVar(CVAR_FOCUSED_WINDOW);
+    TilingCVars.BspInsertionPoint = ResolveCVar(CVAR_BSP_INSERTION_POINT);
+    TilingCVars.ActiveDesktop = ResolveCVar(CVAR_ACTIVE_DESKTOP);
+    TilingCVars.LastActiveDesktop = ResolveCVar(CVAR_LAST_ACTIVE_DESKTOP);
+}
+
+internal
+CHUNKWM_API_CVAR_WATCH_FUNC(TilingCVarChanged)
+{
+    if (CVar == TilingCVars.WindowRegionLocked) {
+        WatchedCVars.WindowRegionLocked = CVarIntegerValue(CVar);
+    } else if (CVar == TilingCVars.WindowCGSMove) {
+        WatchedCVars.WindowCGSMove = CVarIntegerValue(CVar);
+    } else {
+        VirtualSpaceConfigChanged(Name);
+    }
+}
+
+internal void
+WatchTilingCVars()
+{
+    TilingCVarChanged(CVAR_WINDOW_REGION_LOCKED, TilingCVars.WindowRegionLocked);
+    TilingCVarChanged(CVAR_WINDOW_CGS_MOVE, TilingCVars.WindowCGSMove);
+
+    if (!API.WatchCVar(PluginName, CVAR_WINDOW_REGION_LOCKED, TilingCVarChanged) ||
+        !API.WatchCVar(PluginName, CVAR_WINDOW_CGS_MOVE, TilingCVarChanged) ||
+        !API.WatchCVar(PluginName, "*_desktop_*", TilingCVarChanged)) {
+        c_log(C_LOG_LEVEL_WARN, "chunkwm-tiling: could not watch cvars, changes are not applied until restart!\n");
+    }
 }
 
 internal bool
@@ -1604,6 +1715,7 @@ Init(chunkwm_api ChunkwmAPI)
 
     API = ChunkwmAPI;
     c_log = API.Log;
+    FocusedWindowFloatTopic = API.InternTopic(PluginName, "focused_window_float");
     BeginCVars(&API);
 
     if (!AXLibDisplayHasSeparateSpaces()) {
@@ -1664,6 +1776,9 @@ Init(chunkwm_api ChunkwmAPI)
 
     /*   ---------------------------------------------------------   */
 
+    ResolveTilingCVars();
+    WatchTilingCVars();
+
     ProcessPolicy = Process_Policy_Regular;
     Applications = AXLibRunningProcesses(ProcessPolicy);
     for (size_t Index = 0; Index < Applications.size(); ++Index) {
@@ -1672,6 +1787,8 @@ Init(chunkwm_api ChunkwmAPI)
         AddApplicationWindowList(Application);
     }
 
+    ApplyRestoredWindowFlags();
+
     Success = AXLibActiveSpace(&Space);
     ASSERT(Success);
 
@@ -1680,13 +1797,16 @@ Init(chunkwm_api ChunkwmAPI)
 
     AXLibDestroySpace(Space);
 
-    UpdateCVar(CVAR_ACTIVE_DESKTOP, (int)DesktopId);
-    UpdateCVar(CVAR_LAST_ACTIVE_DESKTOP, (int)DesktopId);
+    UpdateCVar(TilingCVars.ActiveDesktop, (int)DesktopId);
+    UpdateCVar(TilingCVars.LastActiveDesktop, (int)DesktopId);
 
     Success = BeginVirtualSpaces();
     if (Success) {
-        bool MouseMoveBound = BindMouseMoveAction(CVarStringValue(CVAR_MOUSE_MOVE_BINDING));
-        bool MouseResizeBound = BindMouseResizeAction(CVarStringValue(CVAR_MOUSE_RESIZE_BINDING));
+        char Binding[CVAR_STRING_SIZE];
+        CVarStringValue(CVAR_MOUSE_MOVE_BINDING, Binding, sizeof(Binding));
+        bool MouseMoveBound = BindMouseMoveAction(Binding);
+        CVarStringValue(CVAR_MOUSE_RESIZE_BINDING, Binding, sizeof(Binding));
+        bool MouseResizeBound = BindMouseResizeAction(Binding);
         if (MouseMoveBound || MouseResizeBound) {
             EventTap.Mask = ((1 << kCGEventLeftMouseDown) |
                              (1 << kCGEventLeftMouseDragged) |
@@ -1696,6 +1816,7 @@ Init(chunkwm_api ChunkwmAPI)
                              (1 << kCGEventRightMouseUp));
             BeginEventTap(&EventTap, &EventTapCallback);
         }
+        API.RegisterMethod(PluginName, TILING_METHOD_DESKTOP_LAYOUT, DesktopLayoutMethod);
         goto out;
     }
 
@@ -1731,7 +1852,87 @@ PLUGIN_VOID_FUNC(PluginDeInit)
     Deinit();
 }
 
-CHUNKWM_PLUGIN_VTABLE(PluginInit, PluginDeInit, PluginMain)
+/*
+ * NOTE(koekeishiya): When an application launches or the space changes, we receive many
+ * events in a row. Handle them in order, but resize the windows of a space only once.
+ */
+PLUGIN_BATCH_FUNC(PluginMainBatch)
+{
+    DeferNodeRegions = true;
+    for (uint32_t Index = 0; Index < Count; ++Index) {
+        chunkwm_event *Event = Events + Index;
+        PluginMain(Event->Export, Event->Topic, Event->Node, Event->Data);
+    }
+    DeferNodeRegions = false;
+
+    ApplyDeferredNodeRegions();
+}
+
+/*
+ * NOTE(koekeishiya): The window trees of every space and the flags of windows are handed to
+ * the next instance when the plugin is reloaded, so that the layout survives a rebuild.
+ * Called before 'PluginDeInit'.
+ */
+PLUGIN_SAVE_STATE_FUNC(PluginSaveState)
+{
+    state_buffer Buffer = {};
+    WriteStateU32(&Buffer, STATE_MAGIC);
+    WriteStateU32(&Buffer, STATE_VERSION);
+
+    pthread_mutex_lock(&WindowsLock);
+    std::vector<restored_window_flags> Flags;
+    for (macos_window_map_it It = Windows.begin(); It != Windows.end(); ++It) {
+        uint32_t WindowFlags = It->second->Flags & RESTORED_WINDOW_FLAGS;
+        if (WindowFlags) {
+            restored_window_flags Entry = { It->first, WindowFlags };
+            Flags.push_back(Entry);
+        }
+    }
+    pthread_mutex_unlock(&WindowsLock);
+
+    WriteStateU32(&Buffer, Flags.size());
+    for (size_t Index = 0; Index < Flags.size(); ++Index) {
+        WriteState(&Buffer, &Flags[Index], sizeof(restored_window_flags));
+    }
+
+    WriteVirtualSpacesState(&Buffer);
+
+    State->Data = Buffer.Data;
+    State->Size = Buffer.Size;
+    return true;
+}
+
+// NOTE(koekeishiya): Called before 'PluginInit'; nothing is applied until a space is acquired.
+PLUGIN_RESTORE_STATE_FUNC(PluginRestoreState)
+{
+    state_buffer Buffer = {};
+    Buffer.Data = (char *) State->Data;
+    Buffer.Size = State->Size;
+
+    if ((ReadStateU32(&Buffer) != STATE_MAGIC) ||
+        (ReadStateU32(&Buffer) != STATE_VERSION)) {
+        return false;
+    }
+
+    uint32_t Count = ReadStateU32(&Buffer);
+    for (uint32_t Index = 0; !Buffer.Failed && Index < Count; ++Index) {
+        restored_window_flags Flags;
+        if (ReadState(&Buffer, &Flags, sizeof(restored_window_flags))) {
+            RestoredWindowFlags.push_back(Flags);
+        }
+    }
+
+    if ((Buffer.Failed) ||
+        (!ReadVirtualSpacesState(&Buffer))) {
+        RestoredWindowFlags.clear();
+        return false;
+    }
+
+    return true;
+}
+
+CHUNKWM_PLUGIN_VTABLE_BATCH(PluginInit, PluginDeInit, PluginMain, PluginMainBatch)
+CHUNKWM_PLUGIN_STATE(PluginSaveState, PluginRestoreState)
 chunkwm_plugin_export Subscriptions[] =
 {
     chunkwm_export_application_launched,
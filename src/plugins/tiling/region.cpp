@@ -70,10 +70,14 @@ void ConstrainRegion(CFStringRef DisplayRef, region *Region)
 }
 
 internal region
-FullscreenRegion(CFStringRef DisplayRef, virtual_space *VirtualSpace)
+FullscreenRegion(macos_space *Space, virtual_space *VirtualSpace)
 {
+    CFStringRef DisplayRef = AXLibGetDisplayIdentifierFromSpace(Space->Id);
+    ASSERT(DisplayRef);
+
     region Result = CGRectToRegion(AXLibGetDisplayBounds(DisplayRef));
     ConstrainRegion(DisplayRef, &Result);
+    CFRelease(DisplayRef);
 
     region_offset *Offset = VirtualSpace->Offset;
     if (Offset) {
@@ -172,15 +176,16 @@ LowerHorizontalRegion(node *Node, virtual_space *VirtualSpace)
     return Result;
 }
 
+/*
+ * NOTE(koekeishiya): Only the full region depends on the display, a split region is computed
+ * from the region of its parent. The display is not looked up for every node of a tree.
+ */
 void CreateNodeRegion(node *Node, region_type Type, macos_space *Space, virtual_space *VirtualSpace)
 {
     ASSERT(Type >= Region_Full && Type <= Region_Lower);
 
-    CFStringRef DisplayRef = AXLibGetDisplayIdentifierFromSpace(Space->Id);
-    ASSERT(DisplayRef);
-
     switch (Type) {
-    case Region_Full:   { Node->Region = FullscreenRegion(DisplayRef, VirtualSpace);        } break;
+    case Region_Full:   { Node->Region = FullscreenRegion(Space, VirtualSpace);             } break;
     case Region_Left:   { Node->Region = LeftVerticalRegion(Node->Parent, VirtualSpace);    } break;
     case Region_Right:  { Node->Region = RightVerticalRegion(Node->Parent, VirtualSpace);   } break;
     case Region_Upper:  { Node->Region = UpperHorizontalRegion(Node->Parent, VirtualSpace); } break;
@@ -189,18 +194,14 @@ void CreateNodeRegion(node *Node, region_type Type, macos_space *Space, virtual_
     }
 
     Node->Region.Type = Type;
-    CFRelease(DisplayRef);
 }
 
 void CreatePreselectRegion(preselect_node *Preselect, region_type Type, macos_space *Space, virtual_space *VirtualSpace)
 {
     ASSERT(Type >= Region_Full && Type <= Region_Lower);
 
-    CFStringRef DisplayRef = AXLibGetDisplayIdentifierFromSpace(Space->Id);
-    ASSERT(DisplayRef);
-
     switch (Type) {
-    case Region_Full:   { Preselect->Region = FullscreenRegion(DisplayRef, VirtualSpace);           } break;
+    case Region_Full:   { Preselect->Region = FullscreenRegion(Space, VirtualSpace);                } break;
     case Region_Left:   { Preselect->Region = LeftVerticalRegion(Preselect->Node, VirtualSpace);    } break;
     case Region_Right:  { Preselect->Region = RightVerticalRegion(Preselect->Node, VirtualSpace);   } break;
     case Region_Upper:  { Preselect->Region = UpperHorizontalRegion(Preselect->Node, VirtualSpace); } break;
@@ -209,7 +210,6 @@ void CreatePreselectRegion(preselect_node *Preselect, region_type Type, macos_sp
     }
 
     Preselect->Region.Type = Type;
-    CFRelease(DisplayRef);
 }
 
 internal void
@@ -0,0 +1,91 @@
+#ifndef PLUGIN_STATE_H
+#define PLUGIN_STATE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * NOTE(koekeishiya): The state that is handed to the next instance of the plugin when it is
+ * reloaded, see 'PluginSaveState'. The buffer never leaves the process, so values are written
+ * as they are in memory. Reading past the end marks the buffer as failed and yields zeroes.
+ */
+#define STATE_MAGIC 0x676e6974
+#define STATE_VERSION 1
+
+struct state_buffer
+{
+    char *Data;
+    size_t Size;
+    size_t Capacity;
+    size_t Cursor;
+    bool Failed;
+};
+
+inline void
+WriteState(state_buffer *Buffer, const void *Value, size_t Size)
+{
+    if (Buffer->Size + Size > Buffer->Capacity) {
+        Buffer->Capacity = 2 * (Buffer->Size + Size);
+        Buffer->Data = (char *) realloc(Buffer->Data, Buffer->Capacity);
+    }
+
+    memcpy(Buffer->Data + Buffer->Size, Value, Size);
+    Buffer->Size += Size;
+}
+
+inline bool
+ReadState(state_buffer *Buffer, void *Value, size_t Size)
+{
+    if ((Buffer->Failed) ||
+        (Buffer->Cursor + Size > Buffer->Size)) {
+        Buffer->Failed = true;
+        memset(Value, 0, Size);
+        return false;
+    }
+
+    memcpy(Value, Buffer->Data + Buffer->Cursor, Size);
+    Buffer->Cursor += Size;
+    return true;
+}
+
+inline void
+WriteStateU32(state_buffer *Buffer, uint32_t Value)
+{
+    WriteState(Buffer, &Value, sizeof(uint32_t));
+}
+
+inline uint32_t
+ReadStateU32(state_buffer *Buffer)
+{
+    uint32_t Value;
+    ReadState(Buffer, &Value, sizeof(uint32_t));
+    return Value;
+}
+
+inline void
+WriteStateString(state_buffer *Buffer, const char *String)
+{
+    uint32_t Length = strlen(String);
+    WriteStateU32(Buffer, Length);
+    WriteState(Buffer, String, Length);
+}
+
+// NOTE(koekeishiya): Caller is responsible for memory, NULL if the buffer failed.
+inline char *
+ReadStateString(state_buffer *Buffer)
+{
+    uint32_t Length = ReadStateU32(Buffer);
+    if ((Buffer->Failed) ||
+        (Buffer->Cursor + Length > Buffer->Size)) {
+        Buffer->Failed = true;
+        return NULL;
+    }
+
+    char *Result = (char *) malloc(Length + 1);
+    ReadState(Buffer, Result, Length);
+    Result[Length] = '\0';
+    return Result;
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "node.h"
 #include "constants.h"
 #include "misc.h"
+#include "state.h"
 
 #include "../../common/accessibility/element.h"
 #include "../../common/accessibility/display.h"
@@ -9,14 +10,34 @@
 #include "../../common/config/cvar.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 
+#include <vector>
+
 #define internal static
 #define local_persist static
 
+extern macos_window *GetWindowByID(uint32_t Id);
+
 internal virtual_space_map VirtualSpaces;
 internal pthread_mutex_t VirtualSpacesLock;
 
+/*
+ * NOTE(koekeishiya): Virtual spaces handed over by the previous instance of the plugin, see
+ * 'ReadVirtualSpacesState'. They are taken over when the space is first acquired.
+ */
+struct restored_virtual_space
+{
+    virtual_space_mode Mode;
+    region_offset Offset;
+    bool HasOffset;
+    uint32_t Flags;
+    node *Tree;
+};
+
+internal std::map<const char *, restored_virtual_space, string_comparator> RestoredVirtualSpaces;
+
 internal virtual_space_mode
 VirtualSpaceModeFromString(char *Value)
 {
@@ -29,40 +50,119 @@ VirtualSpaceModeFromString(char *Value)
     return Virtual_Space_Bsp;
 }
 
-internal virtual_space_config
-GetVirtualSpaceConfig(unsigned SpaceIndex)
+/*
+ * NOTE(koekeishiya): The effective config of each desktop, indexed by desktop id. An entry is
+ * compiled from the cvars of the desktop, e.g. '3_desktop_offset_top', falling back to the
+ * global cvars, the first time it is needed. It is compiled again after one of those cvars has
+ * changed, see 'VirtualSpaceConfigChanged'. Desktop ids at or above VIRTUAL_SPACE_CONFIG_MAX
+ * are compiled every time instead of growing the table.
+ */
+#define VIRTUAL_SPACE_CONFIG_MAX 256
+struct virtual_space_config_entry
 {
     virtual_space_config Config;
+    bool Valid;
+};
+
+internal std::vector<virtual_space_config_entry> VirtualSpaceConfigs;
+internal pthread_mutex_t VirtualSpaceConfigsLock;
 
-    char KeyMode[BUFFER_SIZE];
-    snprintf(KeyMode, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_MODE);
-    Config.Mode = CVarExists(KeyMode) ? VirtualSpaceModeFromString(CVarStringValue(KeyMode))
-                                      : VirtualSpaceModeFromString(CVarStringValue(CVAR_SPACE_MODE));
-    char KeyTop[BUFFER_SIZE];
-    snprintf(KeyTop, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_OFFSET_TOP);
-    Config.Offset.Top = CVarExists(KeyTop) ? CVarFloatingPointValue(KeyTop)
-                                           : CVarFloatingPointValue(CVAR_SPACE_OFFSET_TOP);
-    char KeyBottom[BUFFER_SIZE];
-    snprintf(KeyBottom, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_OFFSET_BOTTOM);
-    Config.Offset.Bottom = CVarExists(KeyBottom) ? CVarFloatingPointValue(KeyBottom)
-                                                 : CVarFloatingPointValue(CVAR_SPACE_OFFSET_BOTTOM);
-    char KeyLeft[BUFFER_SIZE];
-    snprintf(KeyLeft, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_OFFSET_LEFT);
-    Config.Offset.Left = CVarExists(KeyLeft) ? CVarFloatingPointValue(KeyLeft)
-                                             : CVarFloatingPointValue(CVAR_SPACE_OFFSET_LEFT);
-    char KeyRight[BUFFER_SIZE];
-    snprintf(KeyRight, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_OFFSET_RIGHT);
-    Config.Offset.Right = CVarExists(KeyRight) ? CVarFloatingPointValue(KeyRight)
-                                               : CVarFloatingPointValue(CVAR_SPACE_OFFSET_RIGHT);
-    char KeyGap[BUFFER_SIZE];
-    snprintf(KeyGap, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_OFFSET_GAP);
-    Config.Offset.Gap = CVarExists(KeyGap) ? CVarFloatingPointValue(KeyGap)
-                                           : CVarFloatingPointValue(CVAR_SPACE_OFFSET_GAP);
-    char KeyTree[BUFFER_SIZE];
-    snprintf(KeyTree, BUFFER_SIZE, "%d_%s", SpaceIndex, _CVAR_SPACE_TREE);
-    Config.TreeLayout = CVarExists(KeyTree) ? CVarStringValue(KeyTree)
-                                            : NULL;
-    return Config;
+internal cvar *
+ResolveVirtualSpaceCVar(unsigned DesktopId, const char *Key, cvar *Global)
+{
+    char Name[BUFFER_SIZE];
+    snprintf(Name, BUFFER_SIZE, "%d_%s", DesktopId, Key);
+    cvar *Result = ResolveCVar(Name);
+    return Result ? Result : Global;
+}
+
+internal void
+CompileVirtualSpaceConfig(unsigned DesktopId, virtual_space_config *Config)
+{
+    cvar *Mode = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_MODE, TilingCVars.SpaceMode);
+    char ModeString[CVAR_STRING_SIZE];
+    CVarStringValue(Mode, ModeString, sizeof(ModeString));
+    Config->Mode = VirtualSpaceModeFromString(ModeString);
+
+    cvar *Top = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_OFFSET_TOP, TilingCVars.SpaceOffsetTop);
+    Config->Offset.Top = CVarFloatingPointValue(Top);
+
+    cvar *Bottom = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_OFFSET_BOTTOM, TilingCVars.SpaceOffsetBottom);
+    Config->Offset.Bottom = CVarFloatingPointValue(Bottom);
+
+    cvar *Left = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_OFFSET_LEFT, TilingCVars.SpaceOffsetLeft);
+    Config->Offset.Left = CVarFloatingPointValue(Left);
+
+    cvar *Right = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_OFFSET_RIGHT, TilingCVars.SpaceOffsetRight);
+    Config->Offset.Right = CVarFloatingPointValue(Right);
+
+    cvar *Gap = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_OFFSET_GAP, TilingCVars.SpaceOffsetGap);
+    Config->Offset.Gap = CVarFloatingPointValue(Gap);
+
+    cvar *Tree = ResolveVirtualSpaceCVar(DesktopId, _CVAR_SPACE_TREE, NULL);
+    char TreeLayout[PATH_MAX];
+    Config->TreeLayout = (Tree && CVarStringValue(Tree, TreeLayout, sizeof(TreeLayout))) ? strdup(TreeLayout) : NULL;
+}
+
+// NOTE(koekeishiya): The tree layout of the returned config is a copy, see 'FreeVirtualSpaceConfig'.
+virtual_space_config GetVirtualSpaceConfig(unsigned DesktopId)
+{
+    if (DesktopId >= VIRTUAL_SPACE_CONFIG_MAX) {
+        virtual_space_config Result = {};
+        CompileVirtualSpaceConfig(DesktopId, &Result);
+        return Result;
+    }
+
+    pthread_mutex_lock(&VirtualSpaceConfigsLock);
+
+    if (DesktopId >= VirtualSpaceConfigs.size()) {
+        VirtualSpaceConfigs.resize(DesktopId + 1);
+    }
+
+    virtual_space_config_entry *Entry = &VirtualSpaceConfigs[DesktopId];
+    if (!Entry->Valid) {
+        FreeVirtualSpaceConfig(&Entry->Config);
+        CompileVirtualSpaceConfig(DesktopId, &Entry->Config);
+        Entry->Valid = true;
+    }
+
+    virtual_space_config Result = Entry->Config;
+    Result.TreeLayout = Result.TreeLayout ? strdup(Result.TreeLayout) : NULL;
+
+    pthread_mutex_unlock(&VirtualSpaceConfigsLock);
+    return Result;
+}
+
+void FreeVirtualSpaceConfig(virtual_space_config *Config)
+{
+    if (Config->TreeLayout) {
+        free(Config->TreeLayout);
+        Config->TreeLayout = NULL;
+    }
+}
+
+/*
+ * NOTE(koekeishiya): Called when a cvar that matches '*_desktop_*' changes. A cvar of a desktop
+ * invalidates the entry of that desktop, and a global cvar invalidates every entry, as they may
+ * fall back to it. Virtual spaces that already exist keep their config, the same as before.
+ */
+void VirtualSpaceConfigChanged(const char *Name)
+{
+    char *End;
+    unsigned long DesktopId = strtoul(Name, &End, 10);
+    bool Desktop = (End != Name) && (*End == '_');
+    bool Global = strncmp(Name, "global_", strlen("global_")) == 0;
+    if (!Desktop && !Global) return;
+
+    pthread_mutex_lock(&VirtualSpaceConfigsLock);
+    if (Global) {
+        for (size_t Index = 0; Index < VirtualSpaceConfigs.size(); ++Index) {
+            VirtualSpaceConfigs[Index].Valid = false;
+        }
+    } else if (DesktopId < VirtualSpaceConfigs.size()) {
+        VirtualSpaceConfigs[DesktopId].Valid = false;
+    }
+    pthread_mutex_unlock(&VirtualSpaceConfigsLock);
 }
 
 internal virtual_space *
@@ -115,6 +215,131 @@ void VirtualSpaceClearFlags(virtual_space *VirtualSpace, uint32_t Flag)
     VirtualSpace->Flags &= ~Flag;
 }
 
+// NOTE(koekeishiya): A tree that refers to a window that no longer exists is not taken over.
+internal bool
+IsRestoredTreeValid(node *Tree, virtual_space_mode Mode)
+{
+    if (!Tree) return true;
+
+    if ((Tree->WindowId != Node_Root) &&
+        (Tree->WindowId != (uint32_t) Node_PseudoLeaf) &&
+        (!GetWindowByID(Tree->WindowId))) {
+        return false;
+    }
+
+    if (Mode == Virtual_Space_Bsp) {
+        return IsRestoredTreeValid(Tree->Left, Mode) && IsRestoredTreeValid(Tree->Right, Mode);
+    } else {
+        return IsRestoredTreeValid(Tree->Right, Mode);
+    }
+}
+
+internal void
+FreeRestoredVirtualSpace(restored_virtual_space *Restored)
+{
+    if (Restored->Tree) {
+        FreeNodeTree(Restored->Tree, Restored->Mode);
+    }
+}
+
+// NOTE(koekeishiya): Must be called with 'VirtualSpacesLock' held.
+internal void
+TakeRestoredVirtualSpace(const char *SpaceCRef, virtual_space *VirtualSpace)
+{
+    std::map<const char *, restored_virtual_space, string_comparator>::iterator It = RestoredVirtualSpaces.find(SpaceCRef);
+    if (It == RestoredVirtualSpaces.end()) {
+        return;
+    }
+
+    restored_virtual_space *Restored = &It->second;
+    VirtualSpace->Mode = Restored->Mode;
+    VirtualSpace->_Offset = Restored->Offset;
+    VirtualSpace->Offset = Restored->HasOffset ? &VirtualSpace->_Offset : NULL;
+    VirtualSpace->Flags = Restored->Flags;
+
+    if (IsRestoredTreeValid(Restored->Tree, Restored->Mode)) {
+        VirtualSpace->Tree = Restored->Tree;
+    } else {
+        FreeRestoredVirtualSpace(Restored);
+    }
+
+    free((char *) It->first);
+    RestoredVirtualSpaces.erase(It);
+}
+
+void WriteVirtualSpacesState(state_buffer *Buffer)
+{
+    pthread_mutex_lock(&VirtualSpacesLock);
+    WriteStateU32(Buffer, VirtualSpaces.size());
+
+    for (virtual_space_map_it It = VirtualSpaces.begin(); It != VirtualSpaces.end(); ++It) {
+        virtual_space *VirtualSpace = It->second;
+        pthread_mutex_lock(&VirtualSpace->Lock);
+
+        WriteStateString(Buffer, It->first);
+        WriteStateU32(Buffer, VirtualSpace->Mode);
+        WriteState(Buffer, &VirtualSpace->_Offset, sizeof(region_offset));
+        WriteStateU32(Buffer, VirtualSpace->Offset != NULL);
+        WriteStateU32(Buffer, VirtualSpace->Flags);
+
+        WriteStateU32(Buffer, VirtualSpace->Tree != NULL);
+        if (VirtualSpace->Tree) {
+            WriteNodeTreeState(Buffer, VirtualSpace->Tree, VirtualSpace->Mode);
+        }
+
+        pthread_mutex_unlock(&VirtualSpace->Lock);
+    }
+
+    pthread_mutex_unlock(&VirtualSpacesLock);
+}
+
+// NOTE(koekeishiya): Called before 'BeginVirtualSpaces', so nothing else can be running yet.
+bool ReadVirtualSpacesState(state_buffer *Buffer)
+{
+    uint32_t Count = ReadStateU32(Buffer);
+    for (uint32_t Index = 0; !Buffer->Failed && Index < Count; ++Index) {
+        char *SpaceCRef = ReadStateString(Buffer);
+
+        restored_virtual_space Restored = {};
+        Restored.Mode = (virtual_space_mode) ReadStateU32(Buffer);
+        ReadState(Buffer, &Restored.Offset, sizeof(region_offset));
+        Restored.HasOffset = ReadStateU32(Buffer);
+        Restored.Flags = ReadStateU32(Buffer);
+
+        if ((Buffer->Failed) ||
+            (Restored.Mode > Virtual_Space_Float) ||
+            (RestoredVirtualSpaces.find(SpaceCRef) != RestoredVirtualSpaces.end())) {
+            Buffer->Failed = true;
+        } else if (ReadStateU32(Buffer)) {
+            Restored.Tree = ReadNodeTreeState(Buffer, Restored.Mode);
+        }
+
+        if (Buffer->Failed) {
+            FreeRestoredVirtualSpace(&Restored);
+            free(SpaceCRef);
+        } else {
+            RestoredVirtualSpaces[SpaceCRef] = Restored;
+        }
+    }
+
+    if (Buffer->Failed) {
+        FreeRestoredVirtualSpaces();
+    }
+
+    return !Buffer->Failed;
+}
+
+void FreeRestoredVirtualSpaces()
+{
+    std::map<const char *, restored_virtual_space, string_comparator>::iterator It;
+    for (It = RestoredVirtualSpaces.begin(); It != RestoredVirtualSpaces.end(); ++It) {
+        FreeRestoredVirtualSpace(&It->second);
+        free((char *) It->first);
+    }
+
+    RestoredVirtualSpaces.clear();
+}
+
 // NOTE(koekeishiya): If the requested space does not exist, we create it.
 virtual_space *AcquireVirtualSpace(macos_space *Space)
 {
@@ -130,6 +355,7 @@ virtual_space *AcquireVirtualSpace(macos_space *Space)
         free(SpaceCRef);
     } else {
         VirtualSpace = CreateAndInitVirtualSpace(Space);
+        TakeRestoredVirtualSpace(SpaceCRef, VirtualSpace);
         VirtualSpaces[SpaceCRef] = VirtualSpace;
     }
     pthread_mutex_unlock(&VirtualSpacesLock);
@@ -145,7 +371,8 @@ void ReleaseVirtualSpace(virtual_space *VirtualSpace)
 
 bool BeginVirtualSpaces()
 {
-    return pthread_mutex_init(&VirtualSpacesLock, NULL) == 0;
+    return ((pthread_mutex_init(&VirtualSpacesLock, NULL) == 0) &&
+            (pthread_mutex_init(&VirtualSpaceConfigsLock, NULL) == 0));
 }
 
 void EndVirtualSpaces()
@@ -157,13 +384,25 @@ void EndVirtualSpaces()
             FreeNodeTree(VirtualSpace->Tree, VirtualSpace->Mode);
         }
 
+        if (VirtualSpace->TreeLayout) {
+            free(VirtualSpace->TreeLayout);
+        }
+
         pthread_mutex_destroy(&VirtualSpace->Lock);
         free(VirtualSpace);
         free((char *) It->first);
     }
 
     VirtualSpaces.clear();
+    FreeRestoredVirtualSpaces();
     pthread_mutex_destroy(&VirtualSpacesLock);
+
+    for (size_t Index = 0; Index < VirtualSpaceConfigs.size(); ++Index) {
+        FreeVirtualSpaceConfig(&VirtualSpaceConfigs[Index].Config);
+    }
+
+    VirtualSpaceConfigs.clear();
+    pthread_mutex_destroy(&VirtualSpaceConfigsLock);
 }
 
 void VirtualSpaceRecreateRegions(macos_space *Space, virtual_space *VirtualSpace)
@@ -60,6 +60,15 @@ void VirtualSpaceClearFlags(virtual_space *VirtualSpace, uint32_t Flag);
 virtual_space *AcquireVirtualSpace(macos_space *Space);
 void ReleaseVirtualSpace(virtual_space *VirtualSpace);
 
+struct state_buffer;
+void WriteVirtualSpacesState(state_buffer *Buffer);
+bool ReadVirtualSpacesState(state_buffer *Buffer);
+void FreeRestoredVirtualSpaces();
+
+virtual_space_config GetVirtualSpaceConfig(unsigned DesktopId);
+void FreeVirtualSpaceConfig(virtual_space_config *Config);
+void VirtualSpaceConfigChanged(const char *Name);
+
 void VirtualSpaceRecreateRegions(macos_space *Space, virtual_space *VirtualSpace);
 void VirtualSpaceUpdateRegions(virtual_space *VirtualSpace);
 
@@ -0,0 +1,707 @@
+/*
+ * NOTE(koekeishiya): Replays an event trace recorded with 'chunkc core::trace start <file>'
+ * against a set of plugins, without a window server. Windows and applications are rebuilt
+ * from the snapshots in the trace, and the accessibility API is replaced by the stubs in
+ * ./stub. Events are dispatched through the same plugin lists and work-queue as the core,
+ * either as fast as possible or at the pacing they were recorded with.
+ *
+ *   make && ./bin/replay [-r] [-t threads] <trace> <plugin.so>..
+ *   make && ./bin/replay -g <events> <trace>
+ */
+
+#define CHUNKWM_CORE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <map>
+#include <vector>
+
+#include "../core/constants.h"
+#include "../core/clog.h"
+#include "../core/clog.c"
+
+#include "../core/histogram.cpp"
+#include "../core/trace.cpp"
+#include "../core/dispatch/ring.cpp"
+#include "../core/dispatch/event.cpp"
+#include "../core/wakeup.cpp"
+#include "../core/pool.cpp"
+#include "../core/epoch.cpp"
+
+#include "../common/accessibility/application.h"
+#include "../common/accessibility/window.h"
+#include "../common/misc/timer.h"
+
+#define internal static
+
+struct plugin_payload;
+plugin_payload *CreatePluginPayloadCopy(void *Data, size_t Size, void *Context);
+
+internal std::vector<plugin_payload *> Broadcasts;
+internal pthread_mutex_t BroadcastLock;
+
+uint32_t InternTopic(const char *Plugin, const char *Event);
+void ChunkwmBroadcastTopic(uint32_t Topic, void *Data, size_t Size);
+
+// NOTE(koekeishiya): Same semantics as 'ChunkwmBroadcast' in the core, see callback.cpp.
+void ChunkwmBroadcast(const char *PluginName, const char *EventName,
+                      void *PluginData, size_t Size)
+{
+    if (!PluginName || !EventName) {
+        return;
+    }
+
+    ChunkwmBroadcastTopic(InternTopic(PluginName, EventName), PluginData, Size);
+}
+
+void ChunkwmBroadcastTopic(uint32_t Topic, void *Data, size_t Size)
+{
+    if (!Topic) {
+        return;
+    }
+
+    plugin_payload *Payload = CreatePluginPayloadCopy(Data, Size, (void *) (uintptr_t) Topic);
+
+    pthread_mutex_lock(&BroadcastLock);
+    Broadcasts.push_back(Payload);
+    pthread_mutex_unlock(&BroadcastLock);
+}
+
+#include "../core/mailbox.cpp"
+#include "../core/filter.cpp"
+#include "../core/method.cpp"
+#include "../core/watch.cpp"
+#include "../core/plugin.cpp"
+#include "../core/shmring.cpp"
+#include "../core/host.cpp"
+#include "../core/cvar.cpp"
+#include "../common/config/cvar.cpp"
+#include "../common/ipc/daemon.cpp"
+#include "./stub/element.cpp"
+
+#define REPLAY_BROADCAST_EXPORT chunkwm_export_plugin_broadcast
+
+struct replay_plugin
+{
+    const char *Name;
+    latency_histogram Exports[REPLAY_BROADCAST_EXPORT + 1];
+    uint64_t volatile Total[REPLAY_BROADCAST_EXPORT + 1];
+};
+
+struct replay_work
+{
+    replay_plugin *Stats;
+    plugin *Plugin;
+    bool Legacy;
+    chunkwm_plugin_export Export;
+    uint32_t Topic;
+    const char *Node;
+    void *Data;
+};
+
+internal std::map<plugin *, replay_plugin *> ReplayPlugins;
+internal std::map<pid_t, macos_application *> Applications;
+internal std::map<uint32_t, macos_window *> Windows;
+
+internal thread_pool Pool;
+internal int ThreadCount = -1;
+
+internal
+THREAD_POOL_CALLBACK(ReplayWorkCallback)
+{
+    replay_work *Work = (replay_work *) Data;
+
+    uint64_t Begin = GetTimeNanoseconds();
+    RunPlugin(Work->Plugin, Work->Legacy, Work->Export, Work->Topic, Work->Node, Work->Data);
+    uint64_t Elapsed = GetTimeNanoseconds() - Begin;
+
+    HistogramRecord(Work->Stats->Exports + Work->Export, Elapsed);
+    __sync_fetch_and_add(Work->Stats->Total + Work->Export, Elapsed);
+}
+
+internal void
+RunWork(replay_work *WorkArray, int WorkCount)
+{
+    task_group Group = {};
+    for (int Index = 0; Index < WorkCount; ++Index) {
+        ThreadPoolSubmit(&Pool, &Group, &ReplayWorkCallback, WorkArray + Index);
+    }
+
+    ThreadPoolWait(&Pool, &Group);
+}
+
+/*
+ * NOTE(koekeishiya): Mirrors 'PostPluginList' in callback.cpp, but waits for every plugin
+ * before the next event is replayed instead of posting to their mailboxes, so that the
+ * time spent per export is measured without the time an event waited in a mailbox.
+ */
+internal void
+DispatchExport(chunkwm_plugin_export Export, void *Data)
+{
+    uint64_t Epoch;
+    plugin_list *List = BeginPluginList(Export, &Epoch);
+    replay_work WorkArray[List->Count];
+    int WorkCount = 0;
+
+    for (uint32_t Index = 0; Index < List->Count; ++Index) {
+        plugin_subscriber *Subscriber = List->Subscribers + Index;
+        if (Subscriber->Filter && !PluginFilterAccepts(Subscriber->Filter, Export, Data)) {
+            continue;
+        }
+
+        replay_work *Work = WorkArray + WorkCount++;
+        Work->Stats = ReplayPlugins[Subscriber->Plugin];
+        Work->Plugin = Subscriber->Plugin;
+        Work->Legacy = Subscriber->Mailbox->Legacy;
+        Work->Export = Export;
+        Work->Topic = 0;
+        Work->Node = chunkwm_plugin_export_str[Export];
+        Work->Data = Data;
+    }
+
+    EndPluginList(Epoch);
+    RunWork(WorkArray, WorkCount);
+}
+
+internal void
+AddBroadcastWork(replay_work *Work, plugin_subscriber *Subscriber, uint32_t Topic, plugin_payload *Payload)
+{
+    Work->Stats = ReplayPlugins[Subscriber->Plugin];
+    Work->Plugin = Subscriber->Plugin;
+    Work->Legacy = Subscriber->Mailbox->Legacy;
+    Work->Export = REPLAY_BROADCAST_EXPORT;
+    Work->Topic = Topic;
+    Work->Node = TopicName(Topic);
+    Work->Data = Payload->Data;
+}
+
+// NOTE(koekeishiya): Mirrors 'Callback_ChunkWM_PluginBroadcast' in callback.cpp.
+internal void
+DispatchBroadcasts()
+{
+    for (;;) {
+        pthread_mutex_lock(&BroadcastLock);
+        std::vector<plugin_payload *> Pending;
+        Pending.swap(Broadcasts);
+        pthread_mutex_unlock(&BroadcastLock);
+
+        if (Pending.empty()) break;
+
+        for (size_t Index = 0; Index < Pending.size(); ++Index) {
+            plugin_payload *Payload = Pending[Index];
+            uint32_t Topic = (uint32_t) (uintptr_t) Payload->Context;
+            const char *Node = TopicName(Topic);
+
+            uint64_t TopicEpoch, LoadedEpoch;
+            plugin_list *TopicList = BeginTopicList(Topic, &TopicEpoch);
+            plugin_list *LoadedList = BeginPluginList(chunkwm_export_plugin_broadcast, &LoadedEpoch);
+
+            replay_work WorkArray[TopicList->Count + LoadedList->Count];
+            int WorkCount = 0;
+
+            for (uint32_t Index = 0; Index < TopicList->Count; ++Index) {
+                AddBroadcastWork(WorkArray + WorkCount++, TopicList->Subscribers + Index, Topic, Payload);
+            }
+
+            for (uint32_t Index = 0; Index < LoadedList->Count; ++Index) {
+                plugin_subscriber *Subscriber = LoadedList->Subscribers + Index;
+                if ((Subscriber->Mailbox->Legacy) &&
+                    (strncmp(Subscriber->Mailbox->Name, Node, strlen(Subscriber->Mailbox->Name)) != 0)) {
+                    AddBroadcastWork(WorkArray + WorkCount++, Subscriber, Topic, Payload);
+                }
+            }
+
+            EndPluginList(LoadedEpoch);
+            EndPluginList(TopicEpoch);
+            RunWork(WorkArray, WorkCount);
+
+            ReleasePluginPayload(Payload);
+        }
+    }
+}
+
+internal inline char *
+ReplaceString(char *Old, char *New)
+{
+    free(Old);
+    return New;
+}
+
+/*
+ * NOTE(koekeishiya): Applications and windows are created the first time they are seen,
+ * because a trace can be started while applications and windows already exist.
+ */
+internal macos_application *
+ApplicationFromSnapshot(int32_t PID, char *Name)
+{
+    macos_application *Application = Applications[PID];
+    if (!Application) {
+        Application = (macos_application *) calloc(1, sizeof(macos_application));
+        Application->Ref = (AXUIElementRef) Application;
+        Application->PID = PID;
+        Applications[PID] = Application;
+    }
+
+    if (Name && (!Application->Name || strcmp(Application->Name, Name) != 0)) {
+        Application->Name = ReplaceString(Application->Name, strdup(Name));
+    }
+
+    return Application;
+}
+
+internal macos_window *
+WindowFromSnapshot(trace_window *Snapshot)
+{
+    macos_window *Window = Windows[Snapshot->Id];
+    if (!Window) {
+        Window = (macos_window *) calloc(1, sizeof(macos_window));
+        Window->Ref = (AXUIElementRef) Window;
+        Window->Id = Snapshot->Id;
+        Windows[Snapshot->Id] = Window;
+    }
+
+    Window->Owner = ApplicationFromSnapshot(Snapshot->PID, Snapshot->Owner);
+    Window->Flags = Snapshot->Flags;
+    Window->Level = Snapshot->Level;
+    Window->Position.x = Snapshot->X;
+    Window->Position.y = Snapshot->Y;
+    Window->Size.width = Snapshot->Width;
+    Window->Size.height = Snapshot->Height;
+
+    // NOTE(koekeishiya): The window takes ownership of the strings in the snapshot.
+    Window->Name = ReplaceString(Window->Name, Snapshot->Name);
+    Window->Mainrole = ReplaceString((char *) Window->Mainrole, Snapshot->Role);
+    Window->Subrole = ReplaceString((char *) Window->Subrole, Snapshot->Subrole);
+    free(Snapshot->Owner);
+
+    return Window;
+}
+
+internal void
+DestroyWindow(macos_window *Window)
+{
+    Windows.erase(Window->Id);
+    free(Window->Name);
+    free((char *) Window->Mainrole);
+    free((char *) Window->Subrole);
+    free(Window);
+}
+
+internal void
+DestroyApplication(macos_application *Application)
+{
+    for (std::map<uint32_t, macos_window *>::iterator It = Windows.begin(); It != Windows.end();) {
+        macos_window *Window = It->second;
+        ++It;
+
+        if (Window->Owner == Application) {
+            DestroyWindow(Window);
+        }
+    }
+
+    Applications.erase(Application->PID);
+    free(Application->Name);
+    free(Application);
+}
+
+internal void
+ReplayApplicationEvent(event_type Type, trace_buffer *Payload)
+{
+    trace_application Snapshot;
+    if (!TraceReadApplication(Payload, &Snapshot)) return;
+
+    macos_application *Application = ApplicationFromSnapshot(Snapshot.PID, Snapshot.Name);
+    TraceFreeApplication(&Snapshot);
+
+    switch (Type) {
+    case ChunkWM_ApplicationLaunched:     DispatchExport(chunkwm_export_application_launched, Application);     break;
+    case ChunkWM_ApplicationActivated:    DispatchExport(chunkwm_export_application_activated, Application);    break;
+    case ChunkWM_ApplicationDeactivated:  DispatchExport(chunkwm_export_application_deactivated, Application);  break;
+    case ChunkWM_ApplicationVisible:      DispatchExport(chunkwm_export_application_unhidden, Application);     break;
+    case ChunkWM_ApplicationHidden:       DispatchExport(chunkwm_export_application_hidden, Application);       break;
+    case ChunkWM_ApplicationTerminated: {
+        DispatchExport(chunkwm_export_application_terminated, Application);
+        DestroyApplication(Application);
+    } break;
+    default: break;
+    }
+}
+
+internal void
+ReplayDisplayEvent(event_type Type, trace_buffer *Payload)
+{
+    CGDirectDisplayID DisplayId;
+    if (!TraceReadU32(Payload, &DisplayId)) return;
+
+    switch (Type) {
+    case ChunkWM_DisplayAdded:    DispatchExport(chunkwm_export_display_added, &DisplayId);   break;
+    case ChunkWM_DisplayRemoved:  DispatchExport(chunkwm_export_display_removed, &DisplayId); break;
+    case ChunkWM_DisplayMoved:    DispatchExport(chunkwm_export_display_moved, &DisplayId);   break;
+    case ChunkWM_DisplayResized:  DispatchExport(chunkwm_export_display_resized, &DisplayId); break;
+    default: break;
+    }
+}
+
+// NOTE(koekeishiya): Mirrors the checks performed by the window callbacks in callback.cpp.
+internal void
+ReplayWindowEvent(event_type Type, trace_buffer *Payload)
+{
+    trace_window Snapshot;
+    if (!TraceReadWindow(Payload, &Snapshot)) return;
+    if (!Snapshot.Id) {
+        TraceFreeWindow(&Snapshot);
+        return;
+    }
+
+    macos_window *Window = WindowFromSnapshot(&Snapshot);
+
+    if (Type == ChunkWM_WindowCreated) {
+        DispatchExport(chunkwm_export_window_created, Window);
+        return;
+    }
+
+    if (Type == ChunkWM_WindowDestroyed) {
+        DispatchExport(chunkwm_export_window_destroyed, Window);
+        DestroyWindow(Window);
+        return;
+    }
+
+    if (AXLibHasFlags(Window, Window_Invalid)) {
+        return;
+    }
+
+    switch (Type) {
+    case ChunkWM_WindowFocused: {
+        if (!AXLibHasFlags(Window, Window_Minimized)) {
+            DispatchExport(chunkwm_export_window_focused, Window);
+        }
+    } break;
+    case ChunkWM_WindowMoved:         DispatchExport(chunkwm_export_window_moved, Window);         break;
+    case ChunkWM_WindowResized:       DispatchExport(chunkwm_export_window_resized, Window);       break;
+    case ChunkWM_WindowTitleChanged:  DispatchExport(chunkwm_export_window_title_changed, Window); break;
+    case ChunkWM_WindowMinimized: {
+        AXLibAddFlags(Window, Window_Minimized);
+        DispatchExport(chunkwm_export_window_minimized, Window);
+    } break;
+    case ChunkWM_WindowDeminimized: {
+        AXLibClearFlags(Window, Window_Init_Minimized | Window_Minimized);
+        DispatchExport(chunkwm_export_window_deminimized, Window);
+    } break;
+    default: break;
+    }
+}
+
+internal void
+ReplayEvent(trace_record *Record, trace_buffer *Payload)
+{
+    event_type Type = (event_type) Record->Type;
+
+    switch (Type) {
+    case ChunkWM_ApplicationLaunched:
+    case ChunkWM_ApplicationTerminated:
+    case ChunkWM_ApplicationActivated:
+    case ChunkWM_ApplicationDeactivated:
+    case ChunkWM_ApplicationVisible:
+    case ChunkWM_ApplicationHidden: {
+        ReplayApplicationEvent(Type, Payload);
+    } break;
+    case ChunkWM_DisplayAdded:
+    case ChunkWM_DisplayRemoved:
+    case ChunkWM_DisplayMoved:
+    case ChunkWM_DisplayResized: {
+        ReplayDisplayEvent(Type, Payload);
+    } break;
+    case ChunkWM_DisplayChanged: {
+        DispatchExport(chunkwm_export_display_changed, NULL);
+    } break;
+    case ChunkWM_SpaceChanged: {
+        DispatchExport(chunkwm_export_space_changed, NULL);
+    } break;
+    case ChunkWM_WindowCreated:
+    case ChunkWM_WindowDestroyed:
+    case ChunkWM_WindowFocused:
+    case ChunkWM_WindowMoved:
+    case ChunkWM_WindowResized:
+    case ChunkWM_WindowMinimized:
+    case ChunkWM_WindowDeminimized:
+    case ChunkWM_WindowTitleChanged: {
+        ReplayWindowEvent(Type, Payload);
+    } break;
+    default: {
+        fprintf(stderr, "replay: skipping event of unknown type %u\n", Record->Type);
+    } break;
+    }
+
+    DispatchBroadcasts();
+}
+
+internal void
+SleepUntil(uint64_t Deadline)
+{
+    uint64_t Now = GetTimeNanoseconds();
+    if (Deadline > Now) {
+        uint64_t Remaining = Deadline - Now;
+        struct timespec Time = { (time_t) (Remaining / 1000000000ULL), (long) (Remaining % 1000000000ULL) };
+        nanosleep(&Time, NULL);
+    }
+}
+
+internal bool
+ReplayTrace(const char *Path, bool Realtime)
+{
+    trace_reader Reader;
+    if (!BeginTraceReader(&Reader, Path)) {
+        fprintf(stderr, "replay: '%s' is not a valid trace file!\n", Path);
+        return false;
+    }
+
+    trace_record Record;
+    trace_buffer Payload;
+    uint64_t Count = 0;
+    uint64_t First = 0;
+
+    uint64_t Begin = GetTimeNanoseconds();
+    while (TraceReadRecord(&Reader, &Record, &Payload)) {
+        if (!Count) First = Record.Timestamp;
+        if (Realtime) SleepUntil(Begin + (Record.Timestamp - First));
+
+        ReplayEvent(&Record, &Payload);
+        ++Count;
+    }
+    uint64_t Elapsed = GetTimeNanoseconds() - Begin;
+
+    EndTraceReader(&Reader);
+
+    printf("replayed %llu events in %.2f ms (%.0f events/s)\n",
+           (unsigned long long) Count,
+           (double) Elapsed / 1e6,
+           Elapsed ? (double) Count / ((double) Elapsed / 1e9) : 0.0);
+    return true;
+}
+
+internal void
+PrintPluginStats()
+{
+    for (std::map<plugin *, replay_plugin *>::iterator It = ReplayPlugins.begin(); It != ReplayPlugins.end(); ++It) {
+        replay_plugin *Stats = It->second;
+        printf("plugin '%s'\n", Stats->Name);
+
+        for (int Index = 0; Index <= REPLAY_BROADCAST_EXPORT; ++Index) {
+            latency_histogram *Histogram = Stats->Exports + Index;
+            uint64_t Count = HistogramCount(Histogram);
+            if (!Count) continue;
+
+            printf("    %-40s count %8llu  p50 %9.1fus  p99 %9.1fus  max %9.1fus  total %9.2fms\n",
+                   Index == REPLAY_BROADCAST_EXPORT ? "(broadcasts)" : chunkwm_plugin_export_str[Index],
+                   (unsigned long long) Count,
+                   HistogramPercentile(Histogram, 50.0) / 1000.0,
+                   HistogramPercentile(Histogram, 99.0) / 1000.0,
+                   HistogramMax(Histogram) / 1000.0,
+                   Stats->Total[Index] / 1e6);
+        }
+    }
+}
+
+internal bool
+QueueReplayPlugin(const char *Path)
+{
+    char Absolutepath[PATH_MAX];
+    if (!realpath(Path, Absolutepath)) {
+        fprintf(stderr, "replay: plugin '%s' not found!\n", Path);
+        return false;
+    }
+
+    plugin_fs *PluginFS = (plugin_fs *) malloc(sizeof(plugin_fs));
+    PluginFS->Absolutepath = strdup(Absolutepath);
+    PluginFS->Filename = strdup(basename(Absolutepath));
+    QueueStartupPlugin(PluginFS);
+
+    return true;
+}
+
+// NOTE(koekeishiya): Loads the queued plugins the same way chunkwm does at startup, and prints the timeline.
+internal bool
+LoadReplayPlugins()
+{
+    LoadQueuedPlugins(&Pool);
+
+    bool Result = true;
+    char Buffer[256];
+    plugin_load_timeline *Timeline = GetStartupTimeline();
+    printf("loaded %u plugins in %.2fms\n", Timeline->Count, Timeline->Elapsed / 1000000.0);
+
+    for (uint32_t Index = 0; Index < Timeline->Count; ++Index) {
+        plugin_load_timing *Timing = Timeline->Plugins + Index;
+        FormatPluginLoadTiming(Timing, Buffer, sizeof(Buffer));
+        printf("    %s", Buffer);
+
+        if (!Timing->Loaded) {
+            fprintf(stderr, "replay: could not load plugin '%s'!\n", Timing->Filename);
+            Result = false;
+        }
+    }
+
+    loaded_plugin_list *List = BeginLoadedPluginList();
+    for (loaded_plugin_list_iter It = List->begin(); It != List->end(); ++It) {
+        loaded_plugin *LoadedPlugin = It->second;
+        if (!ReplayPlugins[LoadedPlugin->Plugin]) {
+            replay_plugin *Stats = (replay_plugin *) calloc(1, sizeof(replay_plugin));
+            Stats->Name = LoadedPlugin->Info->PluginName;
+            ReplayPlugins[LoadedPlugin->Plugin] = Stats;
+        }
+    }
+    EndLoadedPluginList();
+
+    return Result;
+}
+
+/*
+ * NOTE(koekeishiya): Writes a synthetic trace, a handful of applications that create, focus,
+ * move, resize, retitle and destroy windows, so that the harness can be used without
+ * recording a trace on macOS first. Events are spaced 1ms apart.
+ */
+internal bool
+GenerateTrace(const char *Path, uint32_t EventCount)
+{
+    trace_writer Writer;
+    if (!BeginTraceWriter(&Writer, Path, 0)) {
+        fprintf(stderr, "replay: could not create trace file '%s'!\n", Path);
+        return false;
+    }
+
+    const int ApplicationCount = 8;
+    const int WindowsPerApplication = 4;
+    char Name[64], Owner[64];
+    trace_buffer Buffer;
+    uint64_t Timestamp = 0;
+
+    for (int Index = 0; Index < ApplicationCount; ++Index) {
+        snprintf(Owner, sizeof(Owner), "Application %d", Index);
+        trace_application Application = { 1000 + Index, Owner };
+
+        TraceBufferReset(&Buffer);
+        TraceWriteApplication(&Buffer, &Application);
+        TraceWriteRecord(&Writer, ChunkWM_ApplicationLaunched, Timestamp += 1000000, &Buffer);
+    }
+
+    uint32_t Seed = 1;
+    for (uint32_t Index = 0; Index < EventCount; ++Index) {
+        Seed = Seed * 1103515245 + 12345;
+        uint32_t Random = Seed >> 8;
+
+        int Application = Random % ApplicationCount;
+        uint32_t WindowId = 1 + Application * WindowsPerApplication + ((Random >> 4) % WindowsPerApplication);
+
+        event_type Types[] =
+        {
+            ChunkWM_WindowCreated, ChunkWM_WindowFocused, ChunkWM_WindowMoved,
+            ChunkWM_WindowResized, ChunkWM_WindowTitleChanged, ChunkWM_WindowTitleChanged,
+            ChunkWM_WindowMoved, ChunkWM_WindowDestroyed,
+        };
+        event_type Type = Types[(Random >> 8) % (sizeof(Types) / sizeof(*Types))];
+
+        snprintf(Owner, sizeof(Owner), "Application %d", Application);
+        snprintf(Name, sizeof(Name), "Window %u - %u", WindowId, Index);
+
+        trace_window Window = {};
+        Window.Id = WindowId;
+        Window.Flags = Window_Movable | Window_Resizable;
+        Window.PID = 1000 + Application;
+        Window.X = (Random >> 12) % 1280;
+        Window.Y = (Random >> 16) % 800;
+        Window.Width = 400 + (Random % 800);
+        Window.Height = 300 + (Random % 500);
+        Window.Name = Name;
+        Window.Owner = Owner;
+        Window.Role = (char *) "AXWindow";
+        Window.Subrole = (char *) "AXStandardWindow";
+
+        TraceBufferReset(&Buffer);
+        TraceWriteWindow(&Buffer, &Window);
+        TraceWriteRecord(&Writer, Type, Timestamp += 1000000, &Buffer);
+    }
+
+    printf("generated %llu events in '%s'\n", (unsigned long long) Writer.Records, Path);
+    EndTraceWriter(&Writer);
+    return true;
+}
+
+internal void
+PrintUsage()
+{
+    fprintf(stderr,
+            "usage: replay [-r] [-t threads] <trace> <plugin.so>..\n"
+            "       replay -g <events> <trace>\n"
+            "\n"
+            "  -r          replay at the recorded pacing instead of as fast as possible\n"
+            "  -t threads  size of the plugin thread pool, 0 runs plugins on the replay thread\n"
+            "              (default: one thread per processor)\n"
+            "  -g events   write a synthetic trace with the given number of window events\n");
+}
+
+int main(int Count, char **Args)
+{
+    bool Realtime = false;
+    uint32_t GenerateCount = 0;
+
+    int Option;
+    while ((Option = getopt(Count, Args, "rt:g:")) != -1) {
+        switch (Option) {
+        case 'r': Realtime = true; break;
+        case 't': ThreadCount = atoi(optarg); break;
+        case 'g': GenerateCount = strtoul(optarg, NULL, 10); break;
+        default: PrintUsage(); return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= Count) {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    const char *TracePath = Args[optind++];
+    if (GenerateCount) {
+        return GenerateTrace(TracePath, GenerateCount) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    c_log_active_level = C_LOG_LEVEL_WARN;
+    pthread_mutex_init(&BroadcastLock, NULL);
+
+    if (!BeginCVars() || !BeginPlugins() || !BeginPluginMailboxes(NULL)) {
+        fprintf(stderr, "replay: failed to initialize critical mutex!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (ThreadCount < 0) {
+        ThreadCount = ThreadPoolDefaultThreadCount();
+    }
+
+    if (!BeginThreadPool(&Pool, ThreadCount)) {
+        fprintf(stderr, "replay: could not initialize thread pool!\n");
+        return EXIT_FAILURE;
+    }
+
+    while (optind < Count) {
+        if (!QueueReplayPlugin(Args[optind++])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!LoadReplayPlugins()) {
+        return EXIT_FAILURE;
+    }
+
+    if (!ReplayTrace(TracePath, Realtime)) {
+        return EXIT_FAILURE;
+    }
+
+    PrintPluginStats();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#ifndef CHUNKWM_REPLAY_STUB_CARBON_H
+#define CHUNKWM_REPLAY_STUB_CARBON_H
+
+/*
+ * NOTE(koekeishiya): Minimal stand-in for the Carbon framework headers, so that the
+ * accessibility structs and plugins can be compiled on platforms without it. Only the
+ * types used by the structs in common/accessibility are provided. Strings are plain
+ * C strings owned by the replay driver, so CFRelease does nothing.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+
+typedef double CGFloat;
+typedef uint32_t CGDirectDisplayID;
+typedef uint32_t CGWindowID;
+typedef unsigned char Boolean;
+
+struct CGPoint
+{
+    CGFloat x;
+    CGFloat y;
+};
+
+struct CGSize
+{
+    CGFloat width;
+    CGFloat height;
+};
+
+struct CGRect
+{
+    CGPoint origin;
+    CGSize size;
+};
+
+struct ProcessSerialNumber
+{
+    uint32_t highLongOfPSN;
+    uint32_t lowLongOfPSN;
+};
+
+typedef const void *CFTypeRef;
+typedef const char *CFStringRef;
+typedef struct __AXUIElement *AXUIElementRef;
+typedef struct __AXObserver *AXObserverRef;
+
+typedef uint32_t CFStringEncoding;
+typedef const void *CFAllocatorRef;
+#define kCFStringEncodingUTF8 0x08000100
+
+typedef int32_t AXError;
+enum
+{
+    kAXErrorSuccess = 0,
+    kAXErrorFailure = -25200,
+    kAXErrorIllegalArgument = -25201,
+    kAXErrorInvalidUIElement = -25202,
+    kAXErrorCannotComplete = -25204,
+    kAXErrorNotificationAlreadyRegistered = -25209,
+};
+
+#define CFSTR(String) (String)
+
+#define kAXWindowRole                       CFSTR("AXWindow")
+#define kAXStandardWindowSubrole            CFSTR("AXStandardWindow")
+#define kAXDialogSubrole                    CFSTR("AXDialog")
+#define kAXSystemDialogSubrole              CFSTR("AXSystemDialog")
+#define kAXFloatingWindowSubrole            CFSTR("AXFloatingWindow")
+#define kAXUIElementDestroyedNotification   CFSTR("AXUIElementDestroyed")
+#define kAXWindowMiniaturizedNotification   CFSTR("AXWindowMiniaturized")
+#define kAXWindowDeminiaturizedNotification CFSTR("AXWindowDeminiaturized")
+
+inline void
+CFRelease(CFTypeRef)
+{
+}
+
+// NOTE(koekeishiya): The string is not copied, it must outlive the result.
+inline CFStringRef
+CFStringCreateWithCString(CFAllocatorRef, const char *String, CFStringEncoding)
+{
+    return String;
+}
+
+inline Boolean
+CFEqual(CFTypeRef A, CFTypeRef B)
+{
+    return (A == B) || (A && B && strcmp((const char *) A, (const char *) B) == 0);
+}
+
+#endif
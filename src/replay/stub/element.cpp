@@ -0,0 +1,156 @@
+#include "../../common/accessibility/element.h"
+#include "../../common/accessibility/window.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * NOTE(koekeishiya): Stubbed accessibility layer for plugins that are built for the replay
+ * driver. Plugins include this file instead of common/accessibility/element.cpp.
+ *
+ * The replay driver sets the 'Ref' of every macos_window to the window itself, so these
+ * functions read and write the recorded snapshot instead of talking to another process.
+ * Everything that would require a running window server fails or does nothing.
+ */
+
+#define internal static
+
+internal inline macos_window *
+StubWindow(AXUIElementRef WindowRef)
+{
+    return (macos_window *) WindowRef;
+}
+
+extern "C" AXError _AXUIElementGetWindow(AXUIElementRef WindowRef, uint32_t *WID)
+{
+    *WID = WindowRef ? StubWindow(WindowRef)->Id : 0;
+    return WindowRef ? kAXErrorSuccess : kAXErrorInvalidUIElement;
+}
+
+uint32_t AXLibGetWindowID(AXUIElementRef WindowRef)
+{
+    return StubWindow(WindowRef)->Id;
+}
+
+bool AXLibIsWindowMinimized(AXUIElementRef WindowRef)
+{
+    return AXLibHasFlags(StubWindow(WindowRef), Window_Minimized);
+}
+
+bool AXLibIsWindowResizable(AXUIElementRef WindowRef)
+{
+    return AXLibHasFlags(StubWindow(WindowRef), Window_Resizable);
+}
+
+bool AXLibIsWindowMovable(AXUIElementRef WindowRef)
+{
+    return AXLibHasFlags(StubWindow(WindowRef), Window_Movable);
+}
+
+bool AXLibIsWindowFullscreen(AXUIElementRef WindowRef)
+{
+    return false;
+}
+
+bool AXLibSetWindowPosition(AXUIElementRef WindowRef, float X, float Y)
+{
+    macos_window *Window = StubWindow(WindowRef);
+    Window->Position.x = X;
+    Window->Position.y = Y;
+    return true;
+}
+
+bool AXLibSetWindowSize(AXUIElementRef WindowRef, float Width, float Height)
+{
+    macos_window *Window = StubWindow(WindowRef);
+    Window->Size.width = Width;
+    Window->Size.height = Height;
+    return true;
+}
+
+bool AXLibSetWindowFullscreen(AXUIElementRef WindowRef, bool Fullscreen)
+{
+    return false;
+}
+
+void AXLibCloseWindow(AXUIElementRef WindowRef)
+{
+}
+
+CFTypeRef AXLibGetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property)
+{
+    return NULL;
+}
+
+AXError AXLibSetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property, CFTypeRef Value)
+{
+    return kAXErrorCannotComplete;
+}
+
+AXUIElementRef AXLibGetFocusedWindow(AXUIElementRef ApplicationRef)
+{
+    return NULL;
+}
+
+void AXLibSetFocusedWindow(AXUIElementRef WindowRef)
+{
+}
+
+AXUIElementRef AXLibGetFocusedApplication()
+{
+    return NULL;
+}
+
+void AXLibSetFocusedApplication(ProcessSerialNumber PSN)
+{
+}
+
+void AXLibSetFocusedApplication(pid_t PID)
+{
+}
+
+// NOTE(koekeishiya): Caller is responsible for freeing memory of returned pointer
+char *AXLibGetWindowTitle(AXUIElementRef WindowRef)
+{
+    macos_window *Window = StubWindow(WindowRef);
+    return Window->Name ? strdup(Window->Name) : NULL;
+}
+
+CGPoint AXLibGetWindowPosition(AXUIElementRef WindowRef)
+{
+    return StubWindow(WindowRef)->Position;
+}
+
+CGSize AXLibGetWindowSize(AXUIElementRef WindowRef)
+{
+    return StubWindow(WindowRef)->Size;
+}
+
+bool AXLibGetWindowRole(AXUIElementRef WindowRef, CFStringRef *Role)
+{
+    *Role = StubWindow(WindowRef)->Mainrole;
+    return *Role != NULL;
+}
+
+bool AXLibGetWindowSubrole(AXUIElementRef WindowRef, CFStringRef *Subrole)
+{
+    *Subrole = StubWindow(WindowRef)->Subrole;
+    return *Subrole != NULL;
+}
+
+CGPoint AXLibGetCursorPos()
+{
+    CGPoint Result = {};
+    return Result;
+}
+
+// NOTE(koekeishiya): Caller is responsible for freeing memory of returned pointer
+char *CopyCFStringToC(CFStringRef String)
+{
+    return strdup(String);
+}
+
+const char *AXLibAXErrorToString(AXError Error)
+{
+    return Error == kAXErrorSuccess ? "kAXErrorSuccess" : "kAXErrorFailure";
+}
@@ -0,0 +1,6 @@
+#ifndef CHUNKWM_REPLAY_STUB_LIBPROC_H
+#define CHUNKWM_REPLAY_STUB_LIBPROC_H
+
+// NOTE(koekeishiya): Included by chunkc, which does not use it, see the 'config' benchmark.
+
+#endif